@@ -88,6 +88,10 @@ static int __init venus_init(void) {
 	if (current_cpu_data.cputype != CPU_4KEC) {
 		return -ENODEV;
 	}
+#if defined(CONFIG_HIGH_RES_TIMERS) && defined(CONFIG_REALTEK_USE_EXTERNAL_TIMER_INTERRUPT)
+	/* CP0 compare belongs to the hrtimer event source */
+	return -ENODEV;
+#endif
 	op_model_venus.cpu_type = "timer";
 	return 0;
 }
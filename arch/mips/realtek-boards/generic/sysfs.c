@@ -278,6 +278,16 @@ static ssize_t signature_show(struct subsystem *subsys, char *page)
 }
 REALTEK_BOARDS_ATTR_RO(signature);
 
+#ifdef CONFIG_NO_IDLE_HZ
+extern ssize_t realtek_dyntick_show(char *page);
+
+static ssize_t dyntick_show(struct subsystem *subsys, char *page)
+{
+	return realtek_dyntick_show(page);
+}
+REALTEK_BOARDS_ATTR_RO(dyntick);
+#endif
+
 decl_subsys(realtek_boards, NULL, NULL);
 EXPORT_SYMBOL(realtek_boards_subsys);
 
@@ -299,6 +309,9 @@ static struct attribute * realtek_boards_attrs[] = {
 	&modelconfig_attr.attr,
 	&update_attr.attr,
 	&dvrfs_buffer_attr.attr,
+#ifdef CONFIG_NO_IDLE_HZ
+	&dyntick_attr.attr,
+#endif
 	NULL
 };
 
@@ -25,6 +25,8 @@
 #include <linux/sched.h>
 #include <linux/spinlock.h>
 #include <linux/interrupt.h>
+#include <linux/hrtimer.h>
+#include <linux/rcupdate.h>
 //#include <linux/time.h>
 //#include <linux/timex.h>
 //#include <linux/mc146818rtc.h>
@@ -35,6 +37,7 @@
 //#include <asm/cpu.h>
 #include <asm/time.h>
 #include <asm/io.h>
+#include <asm/div64.h>
 #include <venus.h>
 
 //#include <generic.h>
@@ -68,8 +71,15 @@ static unsigned int display_count = 0;
 
 static unsigned int timer_tick_count=0;
 
+#ifdef CONFIG_NO_IDLE_HZ
+void start_hz_timer(struct pt_regs *regs);
+#endif
+
 void mips_timer_interrupt(struct pt_regs *regs)
 {
+#ifdef CONFIG_NO_IDLE_HZ
+	start_hz_timer(regs);
+#endif
 //#ifdef CONFIG_REALTEK_USE_EXTERNAL_TIMER_INTERRUPT
 //outl(0x100, VENUS_MIS_ISR);
 //#endif
@@ -260,16 +270,246 @@ static void realtek_hpt_init(unsigned int count)
 	return;
 }
 
+#define TC2_CYCLES_PER_JIFFY	(27000000/HZ)
+
+#ifdef CONFIG_NO_IDLE_HZ
+#ifdef CONFIG_NO_IDLE_HZ_INIT
+int sysctl_hz_timer = 0;
+#else
+int sysctl_hz_timer = 1;
+#endif
+
+/*
+ * While idle with nothing due for a while, TC2 is reloaded with a
+ * period of several jiffies instead of one. It keeps counting from the
+ * last tick, so when something else wakes us early the elapsed jiffies
+ * can be read straight off TC2CVR and the period cut back to end on the
+ * next jiffy boundary: the tick phase is never lost.
+ */
+static int realtek_tick_stopped;	/* TC2 is running a long period */
+static int realtek_tick_restore;	/* reload one jiffy on the next tick */
+static unsigned int realtek_tick_skip;	/* jiffies in the long period */
+static unsigned int realtek_hpt_base;	/* TC2CVR of the last accounted tick */
+
+static struct {
+	unsigned long	entries;	/* times the tick was stopped */
+	unsigned long	early;		/* woken before the period ran out */
+	unsigned long	skipped;	/* jiffies spent without a tick */
+	unsigned long	longest;	/* longest tickless stretch */
+} realtek_dyntick_stat;
+#endif
+
 static unsigned int realtek_hpt_read(void)
 {
+#ifdef CONFIG_NO_IDLE_HZ
+	unsigned int count = inl(VENUS_MIS_TC2CVR);
+
+	if (count >= realtek_hpt_base)
+		count -= realtek_hpt_base;
+	return count;
+#else
 	return inl(VENUS_MIS_TC2CVR);
+#endif
 }
 
 static void realtek_timer_ack(void)
 {
 	outl(0x100, VENUS_MIS_ISR);
+#ifdef CONFIG_NO_IDLE_HZ
+	if (realtek_tick_restore) {
+		outl(TC2_CYCLES_PER_JIFFY, VENUS_MIS_TC2TVR);
+		realtek_hpt_base = 0;
+		realtek_tick_restore = 0;
+	}
+#endif
+}
+
+#ifdef CONFIG_NO_IDLE_HZ
+/*
+ * Stop the HZ tick. Only the idle loop may call this, with interrupts
+ * disabled.
+ */
+static void stop_hz_timer(void)
+{
+	unsigned long delta;
+
+	if (sysctl_hz_timer != 0 || realtek_tick_stopped)
+		return;
+
+	cpu_set(smp_processor_id(), nohz_cpu_mask);
+
+	/* Keep ticking if rcu or a softirq still needs this cpu */
+	if (rcu_pending(smp_processor_id()) || local_softirq_pending())
+		goto out;
+
+	delta = next_timer_interrupt() - jiffies;
+	if (delta > 0xffffffff / TC2_CYCLES_PER_JIFFY)
+		delta = 0xffffffff / TC2_CYCLES_PER_JIFFY;
+	if (delta <= 1)
+		goto out;
+
+	/* A tick that is already due has to be taken first */
+	if (inl(VENUS_MIS_ISR) & 0x100)
+		goto out;
+	outl(delta * TC2_CYCLES_PER_JIFFY, VENUS_MIS_TC2TVR);
+	if (inl(VENUS_MIS_ISR) & 0x100) {
+		outl(TC2_CYCLES_PER_JIFFY, VENUS_MIS_TC2TVR);
+		goto out;
+	}
+
+	realtek_tick_skip = delta;
+	realtek_tick_stopped = 1;
+	realtek_dyntick_stat.entries++;
+	return;
+out:
+	cpu_clear(smp_processor_id(), nohz_cpu_mask);
+}
+
+/*
+ * Restart the HZ tick and account the jiffies that went by without it.
+ * Called with interrupts disabled on every interrupt entry.
+ */
+void start_hz_timer(struct pt_regs *regs)
+{
+	unsigned int ticks, next;
+
+	if (!realtek_tick_stopped)
+		return;
+	realtek_tick_stopped = 0;
+
+	if (inl(VENUS_MIS_ISR) & 0x100) {
+		/*
+		 * The long period ran out. TC2 has wrapped, and the pending
+		 * tick interrupt accounts for the last jiffy of the period.
+		 */
+		ticks = realtek_tick_skip - 1;
+		realtek_hpt_base = 0;
+		realtek_tick_restore = 1;
+	} else {
+		/* Woken early: end the period on the next jiffy boundary */
+		ticks = inl(VENUS_MIS_TC2CVR) / TC2_CYCLES_PER_JIFFY;
+		next = (ticks + 1) * TC2_CYCLES_PER_JIFFY;
+		outl(next, VENUS_MIS_TC2TVR);
+		while (inl(VENUS_MIS_TC2CVR) >= next) {
+			ticks++;
+			next += TC2_CYCLES_PER_JIFFY;
+			outl(next, VENUS_MIS_TC2TVR);
+		}
+		realtek_hpt_base = ticks * TC2_CYCLES_PER_JIFFY;
+		realtek_tick_restore = 1;
+		realtek_dyntick_stat.early++;
+	}
+
+	realtek_dyntick_stat.skipped += ticks;
+	if (ticks > realtek_dyntick_stat.longest)
+		realtek_dyntick_stat.longest = ticks;
+
+	/*
+	 * Account as hardirq time, but leave the softirqs to the irq_exit()
+	 * of the interrupt that woke us: running them here would re-enable
+	 * interrupts before its source has been acknowledged.
+	 */
+	add_preempt_count(HARDIRQ_OFFSET);
+	write_seqlock(&xtime_lock);
+	next = ticks;
+	while (next--)
+		do_timer(regs);
+	write_sequnlock(&xtime_lock);
+	while (ticks--)
+		update_process_times(user_mode(regs));
+	sub_preempt_count(HARDIRQ_OFFSET);
+
+	cpu_clear(smp_processor_id(), nohz_cpu_mask);
+}
+
+static void realtek_nohz_idle(void)
+{
+	local_irq_disable();
+	if (!need_resched()) {
+		stop_hz_timer();
+		local_irq_enable();
+		/* Any interrupt brings the tick back through start_hz_timer() */
+		__asm__ __volatile__(
+			"	.set	mips3		\n"
+			"	wait			\n"
+			"	.set	mips0		\n");
+		return;
+	}
+	local_irq_enable();
+}
+
+/* Tickless idle statistics for /sys/realtek_boards/dyntick */
+ssize_t realtek_dyntick_show(char *page)
+{
+	return sprintf(page, "hz_timer %d\nentries %lu\nearly %lu\n"
+			"skipped %lu\nlongest %lu\n",
+			sysctl_hz_timer,
+			realtek_dyntick_stat.entries,
+			realtek_dyntick_stat.early,
+			realtek_dyntick_stat.skipped,
+			realtek_dyntick_stat.longest);
+}
+#endif
+
+#ifdef CONFIG_HIGH_RES_TIMERS
+/*
+ * The tick comes from TC2, which leaves the CP0 count/compare pair free
+ * to serve as the one-shot event source of the high resolution timers.
+ */
+static unsigned int realtek_hrt_freq;	/* CP0 count rate, est_freq/2 */
+static unsigned int realtek_hrt_mult;	/* count cycles per ns, 0.32 fixed point */
+static int realtek_hrt_armed;
+
+static int realtek_hrt_set_next_event(unsigned long delta)
+{
+	unsigned int cnt;
+
+	cnt = read_c0_count() + (unsigned int)(((u64)delta * realtek_hrt_mult) >> 32);
+	write_c0_compare(cnt);
+	realtek_hrt_armed = 1;
+
+	if ((int)(read_c0_count() - cnt) >= 0) {
+		realtek_hrt_armed = 0;
+		return -ETIME;
+	}
+	return 0;
+}
+
+static struct hrtimer_event_source realtek_hrt_source = {
+	.name		= "cp0 compare",
+	.min_delta_ns	= 2000,
+	.max_delta_ns	= NSEC_PER_SEC,
+	.set_next_event	= realtek_hrt_set_next_event,
+};
+
+/*
+ * Called from the IP7 dispatch. Writing compare acknowledges the
+ * interrupt; a match while nothing is armed is the counter wrapping
+ * around onto a stale compare value and is just dropped.
+ */
+void realtek_hrt_interrupt(void)
+{
+	write_c0_compare(read_c0_compare());
+	if (realtek_hrt_armed) {
+		realtek_hrt_armed = 0;
+		hrtimer_interrupt();
+	}
+}
+
+static void __init realtek_hrt_init(void)
+{
+	u64 mult = (u64)realtek_hrt_freq << 32;
+
+	do_div(mult, NSEC_PER_SEC);
+	realtek_hrt_mult = (unsigned int)mult;
+
+	write_c0_cause(read_c0_cause() & ~0x08000000);	/* count enable */
+	clear_c0_cause(IE_IRQ5);
+	set_c0_status(IE_IRQ5);
+	hrtimer_register_event_source(&realtek_hrt_source);
 }
 #endif
+#endif
 
 void __init mips_time_init(void)
 {
@@ -310,6 +550,9 @@ void __init mips_time_init(void)
 	mips_hpt_read = realtek_hpt_read;
 	mips_hpt_init = realtek_hpt_init;
 	mips_timer_ack = realtek_timer_ack;
+#ifdef CONFIG_HIGH_RES_TIMERS
+	realtek_hrt_freq = est_freq/2;
+#endif
 #else
 	mips_hpt_frequency = est_freq/2;
 #endif
@@ -350,6 +593,12 @@ void __init mips_timer_setup(struct irqaction *irq)
 #else
 	clear_c0_cause(IE_IRQ5);
 	clear_c0_status(IE_IRQ5);
+#ifdef CONFIG_HIGH_RES_TIMERS
+	realtek_hrt_init();
+#endif
+#ifdef CONFIG_NO_IDLE_HZ
+	cpu_wait = realtek_nohz_idle;
+#endif
 #endif
 
 }
@@ -36,6 +36,8 @@
 
 extern asmlinkage void mipsIRQ(void);
 extern void mips_sb2_setup();
+extern void realtek_hrt_interrupt(void);
+extern void start_hz_timer(struct pt_regs *regs);
 
 #define USING_SEARCHING_TABLE
 
@@ -67,6 +69,11 @@ void venus_hw0_irqdispatch(int irq, struct pt_regs *regs)
 	int i =0;
 	static unsigned short table[]={0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
 
+#ifdef CONFIG_NO_IDLE_HZ
+	/* Bring the tick back before anything looks at jiffies */
+	start_hz_timer(regs);
+#endif
+
 #ifdef CONFIG_REALTEK_USE_FAST_INTERRUPT
 	if (irq & 0x4) {
 		i = 2;
@@ -82,6 +89,12 @@ void venus_hw0_irqdispatch(int irq, struct pt_regs *regs)
 		/* if we open the oprofile function... */
 	        cause = read_c0_cause();
 	        if (cause & CAUSEF_IP7) {
+#ifdef CONFIG_HIGH_RES_TIMERS
+			/* CP0 compare is the hrtimer event source */
+			irq_enter();
+			realtek_hrt_interrupt();
+			irq_exit();
+#endif
 	                perf_irq(regs);
 	                return;
 	        }
@@ -20,6 +20,7 @@
 #include <linux/hash.h>
 #include <linux/rbtree.h>
 #include <linux/interrupt.h>
+#include <linux/ioprio.h>
 
 #define REQ_SYNC	1
 #define REQ_ASYNC	0
@@ -124,7 +125,9 @@ struct as_data {
 	struct work_struct antic_work;	/* Deferred unplugging */
 	struct io_context *io_context;	/* Identify the expected process */
 	int ioc_finished; /* IO associated with io_context is finished */
+	int ioc_class;			/* io priority class of that process */
 	int nr_dispatched;
+	unsigned long nr_class[IOPRIO_CLASS_IDLE + 1];	/* queued, per class */
 
 	/*
 	 * settings that change how the i/o scheduler behaves
@@ -175,6 +178,7 @@ struct as_rq {
 	unsigned long expires;
 
 	unsigned int is_sync;
+	unsigned int ioprio_class;
 	enum arq_state state;
 };
 
@@ -323,6 +327,68 @@ static struct request *as_find_arq_hash(struct as_data *ad, sector_t offset)
 	return NULL;
 }
 
+/*
+ * io priority support functions. requests are counted per class while
+ * they sit on a fifo list
+ */
+static inline void
+as_add_arq_fifo(struct as_data *ad, struct as_rq *arq, int data_dir)
+{
+	list_add_tail(&arq->fifo, &ad->fifo_list[data_dir]);
+	ad->nr_class[arq->ioprio_class]++;
+}
+
+static inline void as_del_arq_fifo(struct as_data *ad, struct as_rq *arq)
+{
+	if (!list_empty(&arq->fifo)) {
+		list_del_init(&arq->fifo);
+		ad->nr_class[arq->ioprio_class]--;
+	}
+}
+
+/*
+ * true if everything queued is idle class io
+ */
+static inline int as_only_idle_queued(struct as_data *ad)
+{
+	return ad->nr_class[IOPRIO_CLASS_IDLE]
+		&& !ad->nr_class[IOPRIO_CLASS_RT]
+		&& !ad->nr_class[IOPRIO_CLASS_BE];
+}
+
+/*
+ * as_ioprio_select overrides the pick of the deadline/batch logic when a
+ * more important request is waiting in the same direction: real-time
+ * requests go before anything else, idle requests after everything else.
+ */
+static struct as_rq *as_ioprio_select(struct as_data *ad, struct as_rq *arq)
+{
+	struct as_rq *best = NULL;
+	struct list_head *entry;
+
+	if (arq->ioprio_class == IOPRIO_CLASS_RT)
+		return arq;
+	if (arq->ioprio_class != IOPRIO_CLASS_IDLE) {
+		if (!ad->nr_class[IOPRIO_CLASS_RT])
+			return arq;
+		best = arq;
+	}
+
+	list_for_each(entry, &ad->fifo_list[ad->batch_data_dir]) {
+		struct as_rq *__arq = list_entry_fifo(entry);
+
+		if (__arq->ioprio_class == IOPRIO_CLASS_RT)
+			return __arq;
+		if (!best && __arq->ioprio_class != IOPRIO_CLASS_IDLE) {
+			best = __arq;
+			if (!ad->nr_class[IOPRIO_CLASS_RT])
+				break;
+		}
+	}
+
+	return best ? best : arq;
+}
+
 /*
  * rb tree support functions
  */
@@ -686,6 +752,12 @@ static int as_can_break_anticipation(struct as_data *ad, struct as_rq *arq)
 		return 1;
 	}
 
+	if (arq && arq->ioprio_class == IOPRIO_CLASS_RT
+			&& ad->ioc_class != IOPRIO_CLASS_RT) {
+		/* real-time io never waits for someone else's */
+		return 1;
+	}
+
 	if (ad->ioc_finished && as_antic_expired(ad)) {
 		/*
 		 * In this situation status should really be FINISHED,
@@ -781,6 +853,12 @@ static int as_can_anticipate(struct as_data *ad, struct as_rq *arq)
 		 */
 		return 0;
 
+	if (ad->ioc_class == IOPRIO_CLASS_IDLE)
+		/*
+		 * Never hold the disk for an idle class process
+		 */
+		return 0;
+
 	if (ad->antic_status == ANTIC_FINISHED)
 		/*
 		 * Don't restart if we have just finished. Run the next request
@@ -977,6 +1055,13 @@ static void as_completed_request(request_queue_t *q, struct request *rq)
 	WARN_ON(ad->nr_dispatched == 0);
 	ad->nr_dispatched--;
 
+	/*
+	 * idle class io is held back while the disk is busy, kick it once
+	 * the last request is done
+	 */
+	if (!ad->nr_dispatched && ad->nr_class[IOPRIO_CLASS_IDLE])
+		kblockd_schedule_work(&ad->antic_work);
+
 	/*
 	 * Start counting the batch from when a request of that direction is
 	 * actually serviced. This should help devices with big TCQ windows
@@ -1046,7 +1131,7 @@ static void as_remove_queued_request(request_queue_t *q, struct request *rq)
 	if (ad->next_arq[data_dir] == arq)
 		ad->next_arq[data_dir] = as_find_next_arq(ad, arq);
 
-	list_del_init(&arq->fifo);
+	as_del_arq_fifo(ad, arq);
 	as_remove_merge_hints(q, arq);
 	as_del_arq_rb(ad, arq);
 }
@@ -1182,6 +1267,7 @@ static void as_move_to_dispatch(struct as_data *ad, struct as_rq *arq)
 	if (data_dir == REQ_SYNC) {
 		/* In case we have to anticipate after this */
 		copy_io_context(&ad->io_context, &arq->io_context);
+		ad->ioc_class = arq->ioprio_class;
 	} else {
 		if (ad->io_context) {
 			put_io_context(ad->io_context);
@@ -1248,6 +1334,12 @@ static int as_dispatch_request(struct as_data *ad)
 		|| ad->changed_batch)
 		return 0;
 
+	/*
+	 * idle class io only gets the disk when nobody else is using it
+	 */
+	if (as_only_idle_queued(ad) && ad->nr_dispatched)
+		return 0;
+
 	if (!(reads && writes && as_batch_expired(ad)) ) {
 		/*
 		 * batch is still running or no reads or no writes
@@ -1336,6 +1428,8 @@ fifo_expired:
 		BUG_ON(arq == NULL);
 	}
 
+	arq = as_ioprio_select(ad, arq);
+
 	if (ad->changed_batch) {
 		WARN_ON(ad->new_batch);
 
@@ -1421,6 +1515,7 @@ static void as_add_request(struct as_data *ad, struct as_rq *arq)
 	else
 		arq->is_sync = 0;
 	data_dir = arq->is_sync;
+	arq->ioprio_class = task_ioprio_class(current);
 
 	arq->io_context = as_get_io_context();
 
@@ -1435,7 +1530,7 @@ static void as_add_request(struct as_data *ad, struct as_rq *arq)
 		 * set expire time (only used for reads) and add to fifo list
 		 */
 		arq->expires = jiffies + ad->fifo_expire[data_dir];
-		list_add_tail(&arq->fifo, &ad->fifo_list[data_dir]);
+		as_add_arq_fifo(ad, arq, data_dir);
 
 		if (rq_mergeable(arq->request)) {
 			as_add_arq_hash(ad, arq);
@@ -1682,7 +1777,7 @@ static void as_merged_request(request_queue_t *q, struct request *req)
 		 */
 		as_del_arq_rb(ad, arq);
 		if ((alias = as_add_arq_rb(ad, arq)) ) {
-			list_del_init(&arq->fifo);
+			as_del_arq_fifo(ad, arq);
 			as_add_aliased_request(ad, arq, alias);
 			if (next_arq)
 				ad->next_arq[arq->is_sync] = next_arq;
@@ -1724,7 +1819,7 @@ as_merged_requests(request_queue_t *q, struct request *req,
 
 		as_del_arq_rb(ad, arq);
 		if ((alias = as_add_arq_rb(ad, arq)) ) {
-			list_del_init(&arq->fifo);
+			as_del_arq_fifo(ad, arq);
 			as_add_aliased_request(ad, arq, alias);
 			if (next_arq)
 				ad->next_arq[arq->is_sync] = next_arq;
@@ -1747,6 +1842,17 @@ as_merged_requests(request_queue_t *q, struct request *req,
 		}
 	}
 
+	/*
+	 * the merged request inherits the more important io class
+	 */
+	if (anext->ioprio_class < arq->ioprio_class) {
+		if (!list_empty(&arq->fifo)) {
+			ad->nr_class[arq->ioprio_class]--;
+			ad->nr_class[anext->ioprio_class]++;
+		}
+		arq->ioprio_class = anext->ioprio_class;
+	}
+
 	/*
 	 * Transfer list of aliases
 	 */
@@ -21,6 +21,7 @@
 #include <linux/hash.h>
 #include <linux/rbtree.h>
 #include <linux/mempool.h>
+#include <linux/ioprio.h>
 
 static unsigned long max_elapsed_crq;
 static unsigned long max_elapsed_dispatch;
@@ -75,6 +76,12 @@ static int cfq_back_penalty = 2;	/* penalty of a backwards seek */
 #define rb_entry_crq(node)	rb_entry((node), struct cfq_rq, rb_node)
 #define rq_rb_key(rq)		(rq)->sector
 
+/*
+ * one round robin list per io priority class, indexed by class
+ */
+#define CFQ_PRIO_LISTS		(IOPRIO_CLASS_IDLE + 1)
+#define cfq_class_rr(cfqd, cfqq)	(&(cfqd)->rr_list[(cfqq)->ioprio_class])
+
 /*
  * threshold for switching off non-tag accounting
  */
@@ -98,7 +105,7 @@ static kmem_cache_t *cfq_pool;
 static kmem_cache_t *cfq_ioc_pool;
 
 struct cfq_data {
-	struct list_head rr_list;
+	struct list_head rr_list[CFQ_PRIO_LISTS];
 	struct list_head empty_list;
 
 	struct hlist_head *cfq_hash;
@@ -173,6 +180,10 @@ struct cfq_queue {
 	int in_flight;
 	/* number of currently allocated requests */
 	int alloc_limit[2];
+
+	/* io priority class and level of the owning task(s) */
+	unsigned short ioprio_class;
+	unsigned short ioprio;
 };
 
 struct cfq_rq {
@@ -403,7 +414,7 @@ static void cfq_update_next_crq(struct cfq_rq *crq)
 
 static int cfq_check_sort_rr_list(struct cfq_queue *cfqq)
 {
-	struct list_head *head = &cfqq->cfqd->rr_list;
+	struct list_head *head = cfq_class_rr(cfqq->cfqd, cfqq);
 	struct list_head *next, *prev;
 
 	/*
@@ -430,7 +441,8 @@ static int cfq_check_sort_rr_list(struct cfq_queue *cfqq)
 
 static void cfq_sort_rr_list(struct cfq_queue *cfqq, int new_queue)
 {
-	struct list_head *entry = &cfqq->cfqd->rr_list;
+	struct list_head *head = cfq_class_rr(cfqq->cfqd, cfqq);
+	struct list_head *entry = head;
 
 	if (!cfqq->on_rr)
 		return;
@@ -442,7 +454,7 @@ static void cfq_sort_rr_list(struct cfq_queue *cfqq, int new_queue)
 	/*
 	 * sort by our mean service_used, sub-sort by in-flight requests
 	 */
-	while ((entry = entry->prev) != &cfqq->cfqd->rr_list) {
+	while ((entry = entry->prev) != head) {
 		struct cfq_queue *__cfqq = list_entry_cfqq(entry);
 
 		if (cfqq->service_used > __cfqq->service_used)
@@ -450,7 +462,7 @@ static void cfq_sort_rr_list(struct cfq_queue *cfqq, int new_queue)
 		else if (cfqq->service_used == __cfqq->service_used) {
 			struct list_head *prv;
 
-			while ((prv = entry->prev) != &cfqq->cfqd->rr_list) {
+			while ((prv = entry->prev) != head) {
 				__cfqq = list_entry_cfqq(prv);
 
 				WARN_ON(__cfqq->service_used > cfqq->service_used);
@@ -467,6 +479,34 @@ static void cfq_sort_rr_list(struct cfq_queue *cfqq, int new_queue)
 	list_add(&cfqq->cfq_list, entry);
 }
 
+/*
+ * service is charged in proportion to the priority level, so within a
+ * class a level 0 queue gets roughly eight times the disk time of a
+ * level 7 queue
+ */
+static inline unsigned long cfq_prio_charge(struct cfq_queue *cfqq,
+					    unsigned long service)
+{
+	return service * (cfqq->ioprio + 1);
+}
+
+/*
+ * sample the io priority of the submitting task. a queue that changes
+ * class while busy moves over to the round robin list of its new class
+ */
+static void cfq_init_prio(struct cfq_queue *cfqq, struct task_struct *tsk)
+{
+	int ioprio_class = task_ioprio_class(tsk);
+
+	cfqq->ioprio = task_ioprio(tsk);
+	if (cfqq->ioprio_class == ioprio_class)
+		return;
+
+	cfqq->ioprio_class = ioprio_class;
+	if (cfqq->on_rr)
+		cfq_sort_rr_list(cfqq, 1);
+}
+
 /*
  * add to busy list of queues for service, trying to be fair in ordering
  * the pending list according to requests serviced
@@ -821,21 +861,22 @@ cfq_dispatch_request(request_queue_t *q, struct cfq_data *cfqd,
 	cfq_dispatch_sort(q, crq);
 }
 
-static int cfq_dispatch_requests(request_queue_t *q, int max_dispatch)
+static int
+__cfq_dispatch_requests(request_queue_t *q, struct cfq_data *cfqd,
+			struct list_head *rr_list, int max_dispatch)
 {
-	struct cfq_data *cfqd = q->elevator->elevator_data;
 	struct cfq_queue *cfqq;
 	struct list_head *entry, *tmp;
 	int queued, busy_queues, first_round;
 
-	if (list_empty(&cfqd->rr_list))
+	if (list_empty(rr_list))
 		return 0;
 
 	queued = 0;
 	first_round = 1;
 restart:
 	busy_queues = 0;
-	list_for_each_safe(entry, tmp, &cfqd->rr_list) {
+	list_for_each_safe(entry, tmp, rr_list) {
 		cfqq = list_entry_cfqq(entry);
 
 		BUG_ON(RB_EMPTY(&cfqq->sort_list));
@@ -863,6 +904,38 @@ restart:
 	return queued;
 }
 
+/*
+ * serve the classes in strict order: best-effort queues only get the
+ * disk when no real-time queue has pending io, and idle queues only when
+ * the disk is otherwise unused. 'force' drains everything, idle included.
+ */
+static int
+cfq_dispatch_requests(request_queue_t *q, int max_dispatch, int force)
+{
+	struct cfq_data *cfqd = q->elevator->elevator_data;
+	int queued;
+
+	if (!cfqd->busy_queues)
+		return 0;
+
+	queued = __cfq_dispatch_requests(q, cfqd,
+				&cfqd->rr_list[IOPRIO_CLASS_RT], max_dispatch);
+	if (queued)
+		return queued;
+
+	queued = __cfq_dispatch_requests(q, cfqd,
+				&cfqd->rr_list[IOPRIO_CLASS_BE], max_dispatch);
+	if (queued)
+		return queued;
+
+	if (!force && cfqd->rq_in_driver)
+		return 0;
+
+	return __cfq_dispatch_requests(q, cfqd,
+				&cfqd->rr_list[IOPRIO_CLASS_IDLE],
+				force ? max_dispatch : 1);
+}
+
 static inline void cfq_account_dispatch(struct cfq_rq *crq)
 {
 	struct cfq_queue *cfqq = crq->cfq_queue;
@@ -895,7 +968,7 @@ static inline void cfq_account_dispatch(struct cfq_rq *crq)
 			cfqq->service_used /= 10;
 		}
 
-		cfqq->service_used++;
+		cfqq->service_used += cfq_prio_charge(cfqq, 1);
 		cfq_sort_rr_list(cfqq, 0);
 	}
 
@@ -932,7 +1005,7 @@ cfq_account_completion(struct cfq_queue *cfqq, struct cfq_rq *crq)
 			cfqq->service_used >>= 3;
 		}
 
-		cfqq->service_used += duration;
+		cfqq->service_used += cfq_prio_charge(cfqq, duration);
 		cfq_sort_rr_list(cfqq, 0);
 
 		if (duration > max_elapsed_crq)
@@ -958,7 +1031,7 @@ dispatch:
 		return rq;
 	}
 
-	if (cfq_dispatch_requests(q, cfqd->cfq_quantum))
+	if (cfq_dispatch_requests(q, cfqd->cfq_quantum, 0))
 		goto dispatch;
 
 	return NULL;
@@ -1228,6 +1301,8 @@ retry:
 		atomic_inc(&cfqd->ref);
 		cfqq->key_type = cfqd->key_type;
 		cfqq->service_start = ~0UL;
+		cfqq->ioprio_class = IOPRIO_CLASS_BE;
+		cfqq->ioprio = IOPRIO_NORM;
 	}
 
 	if (new_cfqq)
@@ -1245,6 +1320,8 @@ static void cfq_enqueue(struct cfq_data *cfqd, struct cfq_rq *crq)
 	if (rq_data_dir(crq->request) == READ || current->flags & PF_SYNCWRITE)
 		crq->is_sync = 1;
 
+	cfq_init_prio(crq->cfq_queue, current);
+
 	cfq_add_crq_rb(crq);
 	crq->queue_start = jiffies;
 
@@ -1259,7 +1336,7 @@ cfq_insert_request(request_queue_t *q, struct request *rq, int where)
 
 	switch (where) {
 		case ELEVATOR_INSERT_BACK:
-			while (cfq_dispatch_requests(q, cfqd->cfq_quantum))
+			while (cfq_dispatch_requests(q, cfqd->cfq_quantum, 1))
 				;
 			list_add_tail(&rq->queuelist, &q->queue_head);
 			break;
@@ -1287,7 +1364,7 @@ static int cfq_queue_empty(request_queue_t *q)
 {
 	struct cfq_data *cfqd = q->elevator->elevator_data;
 
-	return list_empty(&q->queue_head) && list_empty(&cfqd->rr_list);
+	return list_empty(&q->queue_head) && !cfqd->busy_queues;
 }
 
 static void cfq_completed_request(request_queue_t *q, struct request *rq)
@@ -1348,13 +1425,23 @@ static int cfq_may_queue(request_queue_t *q, int rw)
 		if (cfqq->allocated[rw] < cfqd->cfq_queued)
 			return ELV_MQUEUE_MUST;
 
-		if (cfqd->busy_queues)
-			limit = q->nr_requests / cfqd->busy_queues;
-
-		if (limit < cfqd->cfq_queued)
+		/*
+		 * real-time queues may always fill up to the hard limit,
+		 * idle queues never get more than the minimum
+		 */
+		if (cfqq->ioprio_class == IOPRIO_CLASS_RT)
+			return ELV_MQUEUE_MUST;
+		else if (cfqq->ioprio_class == IOPRIO_CLASS_IDLE)
 			limit = cfqd->cfq_queued;
-		else if (limit > cfqd->max_queued)
-			limit = cfqd->max_queued;
+		else {
+			if (cfqd->busy_queues)
+				limit = q->nr_requests / cfqd->busy_queues;
+
+			if (limit < cfqd->cfq_queued)
+				limit = cfqd->cfq_queued;
+			else if (limit > cfqd->max_queued)
+				limit = cfqd->max_queued;
+		}
 
 		if (cfqq->allocated[rw] >= limit) {
 			if (limit > cfqq->alloc_limit[rw])
@@ -1508,7 +1595,8 @@ static int cfq_init_queue(request_queue_t *q, elevator_t *e)
 		return -ENOMEM;
 
 	memset(cfqd, 0, sizeof(*cfqd));
-	INIT_LIST_HEAD(&cfqd->rr_list);
+	for (i = 0; i < CFQ_PRIO_LISTS; i++)
+		INIT_LIST_HEAD(&cfqd->rr_list[i]);
 	INIT_LIST_HEAD(&cfqd->empty_list);
 
 	cfqd->crq_hash = kmalloc(sizeof(struct hlist_head) * CFQ_MHASH_ENTRIES, GFP_KERNEL);
@@ -37,6 +37,10 @@ Update List :
     2.1     |   20081217    |   Kevin Wang  | 1) Add Blocking Write
 -----------------------------------------------------------------------------
     2.2     |   20081218    |   Kevin Wang  | 1) Using Work Queue to instead the timer
+-----------------------------------------------------------------------------
+    2.3     |   20090605    |   1) handle tx/rx entirely in isr, tx timeout / retry by timer
+                            |   2) retry failed messages in driver
+                            |   3) add poll & nonblocking xmit with bounded tx queue
 ----------------------------------------------------------------------------*/
 #include <linux/kernel.h>
 #include <linux/config.h>
@@ -55,6 +59,8 @@ Update List :
 static mars_cec m_cec;
 
 #define TX_TIMEOUT      (HZ<<2)
+#define TX_RETRY        2                   // retries on top of the hardware ones
+#define TX_RETRY_DELAY  ((HZ/50) + 1)       // > signal free time of a new initiator
 //#define FPGA_MODE             // for fpga debug
 
 #ifdef FPGA_MODE
@@ -319,127 +325,295 @@ void mars_cec_rx_reset(mars_cec* p_this)
 
 
 /*------------------------------------------------------------------
- * Func : mars_cec_tx_work
+ * Func : _mars_cec_rx_handler
  *
- * Desc : mars cec tx function 
+ * Desc : mars cec rx state machine, it should be called with lock held
  *
  * Parm : p_this : handle of mars cec 
  *         
  * Retn : N/A  
  *------------------------------------------------------------------*/
-void mars_cec_tx_work(void* data)
-{
-    mars_cec* p_this = (mars_cec*) data;
-    mars_cec_xmit* p_xmit = &p_this->xmit;    
-    unsigned char dest;        
-    unsigned long flags;                
-    
-    spin_lock_irqsave(&p_this->lock, flags);   
-                
-    if (p_xmit->state == XMIT)
+static 
+void _mars_cec_rx_handler(mars_cec* p_this)
+{    
+    mars_cec_rcv* p_rcv = &p_this->rcv;            
+              
+    if (!p_rcv->enable)
     {
-        if (read_reg32(MIS_CEC_TX0) & TX_EN)
-        {                                                   
-            // xmitting
-            if (read_reg32(MIS_CEC_TX1) & TX_INT)
-            {      
-                if (p_xmit->cmb->len)
-                {
-                    _write_tx_fifo(p_xmit->cmb);
+        if (p_rcv->state==RCV)
+        {
+            cec_rx_dbg("force stop\n");            
+            write_reg32(MIS_CEC_RX0, 0);
+            kfree_cmb(p_rcv->cmb);
+            p_rcv->cmb   = NULL;
+            p_rcv->state = IDEL;
+        }        
+        return;
+    }    
                     
-                    if (p_xmit->cmb->len==0)                    
-                        write_reg32(MIS_CEC_TX0, read_reg32(MIS_CEC_TX0) & ~TX_CONTINUOUS);                                                        
+    if (p_rcv->state==RCV)
+    {                   
+        if (read_reg32(MIS_CEC_RX0) & RX_EN)
+        {                           
+            if (read_reg32(MIS_CEC_RX1) & RX_INT)
+            {                                               
+                if (_read_rx_fifo(p_rcv->cmb)<0)                                    
+                {
+                    cec_rx_dbg("read rx fifo failed, return to rx\n");                    
+                    write_reg32(MIS_CEC_RX0, 0);
+                    p_rcv->state = IDEL;
                 }                            
-
-                write_reg32(MIS_CEC_TX1, TX_INT);   // clear interrupt                                                                       
-            }   
-            
-            if (time_after(jiffies, p_xmit->timeout))
-            {                                    
-                write_reg32(MIS_CEC_TX0, 0);                          
-                
-                p_xmit->cmb->status = XMIT_TIMEOUT;                
-                _cmb_tx_complete(p_xmit->cmb);
-                        
-                p_xmit->cmb   = NULL;
-                p_xmit->state = IDEL;
-                
-#ifdef RST_TX_HIGH                
-                write_reg32(MIS_CEC_TX_DATA2, 1);                
-                mars_cec_rx_reset(p_this);              // reset rx
-                schedule_work(&p_this->rcv.work);       // restart rx                   
-#endif
-                cec_warning("cec tx timeout\n");
-                
-                cancel_delayed_work(&p_xmit->work);
-            }                     
-        }            
+                 
+                write_reg32(MIS_CEC_RX1, RX_INT);                     
+            }            
+        }
         else
-        {
-            cancel_delayed_work(&p_xmit->work);
+        {               
+            cec_rx_dbg("rx_stop (0x%08x)\n", read_reg32(MIS_CEC_RX0));
             
-            if ((read_reg32(MIS_CEC_TX1) & TX_EOM)==0)
+            if ((read_reg32(MIS_CEC_RX1) & RX_EOM) && _read_rx_fifo(p_rcv->cmb))
+            {                                                                 
+                *cmb_push(p_rcv->cmb, 1) = (read_reg32(MIS_CEC_RX0) & 0xF)<<4 |
+                                           (read_reg32(MIS_CEC_CR0) & 0xF);
+                                         
+                cmb_queue_tail(&p_this->rx_queue, p_rcv->cmb);                        
+                p_rcv->cmb = NULL;
+                wake_up(&p_rcv->wait);                  // wakeup readers
+            }
+
+            p_rcv->state = IDEL;            
+        }         
+    }
+    
+    if (p_rcv->state==IDEL)
+    {           
+#ifdef RST_TX_HIGH                                
+        if (read_reg32(MIS_CEC_TX_DATA2)!=1)
+        {       
+            cec_warning("[CEC] WARNING, runing rx when tx is running\n");     
+            return;
+        }
+#endif
+        
+        if (!p_rcv->cmb)   
+        {            
+            if (cmb_queue_len(&p_this->rx_free_queue))            
+                p_rcv->cmb = cmb_dequeue(&p_this->rx_free_queue);
+            else if ((p_rcv->cmb = alloc_cmb(RX_BUFFER_SIZE))==NULL)
             {
-                p_xmit->cmb->status = XMIT_FAIL;                
-                cec_warning("cec tx failed\n");
+                cec_warning("[CEC] WARNING, rx over run\n");
+                p_rcv->cmb = cmb_dequeue(&p_this->rx_queue);        // reclaim form rx fifo
             }
-            else
+                
+            if (p_rcv->cmb==NULL)
             {
-                p_xmit->cmb->status = XMIT_OK;
-                cec_tx_dbg("cec tx completed\n");
+                cec_warning("[CEC] FATAL, something wrong, no rx buffer left\n");
+                return;
             }
-            
-            write_reg32(MIS_CEC_TX0, 0);
-            _cmb_tx_complete(p_xmit->cmb);
-            p_xmit->cmb   = NULL;
-            p_xmit->state = IDEL;
-            
-#ifdef RST_TX_HIGH                        
-            write_reg32(MIS_CEC_TX_DATA2, 1);
-            mars_cec_rx_reset(p_this);            
-            schedule_work(&p_this->rcv.work);       // restart rx
-#endif            
-        }                                                 
-    }        
+        }
+                              
+        cmb_purge(p_rcv->cmb);
+        cmb_reserve(p_rcv->cmb, 1);
+                
+        write_reg32(MIS_CEC_RX0, RX_RST);                
+        wmb();
+        write_reg32(MIS_CEC_RX0, 0);        
+        wmb();        
+                                                                                                              
+        write_reg32(MIS_CEC_RX0, RX_EN | RX_INT_EN);
+        cec_rx_dbg("rx_restart (0x%08x)\n", read_reg32(MIS_CEC_RX0));                        
+        p_rcv->state = RCV;        
+    }                         
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : _mars_cec_tx_start
+ *
+ * Desc : start xmitting the next message if tx is idle, it should be
+ *        called with lock held
+ *
+ * Parm : p_this : handle of mars cec 
+ *         
+ * Retn : N/A  
+ *------------------------------------------------------------------*/
+static 
+void _mars_cec_tx_start(mars_cec* p_this)
+{
+    mars_cec_xmit* p_xmit = &p_this->xmit;    
+    unsigned char dest;
     
-    if (p_xmit->state==IDEL)        
+    if (!p_xmit->enable || p_xmit->state!=IDEL)
+        return;
+        
+    if (!p_xmit->cmb)
     {
-        if (p_xmit->enable)
-        {                                    
-            p_xmit->cmb = cmb_dequeue(&p_this->tx_queue);
+        if ((p_xmit->cmb = cmb_dequeue(&p_this->tx_queue))==NULL)
+            return;
             
-            if (p_xmit->cmb)
-            {                            
-                cec_tx_dbg("cec tx : cmb = %p, len=%d\n", p_xmit->cmb, p_xmit->cmb->len);
-                dest = (p_xmit->cmb->data[0] & 0xf);                                
-                cmb_pull(p_xmit->cmb, 1);          
-                p_xmit->timeout = jiffies + TX_TIMEOUT;                                                                        
+        p_xmit->len   = p_xmit->cmb->len;
+        p_xmit->retry = 0;
+        wake_up(&p_xmit->wait);                     // tx queue has space now
+    }
+    
+    cec_tx_dbg("cec tx : cmb = %p, len=%d\n", p_xmit->cmb, p_xmit->cmb->len);
+    dest = (p_xmit->cmb->data[0] & 0xf);                                
+    cmb_pull(p_xmit->cmb, 1);          
+    p_xmit->timeout = jiffies + TX_TIMEOUT;                                                                        
 
 #ifdef RST_TX_HIGH                                    
-                mars_cec_rx_reset(p_this);                // reset rx
-                write_reg32(MIS_CEC_TX_DATA2, TX_DATA2);                
+    mars_cec_rx_reset(p_this);                // reset rx
+    write_reg32(MIS_CEC_TX_DATA2, TX_DATA2);                
 #endif
 
-                // reset tx fifo
-                write_reg32(MIS_CEC_TX0, TX_RST);
-                wmb();
-                write_reg32(MIS_CEC_TX0, 0);                                    
-                wmb();                                
-                                                                                                
-                _write_tx_fifo(p_xmit->cmb);                
-                                                   
-                if (p_xmit->cmb->len==0)
-                    write_reg32(MIS_CEC_TX0, dest | TX_EN | TX_INT_EN);
-                else
-                    write_reg32(MIS_CEC_TX0, dest | TX_EN | TX_INT_EN  | TX_CONTINUOUS);                                    
-                             
-                p_xmit->state = XMIT;
+    // reset tx fifo
+    write_reg32(MIS_CEC_TX0, TX_RST);
+    wmb();
+    write_reg32(MIS_CEC_TX0, 0);                                    
+    wmb();                                
+                                                                                    
+    _write_tx_fifo(p_xmit->cmb);                
+                                       
+    if (p_xmit->cmb->len==0)
+        write_reg32(MIS_CEC_TX0, dest | TX_EN | TX_INT_EN);
+    else
+        write_reg32(MIS_CEC_TX0, dest | TX_EN | TX_INT_EN  | TX_CONTINUOUS);                                    
+                 
+    p_xmit->state = XMIT;
+    
+    cec_tx_dbg("cec tx start\n");
+    
+    mod_timer(&p_xmit->timer, p_xmit->timeout + 1);     // timeout detection
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : _mars_cec_tx_done
+ *
+ * Desc : finish current message, a failed message is retried after 
+ *        the signal free time except polling messages, whose failure 
+ *        is an expected answer. It should be called with lock held.
+ *
+ * Parm : p_this : handle of mars cec 
+ *        status : xmit status
+ *         
+ * Retn : N/A  
+ *------------------------------------------------------------------*/
+static 
+void _mars_cec_tx_done(mars_cec* p_this, unsigned char status)
+{
+    mars_cec_xmit* p_xmit = &p_this->xmit;    
+    cm_buff* cmb = p_xmit->cmb;
+    
+    write_reg32(MIS_CEC_TX0, 0);
+    del_timer(&p_xmit->timer);
+    
+#ifdef RST_TX_HIGH                        
+    write_reg32(MIS_CEC_TX_DATA2, 1);
+    mars_cec_rx_reset(p_this);            
+    _mars_cec_rx_handler(p_this);               // restart rx
+#endif            
+
+    if (status==XMIT_FAIL && p_xmit->len > 1 && p_xmit->retry < TX_RETRY)
+    {
+        cec_tx_dbg("cec tx retry %d\n", p_xmit->retry);
+        p_xmit->retry++;
+        cmb_push(cmb, p_xmit->len - cmb->len);  // rewind message
+        p_xmit->state = XMIT_WAIT;
+        mod_timer(&p_xmit->timer, jiffies + TX_RETRY_DELAY);
+        return;
+    }
+    
+    cmb->status   = status;
+    p_xmit->cmb   = NULL;
+    p_xmit->state = IDEL;
+    _cmb_tx_complete(cmb);
+    
+    _mars_cec_tx_start(p_this);                 // next message
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : _mars_cec_tx_handler
+ *
+ * Desc : mars cec tx interrupt handler, it should be called with lock 
+ *        held
+ *
+ * Parm : p_this : handle of mars cec 
+ *         
+ * Retn : N/A  
+ *------------------------------------------------------------------*/
+static 
+void _mars_cec_tx_handler(mars_cec* p_this)
+{
+    mars_cec_xmit* p_xmit = &p_this->xmit;    
                 
-                cec_tx_dbg("cec tx start\n");
+    if (p_xmit->state != XMIT)
+        return;
+        
+    if (read_reg32(MIS_CEC_TX0) & TX_EN)
+    {                                                   
+        // xmitting
+        if (read_reg32(MIS_CEC_TX1) & TX_INT)
+        {      
+            if (p_xmit->cmb->len)
+            {
+                _write_tx_fifo(p_xmit->cmb);
                 
-                schedule_delayed_work(&p_xmit->work, TX_TIMEOUT+1);      // queue delayed work for timeout detection
-            }
+                if (p_xmit->cmb->len==0)                    
+                    write_reg32(MIS_CEC_TX0, read_reg32(MIS_CEC_TX0) & ~TX_CONTINUOUS);                                                        
+            }                            
+
+            write_reg32(MIS_CEC_TX1, TX_INT);   // clear interrupt                                                                       
+        }   
+    }            
+    else
+    {
+        if ((read_reg32(MIS_CEC_TX1) & TX_EOM)==0)
+        {
+            cec_tx_dbg("cec tx failed\n");
+            _mars_cec_tx_done(p_this, XMIT_FAIL);
         }
+        else
+        {
+            cec_tx_dbg("cec tx completed\n");
+            _mars_cec_tx_done(p_this, XMIT_OK);
+        }
+    }                                                 
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : mars_cec_tx_timer
+ *
+ * Desc : timer of mars cec tx, used for timeout detection and retry
+ *
+ * Parm : data : handle of mars cec 
+ *         
+ * Retn : N/A  
+ *------------------------------------------------------------------*/
+static 
+void mars_cec_tx_timer(unsigned long data)
+{
+    mars_cec* p_this = (mars_cec*) data;
+    mars_cec_xmit* p_xmit = &p_this->xmit;    
+    unsigned long flags;                
+    
+    spin_lock_irqsave(&p_this->lock, flags);   
+    
+    if (p_xmit->state==XMIT && time_after_eq(jiffies, p_xmit->timeout))
+    {
+        cec_warning("cec tx timeout\n");
+        _mars_cec_tx_done(p_this, XMIT_TIMEOUT);
+    }
+    else if (p_xmit->state==XMIT_WAIT)
+    {
+        p_xmit->state = IDEL;
+        _mars_cec_tx_start(p_this);
     }
     
     spin_unlock_irqrestore(&p_this->lock, flags);    
@@ -469,7 +643,7 @@ void mars_cec_tx_start(mars_cec* p_this)
         p_this->xmit.state  = IDEL;
         p_this->xmit.cmb    = NULL;          
         
-        INIT_WORK(&p_this->xmit.work, mars_cec_tx_work, (void*)p_this);
+        _mars_cec_tx_start(p_this);
     }    
     
     spin_unlock_irqrestore(&p_this->lock, flags);
@@ -496,6 +670,7 @@ void mars_cec_tx_stop(mars_cec* p_this)
     {   
         cec_info("cec tx stop\n");
             
+        write_reg32(MIS_CEC_TX0, 0);
         mars_cec_rx_reset(p_this);        
                     
         if (p_this->xmit.cmb)
@@ -507,128 +682,17 @@ void mars_cec_tx_stop(mars_cec* p_this)
         p_this->xmit.enable = 0;
         p_this->xmit.state  = IDEL;
         p_this->xmit.cmb    = NULL;
+        
+        wake_up(&p_this->xmit.wait);
     }    
     
     spin_unlock_irqrestore(&p_this->lock, flags);
-}
-
-
-
-/*------------------------------------------------------------------
- * Func : mars_cec_rx
- *
- * Desc : mars cec rx function 
- *
- * Parm : p_this : handle of mars cec 
- *         
- * Retn : N/A  
- *------------------------------------------------------------------*/
-void mars_cec_rx_work(void* data)
-{    
-    mars_cec* p_this = (mars_cec*) data;
-    mars_cec_rcv* p_rcv = &p_this->rcv;            
-    unsigned long flags;           
-     
-    spin_lock_irqsave(&p_this->lock, flags);       
-              
-    if (!p_rcv->enable)
-    {
-        if (p_rcv->state==RCV)
-        {
-            cec_rx_dbg("force stop\n");            
-            write_reg32(MIS_CEC_RX0, 0);
-            kfree_cmb(p_rcv->cmb);
-            p_rcv->cmb   = NULL;
-            p_rcv->state = IDEL;
-        }        
-        goto end_proc;
-    }    
-                    
-    if (p_rcv->state==RCV)
-    {                   
-        if (read_reg32(MIS_CEC_RX0) & RX_EN)
-        {                           
-            if (read_reg32(MIS_CEC_RX1) & RX_INT)
-            {                                               
-                if (_read_rx_fifo(p_rcv->cmb)<0)                                    
-                {
-                    cec_rx_dbg("read rx fifo failed, return to rx\n");                    
-                    write_reg32(MIS_CEC_RX0, 0);
-                    p_rcv->state = IDEL;
-                }                            
-                 
-                write_reg32(MIS_CEC_RX1, RX_INT);                     
-            }            
-        }
-        else
-        {               
-            cec_rx_dbg("rx_stop (0x%08x)\n", read_reg32(MIS_CEC_RX0));
-            
-            if ((read_reg32(MIS_CEC_RX1) & RX_EOM) && _read_rx_fifo(p_rcv->cmb))
-            {                                                                 
-                *cmb_push(p_rcv->cmb, 1) = (read_reg32(MIS_CEC_RX0) & 0xF)<<4 |
-                                           (read_reg32(MIS_CEC_CR0) & 0xF);
-                                         
-                cmb_queue_tail(&p_this->rx_queue, p_rcv->cmb);                        
-                p_rcv->cmb = NULL;
-                complete(&p_this->rcv.complete);        // wakeup queue
-            }
-
-            p_rcv->state = IDEL;            
-        }         
-    }
-    
-    if (p_rcv->state==IDEL)
-    {           
-        if (!p_rcv->enable)
-            goto end_proc;
-     
-#ifdef RST_TX_HIGH                                
-        if (read_reg32(MIS_CEC_TX_DATA2)!=1)
-        {       
-            cec_warning("[CEC] WARNING, runing rx when tx is running\n");     
-            goto end_proc;
-        }
-#endif
-        
-        if (!p_rcv->cmb)   
-        {            
-            if (cmb_queue_len(&p_this->rx_free_queue))            
-                p_rcv->cmb = cmb_dequeue(&p_this->rx_free_queue);
-            else
-            {
-                cec_warning("[CEC] WARNING, rx over run\n");
-                p_rcv->cmb = cmb_dequeue(&p_this->rx_queue);        // reclaim form rx fifo
-            }
-                
-            if (p_rcv->cmb==NULL)
-            {
-                cec_warning("[CEC] FATAL, something wrong, no rx buffer left\n");
-                goto end_proc;
-            }
-        }
-                              
-        cmb_purge(p_rcv->cmb);
-        cmb_reserve(p_rcv->cmb, 1);
-                
-        write_reg32(MIS_CEC_RX0, RX_RST);                
-        wmb();
-        write_reg32(MIS_CEC_RX0, 0);        
-        wmb();        
-                                                                                                              
-        write_reg32(MIS_CEC_RX0, RX_EN | RX_INT_EN);
-        cec_rx_dbg("rx_restart (0x%08x)\n", read_reg32(MIS_CEC_RX0));                        
-        p_rcv->state = RCV;        
-    }                         
     
-end_proc:
-
-    spin_unlock_irqrestore(&p_this->lock, flags);                      
+    del_timer_sync(&p_this->xmit.timer);
 }
 
 
 
-
 /*------------------------------------------------------------------
  * Func : mars_cec_rx_start
  *
@@ -648,15 +712,11 @@ void mars_cec_rx_start(mars_cec* p_this)
     {                       
         cec_info("rx start\n");
         
-        init_completion(&p_this->rcv.complete);           
-        
         p_this->rcv.enable = 1;
         p_this->rcv.state  = IDEL;
         p_this->rcv.cmb    = NULL;      
         
-        INIT_WORK(&p_this->rcv.work, mars_cec_rx_work, (void*)p_this);
-                
-        schedule_work(&p_this->rcv.work);                  
+        _mars_cec_rx_handler(p_this);
     }    
     
     spin_unlock_irqrestore(&p_this->lock, flags);
@@ -708,7 +768,7 @@ void mars_cec_rx_stop(mars_cec* p_this)
         p_this->rcv.state  = IDEL;
         p_this->rcv.cmb    = NULL;
         
-        complete_all(&p_this->rcv.complete);
+        wake_up(&p_this->rcv.wait);
     }    
     spin_unlock_irqrestore(&p_this->lock, flags);
 }
@@ -733,6 +793,7 @@ irqreturn_t mars_cec_isr(
     struct pt_regs*         regs
     )
 {            
+    mars_cec* p_this = (mars_cec*) dev_id;
     unsigned long event = read_reg32(MIS_ISR) & (CEC_TX_INT | CEC_RX_INT);    
     
     if (!event)
@@ -740,11 +801,15 @@ irqreturn_t mars_cec_isr(
         
     //DBG_CHAR('i');            
     
+    spin_lock(&p_this->lock);
+    
     if (event & CEC_TX_INT)                    
-        mars_cec_tx_work((void*) dev_id);    
+        _mars_cec_tx_handler(p_this);    
     
     if (event & CEC_RX_INT)    
-        mars_cec_rx_work((void*) dev_id);
+        _mars_cec_rx_handler(p_this);
+        
+    spin_unlock(&p_this->lock);
             
     write_reg32(MIS_ISR, event );      
                       
@@ -791,10 +856,14 @@ int mars_cec_init(mars_cec* p_this)
         p_this->xmit.state      = IDEL;    
         p_this->xmit.cmb        = NULL;    
         p_this->xmit.timeout    = 0;        
+        init_timer(&p_this->xmit.timer);
+        p_this->xmit.timer.data     = (unsigned long) p_this;
+        p_this->xmit.timer.function = mars_cec_tx_timer;
+        init_waitqueue_head(&p_this->xmit.wait);
         
         p_this->rcv.state       = IDEL;  
         p_this->rcv.cmb         = NULL;  
-        init_completion(&p_this->rcv.complete);                    
+        init_waitqueue_head(&p_this->rcv.wait);
         
         cmb_queue_head_init(&p_this->tx_queue);
         cmb_queue_head_init(&p_this->rx_queue);
@@ -898,28 +967,41 @@ int mars_cec_set_logical_addr(
 /*------------------------------------------------------------------
  * Func : mars_cec_xmit_msg
  *
- * Desc : xmit message
+ * Desc : xmit message. A blocking xmit always consumes the cmb, a 
+ *        nonblocking one consumes it only when it has been queued.
  *
  * Parm : p_this   : handle of mars cec 
  *        cmb      : msg to xmit
+ *        flags    : NONBLOCK : return once the message is queued
  *         
- * Retn : 0 : for success, others : fail
+ * Retn : 0 : for success, -EAGAIN : tx queue full, others : fail
  *------------------------------------------------------------------*/
 int mars_cec_xmit_message(mars_cec* p_this, cm_buff* cmb, unsigned long flags)
 {    
+    unsigned long irq_flags;
     int ret = 0;
     
-    if (!p_this->xmit.enable)
-        return -1;
-    
     cmb->flags  = flags;
     cmb->status = WAIT_XMIT;
     
-    cmb_queue_tail(&p_this->tx_queue, cmb);
+    spin_lock_irqsave(&p_this->lock, irq_flags);
     
-    schedule_work(&p_this->xmit.work);
+    if (!p_this->xmit.enable)
+        ret = -1;
+    else if ((flags & NONBLOCK) && cmb_queue_len(&p_this->tx_queue) >= TX_RING_LENGTH)
+        ret = -EAGAIN;
+    else
+    {
+        cmb_queue_tail(&p_this->tx_queue, cmb);
+        _mars_cec_tx_start(p_this);
+    }
     
-    if ((cmb->flags & NONBLOCK)==0)
+    spin_unlock_irqrestore(&p_this->lock, irq_flags);
+    
+    if (flags & NONBLOCK)
+        return ret;
+        
+    if (ret==0)
     {                
         wait_for_completion(&cmb->complete);    
         switch(cmb->status)    
@@ -942,9 +1024,9 @@ int mars_cec_xmit_message(mars_cec* p_this, cm_buff* cmb, unsigned long flags)
         }
             
         ret = (cmb->status==XMIT_OK) ? 0 : -1;
-        kfree_cmb(cmb);
     }                    
     
+    kfree_cmb(cmb);
     return ret;
 }
 
@@ -963,17 +1045,28 @@ int mars_cec_xmit_message(mars_cec* p_this, cm_buff* cmb, unsigned long flags)
  *------------------------------------------------------------------*/
 static cm_buff* mars_cec_read_message(mars_cec* p_this, unsigned char flags)
 {                
-    while(!(flags & NONBLOCK) && p_this->status.enable && !cmb_queue_len(&p_this->rx_queue))
-        wait_for_completion(&p_this->rcv.complete);    // wait message
+    cm_buff* cmb;
+    
+    if (!(flags & NONBLOCK))
+    {
+        if (wait_event_interruptible(p_this->rcv.wait, 
+                !p_this->status.enable || cmb_queue_len(&p_this->rx_queue)))
+            return NULL;
+    }
 
     if (p_this->status.enable)
     {
-        cm_buff* cmb = cmb_dequeue(&p_this->rx_queue);
+        cmb = cmb_dequeue(&p_this->rx_queue);
     
         if (cmb)
         {   
+            cm_buff* free_cmb = alloc_cmb(RX_BUFFER_SIZE);     // from cmb pool
+            
             cec_rx_dbg("got msg %p\n", cmb);
-            cmb_queue_tail(&p_this->rx_free_queue, alloc_cmb(RX_BUFFER_SIZE));
+            
+            if (free_cmb)
+                cmb_queue_tail(&p_this->rx_free_queue, free_cmb);
+                
             return cmb;
         }        
     }
@@ -982,6 +1075,38 @@ static cm_buff* mars_cec_read_message(mars_cec* p_this, unsigned char flags)
 }
 
 
+
+/*------------------------------------------------------------------
+ * Func : mars_cec_poll
+ *
+ * Desc : poll status of mars cec
+ *
+ * Parm : p_this : handle of cec device
+ *        file   : file to be polled
+ *        wait   : poll table
+ * 
+ * Retn : poll mask
+ *------------------------------------------------------------------*/
+static unsigned int mars_cec_poll(mars_cec* p_this, struct file* file, poll_table* wait)
+{
+    unsigned int mask = 0;
+    
+    poll_wait(file, &p_this->rcv.wait, wait);
+    poll_wait(file, &p_this->xmit.wait, wait);
+    
+    if (!p_this->status.enable)
+        return POLLERR;
+        
+    if (cmb_queue_len(&p_this->rx_queue))
+        mask |= POLLIN | POLLRDNORM;
+        
+    if (cmb_queue_len(&p_this->tx_queue) < TX_RING_LENGTH)
+        mask |= POLLOUT | POLLWRNORM;
+        
+    return mask;
+}
+
+
 /*------------------------------------------------------------------
  * Func : mars_cec_uninit
  *
@@ -1095,6 +1220,12 @@ static cm_buff* ops_read(cec_device* dev, unsigned char flags)
     return mars_cec_read_message((mars_cec*) cec_get_drvdata(dev), flags);     
 }
 
+
+static unsigned int ops_poll(cec_device* dev, struct file* file, poll_table* wait)
+{
+    return mars_cec_poll((mars_cec*) cec_get_drvdata(dev), file, wait);     
+}
+
 static int ops_suspend(cec_device* dev)
 {       
     return mars_cec_suspend((mars_cec*) cec_get_drvdata(dev));    
@@ -1125,6 +1256,7 @@ static cec_driver mars_cec_driver =
     .enable   = ops_enable,
     .xmit     = ops_xmit,
     .read     = ops_read,
+    .poll     = ops_poll,
     .set_logical_addr = ops_set_logical_addr,    
 };
 
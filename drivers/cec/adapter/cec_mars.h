@@ -18,8 +18,11 @@ typedef struct {
     unsigned char       enable : 1;
     unsigned char       state  : 7;    
     cm_buff*            cmb;    
+    unsigned char       len;            // length of cmb before xmit, for retry
+    unsigned char       retry;    
     unsigned long       timeout;    
-    struct work_struct  work;        
+    struct timer_list   timer;          // tx timeout / retry delay
+    wait_queue_head_t   wait;           // tx queue space available
 }mars_cec_xmit;
 
 
@@ -27,8 +30,7 @@ typedef struct {
     unsigned char       enable : 1;
     unsigned char       state  : 7;
     cm_buff*            cmb;
-    struct completion   complete;
-    struct work_struct  work;
+    wait_queue_head_t   wait;           // message received
 }mars_cec_rcv;
 
 
@@ -36,6 +38,7 @@ enum
 {
     IDEL,
     XMIT,        
+    XMIT_WAIT,          // wait to retry
     RCV    
 };
 
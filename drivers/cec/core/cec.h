@@ -2,6 +2,7 @@
 #define __CEC_H__
 
 #include <linux/device.h>
+#include <linux/poll.h>
 #include "cec_debug.h"
 #include "cm_buff.h"
 
@@ -46,6 +47,7 @@ typedef struct
     void     (*remove)      (cec_device* dev);
     int      (*xmit)        (cec_device* dev, cm_buff* cmg, unsigned char flags);
     cm_buff* (*read)        (cec_device* dev, unsigned char flags);
+    unsigned int (*poll)    (cec_device* dev, struct file* file, poll_table* wait);
     int      (*enable)      (cec_device* dev, unsigned char on_off);
     
     int      (*set_logical_addr)(cec_device* dev, unsigned char log_addr);
@@ -63,6 +65,8 @@ extern void unregister_cec_driver(cec_driver* driver);
 
 
 
+#define CEC_MAX_MSG_SIZE                    16      // header + opcode + 14 operands
+
 #define CEC_WAKEUP_BY_SET_STREAM_PATH       0x01
 #define CEC_WAKEUP_BY_PLAY_CMD              0x02
 #define CEC_WAKEUP_BY_IMAGE_VIEW_ON         0x04
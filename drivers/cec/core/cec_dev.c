@@ -11,6 +11,8 @@
 #include <linux/fs.h>
 #include <linux/cdev.h>
 #include <linux/devfs_fs_kernel.h>
+#include <linux/poll.h>
+#include <asm/uaccess.h>
 #include "cec.h"
 #include "cec_dev.h"
 
@@ -185,7 +187,10 @@ int cec_dev_ioctl(
             return -ENOMEM;
             
         if (copy_from_user(cmb_put(cmb, msg.len), (unsigned char __user *)msg.buf, msg.len))
+        {
+            kfree_cmb(cmb);
             return -EFAULT;                    
+        }
                     
         return drv->xmit(dev, cmb, 0);      // BLOCK I/O        
         
@@ -228,9 +233,189 @@ int cec_dev_ioctl(
 
 
 
+/*------------------------------------------------------------------
+ * Func : cec_dev_read
+ *
+ * Desc : read function of cec dev, all queued messages which fit in 
+ *        the buffer are returned at once
+ *
+ * Parm : file  : context of file
+ *        buf   : user buffer
+ *        count : size of user buffer
+ *        ppos  : file position
+ *         
+ * Retn : number of bytes read, negative for error
+ *------------------------------------------------------------------*/
+static 
+ssize_t cec_dev_read(
+    struct file*            file, 
+    char __user*            buf, 
+    size_t                  count, 
+    loff_t*                 ppos
+    )
+{
+    cec_device* dev = node_list[iminor(file->f_dentry->d_inode)].device;
+    cec_driver* drv;
+    cm_buff*    cmb;
+    size_t      n = 0;
+    
+    if (!dev)
+        return -ENODEV;
+        
+    if (count < 1 + CEC_MAX_MSG_SIZE)
+        return -EINVAL;
+        
+    drv = (cec_driver*) to_cec_driver(dev->dev.driver);
+    
+    while (count - n >= 1 + CEC_MAX_MSG_SIZE)
+    {
+        // block for the first message only
+        cmb = drv->read(dev, (n || (file->f_flags & O_NONBLOCK)) ? NONBLOCK : 0);
+        
+        if (!cmb)
+            break;
+            
+        if (cmb->len > CEC_MAX_MSG_SIZE)
+        {
+            cec_warning("cec : drop oversized message (%d bytes)\n", cmb->len);
+            kfree_cmb(cmb);
+            continue;
+        }
+        
+        if (put_user(cmb->len, (unsigned char __user *) buf + n) ||
+            copy_to_user(buf + n + 1, cmb->data, cmb->len))
+        {
+            kfree_cmb(cmb);
+            return -EFAULT;
+        }
+        
+        n += 1 + cmb->len;
+        kfree_cmb(cmb);
+    }
+    
+    if (n)
+        return n;
+        
+    if (file->f_flags & O_NONBLOCK)
+        return -EAGAIN;
+        
+    return signal_pending(current) ? -ERESTARTSYS : 0;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : cec_dev_write
+ *
+ * Desc : write function of cec dev, all messages of the buffer are 
+ *        queued for transmission. In blocking mode the messages are 
+ *        sent one by one and the write stops at the first failure.
+ *
+ * Parm : file  : context of file
+ *        buf   : user buffer
+ *        count : size of user buffer
+ *        ppos  : file position
+ *         
+ * Retn : number of bytes written, negative for error
+ *------------------------------------------------------------------*/
+static 
+ssize_t cec_dev_write(
+    struct file*            file, 
+    const char __user*      buf, 
+    size_t                  count, 
+    loff_t*                 ppos
+    )
+{
+    cec_device* dev = node_list[iminor(file->f_dentry->d_inode)].device;
+    cec_driver* drv;
+    cm_buff*    cmb;
+    unsigned char len;
+    unsigned char flags = (file->f_flags & O_NONBLOCK) ? NONBLOCK : 0;
+    size_t      n = 0;
+    int         ret = 0;
+    
+    if (!dev)
+        return -ENODEV;
+        
+    drv = (cec_driver*) to_cec_driver(dev->dev.driver);
+    
+    while (n < count)
+    {
+        if (get_user(len, (const unsigned char __user *) buf + n))
+        {
+            ret = -EFAULT;
+            break;
+        }
+        
+        if (!len || len > CEC_MAX_MSG_SIZE || n + 1 + len > count)
+        {
+            ret = -EINVAL;
+            break;
+        }
+        
+        if ((cmb = alloc_cmb(len))==NULL)
+        {
+            ret = -ENOMEM;
+            break;
+        }
+        
+        if (copy_from_user(cmb_put(cmb, len), buf + n + 1, len))
+        {
+            kfree_cmb(cmb);
+            ret = -EFAULT;
+            break;
+        }
+        
+        if ((ret = drv->xmit(dev, cmb, flags)))
+        {
+            if (flags & NONBLOCK)
+                kfree_cmb(cmb);             // not queued
+                
+            if (ret != -EAGAIN)
+                ret = -EIO;
+            break;
+        }
+        
+        n += 1 + len;
+    }
+    
+    return (n) ? n : ret;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : cec_dev_poll
+ *
+ * Desc : poll function of cec dev
+ *
+ * Parm : file  : context of file
+ *        wait  : poll table
+ *         
+ * Retn : poll mask
+ *------------------------------------------------------------------*/
+static 
+unsigned int cec_dev_poll(struct file* file, poll_table* wait)
+{
+    cec_device* dev = node_list[iminor(file->f_dentry->d_inode)].device;
+    cec_driver* drv;
+    
+    if (!dev)
+        return POLLERR;
+        
+    drv = (cec_driver*) to_cec_driver(dev->dev.driver);
+    
+    return (drv->poll) ? drv->poll(dev, file, wait) : (POLLIN | POLLOUT | POLLRDNORM | POLLWRNORM);
+}
+
+
+
 static struct file_operations cec_dev_fops = 
 {
 	.owner		= THIS_MODULE,	
+	.read		= cec_dev_read,
+	.write		= cec_dev_write,
+	.poll		= cec_dev_poll,
 	.ioctl		= cec_dev_ioctl,
 	.open		= cec_dev_open,
 	.release	= cec_dev_release,
@@ -20,6 +20,13 @@ typedef struct {
 }cec_msg;
 
 
+/* read() / write() of a cec device node carry a stream of messages,
+ * each message is a length byte followed by the message itself 
+ * (header, opcode, operands). read() returns as many queued messages
+ * as the buffer could hold, write() sends all messages of the buffer.
+ */
+
+
 typedef struct{        
     struct cdev     cdev;
     cec_device*     device;
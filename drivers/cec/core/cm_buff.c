@@ -22,12 +22,26 @@ Update List :
     1.0     |   20081208    | Create Phase
 ------------------------------------------------------------------------- 
     1.1     |   20081211    | Add Spinlock Protection
+------------------------------------------------------------------------- 
+    1.2     |   20090605    | Allocate small buffers from a preallocated pool
 -------------------------------------------------------------------------*/
 #include <linux/kernel.h>
 #include <linux/slab.h>
+#include <linux/hardirq.h>
 #include "cm_buff.h"
 
 
+typedef struct {
+    cm_buff             cmb;
+    unsigned char       data[RX_BUFFER_SIZE];
+}cmb_pool_entry;
+
+static cmb_pool_entry   cmb_pool[CMB_POOL_SIZE];
+static cm_buff_head     cmb_pool_free;
+static int              cmb_pool_ready = 0;
+static spinlock_t       cmb_pool_lock = SPIN_LOCK_UNLOCKED;
+
+
 void cmb_queue_head_init(cm_buff_head *head)
 {    
     spin_lock_init(&head->lock);
@@ -107,40 +121,109 @@ unsigned int cmb_queue_len(const cm_buff_head *head)
 void cmb_queue_purge(cm_buff_head *head)
 {
     cm_buff *cmb;
-    unsigned long flags;
-    spin_lock_irqsave(&head->lock, flags);
         
     while ((cmb = cmb_dequeue(head)) != NULL)
         kfree_cmb(cmb);
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : cmb_pool_init
+ *
+ * Desc : put all preallocated buffers to the free list, it will be 
+ *        done on the first allocation
+ *
+ * Parm : N/A
+ *         
+ * Retn : N/A
+ *------------------------------------------------------------------*/
+static void cmb_pool_init(void)
+{
+    unsigned long flags;
+    int i;
+    
+    spin_lock_irqsave(&cmb_pool_lock, flags);
+    
+    if (!cmb_pool_ready)
+    {
+        cmb_queue_head_init(&cmb_pool_free);
+        
+        for (i=0; i<CMB_POOL_SIZE; i++)
+        {
+            cmb_pool[i].cmb.pool = 1;
+            list_add_tail(&cmb_pool[i].cmb.list, &cmb_pool_free.list);
+            cmb_pool_free.qlen++;
+        }
         
-    spin_unlock_irqrestore(&head->lock, flags);                    
+        cmb_pool_ready = 1;
+    }
+    
+    spin_unlock_irqrestore(&cmb_pool_lock, flags);
 }
 
 
+/*------------------------------------------------------------------
+ * Func : alloc_cmb
+ *
+ * Desc : allocate a cec message buffer. Buffers no larger than 
+ *        RX_BUFFER_SIZE come from the preallocated pool, so this 
+ *        could be called from interrupt context.
+ *
+ * Parm : size : size of data
+ *         
+ * Retn : cm_buff, NULL if no memory
+ *------------------------------------------------------------------*/
 cm_buff* alloc_cmb(size_t size)
 {        
-    cm_buff* cmb = (cm_buff*) kmalloc(sizeof(cm_buff) + size, GFP_KERNEL);
+    cm_buff* cmb = NULL;
+    
+    if (size <= RX_BUFFER_SIZE)
+    {
+        if (unlikely(!cmb_pool_ready))
+            cmb_pool_init();
+            
+        cmb = cmb_dequeue(&cmb_pool_free);
+        
+        if (cmb)
+        {
+            cmb->head = ((cmb_pool_entry*) cmb)->data;
+            cmb->end  = cmb->head + RX_BUFFER_SIZE;
+        }
+    }
     
-    if (cmb)
+    if (!cmb)
     {
-        INIT_LIST_HEAD(&cmb->list);
-        init_completion(&cmb->complete);        
-        cmb->status = 0; 
-        cmb->flags  = 0;
-        cmb->head   = ((unsigned char*) cmb) + sizeof(cm_buff);
-        cmb->data   = cmb->head;
-        cmb->tail   = cmb->head;
-        cmb->end    = cmb->head + size;
-        cmb->len    = 0;    
+        cmb = (cm_buff*) kmalloc(sizeof(cm_buff) + size, in_interrupt() ? GFP_ATOMIC : GFP_KERNEL);
+        
+        if (!cmb)
+            return NULL;
+            
+        cmb->pool = 0;
+        cmb->head = ((unsigned char*) cmb) + sizeof(cm_buff);
+        cmb->end  = cmb->head + size;
     }
     
+    INIT_LIST_HEAD(&cmb->list);
+    init_completion(&cmb->complete);        
+    cmb->status = 0; 
+    cmb->flags  = 0;
+    cmb->data   = cmb->head;
+    cmb->tail   = cmb->head;
+    cmb->len    = 0;    
+    
     return cmb;
 }
 
 
 void kfree_cmb(cm_buff* cmb)
 {    
-    if (cmb)       
+    if (!cmb)
+        return;
+        
+    if (cmb->pool)
+        cmb_queue_head(&cmb_pool_free, cmb);        // reuse the hot one first
+    else
         kfree(cmb);
 }
 
@@ -6,6 +6,7 @@
 #include <linux/completion.h>
 
 #define RX_BUFFER_SIZE      64
+#define CMB_POOL_SIZE       32          // preallocated buffers of RX_BUFFER_SIZE bytes
 
 typedef struct {    
     struct list_head    list;    
@@ -25,7 +26,7 @@ typedef struct {
     unsigned char*      tail;          
     unsigned char*      end;    
     unsigned char       len;    
-    
+    unsigned char       pool;           // 1 : buffer belongs to the cmb pool
 }cm_buff;
 
 
@@ -78,7 +78,11 @@ void i2c_venus_dump_msg(const struct i2c_msg* p_msg)
 
 
 #define IsReadMsg(x)        (x.flags & I2C_M_RD)
-#define IsSameTarget(x,y)   ((x.addr == y.addr) && !((x.flags ^ y.flags) & (~I2C_M_RD)))
+#define IsSameTarget(x,y)   ((x.addr == y.addr) && !((x.flags ^ y.flags) & ~(I2C_M_RD | I2C_M_NOSTART)))
+
+// the controller only issues a restart where the direction changes, so
+// a message in the same direction may only be merged if it has no start
+#define IsCombinable(x,y)   (IsSameTarget(x,y) && (((x.flags ^ y.flags) & I2C_M_RD) || (y.flags & I2C_M_NOSTART)))
 
 /*------------------------------------------------------------------
  * Func : i2c_venus_xfer
@@ -101,33 +105,28 @@ i2c_venus_xfer(
     venus_i2c* p_this = (venus_i2c*) dev_id;
 	int ret = 0;
 	int i;
+	int n;
 	    
-	for (i = 0; i < num; i++) 
+	for (i = 0; i < num; i += n) 
 	{			         
         ret = p_this->set_tar(p_this, msgs[i].addr, ADDR_MODE_7BITS);
         
         if (ret<0)
             goto err_occur;
         
-        if (IsReadMsg(msgs[i]))            
-        {       
-            // Single Read     
-            ret = p_this->read(p_this, NULL, 0, msgs[i].buf, msgs[i].len);
-        }                            
-        else
-        {             
-            if ((i < (num-1)) && IsReadMsg(msgs[i+1]) && IsSameTarget(msgs[i], msgs[i+1]))
-            {
-                // Random Read = Write + Read (same addr)                
-                ret = p_this->read(p_this, msgs[i].buf, msgs[i].len, msgs[i+1].buf, msgs[i+1].len);                        
-                i++;
-            }
-            else
-            {   
-                // Single Write
-                ret = p_this->write(p_this, msgs[i].buf, msgs[i].len, (i==(num-1)) ? WAIT_STOP : NON_STOP);
-            }            
+        // messages to the same target go out as one combined xfer
+        for (n = 1; (i+n) < num && n < I2C_MAX_XFER_SEGS && IsCombinable(msgs[i+n-1], msgs[i+n]); n++);
+        
+        if (n==1 && !IsReadMsg(msgs[i]))
+        {   
+            // Single Write
+            ret = p_this->write(p_this, msgs[i].buf, msgs[i].len, (i==(num-1)) ? WAIT_STOP : NON_STOP);
         }
+        else
+        {
+            // Read / Random Read / Combined Xfer
+            ret = p_this->combined_xfer(p_this, &msgs[i], n);
+        }            
         
         if (ret < 0)        
             goto err_occur;                          
@@ -186,193 +186,162 @@ void venus_i2c_bus_jam_recover_proc(venus_i2c* p_this);
 
 
 /*------------------------------------------------------------------
- * Func : venus_i2c_timer
+ * Func : venus_i2c_next_rx_seg
  *
- * Desc : timer of venus i2c - this timer is used to stop a blocked xfer
+ * Desc : find next read segment of the xfer
  *
- * Parm : arg : handle of venus i2c xfer complete
+ * Parm : p_xfer : xfer of venus i2c 
+ *        n      : segment to start from
  *         
- * Retn : 0 
+ * Retn : index of the segment, p_xfer->n_seg if there is no more 
  *------------------------------------------------------------------*/
-void venus_i2c_timer(unsigned long arg)
+static inline 
+unsigned char venus_i2c_next_rx_seg(venus_i2c_xfer* p_xfer, unsigned char n)
 {             
-    venus_i2c* p_this = (venus_i2c*) arg;
-    unsigned char i = p_this->id;
-    
-    i2c_print("i2c_%d : time out\n", i);
-    LOG_EVENT(EVENT_EXIT_TIMEOUT); 
-    SET_IC_INTR_MASK(i, 0);
-    SET_IC_ENABLE(i, 0);       
-    complete(&p_this->xfer.complete);  // wake up complete
+    while (n < p_xfer->n_seg && (!p_xfer->seg[n].read || !p_xfer->seg[n].len))
+        n++;
+        
+    return n;
 }
 
 
 
 /*------------------------------------------------------------------
- * Func : venus_i2c_msater_write
+ * Func : venus_i2c_next_tx_seg
  *
- * Desc : master write handler for venus i2c
+ * Desc : find next non empty segment of the xfer
  *
- * Parm : p_this : handle of venus i2c 
- *        event  : INT event of venus i2c
+ * Parm : p_xfer : xfer of venus i2c 
+ *        n      : segment to start from
  *         
- * Retn : N/A 
+ * Retn : index of the segment, p_xfer->n_seg if there is no more 
  *------------------------------------------------------------------*/
-void venus_i2c_msater_write(venus_i2c* p_this, unsigned int event, unsigned int tx_abort_source)
-{                                     
-#define TxComplete()              (p_this->xfer.tx_len >= p_this->xfer.tx_buff_len)            
-    
-    unsigned char i = p_this->id;
-    
-    while(!TxComplete() && NOT_TXFULL(i))
-    {
-        SET_IC_DATA_CMD(i, p_this->xfer.tx_buff[p_this->xfer.tx_len++]);
-    }
-    
-    if (TxComplete())		    
-    {
-        SET_IC_INTR_MASK(i, GET_IC_INTR_MASK(i) & ~TX_EMPTY_BIT);     
-    }
-    
-    if (event & TX_ABRT_BIT)
-    {        
-        p_this->xfer.ret = -ETXABORT;
-        p_this->xfer.tx_abort_source = tx_abort_source;
-    }        
-    else if (event & STOP_DET_BIT)
-    {
-        p_this->xfer.ret = TxComplete() ? p_this->xfer.tx_len : -ECMDSPLIT;	
-    }    
-    
-    if (p_this->xfer.ret)
-    {        
-        SET_IC_INTR_MASK(i, 0);
-        SET_IC_ENABLE(i, 0);                 
-        p_this->xfer.mode = I2C_IDEL;	// change to idle state        
-	    complete(&p_this->xfer.complete);
-    }          
+static inline 
+unsigned char venus_i2c_next_tx_seg(venus_i2c_xfer* p_xfer, unsigned char n)
+{             
+    while (n < p_xfer->n_seg && !p_xfer->seg[n].len)
+        n++;
         
-#undef TxComplete
+    return n;
 }
 
 
 
 /*------------------------------------------------------------------
- * Func : venus_i2c_msater_read
+ * Func : venus_i2c_rx_threshold
  *
- * Desc : master read handler for venus i2c
+ * Desc : get rx fifo threshold for the rest of the xfer, the threshold
+ *        is lowered for the last bytes so the rx full interrupt is 
+ *        still raised for them.
  *
  * Parm : p_this : handle of venus i2c 
  *         
- * Retn : N/A 
+ * Retn : value of IC_RX_TL
  *------------------------------------------------------------------*/
-void venus_i2c_msater_read(venus_i2c* p_this, unsigned int event, unsigned int tx_abort_source)
-{        
-#define TxComplete()        (p_this->xfer.tx_len >= p_this->xfer.rx_buff_len)          
-#define RxComplete()        (p_this->xfer.rx_len >= p_this->xfer.rx_buff_len)                
+static inline 
+unsigned int venus_i2c_rx_threshold(venus_i2c* p_this)
+{             
+    unsigned int tl   = p_this->rx_fifo_depth - FIFO_THRESHOLD;
+    unsigned int left = p_this->xfer.rx_total - p_this->xfer.rx_len;
     
-    unsigned char i = p_this->id;
+    if (left && left <= tl)
+        tl = left - 1;
         
-    // TX Thread          
-    while(!TxComplete() && NOT_TXFULL(i))
-    {
-        SET_IC_DATA_CMD(i, READ_CMD);  // send read command to rx fifo
-        p_this->xfer.tx_len++;
-    }
-            
-    // RX Thread         
-    while (!RxComplete() && NOT_RXEMPTY(i))      
-    {
-        p_this->xfer.rx_buff[p_this->xfer.rx_len++] = (unsigned char)(GET_IC_DATA_CMD(i) & 0xFF); 
-    }        
-    
-    if (TxComplete())
-    {
-        SET_IC_INTR_MASK(i, GET_IC_INTR_MASK(i) & ~TX_EMPTY_BIT);     
-    }
-         
-    if (event & TX_ABRT_BIT)
-    {                
-        p_this->xfer.ret = -ETXABORT;
-        p_this->xfer.tx_abort_source = tx_abort_source;
-    }                
-    else if ((event & STOP_DET_BIT) || RxComplete())
-    {
-        SET_IC_INTR_MASK(i, GET_IC_INTR_MASK(i) & ~RX_FULL_BIT);
-        
-        p_this->xfer.ret = RxComplete() ? p_this->xfer.rx_len : -ECMDSPLIT;	
-    }
-    
-    if (p_this->xfer.ret)
-    {        
-        SET_IC_INTR_MASK(i, 0);
-        SET_IC_ENABLE(i, 0);         
-        p_this->xfer.mode = I2C_IDEL;	// change to idle state        
-	    complete(&p_this->xfer.complete);
-    }
-    
-#undef TxComplete
-#undef RxComplete 
+    return tl;
 }
 
 
 
 /*------------------------------------------------------------------
- * Func : venus_i2c_msater_read
+ * Func : venus_i2c_master_xfer
  *
- * Desc : master read handler for venus i2c
+ * Desc : master xfer handler for venus i2c. The tx fifo is refilled 
+ *        with the data/read commands of all the segments and the rx
+ *        fifo is drained into the read segments on threshold interrupts,
+ *        the segments go out in a single transaction as long as the 
+ *        tx fifo never runs empty.
  *
  * Parm : p_this : handle of venus i2c 
+ *        event  : INT event of venus i2c
+ *        tx_abort_source : value of IC_TX_ABRT_SOURCE
  *         
  * Retn : N/A 
  *------------------------------------------------------------------*/
-void venus_i2c_msater_random_read(venus_i2c* p_this, unsigned int event, unsigned int tx_abort_source)
+void venus_i2c_master_xfer(venus_i2c* p_this, unsigned int event, unsigned int tx_abort_source)
 {    
+#define TxComplete()        (p_xfer->tx_seg >= p_xfer->n_seg)
+#define RxComplete()        (p_xfer->rx_seg >= p_xfer->n_seg)
     
-#define TxComplete()        (p_this->xfer.tx_len >= (p_this->xfer.rx_buff_len + p_this->xfer.tx_buff_len))    // it should add the same number of read command to tx fifo
-#define RxComplete()        (p_this->xfer.rx_len >=  p_this->xfer.rx_buff_len)            
-    
+    venus_i2c_xfer* p_xfer = &p_this->xfer;
+    venus_i2c_seg*  p_seg;
     unsigned char i = p_this->id;
         
     // TX Thread        
     while(!TxComplete() && NOT_TXFULL(i))
     {
-        if (p_this->xfer.tx_len < p_this->xfer.tx_buff_len)
-            SET_IC_DATA_CMD(i, p_this->xfer.tx_buff[p_this->xfer.tx_len]);
-        else
+        p_seg = &p_xfer->seg[p_xfer->tx_seg];
+        
+        if (p_seg->read)
             SET_IC_DATA_CMD(i, READ_CMD);  // send read command to rx fifo                        
+        else
+            SET_IC_DATA_CMD(i, p_seg->buf[p_xfer->tx_pos]);
             
-        p_this->xfer.tx_len++;
+        p_xfer->tx_len++;
+        
+        if (++p_xfer->tx_pos >= p_seg->len)
+        {
+            p_xfer->tx_seg = venus_i2c_next_tx_seg(p_xfer, p_xfer->tx_seg + 1);
+            p_xfer->tx_pos = 0;
+        }
     }
         
     // RX Thread
     while(!RxComplete() && NOT_RXEMPTY(i))        
     {
-        p_this->xfer.rx_buff[p_this->xfer.rx_len++] = (unsigned char)(GET_IC_DATA_CMD(i) & 0xFF); 
+        p_seg = &p_xfer->seg[p_xfer->rx_seg];
+        
+        p_seg->buf[p_xfer->rx_pos++] = (unsigned char)(GET_IC_DATA_CMD(i) & 0xFF); 
+        p_xfer->rx_len++;
+        
+        if (p_xfer->rx_pos >= p_seg->len)
+        {
+            p_xfer->rx_seg = venus_i2c_next_rx_seg(p_xfer, p_xfer->rx_seg + 1);
+            p_xfer->rx_pos = 0;
+        }
     }        
     
-    if TxComplete()
+    if (TxComplete())
     {
         SET_IC_INTR_MASK(i, GET_IC_INTR_MASK(i) & ~TX_EMPTY_BIT);     
     }        
+    
+    if (!RxComplete())
+    {
+        SET_IC_RX_TL(i, venus_i2c_rx_threshold(p_this));
+    }
 
     if (event & TX_ABRT_BIT)
     {        
-        p_this->xfer.ret = -ETXABORT;
-        p_this->xfer.tx_abort_source = tx_abort_source;
+        p_xfer->ret = -ETXABORT;
+        p_xfer->tx_abort_source = tx_abort_source;
     }           
-    else if ((event & STOP_DET_BIT) || RxComplete())
+    else if (TxComplete() && RxComplete() && 
+             ((event & STOP_DET_BIT) || p_xfer->seg[p_xfer->n_seg-1].read))
     {
-        SET_IC_INTR_MASK(i, GET_IC_INTR_MASK(i) & ~RX_FULL_BIT);  
-        p_this->xfer.ret = RxComplete() ? p_this->xfer.rx_len : -ECMDSPLIT;	
+        // all data have been received, don't have to wait for stop
+        p_xfer->ret = (p_xfer->rx_total) ? p_xfer->rx_len : p_xfer->tx_len;
     }    
+    else if (event & STOP_DET_BIT)
+    {
+        p_xfer->ret = -ECMDSPLIT;
+    }
 
-    if (p_this->xfer.ret)
+    if (p_xfer->ret)
     {        
         SET_IC_INTR_MASK(i, 0);
         SET_IC_ENABLE(i, 0);         
-        p_this->xfer.mode = I2C_IDEL;	// change to idle state        
-	    complete(&p_this->xfer.complete);
+        p_xfer->mode = I2C_IDEL;	// change to idle state        
+	    complete(&p_xfer->complete);
     }          
     
 #undef TxComplete
@@ -422,15 +391,10 @@ venus_i2c_isr(
     switch (p_this->xfer.mode)
     {
     case I2C_MASTER_WRITE:
-        venus_i2c_msater_write(p_this, event, tx_abrt_source);
-        break;
-        
     case I2C_MASTER_READ:       
-        venus_i2c_msater_read(p_this, event, tx_abrt_source);       
-        break;
-    
     case I2C_MASTER_RANDOM_READ:
-        venus_i2c_msater_random_read(p_this, event, tx_abrt_source);
+    case I2C_MASTER_COMBINED:
+        venus_i2c_master_xfer(p_this, event, tx_abrt_source);
         break;        
 
     default:
@@ -438,8 +402,6 @@ venus_i2c_isr(
         SET_IC_ENABLE(i, 0);                 
         
     }    
-              
-    mod_timer(&p_this->xfer.timer, jiffies + I2C_TIMEOUT_INTERVAL);        
         
     SET_MIS_ISR(I2C_INT[i]);   // clear I2C Interrupt Flag
     UNLOCK_VENUS_I2C(&p_this->lock, flags);
@@ -1103,21 +1065,21 @@ int venus_i2c_start_xfer(venus_i2c* p_this)
     unsigned char i = p_this->id;    
     unsigned long flags;
     int ret;
-    int mode = p_this->xfer.mode;
 
     LOG_EVENT(EVENT_START_XFER);
     
     LOCK_VENUS_I2C(&p_this->lock, flags);
             
-    switch (p_this->xfer.mode)
+    if (p_this->xfer.mode == I2C_IDEL || !p_this->xfer.tx_total)
     {
-    case I2C_MASTER_WRITE:  
-        SET_IC_INTR_MASK(i, TX_EMPTY_BIT | TX_ABRT_BIT | STOP_DET_BIT);
-        break;
-        
-    case I2C_MASTER_READ:    
-    case I2C_MASTER_RANDOM_READ:   
+        p_this->xfer.mode = I2C_IDEL;
+        UNLOCK_VENUS_I2C(&p_this->lock, flags);       
+        LOG_EVENT(EVENT_STOP_XFER);        
+        return -EILLEGALMSG;
+    }                
     
+    if (p_this->xfer.rx_total)
+    {
         if (GET_IC_RXFLR(i)) 
         {
             printk("WARNING, RX FIFO NOT EMPRY\n");
@@ -1125,41 +1087,27 @@ int venus_i2c_start_xfer(venus_i2c* p_this)
                  GET_IC_DATA_CMD(i);            
         }
     
+        SET_IC_RX_TL(i, venus_i2c_rx_threshold(p_this));
         SET_IC_INTR_MASK(i, RX_FULL_BIT | TX_EMPTY_BIT | TX_ABRT_BIT | STOP_DET_BIT);    
-        break;
-            
-    default:
-        UNLOCK_VENUS_I2C(&p_this->lock, flags);       
-        LOG_EVENT(EVENT_STOP_XFER);        
-        return -EILLEGALMSG;
-    }                
-
-#ifdef MINIMUM_DELAY_EN
-
-    UNLOCK_VENUS_I2C(&p_this->lock, flags);
-    
-    if (jiffies <= p_this->time_stamp)
-        udelay(1000);
-
-    LOCK_VENUS_I2C(&p_this->lock, flags);
-    
-#endif 
-                        
-    p_this->xfer.timer.expires  = jiffies + I2C_TIMEOUT_INTERVAL;    
-    add_timer(&p_this->xfer.timer);
+    }
+    else
+        SET_IC_INTR_MASK(i, TX_EMPTY_BIT | TX_ABRT_BIT | STOP_DET_BIT);
                                     
-    SET_IC_ENABLE(i, 1);                   // Start Xfer
+    SET_IC_ENABLE(i, 1);                   // Start Xfer, the rest is done by isr
     
     UNLOCK_VENUS_I2C(&p_this->lock, flags);       
     
-    wait_for_completion(&p_this->xfer.complete);
+    wait_for_completion_timeout(&p_this->xfer.complete, I2C_TIMEOUT_INTERVAL);
     
     LOCK_VENUS_I2C(&p_this->lock, flags);  
     
-    del_timer(&p_this->xfer.timer);
-    
     if (p_this->xfer.mode != I2C_IDEL)
     {
+        i2c_print("i2c_%d : time out\n", i);
+        LOG_EVENT(EVENT_EXIT_TIMEOUT); 
+        SET_IC_INTR_MASK(i, 0);
+        SET_IC_ENABLE(i, 0);       
+        p_this->xfer.mode = I2C_IDEL;
         p_this->xfer.ret  = -ETIMEOUT;
         
 #ifdef CONFIG_I2C_VENUS_BUS_JAM_RECOVER
@@ -1171,7 +1119,6 @@ int venus_i2c_start_xfer(venus_i2c* p_this)
         {
             printk("WARNING, I2C Bus Jammed, Do Recorver\n");        
             venus_i2c_bus_jam_recover_proc(p_this);
-            msleep(50);
         }
 
         LOCK_VENUS_I2C(&p_this->lock, flags);  
@@ -1179,39 +1126,16 @@ int venus_i2c_start_xfer(venus_i2c* p_this)
     }
     else if (p_this->xfer.ret==-ECMDSPLIT)
     {
-        switch(mode)
-        {
-        case I2C_MASTER_WRITE:          
-            printk("WARNING, Write Cmd Split, tx : %d/%d\n", 
-                    p_this->xfer.tx_len, p_this->xfer.tx_buff_len);                     
-            break;
-        
-        case I2C_MASTER_READ:                
-            printk("WARNING, Read Cmd Split, tx : %d/%d rx : %d/%d\n", 
-                    p_this->xfer.tx_len, p_this->xfer.tx_buff_len,
-                    p_this->xfer.rx_len, p_this->xfer.rx_buff_len);
-            break;                    
-            
-        case I2C_MASTER_RANDOM_READ:              
-            printk("WARNING, Read Cmd Split, tx : %d/%d rx : %d/%d\n", 
-                    p_this->xfer.tx_len, p_this->xfer.tx_buff_len + p_this->xfer.rx_buff_len,
-                    p_this->xfer.rx_len, p_this->xfer.rx_buff_len);
-            break;                                        
-        }        
+        printk("WARNING, Cmd Split, seg : %d/%d tx : %d/%d rx : %d/%d\n", 
+                p_this->xfer.tx_seg, p_this->xfer.n_seg,
+                p_this->xfer.tx_len, p_this->xfer.tx_total,
+                p_this->xfer.rx_len, p_this->xfer.rx_total);
     }
 
-#ifdef MINIMUM_DELAY_EN            
-    p_this->time_stamp = (unsigned long) jiffies;
-#endif    
-
     ret = p_this->xfer.ret;
     
     UNLOCK_VENUS_I2C(&p_this->lock, flags);       
 
-#ifndef MINIMUM_DELAY_EN
-    udelay(1200);
-#endif
-
     if (ret==-ECMDSPLIT)
     {
         if (venus_i2c_probe(p_this)<0)
@@ -1256,6 +1180,9 @@ int venus_i2c_start_gpio_xfer(
     int j;
     int d = p_this->tick / 2;      
     unsigned char data;        
+    unsigned char* tx_buf  = p_this->xfer.seg[0].buf;
+    unsigned short tx_len  = p_this->xfer.seg[0].len;
+    unsigned long  timeout = jiffies + 2 * HZ;
     
     if (p_this->xfer.mode != I2C_MASTER_WRITE) 
     {
@@ -1264,7 +1191,6 @@ int venus_i2c_start_gpio_xfer(
     } 
     
     p_this->xfer.ret = 0;
-    p_this->xfer.timer.expires  = jiffies + 2 * HZ;
              
     wr_reg(MIS_GPDIR, rd_reg(MIS_GPDIR) & ~SDA_SCL_MASK);                     // Dir = Input
     wr_reg(MIS_GPIE,  rd_reg(MIS_GPIE)  & ~SDA_SCL_MASK);                     // Interrupt Disable
@@ -1274,7 +1200,7 @@ int venus_i2c_start_gpio_xfer(
     //---- wait for bus free
     while((rd_reg(MIS_GPDATI)& SDA_SCL_MASK)!=SDA_SCL_MASK)
     {
-        if (jiffies > p_this->xfer.timer.expires)
+        if (time_after(jiffies, timeout))
         {
             p_this->xfer.ret = -ETIMEOUT;                
             goto stop_xfer;
@@ -1287,9 +1213,9 @@ int venus_i2c_start_gpio_xfer(
     udelay(d);
             
     // Send data
-    for (i=-1; i<p_this->xfer.tx_buff_len && !p_this->xfer.ret; i++)
+    for (i=-1; i<tx_len && !p_this->xfer.ret; i++)
     {                       
-        data = (i<0) ? (p_this->tar <<1) : p_this->xfer.tx_buff[i];   
+        data = (i<0) ? (p_this->tar <<1) : tx_buf[i];   
                      
         // Send Data Bits
         for (j=7; j>=0; j--)
@@ -1346,10 +1272,7 @@ stop_xfer:
     wr_reg(MIS_GPDIR, rd_reg(MIS_GP0DIR) & ~SDA_SCL_MASK);           // Dir = Input    
     
     venus_i2c_gpio_selection(p_this, I2C_MODE);
-    
-#ifndef MINIMUM_DELAY_EN
-    p_this->time_stamp = jiffies-1; // non stop
-#endif        
+    p_this->xfer.mode = I2C_IDEL;
 
     return p_this->xfer.ret;
 }
@@ -1400,19 +1323,83 @@ int venus_i2c_load_message(
     
     memset(&p_this->xfer, 0, sizeof(p_this->xfer));        
         
-    p_this->xfer.mode           = mode;
-    p_this->xfer.tx_buff        = tx_buf;
-    p_this->xfer.tx_buff_len    = tx_buf_len;
-    p_this->xfer.rx_buff        = rx_buf;
-    p_this->xfer.rx_buff_len    = rx_buf_len;
-    
-    //reset timer
-    init_timer(&p_this->xfer.timer);    
-    p_this->xfer.timer.data     = (unsigned long) p_this;
-    p_this->xfer.timer.expires  = jiffies + 4 * HZ;
-    p_this->xfer.timer.function = venus_i2c_timer; 
-    
-    //reset timer
+    p_this->xfer.mode = mode;
+    
+    if (tx_buf_len)
+    {
+        p_this->xfer.seg[p_this->xfer.n_seg].buf  = tx_buf;
+        p_this->xfer.seg[p_this->xfer.n_seg].len  = tx_buf_len;
+        p_this->xfer.seg[p_this->xfer.n_seg].read = 0;
+        p_this->xfer.n_seg++;
+    }
+    
+    if (rx_buf_len)
+    {
+        p_this->xfer.seg[p_this->xfer.n_seg].buf  = rx_buf;
+        p_this->xfer.seg[p_this->xfer.n_seg].len  = rx_buf_len;
+        p_this->xfer.seg[p_this->xfer.n_seg].read = 1;
+        p_this->xfer.n_seg++;
+    }
+    
+    p_this->xfer.tx_total = tx_buf_len + rx_buf_len;   // read commands count
+    p_this->xfer.rx_total = rx_buf_len;
+    p_this->xfer.rx_seg   = venus_i2c_next_rx_seg(&p_this->xfer, 0);
+    
+    init_completion(&p_this->xfer.complete);
+    
+    UNLOCK_VENUS_I2C(&p_this->lock, flags);     
+    
+    return 0;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : venus_i2c_load_segments
+ *
+ * Desc : load i2c messages of the same target as a combined xfer, 
+ *        they will be sent in a single transaction (repeated start)
+ *
+ * Parm : p_this : handle of venus i2c 
+ *        msgs   : i2c messages
+ *        num    : number of messages
+ *         
+ * Retn : 0 for success, others is failed
+ *------------------------------------------------------------------*/    
+int venus_i2c_load_segments(
+    venus_i2c*              p_this,
+    struct i2c_msg*         msgs,
+    int                     num
+    )
+{           
+    unsigned long flags;
+    int n;
+    
+    if (num <= 0 || num > I2C_MAX_XFER_SEGS)
+        return -EILLEGALMSG;
+    
+    LOCK_VENUS_I2C(&p_this->lock, flags);     
+    
+    memset(&p_this->xfer, 0, sizeof(p_this->xfer));        
+        
+    p_this->xfer.mode  = I2C_MASTER_COMBINED;
+    p_this->xfer.n_seg = num;
+    
+    for (n=0; n<num; n++)
+    {
+        p_this->xfer.seg[n].buf  = msgs[n].buf;
+        p_this->xfer.seg[n].len  = msgs[n].len;
+        p_this->xfer.seg[n].read = (msgs[n].flags & I2C_M_RD) ? 1 : 0;
+        
+        p_this->xfer.tx_total += msgs[n].len;
+        
+        if (msgs[n].flags & I2C_M_RD)
+            p_this->xfer.rx_total += msgs[n].len;
+    }
+    
+    p_this->xfer.tx_seg = venus_i2c_next_tx_seg(&p_this->xfer, 0);
+    p_this->xfer.rx_seg = venus_i2c_next_rx_seg(&p_this->xfer, 0);
+    
     init_completion(&p_this->xfer.complete);
     
     UNLOCK_VENUS_I2C(&p_this->lock, flags);     
@@ -1447,6 +1434,33 @@ int venus_i2c_read(
 
 
 
+/*------------------------------------------------------------------
+ * Func : venus_i2c_combined_xfer
+ *
+ * Desc : do a combined xfer, all messages should have the same target
+ *
+ * Parm : p_this : handle of venus i2c 
+ *        msgs   : i2c messages
+ *        num    : number of messages (up to I2C_MAX_XFER_SEGS)
+ *         
+ * Retn : >=0 for success, others is failed
+ *------------------------------------------------------------------*/
+int venus_i2c_combined_xfer(
+    venus_i2c*              p_this, 
+    struct i2c_msg*         msgs, 
+    int                     num
+    )
+{
+    int ret = venus_i2c_load_segments(p_this, msgs, num);
+    
+    if (ret < 0)
+        return ret;
+    
+    return venus_i2c_start_xfer(p_this);
+}    
+
+
+
 /*------------------------------------------------------------------
  * Func : venus_i2c_write
  *
@@ -1526,6 +1540,7 @@ create_venus_i2c_handle(
         hHandle->set_tar      = venus_i2c_set_tar;
         hHandle->read         = venus_i2c_read;
         hHandle->write        = venus_i2c_write;        
+        hHandle->combined_xfer = venus_i2c_combined_xfer;
         hHandle->dump         = venus_i2c_dump;      
         hHandle->suspend      = venus_i2c_suspend;        
         hHandle->resume       = venus_i2c_resume;  
@@ -15,9 +15,9 @@
 
 #define VERSION                "2.0a"
 
-#define MINIMUM_DELAY_EN    
 #define SPIN_LOCK_PROTECT_EN
 #define FIFO_THRESHOLD         4
+#define I2C_MAX_XFER_SEGS      8      // max messages of a combined xfer
 //#define I2C_PROFILEING_EN         
 //#define I2C_TIMEOUT_INTERVAL   20    // (unit : jiffies = 10ms)
 #define I2C_TIMEOUT_INTERVAL   100    // (unit : jiffies = 10ms)
@@ -59,6 +59,13 @@ enum {
 };
 
     
+typedef struct {
+    unsigned char*      buf;
+    unsigned short      len;
+    unsigned char       read;       // 1 : read segment, 0 : write segment
+}venus_i2c_seg;
+
+
 typedef struct {    
     unsigned char       mode;
         
@@ -66,20 +73,27 @@ typedef struct {
     #define I2C_MASTER_READ        1
     #define I2C_MASTER_WRITE       2
     #define I2C_MASTER_RANDOM_READ 3
+    #define I2C_MASTER_COMBINED    4
     
     unsigned char       flags;
+    
+    // segments of the xfer, they are sent back to back in a single 
+    // transaction, a restart is issued where the direction changes
+    venus_i2c_seg       seg[I2C_MAX_XFER_SEGS];
+    unsigned char       n_seg;
+    
+    unsigned char       tx_seg;     // segment being loaded to tx fifo
+    unsigned short      tx_pos;
+    unsigned char       rx_seg;     // segment being drained from rx fifo
+    unsigned short      rx_pos;
                               
-    unsigned char*      tx_buff;
-    unsigned short      tx_buff_len;
-    unsigned short      tx_len;        
-    unsigned char*      rx_buff;
-    unsigned short      rx_buff_len;
-    unsigned short      rx_len;           
-    unsigned long       timeout;            
+    unsigned int        tx_len;     // number of commands loaded to tx fifo
+    unsigned int        tx_total;   
+    unsigned int        rx_len;     // number of bytes read from rx fifo
+    unsigned int        rx_total;
     int                 ret;        // 0 : on going, >0 : success, <0 : err                        
     unsigned int        tx_abort_source;
     struct completion   complete;
-    struct timer_list   timer;        
     
 }venus_i2c_xfer;
     
@@ -112,8 +126,6 @@ struct venus_i2c_t
     unsigned char       rx_fifo_depth;
     unsigned char       tx_fifo_depth;
     
-    unsigned long       time_stamp;
-    
     venus_i2c_xfer      xfer;
     
     spinlock_t          lock;
@@ -124,6 +136,7 @@ struct venus_i2c_t
     int (*set_tar)      (venus_i2c* p_this, unsigned short, ADDR_MODE mode);    
     int (*read)         (venus_i2c* p_this, unsigned char* tx_buf, unsigned short tx_buf_len, unsigned char *rx_buff, unsigned short rx_buf_len);
     int (*write)        (venus_i2c* p_this, unsigned char* tx_buf, unsigned short tx_buf_len, unsigned char wait_stop);    
+    int (*combined_xfer)(venus_i2c* p_this, struct i2c_msg* msgs, int num);
     int (*dump)         (venus_i2c* p_this);        // for debug
     int (*suspend)      (venus_i2c* p_this);
     int (*resume)       (venus_i2c* p_this);
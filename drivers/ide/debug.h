@@ -11,6 +11,8 @@
 #ifdef VENUS_DMA_BUFFER
 #define	VENUS_MAX_SG_SEGMENT            	31
 #define	VENUS_DMA_BUF_LEN               	(32*PAGE_SIZE)
+// Physically contiguous runs at least this long are DMAed in place
+#define	VENUS_DMA_DIRECT_RUN            	(4*PAGE_SIZE)
 #endif
 //***************************
 
@@ -349,14 +349,21 @@ ide_startstop_t venus_dma_intr (ide_drive_t *drive)
     if (OK_STAT(stat,DRIVE_READY,drive->bad_wstat|DRQ_STAT)) {
         if (!dma_stat) {
             struct request *rq = HWGROUP(drive)->rq;
+            struct venus_state *state = HWIF(drive)->hwif_data;
+            int nsect = state->dma_sectors ? state->dma_sectors : rq->nr_sectors;
+
+            /*
+             * After a direct run the rest of the request stays queued
+             * and is restarted from the next sector.
+             */
             if (rq->rq_disk) {
 
                 ide_driver_t *drv;
                 drv = *(ide_driver_t **)rq->rq_disk->private_data;;
 
-                drv->end_request(drive, 1, rq->nr_sectors);
+                drv->end_request(drive, 1, nsect);
             } else
-                ide_end_request(drive, 1, rq->nr_sectors);
+                ide_end_request(drive, 1, nsect);
 
             return ide_stopped;
         }
@@ -397,6 +404,67 @@ static void venus_copy_sg_to_dma_buffer(ide_hwif_t *hwif)
     }
 }
 
+/*
+ * Length of the physically contiguous run at the head of the sg list,
+ * capped to what one DMA transfer may carry.
+ */
+static unsigned int venus_sg_run(struct scatterlist *sg, int n_sg, int *run_nents)
+{
+    dma_addr_t start = page_to_phys(sg->page) + sg->offset;
+    unsigned int length = sg->length;
+    int i;
+
+    for (i= 1; i< n_sg; i++){
+        if (page_to_phys(sg[i].page) + sg[i].offset != start + length)
+            break;
+        if (length + sg[i].length > VENUS_DMA_BUF_LEN)
+            break;
+        length+= sg[i].length;
+    }
+    *run_nents = i;
+    return length;
+}
+
+/*
+ * The controller has one address/length pair, so a scattered disk request
+ * is bounced through p_virt_single_buf. When it starts with a long enough
+ * physically contiguous run, DMA that run in place instead: shrink the
+ * sector count already in the taskfile to the run and let venus_dma_intr()
+ * complete just those sectors. The block layer then restarts the rest of
+ * the request, which goes through here again. Packet commands cannot be
+ * cut short like this, so ATAPI keeps using the bounce buffer.
+ */
+static int venus_map_direct_run(ide_drive_t *drive, struct request *rq,
+                                dma_addr_t *dma_addr, unsigned int *dma_len)
+{
+    ide_hwif_t *hwif = drive->hwif;
+    struct venus_state *state = hwif->hwif_data;
+    struct scatterlist *sg = hwif->sg_table;
+    unsigned int length, nsect;
+    int run_nents;
+
+    if (drive->media != ide_disk || !blk_fs_request(rq))
+        return 0;
+
+    length = venus_sg_run(sg, hwif->sg_nents, &run_nents);
+    if (length < VENUS_DMA_DIRECT_RUN || (length & (SECTOR_SIZE - 1)))
+        return 0;
+
+    nsect = length / SECTOR_SIZE;
+    if (nsect < rq->nr_sectors){
+        /* same choice of command as __ide_do_rw_disk() */
+        if (drive->addressing == 1 && !hwif->no_lba48_dma)
+            hwif->OUTB(nsect >> 8, IDE_NSECTOR_REG);
+        hwif->OUTB(nsect, IDE_NSECTOR_REG);
+        state->dma_sectors = nsect;
+    }
+
+    hwif->sg_nents = dma_map_sg(state->dev, sg, run_nents, hwif->sg_dma_direction);
+    *dma_addr = sg_dma_address(sg);
+    *dma_len = length;
+    return 1;
+}
+
 #endif
 
 /*
@@ -418,6 +486,7 @@ static void venus_build_sglist(ide_drive_t *drive, dma_addr_t *dma_addr, unsigne
     u32 *table = state->wrap_dmatable;  //@ for NEPTUNE
 
     ide_map_sg(drive, rq);
+    state->dma_sectors = 0;
 
     ideinfo("venus_build_sglist = %i\n", hwif->sg_nents);
 
@@ -448,6 +517,9 @@ static void venus_build_sglist(ide_drive_t *drive, dma_addr_t *dma_addr, unsigne
     }
 
 #ifdef VENUS_DMA_BUFFER
+    if (venus_map_direct_run(drive, rq, dma_addr, dma_len))
+        return;
+
     if (DMA_TO_DEVICE== hwif->sg_dma_direction){
         venus_copy_sg_to_dma_buffer(hwif);
     }else{
@@ -659,6 +731,11 @@ static void venus_release_buffer(ide_hwif_t *hwif)
     }
 
 #ifdef VENUS_DMA_BUFFER
+    if (state->dma_buffer_length== 0){
+        /* direct run, see venus_map_direct_run() */
+        dma_unmap_sg(state->dev, hwif->sg_table, sg_nents, sg_dma_direction);
+        return;
+    }
 
     dma_unmap_single(state->dev, state->p_bus_addr_single_buf, state->dma_buffer_length, sg_dma_direction);
 
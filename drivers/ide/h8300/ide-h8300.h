@@ -51,6 +51,7 @@ struct venus_state {
 	u8 *p_virt_single_buf;			// Virtual memory address
 	dma_addr_t p_bus_addr_single_buf;	// Physical memory address
 	unsigned int	 dma_buffer_length;		// DMA buffer length
+	unsigned int	 dma_sectors;			// sectors of a direct run, 0: whole request
 	
 	// variable for content protection controller
 	u8 cp[2];				// requst for content protection
@@ -30,6 +30,7 @@
 #include <linux/poll.h>
 #include <linux/ioctl.h>
 #include <linux/wait.h>
+#include <linux/pipe_fs_i.h>
 #include <asm/uaccess.h>
 #include <asm/system.h>
 
@@ -92,8 +93,19 @@ static inline int dvb_dmxdev_buffer_write(struct dmxdev_buffer *buf, const u8 *s
 	return len;
 }
 
-static ssize_t dvb_dmxdev_buffer_read(struct dmxdev_buffer *src,
-		int non_blocking, char __user *buf, size_t count, loff_t *ppos)
+static inline int dvb_dmxdev_buffer_copy(char *dst, const u8 *src,
+		int len, int to_user)
+{
+	if (!to_user) {
+		memcpy(dst, src, len);
+		return 0;
+	}
+	return copy_to_user((char __user *)dst, src, len) ? -EFAULT : 0;
+}
+
+/* Drain the ring buffer either to user space or into a kernel buffer */
+static ssize_t __dvb_dmxdev_buffer_read(struct dmxdev_buffer *src,
+		int non_blocking, char *buf, size_t count, int to_user)
 {
 	unsigned long todo=count;
 	int split, avail, error;
@@ -134,15 +146,17 @@ static ssize_t dvb_dmxdev_buffer_read(struct dmxdev_buffer *src,
 		if (avail>todo)
 			avail=todo;
 		if (split<avail) {
-			if (copy_to_user(buf, src->data+src->pread, split))
-				  return -EFAULT;
+			if (dvb_dmxdev_buffer_copy(buf, src->data+src->pread,
+						   split, to_user))
+				return -EFAULT;
 			buf+=split;
 			src->pread=0;
 			todo-=split;
 			avail-=split;
 		}
 		if (avail) {
-			if (copy_to_user(buf, src->data+src->pread, avail))
+			if (dvb_dmxdev_buffer_copy(buf, src->data+src->pread,
+						   avail, to_user))
 				return -EFAULT;
 			src->pread = (src->pread + avail) % src->size;
 			todo-=avail;
@@ -152,6 +166,13 @@ static ssize_t dvb_dmxdev_buffer_read(struct dmxdev_buffer *src,
 	return count;
 }
 
+static ssize_t dvb_dmxdev_buffer_read(struct dmxdev_buffer *src,
+		int non_blocking, char __user *buf, size_t count, loff_t *ppos)
+{
+	return __dvb_dmxdev_buffer_read(src, non_blocking, (char __force *)buf,
+					count, 1);
+}
+
 static struct dmx_frontend * get_fe(struct dmx_demux *demux, int type)
 {
 	struct list_head *head, *pos;
@@ -282,6 +303,71 @@ static ssize_t dvb_dvr_read(struct file *file, char __user *buf, size_t count,
 	return ret;
 }
 
+/*
+ * Recording a transport stream to disk: the DVR ring buffer is drained
+ * straight into freshly allocated pages which are handed to the pipe,
+ * so splicing the pipe on to a file never bounces through user space.
+ * Only the first page may block; after that we return what was ready.
+ */
+static ssize_t dvb_dvr_splice_read(struct file *file, loff_t *ppos,
+		struct inode *pipe, size_t len, unsigned int flags)
+{
+	struct dvb_device *dvbdev = file->private_data;
+	struct dmxdev *dmxdev = dvbdev->priv;
+	struct dmxdev_buffer *src = &dmxdev->dvr_buffer;
+	struct partial_page partial[PIPE_BUFFERS];
+	struct page *pages[PIPE_BUFFERS];
+	struct splice_pipe_desc spd = {
+		.pages = pages,
+		.partial = partial,
+		.flags = flags,
+		.ops = &page_pipe_buf_ops,
+	};
+	int non_blocking, room;
+	ssize_t ret = -ENOMEM;
+
+	non_blocking = (file->f_flags & O_NONBLOCK) ||
+		       (flags & SPLICE_F_NONBLOCK);
+
+	room = splice_pipe_room(pipe);
+	if (room <= 0)
+		room = 1;
+
+	while (len && spd.nr_pages < room) {
+		struct page *page;
+		size_t chunk = min_t(size_t, len, PAGE_SIZE);
+
+		/* leave a pending overflow to be reported on the next call */
+		if (spd.nr_pages && src->error)
+			break;
+
+		page = alloc_page(GFP_KERNEL);
+		if (!page)
+			break;
+
+		ret = __dvb_dmxdev_buffer_read(src, non_blocking || spd.nr_pages,
+					       page_address(page), chunk, 0);
+		if (ret <= 0) {
+			__free_page(page);
+			break;
+		}
+
+		pages[spd.nr_pages] = page;
+		partial[spd.nr_pages].offset = 0;
+		partial[spd.nr_pages].len = ret;
+		spd.nr_pages++;
+		len -= ret;
+
+		if (ret < chunk)
+			break;
+	}
+
+	if (!spd.nr_pages)
+		return ret;
+
+	return splice_to_pipe(pipe, &spd);
+}
+
 static inline void dvb_dmxdev_filter_state_set(struct dmxdev_filter *dmxdevfilter, int state)
 {
 	spin_lock_irq(&dmxdevfilter->dev->lock);
@@ -1069,6 +1155,7 @@ static struct file_operations dvb_dvr_fops = {
 	.owner		= THIS_MODULE,
 	.read		= dvb_dvr_read,
 	.write		= dvb_dvr_write,
+	.splice_read	= dvb_dvr_splice_read,
 	.ioctl		= dvb_dvr_ioctl,
 	.open		= dvb_dvr_open,
 	.release	= dvb_dvr_release,
@@ -26,6 +26,7 @@
 #include <linux/delay.h>
 #include <linux/time.h>
 #include <linux/proc_fs.h>
+#include <linux/async.h>
 #include <linux/string.h>
 #include <asm/mach-venus/platform.h>
 //CMYu, 20090720, for CP
@@ -855,25 +856,14 @@ static void display_version (void)
 }
 
 
-static int __init rtk_nand_init (void)
+/*
+ * Scanning the bad block table reads the spare area of every block, which
+ * takes a good part of a second on large parts, so it runs asynchronously
+ * and the kernel waits for it only before mounting the root filesystem.
+ */
+static void __init rtk_nand_probe (void *data, async_cookie_t cookie)
 {
-	if ( is_venus_cpu() || is_neptune_cpu() )
-		return -1;
-
-	if ( rtk_readl(0xb800000c) & 0x00800000 ){
-		display_version();
-	}else{ 
-		printk(KERN_ERR "Nand Flash Clock is NOT Open. Installing fails.\n");
-		return -1;	
-	}
-
-	rtk_writel( 0x103, 0xb800036c );
-	
-	rtk_writel(rtk_readl(0xb800000c)& (~0x00800000), 0xb800000c);
-	rtk_writel( 0x02, 0xb8000034 );
-	rtk_writel(rtk_readl(0xb800000c)| (0x00800000), 0xb800000c);
-
-	struct nand_chip *this;
+	struct nand_chip *this = NULL;
 	int rc = 0;
 	
 	rtk_mtd = kmalloc (MTDSIZE, GFP_KERNEL);
@@ -935,12 +925,36 @@ EXIT:
 				free_pages((unsigned long)this->erase_page_flag, mempage_order);
 			}
 			kfree(rtk_mtd);
+			rtk_mtd = NULL;
 		}
 		remove_proc_entry("nandinfo", NULL);
+		printk(KERN_ERR "Realtek Nand Flash Driver installing fails (%d).\n", rc);
 	}else
 		printk(KERN_INFO "Realtek Nand Flash Driver is successfully installing.\n");
+}
+
+
+static int __init rtk_nand_init (void)
+{
+	if ( is_venus_cpu() || is_neptune_cpu() )
+		return -1;
+
+	if ( rtk_readl(0xb800000c) & 0x00800000 ){
+		display_version();
+	}else{ 
+		printk(KERN_ERR "Nand Flash Clock is NOT Open. Installing fails.\n");
+		return -1;	
+	}
+
+	rtk_writel( 0x103, 0xb800036c );
 	
-	return rc;
+	rtk_writel(rtk_readl(0xb800000c)& (~0x00800000), 0xb800000c);
+	rtk_writel( 0x02, 0xb8000034 );
+	rtk_writel(rtk_readl(0xb800000c)| (0x00800000), 0xb800000c);
+
+	async_schedule(rtk_nand_probe, NULL);
+
+	return 0;
 }
 
 
@@ -441,6 +441,7 @@ struct cp_private {
 	struct cp_desc		*rx_ring;
 	struct ring_info	rx_skb[CP_RX_RING_SIZE];
 	unsigned		rx_buf_sz;
+	struct sk_buff_pool	*rx_pool;	/* recycled rx buffers */
 
 	
 
@@ -819,7 +820,7 @@ rx_status_loop:
 			printk(KERN_DEBUG "%s: rx slot %d status 0x%x len %d\n",
 			       cp->dev->name, rx_tail, status, len);
 		buflen = cp->rx_buf_sz + RX_OFFSET;
-		new_skb = dev_alloc_skb (buflen);
+		new_skb = skb_pool_alloc(cp->rx_pool, buflen, GFP_ATOMIC);
 		if (!new_skb) {
 		        
 			cp->net_stats.rx_dropped++;     //see re8670.c to check
@@ -1426,7 +1427,8 @@ static int cp_refill_rx (struct cp_private *cp)
 	for (i = 0; i < CP_RX_RING_SIZE; i++) {
 		struct sk_buff *skb;
                 
-		skb = dev_alloc_skb(cp->rx_buf_sz + RX_OFFSET);
+		skb = skb_pool_alloc(cp->rx_pool, cp->rx_buf_sz + RX_OFFSET,
+				     GFP_ATOMIC);
 		
 		if (!skb)
 		{//       printk("refill e1\n");//cy test
@@ -1571,9 +1573,13 @@ static int cp_open (struct net_device *dev)
 	if (netif_msg_ifup(cp))
 		printk(KERN_DEBUG "%s: enabling interface\n", dev->name);
 
+	/* keep one ring's worth of received buffers for reuse */
+	cp->rx_pool = skb_pool_create(dev, cp->rx_buf_sz + RX_OFFSET,
+				      CP_RX_RING_SIZE);
+
 	rc = cp_alloc_rings(cp);
 	if (rc)
-		return rc;
+		goto err_out_pool;
 	rc = cp_init_hw(cp);
 	if (rc)
 		goto err_out_rings;
@@ -1603,6 +1609,9 @@ err_out_hw:
 	cp_stop_hw(cp);
 err_out_rings:	
 	cp_free_rings(cp);
+err_out_pool:
+	skb_pool_destroy(cp->rx_pool);
+	cp->rx_pool = NULL;
 	return rc;
 }
 static int cp_close (struct net_device *dev)
@@ -1644,6 +1653,8 @@ static int cp_close (struct net_device *dev)
 	free_irq(dev->irq, dev);
 
 	cp_free_rings(cp);
+	skb_pool_destroy(cp->rx_pool);
+	cp->rx_pool = NULL;
 
 	cp_status =CP_OFF;
 	return 0;
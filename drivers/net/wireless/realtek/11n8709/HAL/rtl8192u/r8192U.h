@@ -924,6 +924,13 @@ typedef struct rx_drvinfo_819x_usb{
 #endif
 #ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
 #define TX_PACKET_DRVAGGR_SUBFRAME_SHIFT_BYTES (sizeof(tx_desc_819x_usb_aggr_subframe) + sizeof(tx_fwinfo_819x_usb))
+// Aggregation buffers are pooled for nr MTU-sized data frames, each padded
+// to 256 bytes and led by a subframe descriptor; tx headroom comes on top.
+// Bigger aggregates are allocated outside the pool. */
+#define DRVAGGR_FRAME_SIZE		(MAX_802_11_HEADER_LENGTH + 8 + ETH_DATA_LEN + \
+					 ENCRYPTION_MAX_OVERHEAD)
+#define DRVAGGR_BUF_SIZE(nr)		((nr) * (DRVAGGR_FRAME_SIZE + 256 + \
+					 TX_PACKET_DRVAGGR_SUBFRAME_SHIFT_BYTES))
 #endif
 #define scrclng					4		// octets for crc32 (FCS, ICV)
 
@@ -1669,6 +1676,10 @@ typedef struct r8192_priv
 // modified by davad for Rx process */
        struct sk_buff_head rx_queue;
        struct sk_buff_head rx_skb_queue;
+       struct sk_buff_pool *rx_pool;	/* recycled rx URB buffers */
+#ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
+       struct sk_buff_pool *tx_agg_pool[VO_QUEUE+1];	/* recycled aggregation buffers per AC */
+#endif
        struct sk_buff_head tx_queue;
        struct sk_buff_head tx_skb_queue;
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(2,5,0))
@@ -52,83 +52,36 @@ void RxPktPendingTimeout(unsigned long data)
 	PRX_TS_RECORD	pRxTs = (PRX_TS_RECORD)data;
 	struct rtllib_device *ieee = container_of(pRxTs, struct rtllib_device, RxTsRecord[pRxTs->num]);
 	
-	PRX_REORDER_ENTRY 	pReorderEntry = NULL;
-
 	//u32 flags = 0;
 	unsigned long flags = 0;
 	struct rtllib_rxb *stats_IndicateArray[REORDER_WIN_SIZE];
 	u8 index = 0;
-	bool bPktInBuf = false;
+	u16 SeqEnd;
 
 
 	spin_lock_irqsave(&(ieee->reorder_spinlock), flags);
 	//PlatformAcquireSpinLock(Adapter, RT_RX_SPINLOCK);
 	RTLLIB_DEBUG(RTLLIB_DL_REORDER,"==================>%s()\n",__FUNCTION__);
-	if(pRxTs->RxTimeoutIndicateSeq != 0xffff)
+	if(pRxTs->RxTimeoutIndicateSeq != 0xffff && pRxTs->RxReorderPendingCnt)
 	{
-		// Indicate the pending packets sequentially according to SeqNum until meet the gap.
-		while(!list_empty(&pRxTs->RxPendingPktList))
-		{
-			pReorderEntry = (PRX_REORDER_ENTRY)list_entry(pRxTs->RxPendingPktList.prev,RX_REORDER_ENTRY,List);
-			if(index == 0)
-				pRxTs->RxIndicateSeq = pReorderEntry->SeqNum;
-
-			if( SN_LESS(pReorderEntry->SeqNum, pRxTs->RxIndicateSeq) || 
-				SN_EQUAL(pReorderEntry->SeqNum, pRxTs->RxIndicateSeq)	)
-			{
-				list_del_init(&pReorderEntry->List);
-			
-				if(SN_EQUAL(pReorderEntry->SeqNum, pRxTs->RxIndicateSeq))
-					pRxTs->RxIndicateSeq = (pRxTs->RxIndicateSeq + 1) % 4096;
-
-				RTLLIB_DEBUG(RTLLIB_DL_REORDER,"RxPktPendingTimeout(): IndicateSeq: %d\n", pReorderEntry->SeqNum);
-				stats_IndicateArray[index] = pReorderEntry->prxb;
-				index++;
-				
-				list_add_tail(&pReorderEntry->List, &ieee->RxReorder_Unused_List);
-			}
-			else
-			{
-				bPktInBuf = true;
-				break;
-			}
-		}
+		// Give up on the hole: indicate from the first buffered packet sequentially until meet the next gap.
+		SeqEnd = pRxTs->RxIndicateSeq;
+		while(pRxTs->RxReorderBuf[SeqEnd % REORDER_WIN_SIZE] == NULL)
+			SeqEnd = (SeqEnd + 1) % 4096;
+		index = RxReorderRelease(pRxTs, SeqEnd, stats_IndicateArray, index);
+		RTLLIB_DEBUG(RTLLIB_DL_REORDER,"RxPktPendingTimeout(): IndicateSeq: %d\n", pRxTs->RxIndicateSeq);
 	}
 
+	// Set RxTimeoutIndicateSeq to 0xffff to indicate no pending timer now.
+	pRxTs->RxTimeoutIndicateSeq = 0xffff;
+
 	if(index>0)
-	{
-		// Set RxTimeoutIndicateSeq to 0xffff to indicate no pending packets in buffer now.
-		pRxTs->RxTimeoutIndicateSeq = 0xffff;
-	
-		// Indicate packets
-		if(index > REORDER_WIN_SIZE){
-			RTLLIB_DEBUG(RTLLIB_DL_ERR, "RxReorderIndicatePacket(): Rx Reorer buffer full!! \n");
-			spin_unlock_irqrestore(&(ieee->reorder_spinlock), flags);
-			return;
-		}
 		rtllib_indicate_packets(ieee, stats_IndicateArray, index);
-		 bPktInBuf = false;
-
-	}
 
-	if(bPktInBuf && (pRxTs->RxTimeoutIndicateSeq==0xffff))
+	if(pRxTs->RxReorderPendingCnt)
 	{
 		pRxTs->RxTimeoutIndicateSeq = pRxTs->RxIndicateSeq;
-#if 0   
-		if(timer_pending(&pTS->RxPktPendingTimer))
-			del_timer_sync(&pTS->RxPktPendingTimer);
-		pTS->RxPktPendingTimer.expires = jiffies + MSECS(pHTInfo->RxReorderPendingTime);
-		add_timer(&pTS->RxPktPendingTimer);
-#else
 		mod_timer(&pRxTs->RxPktPendingTimer,  jiffies + MSECS(ieee->pHTInfo->RxReorderPendingTime));
-#endif
-
-#if 0		
-		if(timer_pending(&pRxTs->RxPktPendingTimer))
-			del_timer_sync(&pRxTs->RxPktPendingTimer);
-		pRxTs->RxPktPendingTimer.expires = jiffies + ieee->pHTInfo->RxReorderPendingTime;
-		add_timer(&pRxTs->RxPktPendingTimer);
-#endif
 	}
 	spin_unlock_irqrestore(&(ieee->reorder_spinlock), flags);
 	//PlatformReleaseSpinLock(Adapter, RT_RX_SPINLOCK);
@@ -173,9 +126,29 @@ void ResetTxTsEntry(PTX_TS_RECORD pTS)
 	ResetBaEntry(&pTS->TxPendingBARecord);
 }
 
+// Free every packet still held in the Rx reorder buffer.
+static void RxReorderPurge(PRX_TS_RECORD pTS)
+{
+	struct rtllib_rxb *prxb;
+	int i, j;
+
+	for(i = 0; i < REORDER_WIN_SIZE && pTS->RxReorderPendingCnt; i++)
+	{
+		prxb = pTS->RxReorderBuf[i];
+		if(prxb == NULL)
+			continue;
+		for(j = 0; j < prxb->nr_subframes; j++)
+			dev_kfree_skb(prxb->subframes[j]);
+		kfree(prxb);
+		pTS->RxReorderBuf[i] = NULL;
+		pTS->RxReorderPendingCnt--;
+	}
+}
+
 void ResetRxTsEntry(PRX_TS_RECORD pTS)
 {
 	ResetTsCommonInfo(&pTS->TsCommonInfo);
+	RxReorderPurge(pTS);
 	pTS->RxIndicateSeq = 0xffff; // This indicate the RxIndicateSeq is not used now!!
 	pTS->RxTimeoutIndicateSeq = 0xffff; // This indicate the RxTimeoutIndicateSeq is not used now!!
 	ResetBaEntry(&pTS->RxAdmittedBARecord);	  // For BA Recepient
@@ -190,6 +163,7 @@ void ResetAdmitTRStream(struct rtllib_device *ieee, u8 *Addr)
 	PTS_COMMON_INFO	pRet = NULL;
 	PRX_TS_RECORD pRxTS = NULL;
 	PTX_TS_RECORD pTxTS = NULL;
+	unsigned long flags = 0;
 
 	if(ieee->iw_mode != IW_MODE_MESH) 
 		return;
@@ -207,8 +181,14 @@ void ResetAdmitTRStream(struct rtllib_device *ieee, u8 *Addr)
 			if ((memcmp(pRet->Addr, Addr, 6) == 0) && (pRet->TSpec.f.TSInfo.field.ucDirection == dir))
 			{
 				pRxTS = (PRX_TS_RECORD)pRet;
+				if(timer_pending(&pRxTS->RxPktPendingTimer))
+					del_timer_sync(&pRxTS->RxPktPendingTimer);
+
+				spin_lock_irqsave(&(ieee->reorder_spinlock), flags);
+				RxReorderPurge(pRxTS);
 				pRxTS->RxIndicateSeq = 0xffff;
 				pRxTS->RxTimeoutIndicateSeq = 0xffff;
+				spin_unlock_irqrestore(&(ieee->reorder_spinlock), flags);
 			}
 					
 		}	
@@ -239,7 +219,6 @@ void TSInitialize(struct rtllib_device *ieee)
 {
 	PTX_TS_RECORD		pTxTS  = ieee->TxTsRecord;
 	PRX_TS_RECORD		pRxTS  = ieee->RxTsRecord;
-	PRX_REORDER_ENTRY	pRxReorderEntry = ieee->RxReorderEntry;
 	u8				count = 0;
 	RTLLIB_DEBUG(RTLLIB_DL_TS, "==========>%s()\n", __FUNCTION__);
 	// Initialize Tx TS related info.
@@ -285,7 +264,6 @@ void TSInitialize(struct rtllib_device *ieee)
 	for(count = 0; count < TOTAL_TS_NUM; count++)
 	{
 		pRxTS->num = count;
-		INIT_LIST_HEAD(&pRxTS->RxPendingPktList);
 		
 		_setup_timer(&pRxTS->TsCommonInfo.SetupTimer,
 			    TsSetupTimeOut,
@@ -307,17 +285,6 @@ void TSInitialize(struct rtllib_device *ieee)
 		list_add_tail(&pRxTS->TsCommonInfo.List, &ieee->Rx_TS_Unused_List);
 		pRxTS++;
 	}
-	// Initialize unused Rx Reorder List.
-	INIT_LIST_HEAD(&ieee->RxReorder_Unused_List);
-//#ifdef TO_DO_LIST
-	for(count = 0; count < REORDER_ENTRY_NUM; count++)
-	{
-		list_add_tail( &pRxReorderEntry->List,&ieee->RxReorder_Unused_List);
-		if(count == (REORDER_ENTRY_NUM-1))
-			break;
-		pRxReorderEntry = &ieee->RxReorderEntry[count+1];
-	}
-//#endif
 
 }
 
@@ -602,36 +569,14 @@ void RemoveTsEntry(
 	if(TxRxSelect == RX_DIR)
 	{
 //#ifdef TO_DO_LIST
-		PRX_REORDER_ENTRY	pRxReorderEntry;
 		PRX_TS_RECORD 		pRxTS = (PRX_TS_RECORD)pTs;
 		if(timer_pending(&pRxTS->RxPktPendingTimer))	
 			del_timer_sync(&pRxTS->RxPktPendingTimer);
 
-                while(!list_empty(&pRxTS->RxPendingPktList))
-                {
-                //      PlatformAcquireSpinLock(Adapter, RT_RX_SPINLOCK);
-                        spin_lock_irqsave(&(ieee->reorder_spinlock), flags);
-                        //pRxReorderEntry = list_entry(&pRxTS->RxPendingPktList.prev,RX_REORDER_ENTRY,List);
-			pRxReorderEntry = (PRX_REORDER_ENTRY)list_entry(pRxTS->RxPendingPktList.prev,RX_REORDER_ENTRY,List);
-                        list_del_init(&pRxReorderEntry->List);
-                        {
-                                int i = 0;
-                                struct rtllib_rxb * prxb = pRxReorderEntry->prxb;
-				if (unlikely(!prxb))
-				{
-					spin_unlock_irqrestore(&(ieee->reorder_spinlock), flags);
-					return;
-				}
-                                for(i =0; i < prxb->nr_subframes; i++) {
-                                        dev_kfree_skb(prxb->subframes[i]);
-                                }
-                                kfree(prxb);
-                                prxb = NULL;
-                        }
-                        list_add_tail(&pRxReorderEntry->List,&ieee->RxReorder_Unused_List);
-                        //PlatformReleaseSpinLock(Adapter, RT_RX_SPINLOCK);
-                        spin_unlock_irqrestore(&(ieee->reorder_spinlock), flags);
-                }
+		spin_lock_irqsave(&(ieee->reorder_spinlock), flags);
+		RxReorderPurge(pRxTS);
+		pRxTS->RxTimeoutIndicateSeq = 0xffff;
+		spin_unlock_irqrestore(&(ieee->reorder_spinlock), flags);
 
 //#endif
 	}
@@ -2293,17 +2293,6 @@ typedef struct _bandwidth_autoswitch
 }bandwidth_autoswitch,*pbandwidth_autoswitch;
 
 
-//added by amy for order
-
-#define REORDER_WIN_SIZE	128
-#define REORDER_ENTRY_NUM	128
-typedef struct _RX_REORDER_ENTRY
-{
-	struct list_head	List;
-	u16			SeqNum;
-	struct rtllib_rxb* prxb;
-} RX_REORDER_ENTRY, *PRX_REORDER_ENTRY;
-//added by amy for order
 typedef enum _Fsync_State{
 	Default_Fsync,
 	HW_Fsync,
@@ -2794,8 +2783,6 @@ struct rtllib_device {
 	struct list_head		Rx_TS_Pending_List;
 	struct list_head		Rx_TS_Unused_List;
 	RX_TS_RECORD		RxTsRecord[TOTAL_TS_NUM];
-	RX_REORDER_ENTRY	RxReorderEntry[128];
-	struct list_head		RxReorder_Unused_List;
 	// Qos related. Added by Annie, 2005-11-01.
 //	PSTA_QOS			pStaQos;
 	u8				ForcedPriority;		// Force per-packet priority 1~7. (default: 0, not to force it.)
@@ -3914,6 +3901,7 @@ extern int rtllib_parse_info_param(struct rtllib_device *ieee,
 		struct rtllib_rx_stats *stats);
 
 void rtllib_indicate_packets(struct rtllib_device *ieee, struct rtllib_rxb** prxbIndicateArray,u8  index);
+u8 RxReorderRelease(PRX_TS_RECORD pTS, u16 SeqEnd, struct rtllib_rxb** prxbIndicateArray, u8 index);
 #if defined(RTL8192U) || defined(RTL8192SU) || defined(RTL8192SE)
 extern void IbssAgeFunction(struct rtllib_device *ieee);//added by amy for adhoc 090403
 extern struct sta_info *GetStaInfo(struct rtllib_device *ieee, u8 *addr);
@@ -588,36 +588,44 @@ drop:
 	
 	return 1;
 }
-bool
-AddReorderEntry(
-	PRX_TS_RECORD			pTS,
-	PRX_REORDER_ENTRY		pReorderEntry
-	)
+/*
+ * The Rx reorder buffer is a ring of REORDER_WIN_SIZE slots indexed by
+ * SeqNum % REORDER_WIN_SIZE.  Every buffered frame lies inside the current
+ * window [RxIndicateSeq, RxIndicateSeq + WinSize), so a slot never holds two
+ * frames and both insertion and release are a single array access.
+ *
+ * Move the window start up to SeqEnd, collecting every frame buffered in
+ * front of it (holes are given up on), then keep collecting the frames that
+ * have become in order.  Returns the new number of frames in
+ * prxbIndicateArray.  Caller holds ieee->reorder_spinlock.
+ */
+u8 RxReorderRelease(PRX_TS_RECORD pTS, u16 SeqEnd, struct rtllib_rxb** prxbIndicateArray, u8 index)
 {
-	struct list_head *pList = &pTS->RxPendingPktList;
-#if  1 
-	while(pList->next != &pTS->RxPendingPktList)
-	{
-		if( SN_LESS(pReorderEntry->SeqNum, ((PRX_REORDER_ENTRY)list_entry(pList->next,RX_REORDER_ENTRY,List))->SeqNum) )
-		{
-			pList = pList->next;
-		}
-		else if( SN_EQUAL(pReorderEntry->SeqNum, ((PRX_REORDER_ENTRY)list_entry(pList->next,RX_REORDER_ENTRY,List))->SeqNum) )
-		{
-			return false;
+	struct rtllib_rxb** pSlot;
+
+	while(pTS->RxReorderPendingCnt && SN_LESS(pTS->RxIndicateSeq, SeqEnd)) {
+		pSlot = &pTS->RxReorderBuf[pTS->RxIndicateSeq % REORDER_WIN_SIZE];
+		if(*pSlot) {
+			prxbIndicateArray[index++] = *pSlot;
+			*pSlot = NULL;
+			pTS->RxReorderPendingCnt--;
 		}
-		else
-		{
+		pTS->RxIndicateSeq = (pTS->RxIndicateSeq + 1) % 4096;
+	}
+	if(SN_LESS(pTS->RxIndicateSeq, SeqEnd))
+		pTS->RxIndicateSeq = SeqEnd;
+
+	while(pTS->RxReorderPendingCnt) {
+		pSlot = &pTS->RxReorderBuf[pTS->RxIndicateSeq % REORDER_WIN_SIZE];
+		if(*pSlot == NULL)
 			break;
-		}
+		prxbIndicateArray[index++] = *pSlot;
+		*pSlot = NULL;
+		pTS->RxReorderPendingCnt--;
+		pTS->RxIndicateSeq = (pTS->RxIndicateSeq + 1) % 4096;
 	}
-#endif
-	pReorderEntry->List.next = pList->next;
-	pReorderEntry->List.next->prev = &pReorderEntry->List;
-	pReorderEntry->List.prev = pList;
-	pList->next = &pReorderEntry->List;
 
-	return true;
+	return index;
 }
 
 void rtllib_indicate_packets(struct rtllib_device *ieee, struct rtllib_rxb** prxbIndicateArray,u8  index)
@@ -695,187 +703,92 @@ void RxReorderIndicatePacket( struct rtllib_device *ieee,
 		u16			SeqNum)
 {
 	PRT_HIGH_THROUGHPUT	pHTInfo = ieee->pHTInfo;
-	PRX_REORDER_ENTRY 	pReorderEntry = NULL;
 	struct rtllib_rxb* prxbIndicateArray[REORDER_WIN_SIZE];
+	struct rtllib_rxb**	pSlot;
 	u8			WinSize = pHTInfo->RxReorderWinSize;
-	u16			WinEnd = (pTS->RxIndicateSeq + WinSize -1)%4096;
+	u16			WinEnd;
 	u8			index = 0;
-	bool			bMatchWinStart = false, bPktInBuf = false;
+	unsigned long		flags;
+
+	if(WinSize > REORDER_WIN_SIZE)
+		WinSize = REORDER_WIN_SIZE;
+
+	spin_lock_irqsave(&(ieee->reorder_spinlock), flags);
 	RTLLIB_DEBUG(RTLLIB_DL_REORDER,"%s(): Seq is %d,pTS->RxIndicateSeq is %d, WinSize is %d\n",__FUNCTION__,SeqNum,pTS->RxIndicateSeq,WinSize);
-#if 0
-	if(!list_empty(&ieee->RxReorder_Unused_List))
-		RTLLIB_DEBUG(RTLLIB_DL_REORDER,"%s(): ieee->RxReorder_Unused_List is nut NULL\n");
-#endif
+
 	/* Rx Reorder initialize condition.*/
 	if(pTS->RxIndicateSeq == 0xffff) {
 		pTS->RxIndicateSeq = SeqNum;
 	}
+	WinEnd = (pTS->RxIndicateSeq + WinSize -1)%4096;
 
 	/* Drop out the packet which SeqNum is smaller than WinStart */
 	if(SN_LESS(SeqNum, pTS->RxIndicateSeq)) {
 		RTLLIB_DEBUG(RTLLIB_DL_REORDER,"Packet Drop! IndicateSeq: %d, NewSeq: %d\n",
 				 pTS->RxIndicateSeq, SeqNum);
 		pHTInfo->RxReorderDropCounter++;
-		{
-			int i;
-			for(i =0; i < prxb->nr_subframes; i++) {
-				dev_kfree_skb(prxb->subframes[i]);
-			}
-			kfree(prxb);
-			prxb = NULL;
-		}
-		return;
+		goto drop;
 	}
 
 	/*
-	 * Sliding window manipulation. Conditions includes:
-	 * 1. Incoming SeqNum is equal to WinStart =>Window shift 1
-	 * 2. Incoming SeqNum is larger than the WinEnd => Window shift N
+	 * Incoming SeqNum is larger than the WinEnd => shift the window so
+	 * that it ends at SeqNum, indicating whatever falls out of its front.
 	 */
-	if(SN_EQUAL(SeqNum, pTS->RxIndicateSeq)) {
-		pTS->RxIndicateSeq = (pTS->RxIndicateSeq + 1) % 4096;
-		bMatchWinStart = true;
-	} else if(SN_LESS(WinEnd, SeqNum)) {
-		if(SeqNum >= (WinSize - 1)) {
-			pTS->RxIndicateSeq = SeqNum + 1 -WinSize;
-		} else {
-			pTS->RxIndicateSeq = 4095 - (WinSize - (SeqNum +1)) + 1;
-		}
+	if(SN_LESS(WinEnd, SeqNum)) {
+		index = RxReorderRelease(pTS, (SeqNum + 4096 - WinSize + 1) % 4096,
+				prxbIndicateArray, index);
 		RTLLIB_DEBUG(RTLLIB_DL_REORDER, "Window Shift! IndicateSeq: %d, NewSeq: %d\n",pTS->RxIndicateSeq, SeqNum);
 	}
 
-	/*
-	 * Indication process.
-	 * After Packet dropping and Sliding Window shifting as above, we can now just indicate the packets
-	 * with the SeqNum smaller than latest WinStart and buffer other packets.
-	 */
-	/* For Rx Reorder condition:
-	 * 1. All packets with SeqNum smaller than WinStart => Indicate
-	 * 2. All packets with SeqNum larger than or equal to WinStart => Buffer it.
-	 */
-	if(bMatchWinStart) {
-		/* Current packet is going to be indicated.*/
+	if(SN_EQUAL(SeqNum, pTS->RxIndicateSeq)) {
+		/* In order: indicate it together with whatever it unblocks. */
+		prxbIndicateArray[index++] = prxb;
+		pTS->RxIndicateSeq = (pTS->RxIndicateSeq + 1) % 4096;
+		index = RxReorderRelease(pTS, pTS->RxIndicateSeq, prxbIndicateArray, index);
 		RTLLIB_DEBUG(RTLLIB_DL_REORDER, "Packets indication!! IndicateSeq: %d, NewSeq: %d\n",\
 				pTS->RxIndicateSeq, SeqNum);
-		prxbIndicateArray[0] = prxb;
-//		printk("========================>%s(): SeqNum is %d\n",__FUNCTION__,SeqNum);
-		index = 1;
 	} else {
-		/* Current packet is going to be inserted into pending list.*/
-		//RTLLIB_DEBUG(RTLLIB_DL_REORDER,"%s(): We RX no ordered packed, insert to orderd list\n",__FUNCTION__);
-		if(!list_empty(&ieee->RxReorder_Unused_List)) {
-			pReorderEntry = (PRX_REORDER_ENTRY)list_entry(ieee->RxReorder_Unused_List.next,RX_REORDER_ENTRY,List);
-			list_del_init(&pReorderEntry->List);
-			
-			/* Make a reorder entry and insert into a the packet list.*/
-			pReorderEntry->SeqNum = SeqNum;
-			pReorderEntry->prxb = prxb;
-	//		RTLLIB_DEBUG(RTLLIB_DL_REORDER,"%s(): pREorderEntry->SeqNum is %d\n",__FUNCTION__,pReorderEntry->SeqNum);
-
-#if 1 
-			if(!AddReorderEntry(pTS, pReorderEntry)) {
-				RTLLIB_DEBUG(RTLLIB_DL_REORDER, "%s(): Duplicate packet is dropped!! IndicateSeq: %d, NewSeq: %d\n", 
+		pSlot = &pTS->RxReorderBuf[SeqNum % REORDER_WIN_SIZE];
+		if(*pSlot) {
+			RTLLIB_DEBUG(RTLLIB_DL_REORDER, "%s(): Duplicate packet is dropped!! IndicateSeq: %d, NewSeq: %d\n",
 					__FUNCTION__, pTS->RxIndicateSeq, SeqNum);
-				list_add_tail(&pReorderEntry->List,&ieee->RxReorder_Unused_List);
-				{
-					int i;
-					for(i =0; i < prxb->nr_subframes; i++) {
-						dev_kfree_skb(prxb->subframes[i]);
-					}
-					kfree(prxb);
-					prxb = NULL;
-				}
-			} else {
-				RTLLIB_DEBUG(RTLLIB_DL_REORDER,
-					 "Pkt insert into buffer!! IndicateSeq: %d, NewSeq: %d\n",pTS->RxIndicateSeq, SeqNum);
-			}
-#endif
-		} 
-		else {
-			/*
-			 * Packets are dropped if there is not enough reorder entries.
-			 * This part shall be modified!! We can just indicate all the 
-			 * packets in buffer and get reorder entries.
-			 */
-			RTLLIB_DEBUG(RTLLIB_DL_ERR, "RxReorderIndicatePacket(): There is no reorder entry!! Packet is dropped!!\n");
-			{
-				int i;
-				for(i =0; i < prxb->nr_subframes; i++) {
-					dev_kfree_skb(prxb->subframes[i]);
-				}
-				kfree(prxb);
-				prxb = NULL;
-			}
-		}
-	}
-
-	/* Check if there is any packet need indicate.*/
-	while(!list_empty(&pTS->RxPendingPktList)) {
-		RTLLIB_DEBUG(RTLLIB_DL_REORDER,"%s(): start RREORDER indicate\n",__FUNCTION__);
-#if 1 
-		pReorderEntry = (PRX_REORDER_ENTRY)list_entry(pTS->RxPendingPktList.prev,RX_REORDER_ENTRY,List);
-		if( SN_LESS(pReorderEntry->SeqNum, pTS->RxIndicateSeq) || 
-				SN_EQUAL(pReorderEntry->SeqNum, pTS->RxIndicateSeq))
-		{
-			/* This protect buffer from overflow. */
-			if(index >= REORDER_WIN_SIZE) {
-				RTLLIB_DEBUG(RTLLIB_DL_ERR, "RxReorderIndicatePacket(): Buffer overflow!! \n");
-				bPktInBuf = true;
-				break;
-			}
-
-			list_del_init(&pReorderEntry->List);
-
-			if(SN_EQUAL(pReorderEntry->SeqNum, pTS->RxIndicateSeq))
-				pTS->RxIndicateSeq = (pTS->RxIndicateSeq + 1) % 4096;
-
-			RTLLIB_DEBUG(RTLLIB_DL_REORDER,"Packets indication!! IndicateSeq: %d, NewSeq: %d\n",pTS->RxIndicateSeq, SeqNum);
-			prxbIndicateArray[index] = pReorderEntry->prxb;
-		//	printk("========================>%s(): pReorderEntry->SeqNum is %d\n",__FUNCTION__,pReorderEntry->SeqNum);
-			index++;
-
-			list_add_tail(&pReorderEntry->List,&ieee->RxReorder_Unused_List);
-		} else {
-			bPktInBuf = true;
-			break;
+			goto drop;
 		}
-#endif
+		*pSlot = prxb;
+		pTS->RxReorderPendingCnt++;
+		RTLLIB_DEBUG(RTLLIB_DL_REORDER,
+			 "Pkt insert into buffer!! IndicateSeq: %d, NewSeq: %d\n",pTS->RxIndicateSeq, SeqNum);
 	}
 
-	/* Handling pending timer. Set this timer to prevent from long time Rx buffering.*/
-	if(index>0) {
-		// Cancel previous pending timer.
-		if(timer_pending(&pTS->RxPktPendingTimer))
-		{
-			del_timer_sync(&pTS->RxPktPendingTimer);
-		}
-	//	del_timer_sync(&pTS->RxPktPendingTimer);
+	if(index > 0) {
+		/*
+		 * Cancel previous pending timer.  Not del_timer_sync(): the
+		 * handler takes reorder_spinlock, which we are holding.
+		 */
+		del_timer(&pTS->RxPktPendingTimer);
 		pTS->RxTimeoutIndicateSeq = 0xffff;
-
-		// Indicate packets
-		if(index>REORDER_WIN_SIZE){
-			RTLLIB_DEBUG(RTLLIB_DL_ERR, "RxReorderIndicatePacket(): Rx Reorer buffer full!! \n");
-			return;
-		}
 		rtllib_indicate_packets(ieee, prxbIndicateArray, index);
-		bPktInBuf = false;
 	}
 
-#if 1 
-	if(bPktInBuf && pTS->RxTimeoutIndicateSeq==0xffff) {
-		// Set new pending timer.
+	/* Set pending timer to prevent from long time Rx buffering behind a hole. */
+	if(pTS->RxReorderPendingCnt && pTS->RxTimeoutIndicateSeq == 0xffff) {
 		RTLLIB_DEBUG(RTLLIB_DL_REORDER,"%s(): SET rx timeout timer\n", __FUNCTION__);
 		pTS->RxTimeoutIndicateSeq = pTS->RxIndicateSeq;
-#if 0	
-		if(timer_pending(&pTS->RxPktPendingTimer))
-			del_timer_sync(&pTS->RxPktPendingTimer);
-		pTS->RxPktPendingTimer.expires = jiffies + MSECS(pHTInfo->RxReorderPendingTime);
-		add_timer(&pTS->RxPktPendingTimer);
-#else
 		mod_timer(&pTS->RxPktPendingTimer,  jiffies + MSECS(pHTInfo->RxReorderPendingTime));
-#endif
 	}
-#endif
+	spin_unlock_irqrestore(&(ieee->reorder_spinlock), flags);
+	return;
+
+drop:
+	spin_unlock_irqrestore(&(ieee->reorder_spinlock), flags);
+	{
+		int i;
+		for(i =0; i < prxb->nr_subframes; i++) {
+			dev_kfree_skb(prxb->subframes[i]);
+		}
+		kfree(prxb);
+		prxb = NULL;
+	}
 }
 
 u8 parse_subframe(struct rtllib_device* ieee,struct sk_buff *skb, 
@@ -892,7 +805,8 @@ u8 parse_subframe(struct rtllib_device* ieee,struct sk_buff *skb,
 	u8		nPadding_Length = 0;
 	u16		SeqNum=0;
 	struct sk_buff *sub_skb;
-	u8             *data_ptr;	
+
+	rxb->nr_subframes = 0;
 	/* just for debug purpose */
 	SeqNum = WLAN_GET_SEQ_SEQ(le16_to_cpu(hdr->seq_ctl));
 	if((RTLLIB_QOS_HAS_SEQ(fc))&&\
@@ -917,16 +831,16 @@ u8 parse_subframe(struct rtllib_device* ieee,struct sk_buff *skb,
 	skb_pull(skb, LLCOffset);
 	ieee->bIsAggregateFrame = bIsAggregateFrame;//added by amy for Leisure PS
 	if(!bIsAggregateFrame) {
-		rxb->nr_subframes = 1;
-#ifndef RTK_DMP_PLATFORM
-#ifdef JOHN_NOCPY
-		rxb->subframes[0] = skb;
-#else
-		rxb->subframes[0] = skb_copy(skb, GFP_ATOMIC);
-#endif
-#else
+		/*
+		 * Share the receive buffer rather than copying it, the caller
+		 * drops its own reference once we return.
+		 */
 		rxb->subframes[0] = skb_clone(skb, GFP_ATOMIC);
-#endif
+		if(rxb->subframes[0] == NULL) {
+			rxb->nr_subframes = 0;
+			return 0;
+		}
+		rxb->nr_subframes = 1;
 		memcpy(rxb->src,src,ETH_ALEN);
 		memcpy(rxb->dst,dst,ETH_ALEN);
 		//RTLLIB_DEBUG_DATA(RTLLIB_DL_RX,skb->data,skb->len);
@@ -954,17 +868,17 @@ u8 parse_subframe(struct rtllib_device* ieee,struct sk_buff *skb,
 			/* move the data point to data content */
 			skb_pull(skb, ETHERNET_HEADER_SIZE);
 
-#ifdef JOHN_NOCPY
+			/*
+			 * Release a clone trimmed to this subframe instead of a
+			 * copy.  The 802.3 header rebuilt at indication time is
+			 * pushed back over this subframe's own A-MSDU header, so
+			 * the clones never write into each other's payload.
+			 */
 			sub_skb = skb_clone(skb, GFP_ATOMIC);
-			sub_skb->len = nSubframe_Length;
-			sub_skb->tail = sub_skb->data + nSubframe_Length;
-#else
-			/* Allocate new skb for releasing to upper layer */
-			sub_skb = dev_alloc_skb(nSubframe_Length + 12);
-			skb_reserve(sub_skb, 12);
-			data_ptr = (u8 *)skb_put(sub_skb, nSubframe_Length);
-			memcpy(data_ptr,skb->data,nSubframe_Length);
-#endif
+			if(sub_skb == NULL) {
+				return 0;
+			}
+			skb_trim(sub_skb, nSubframe_Length);
 			sub_skb->dev = ieee->dev;
 			rxb->subframes[rxb->nr_subframes++] = sub_skb;
 			if(rxb->nr_subframes >= MAX_SUBFRAME_COUNT) {
@@ -986,9 +900,6 @@ u8 parse_subframe(struct rtllib_device* ieee,struct sk_buff *skb,
 				skb_pull(skb,nPadding_Length);	
 			}			
 		}
-#ifdef JOHN_NOCPY
-		dev_kfree_skb(skb);
-#endif
 		//{just for debug added by david
 		//printk("AMSDU::rxb->nr_subframes = %d\n",rxb->nr_subframes);
 		//}
@@ -1844,9 +1755,7 @@ int rtllib_rx(struct rtllib_device *ieee, struct sk_buff *skb,
 #ifdef _RTL8192_EXT_PATCH_
 	}
 #endif	
-#ifndef JOHN_NOCPY
 	dev_kfree_skb(skb);
-#endif
 
  rx_exit:
 #ifdef NOT_YET
@@ -1640,14 +1640,14 @@ static int rtl8192_rx_initiate(struct net_device*dev)
 	// nomal packet rx procedure */
         while (skb_queue_len(&priv->rx_queue) < MAX_RX_URB) {
 #ifdef USB_USE_ALIGNMENT
-                skb = __dev_alloc_skb(RX_URB_SIZE+USB_512B_ALIGNMENT_SIZE, GFP_KERNEL);
+                skb = skb_pool_alloc(priv->rx_pool, RX_URB_SIZE+USB_512B_ALIGNMENT_SIZE, GFP_KERNEL);
                 if (!skb)
                         break;
                 Tmpaddr = (u32)skb->data;
                 alignment = Tmpaddr & 0x1ff;
                 skb_reserve(skb,(USB_512B_ALIGNMENT_SIZE - alignment));
 #else
-                skb = __dev_alloc_skb(RX_URB_SIZE, GFP_KERNEL);
+                skb = skb_pool_alloc(priv->rx_pool, RX_URB_SIZE, GFP_KERNEL);
                 if (!skb)
                         break;
 #endif
@@ -1686,14 +1686,14 @@ static int rtl8192_rx_initiate(struct net_device*dev)
         while (skb_queue_len(&priv->rx_queue) < MAX_RX_URB + 3) {
 //		printk("command packet IN request!\n");
 #ifdef USB_USE_ALIGNMENT
-                skb = __dev_alloc_skb(RX_URB_SIZE+USB_512B_ALIGNMENT_SIZE ,GFP_KERNEL);
+                skb = skb_pool_alloc(priv->rx_pool, RX_URB_SIZE+USB_512B_ALIGNMENT_SIZE, GFP_KERNEL);
                 if (!skb)
                         break;
                 Tmpaddr = (u32)skb->data;
                 alignment = Tmpaddr & 0x1ff;
                 skb_reserve(skb,(USB_512B_ALIGNMENT_SIZE - alignment));
 #else
-                skb = __dev_alloc_skb(RX_URB_SIZE ,GFP_KERNEL);
+                skb = skb_pool_alloc(priv->rx_pool, RX_URB_SIZE, GFP_KERNEL);
                 if (!skb)
                         break;
 #endif
@@ -2166,9 +2166,9 @@ static void rtl8192_rx_isr(struct urb *urb)
 #ifdef USB_USE_ALIGNMENT
 	u32 Tmpaddr=0;
         int alignment=0;
-        skb2 = dev_alloc_skb(RX_URB_SIZE+USB_512B_ALIGNMENT_SIZE);
+        skb2 = skb_pool_alloc(priv->rx_pool, RX_URB_SIZE+USB_512B_ALIGNMENT_SIZE, GFP_ATOMIC);
 #else
-        skb2 = dev_alloc_skb(RX_URB_SIZE);
+        skb2 = skb_pool_alloc(priv->rx_pool, RX_URB_SIZE, GFP_ATOMIC);
 #endif
         if (unlikely(!skb2)) {
 		printk("%s():can,t alloc skb\n",__FUNCTION__);
@@ -2392,6 +2392,7 @@ struct sk_buff *DrvAggr_Aggregation(struct net_device *dev, struct rtllib_drv_ag
 	u32		TotalLength;
 	struct sk_buff	*skb;
 	struct sk_buff  *agg_skb;
+	struct sk_buff_pool *pool = NULL;
 	tx_desc_819x_usb_aggr_subframe *tx_agg_desc = NULL;	
 	tx_fwinfo_819x_usb	       *tx_fwinfo = NULL;
 
@@ -2411,26 +2412,28 @@ struct sk_buff *DrvAggr_Aggregation(struct net_device *dev, struct rtllib_drv_ag
 		TotalLength += (skb->len + TX_PACKET_DRVAGGR_SUBFRAME_SHIFT_BYTES); 
 	}
 
-	// allocate skb to contain the aggregated packets */
+	// allocate skb to contain the aggregated packets: take a recycled
+	// buffer from the queue's pool, it returns there when tx_isr frees it */
+	tcb_desc = (cb_desc *)(pSendList->tx_agg_frames[0]->cb + MAX_DEV_ADDR_SIZE);
+	if (tcb_desc->queue_index <= VO_QUEUE)
+		pool = priv->tx_agg_pool[tcb_desc->queue_index];
 #ifdef USB_USE_ALIGNMENT
 	u32 Tmpaddr=0;
         int alignment=0;
-	agg_skb = dev_alloc_skb(TotalLength + ieee->tx_headroom + 512);
+	agg_skb = skb_pool_alloc(pool, TotalLength + ieee->tx_headroom + 512, GFP_ATOMIC);
         if (!agg_skb) {
         	printk("%s-%d: dev_alloc_skb() failed\n", __FUNCTION__, __LINE__);
-        	return NULL;
+        	goto drop;
         }
         Tmpaddr = (u32)agg_skb->data;
         alignment = Tmpaddr & 0x1ff;
-        memset(agg_skb->data, 0, agg_skb->len);
 	skb_reserve(agg_skb, ieee->tx_headroom + (USB_512B_ALIGNMENT_SIZE - alignment));
 #else
-	agg_skb = dev_alloc_skb(TotalLength + ieee->tx_headroom); 
+	agg_skb = skb_pool_alloc(pool, TotalLength + ieee->tx_headroom, GFP_ATOMIC); 
         if (!agg_skb) {
         	printk("%s-%d: dev_alloc_skb() failed\n", __FUNCTION__, __LINE__);
-        	return NULL;
+        	goto drop;
         }
-	memset(agg_skb->data, 0, agg_skb->len);
 	skb_reserve(agg_skb, ieee->tx_headroom);
 #endif
 
@@ -2607,6 +2610,13 @@ struct sk_buff *DrvAggr_Aggregation(struct net_device *dev, struct rtllib_drv_ag
 	}
 
 	return agg_skb;
+
+drop:
+	// the caller drops the burst, so don't leak the queued frames */
+	for(i = 0; i < pSendList->nr_drv_agg_frames; i++) {
+		dev_kfree_skb_any(pSendList->tx_agg_frames[i]);
+	}
+	return NULL;
 }
 
 // NOTE:
@@ -5926,11 +5936,39 @@ void rtl8192_hw_to_sleep(struct net_device *dev, u32 th, u32 tl)
 	spin_unlock_irqrestore(&priv->ps_lock,flags);	
 }
 
+#ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
+// allocate nr buffers from the pool and free them again, so they are
+// parked there before the first burst needs them in atomic context */
+static void rtl8192_fill_skb_pool(struct sk_buff_pool *pool, unsigned int len, int nr)
+{
+	struct sk_buff *skb, *list = NULL;
+
+	if (!pool)
+		return;
+
+	while (nr-- > 0) {
+		skb = skb_pool_alloc(pool, len, GFP_KERNEL);
+		if (!skb)
+			break;
+		skb->next = list;
+		list = skb;
+	}
+	while ((skb = list) != NULL) {
+		list = skb->next;
+		skb->next = NULL;
+		dev_kfree_skb(skb);
+	}
+}
+#endif
+
 //init priv variables here. only non_zero value should be initialized here.
 static void rtl8192_init_priv_variable(struct net_device* dev)
 {
 	struct r8192_priv *priv = rtllib_priv(dev);
 	u8 i;
+#ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
+	u32 agg_len;
+#endif
 	priv->card_8192 = priv->ops->nic_type;//NIC_8192U;
 	priv->card_8192_version = 0;
 	priv->chan = 1; //set to channel 1
@@ -6198,6 +6236,12 @@ static void rtl8192_init_priv_variable(struct net_device* dev)
 	// rx related queue */
         skb_queue_head_init(&priv->rx_queue);
 	skb_queue_head_init(&priv->rx_skb_queue);
+	// recycle the large rx URB buffers instead of reallocating them */
+#ifdef USB_USE_ALIGNMENT
+	priv->rx_pool = skb_pool_create(dev, RX_URB_SIZE+USB_512B_ALIGNMENT_SIZE, MAX_RX_URB);
+#else
+	priv->rx_pool = skb_pool_create(dev, RX_URB_SIZE, MAX_RX_URB);
+#endif
 
 	// Tx related queue */
 	skb_queue_head_init(&priv->tx_queue);
@@ -6211,6 +6255,18 @@ static void rtl8192_init_priv_variable(struct net_device* dev)
 	for(i = 0; i < MAX_QUEUE_SIZE; i++) {
 		skb_queue_head_init(&priv->rtllib->skb_drv_aggQ [i]);
 	}
+#ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
+	// reuse the driver aggregation buffers instead of allocating one per
+	// burst; sized for a full list of MTU frames and prefilled here */
+	agg_len = DRVAGGR_BUF_SIZE(priv->rtllib->pHTInfo->UsbTxAggrNum) + priv->rtllib->tx_headroom;
+#ifdef USB_USE_ALIGNMENT
+	agg_len += USB_512B_ALIGNMENT_SIZE;
+#endif
+	for(i = 0; i <= VO_QUEUE; i++) {
+		priv->tx_agg_pool[i] = skb_pool_create(dev, agg_len, MAX_TX_URB);
+		rtl8192_fill_skb_pool(priv->tx_agg_pool[i], agg_len, MAX_TX_URB);
+	}
+#endif
 	priv->rf_set_chan = rtl8192_phy_SwChnl;	
 }	
 
@@ -14562,6 +14618,9 @@ static void *rtl8192_usb_probe(struct usb_device *udev,
 	struct r8192_priv *priv= NULL;
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2,5,0)
 	struct usb_device *udev = interface_to_usbdev(intf);
+#endif
+#ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
+	int i;
 #endif
         RT_TRACE(COMP_INIT, "Oops: i'm coming\n");
 
@@ -14677,6 +14736,15 @@ fail:
 #endif
 	if(dev){
 		//unregister_netdev(dev);
+		// the pools are on skb_pool_list and point back at dev */
+		skb_pool_destroy(priv->rx_pool);
+		priv->rx_pool = NULL;
+#ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
+		for(i = 0; i <= VO_QUEUE; i++) {
+			skb_pool_destroy(priv->tx_agg_pool[i]);
+			priv->tx_agg_pool[i] = NULL;
+		}
+#endif
 		free_rtllib(dev);
 	}
 		
@@ -14747,6 +14815,9 @@ static void rtl8192_usb_disconnect(struct usb_device *udev, void *ptr)
 #endif
 	
 	struct r8192_priv *priv = rtllib_priv(dev);
+#ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
+	int i;
+#endif
  	if(dev){
 		
 		unregister_netdev(dev);
@@ -14780,6 +14851,14 @@ static void rtl8192_usb_disconnect(struct usb_device *udev, void *ptr)
 		//rtl8192_reset(dev);
 		mdelay(10);
 
+		skb_pool_destroy(priv->rx_pool);
+		priv->rx_pool = NULL;
+#ifdef USB_TX_DRIVER_AGGREGATION_ENABLE
+		for(i = 0; i <= VO_QUEUE; i++) {
+			skb_pool_destroy(priv->tx_agg_pool[i]);
+			priv->tx_agg_pool[i] = NULL;
+		}
+#endif
 		free_rtllib(dev);
 	}
 
@@ -24,6 +24,7 @@
 #define TS_ADDBA_DELAY		60
 
 #define TOTAL_TS_NUM		16
+#define REORDER_WIN_SIZE	128	// Rx reorder ring, a power of two dividing 4096
 #define TCLAS_NUM		4
 
 // This define the Tx/Rx directions
@@ -61,7 +62,8 @@ typedef struct _RX_TS_RECORD {
 	TS_COMMON_INFO		TsCommonInfo;
 	u16				RxIndicateSeq;
 	u16				RxTimeoutIndicateSeq;
-	struct list_head		RxPendingPktList;
+	struct rtllib_rxb*		RxReorderBuf[REORDER_WIN_SIZE];	// Indexed by SeqNum % REORDER_WIN_SIZE
+	u8				RxReorderPendingCnt;
 	struct timer_list		RxPktPendingTimer;
 	BA_RECORD			RxAdmittedBARecord;	 // For BA Recepient
 	u16				RxLastSeqNum;
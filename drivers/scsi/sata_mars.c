@@ -6,6 +6,7 @@
 #include <linux/blkdev.h>
 #include <linux/delay.h>
 #include <linux/interrupt.h>
+#include <linux/async.h>
 #include "scsi.h"
 #include <scsi/scsi_host.h>
 #include <linux/libata.h>
@@ -1393,55 +1394,70 @@ show_wait_insmod_state_field(struct bus_type *bus, char *buf)
 }
 static BUS_ATTR(wait_insmod_state, S_IRUGO | S_IWUSR, show_wait_insmod_state_field, NULL);
 
-static int __init mars_init(void)
+static unsigned int sata_registered;
+
+/*
+ * Registering the driver probes the host, which resets both ports and
+ * waits for the links to come up. Do that asynchronously so the rest of
+ * the boot goes on meanwhile; wait_insmod_state reports mod_state once
+ * it is done, and the kernel waits for it before mounting the root fs.
+ */
+static void __init mars_init_async(void *data, async_cookie_t cookie)
 {
     int error;
 
-    printk(KERN_INFO"sata driver initial...2009/11/09 10:30\n");
-    error = bus_register(&sata_bus_type);
+    error = device_register(&sata_sb1);
     if (error)
-        goto err_bus_fail;
-    else {
-        bus_create_file(&sata_bus_type, &bus_attr_scan_dev);
-        bus_create_file(&sata_bus_type, &bus_attr_offline_dev);
-        bus_create_file(&sata_bus_type, &bus_attr_wait_insmod_state);
-        error = device_register(&sata_sb1);
-        if (error)
-            goto err_device_fail;
-        else{
-            error = driver_register(&sata_driver);
-            if (error)
-                goto err_driver_fail;
-        }
-    }
+        goto err_device_fail;
+
+    error = driver_register(&sata_driver);
+    if (error)
+        goto err_driver_fail;
+
+    sata_registered = 1;
     goto finish_out;
 
 err_driver_fail:
     printk(KERN_INFO"sata driver insert fail.\n");
-    driver_unregister(&sata_driver);
+    device_unregister(&sata_sb1);
 
 err_device_fail:
     printk(KERN_INFO"sata device insert fail.\n");
-    device_unregister(&sata_sb1);
-    bus_remove_file(&sata_bus_type, &bus_attr_scan_dev);
-    bus_remove_file(&sata_bus_type, &bus_attr_offline_dev);
-    bus_remove_file(&sata_bus_type, &bus_attr_wait_insmod_state);
-
-err_bus_fail:
-    printk(KERN_INFO"sata bus insert fail.\n");
-    bus_unregister(&sata_bus_type);
 
 finish_out:
     mod_state=0x1;
-    return error;
+}
+
+static int __init mars_init(void)
+{
+    int error;
+
+    printk(KERN_INFO"sata driver initial...2009/11/09 10:30\n");
+    error = bus_register(&sata_bus_type);
+    if (error) {
+        printk(KERN_INFO"sata bus insert fail.\n");
+        return error;
+    }
 
+    bus_create_file(&sata_bus_type, &bus_attr_scan_dev);
+    bus_create_file(&sata_bus_type, &bus_attr_offline_dev);
+    bus_create_file(&sata_bus_type, &bus_attr_wait_insmod_state);
+
+    async_schedule(mars_init_async, NULL);
+
+    return 0;
 }
 
 static void __exit mars_exit(void)
 {
     printk(KERN_INFO"%s(%d)\n",__func__,__LINE__);
-    driver_unregister(&sata_driver);
-    device_unregister(&sata_sb1);
+    if (sata_registered) {
+        driver_unregister(&sata_driver);
+        device_unregister(&sata_sb1);
+    }
+    bus_remove_file(&sata_bus_type, &bus_attr_scan_dev);
+    bus_remove_file(&sata_bus_type, &bus_attr_offline_dev);
+    bus_remove_file(&sata_bus_type, &bus_attr_wait_insmod_state);
     bus_unregister(&sata_bus_type);
 
 }
@@ -289,6 +289,27 @@ sc_buff* ops_read(scd_device* dev)
     mars_scd* p_this = (mars_scd*) scd_get_drvdata(dev);
     return p_this->read(p_this);
 }                                 
+
+
+
+/*------------------------------------------------------------------
+ * Func : ops_recv
+ *
+ * Desc : receive data via smart card bus
+ *
+ * Parm : dev     : 
+ *        buf     : receive buffer
+ *        len     : number of bytes to receive
+ *        timeout : max waiting time (in ms)
+ *         
+ * Retn : number of bytes received, negative for error
+ *------------------------------------------------------------------*/        
+static 
+int ops_recv(scd_device* dev, unsigned char* buf, unsigned int len, unsigned long timeout)
+{   
+    mars_scd* p_this = (mars_scd*) scd_get_drvdata(dev);
+    return p_this->recv(p_this, buf, len, timeout);
+}                                 
                                                                   
 
 static scd_device mars_scd_controller[2] = 
@@ -322,6 +343,7 @@ static scd_driver mars_scd_driver =
     .poll_card_status   = ops_poll_card_status,
     .xmit               = ops_xmit,
     .read               = ops_read,
+    .recv               = ops_recv,
 };
 
 
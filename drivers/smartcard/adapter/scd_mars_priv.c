@@ -76,11 +76,13 @@ static const unsigned long          MIS_SC_ISR[]={MIS_SC0_INT, MIS_SC1_INT};
 #define MAX_SC_CLK                   8500000
 #define MIN_SC_CLK                   1000000
 	
-#define ISR_POLLING
+//#define ISR_POLLING                 // data transfer relies on fifo interrupts
 	
 #define ISR_POLLING_INTERVAL        (HZ)
 
+#ifdef ISR_POLLING
 static void mars_scd_timer(unsigned long arg);
+#endif
 
 
 
@@ -137,6 +139,7 @@ int mars_scd_set_state(
         
         SET_SCIRER(id, SC_CPRES_INT    | 
                        SC_ATRS_INT     | 
+                       SC_RCV_INT      | 
                        SC_RXP_INT      | 
                        SC_RX_FOVER_INT);
                        
@@ -155,6 +158,13 @@ int mars_scd_set_state(
         
     case IFD_FSM_ACTIVE:    
         SC_INFO("SC%d - FSM = ACTIVATE\n", id);
+        p_this->rx_head = 0;
+        p_this->rx_tail = 0;
+        p_this->rx_err  = 0;
+        SET_SCIRER(id, SC_CPRES_INT    | 
+                       SC_RCV_INT      | 
+                       SC_RXP_INT      | 
+                       SC_RX_FOVER_INT);
         break;
     default:
     case IFD_FSM_UNKNOWN:
@@ -163,6 +173,8 @@ int mars_scd_set_state(
     
     p_this->fsm = fsm;             
     
+    wake_up(&p_this->rx_wait);      // readers should check the new state
+    
     return 0;
 }
 
@@ -250,10 +262,66 @@ err_atr_failed:
 
 
 
+/*------------------------------------------------------------------
+ * Func : mars_scd_tx_fill
+ *
+ * Desc : move data of the current frame to tx fifo
+ *
+ * Parm : p_this : handle of mars scd 
+ *         
+ * Retn : N/A  
+ *------------------------------------------------------------------*/
+static void mars_scd_tx_fill(mars_scd* p_this)
+{
+    unsigned char id = p_this->id;
+    sc_buff* scb = p_this->tx_scb;
+    
+    while (scb->len && GET_SC_TXLENR(id) < TX_RING_LENGTH)
+    {
+        SET_SC_TXFIFO(id, scb->data[0]);
+        scb_pull(scb, 1);
+    }
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : mars_scd_rx_drain
+ *
+ * Desc : move received data from rx fifo to rx buffer
+ *
+ * Parm : p_this : handle of mars scd 
+ *         
+ * Retn : N/A  
+ *------------------------------------------------------------------*/
+static void mars_scd_rx_drain(mars_scd* p_this)
+{
+    unsigned char id = p_this->id;
+    unsigned char data;
+    unsigned int  next;
+    
+    while (GET_SC_RXLENR(id))
+    {
+        data = (unsigned char) GET_SC_RXFIFO(id);
+        next = (p_this->rx_tail + 1) & (RX_BUFF_SIZE - 1);
+        
+        if (next == p_this->rx_head)
+        {
+            p_this->rx_err = 1;         // overrun, drop it
+            continue;
+        }
+        
+        p_this->rx_buff[p_this->rx_tail] = data;
+        p_this->rx_tail = next;
+    }
+}
+
+
+
 /*------------------------------------------------------------------
  * Func : mars_scd_fsm_active
  *
- * Desc : 
+ * Desc : handle data transfer of an activated card
  *
  * Parm : p_this : handle of mars cec 
  *         
@@ -263,14 +331,43 @@ void mars_scd_fsm_active(mars_scd* p_this)
 {
     unsigned char id = p_this->id;
     unsigned long status = GET_SCIRSR(id);
+    sc_buff* scb;
     
 	if (mars_scd_card_detect(p_this)==0)
     {                		                    	    
 		mars_scd_set_state(p_this, IFD_FSM_IDEL);	    
 		goto end_proc;
 	}
+	
+	spin_lock(&p_this->lock);
+	
+	if (status & (SC_RXP_INT | SC_RX_FOVER_INT))
+	    p_this->rx_err = 1;
 		
-	//-----------------
+	mars_scd_rx_drain(p_this);
+	
+	if ((scb = p_this->tx_scb))
+	{
+	    if (scb->len && (status & (SC_TXEMPTY_INT | SC_TXDONE_INT)))
+	    {
+	        mars_scd_tx_fill(p_this);
+	        
+	        if (status & SC_TXDONE_INT)         // fifo ran dry, restart it
+	            SET_SCCR(id, GET_SCCR(id) | SC_TX_GO(1));
+	    }
+	    else if (!scb->len && (status & SC_TXDONE_INT))
+	    {
+	        SET_SCIRER(id, GET_SCIRER(id) & ~(SC_TXEMPTY_INT | SC_TXDONE_INT));
+	        p_this->tx_scb = NULL;
+	        scb->status = XMIT_OK;
+	        complete(&scb->complete);
+	    }
+	}
+	
+	spin_unlock(&p_this->lock);
+	
+	if (p_this->rx_head != p_this->rx_tail || p_this->rx_err)
+	    wake_up(&p_this->rx_wait);
 	
 end_proc:
 	SET_SCIRSR(id, status);
@@ -291,7 +388,7 @@ void mars_scd_work(mars_scd* p_this)
     unsigned char id = p_this->id;
     unsigned long status = GET_SCIRSR(id);
 
-    SC_INFO("SC%d - work!!\n", p_this->id);    			
+    SC_INT_DGB("SC%d - work!!\n", p_this->id);    			
     
 	if (status & SC_CPRES_INT)            
 	{           
@@ -367,7 +464,7 @@ mars_scd_isr(
                    
     unsigned long event = GET_MIS_ISR() & MIS_SC_ISR[p_this->id];            
 
-    SC_INT_DBG("MIS ISR=%08x\n",GET_MIS_ISR());            
+    SC_INT_DGB("MIS ISR=%08lx\n",GET_MIS_ISR());            
     
     if (!event)
         return IRQ_NONE;
@@ -423,7 +520,7 @@ int mars_scd_set_clock(mars_scd* p_this, unsigned long clk)
 {
     unsigned char id = p_this->id;
     unsigned long val; 
-    unsigned long div = SYSTEM_CLK / clk / p_this->clock_div;    
+    unsigned long div;
 	    
     if (clk > MAX_SC_CLK)
     {
@@ -437,11 +534,17 @@ int mars_scd_set_clock(mars_scd* p_this, unsigned long clk)
         clk = MIN_SC_CLK;
     }
     
+    // round up, the card clock must not exceed the requested one
+    div = (SYSTEM_CLK / p_this->clock_div + clk - 1) / clk;
+    
+    if (div > 0xFF)
+        div = 0xFF;
+    
     p_this->pre_clock_div = div;    
     
     val  = GET_SCFP(id) & ~SC_PRE_CLKDIV_MASK;
     
-    val |= SC_PRE_CLKDIV(p_this->pre_clock_div);
+    val |= SC_PRE_CLKDIV((p_this->pre_clock_div-1));
     
     SET_SCFP(id, val);
     
@@ -481,9 +584,16 @@ int mars_scd_set_etu(mars_scd* p_this, unsigned long etu)
 {
     unsigned char id = p_this->id;   
     unsigned long val; 
+    unsigned long div1 = etu * p_this->clock_div / 31;
+    
+    if (div1 < 1 || div1 > 256)
+    {
+        SC_WARNING("ETU = %lu out of range\n", etu);
+        return -1;
+    }
                
     p_this->baud_div2 = 31;         // to simplify, we always set the baud div2 to 31
-    p_this->baud_div1 = etu * p_this->clock_div / p_this->baud_div2;     
+    p_this->baud_div1 = div1;     
     val = GET_SCFP(id) & ~SC_BAUDDIV_MASK;    
         
     val |= SC_BAUDDIV1((p_this->baud_div1-1)) | SC_BAUDDIV2(0);    
@@ -530,10 +640,8 @@ int mars_scd_set_parity(mars_scd* p_this, unsigned char parity)
                
     p_this->parity = (parity) ? 1 : 0;                                 
     
-    if (p_this->fsm==IFD_FSM_DISABLE)
-        val = SC_FIFO_RST(0) | SC_SCEN(1) | SC_AUTO_ATR(1) | SC_CONV(0);
-    else
-        val = SC_FIFO_RST(0) | SC_SCEN(1) | SC_AUTO_ATR(1) | SC_CONV(0);            
+    // keep reset / enable state of the card untouched
+    val = GET_SCCR(id) & ~(SC_FIFO_RST(1) | SC_TX_GO(1) | SC_PS(1));
         
     SET_SCCR(id, val | SC_PS(p_this->parity));
     return 0;
@@ -724,7 +832,8 @@ int mars_scd_poll_card_status(mars_scd* p_this)
 /*------------------------------------------------------------------
  * Func : mars_scd_xmit
  *
- * Desc : xmit data via smart card bus
+ * Desc : xmit data via smart card bus. The tx fifo is refilled from 
+ *        interrupt when it runs empty, so the frame could be any length.
  *
  * Parm : p_this   : handle of mars scd  
  *        scb      : data to be xmit
@@ -734,51 +843,129 @@ int mars_scd_poll_card_status(mars_scd* p_this)
 int mars_scd_xmit(mars_scd* p_this, sc_buff* scb)
 {    
     unsigned char id = p_this->id;    
-    int i;
-    		
-	SET_SCCR(id, GET_SCCR(id) | SC_FIFO_RST(1));     // Reset RX FIFO		
-		
-    if (scb->len <= 32)		
+    unsigned long clk;
+    unsigned long etu;
+    unsigned long timeout;
+    unsigned long flags;
+    
+    if (p_this->fsm != IFD_FSM_ACTIVE)
     {
-        // fill data to fifo
-        for(i = 0; i < scb->len; i++)                
-			SET_SC_TXFIFO(id, scb->data[i]);				        
-		
-		SC_WARNING("[SC%d] TX FIFO LEN = %ul\n", GET_SC_TXLENR(id));
-		
-		scb_pull(scb, scb->len);
-				
-		SET_SCCR(id, GET_SCCR(id) | SC_TX_GO(1));          // Start Xmit
-    }
-    else
-    {    				
-        SC_WARNING("[SC%d] not supports sending data more than 32 bytes\n", id);
+        SC_WARNING("[SC%d] xmit failed, ICC is not activated\n", id);
         return -1;
-        /*        
-		i=0;
-		isTX = 0;
-		while (i < scb->len)
-		{				
-            i++;				
-            rtd_outl(SC_BASE+SCTXFIFO, *(cardBuffer++));    // put data to tx fifo			
-			
-			if (i==32 && isTX == 0)  //TX GO	
-			{ 
-				//printk("TX GO at %d.\n", i);
-				isTX = 1;
-				rtd_outl(SC_BASE+SCCR,(SC_TX_GO | SC_ENABLE | (temp&0x0fffffff)));	
-			}
-		} 
-		*/   	
-    }	
-
-	msleep(5);
+    }
+    
+    if (!scb->len)
+        return 0;
+    
+    // 12 etu per character at least, plus margin
+    p_this->get_clock(p_this, &clk);
+    p_this->get_etu(p_this, &etu);
+    timeout = (scb->len + 1) * 12 * etu / (clk / 1000) + 100;
+    
+    init_completion(&scb->complete);
+    scb->status = WAIT_XMIT;
+    
+    spin_lock_irqsave(&p_this->lock, flags);
+    
+	SET_SCCR(id, GET_SCCR(id) | SC_FIFO_RST(1));     // Reset RX FIFO		
+	
+	p_this->rx_head = 0;
+	p_this->rx_tail = 0;
+	p_this->rx_err  = 0;
+	p_this->tx_scb  = scb;
+	
+	mars_scd_tx_fill(p_this);
+	
+	SET_SCIRSR(id, SC_TXEMPTY_INT | SC_TXDONE_INT);
+	SET_SCCR  (id, GET_SCCR(id) | SC_TX_GO(1));          // Start Xmit
+	SET_SCIRER(id, GET_SCIRER(id) | SC_TXEMPTY_INT | SC_TXDONE_INT);
+	
+	spin_unlock_irqrestore(&p_this->lock, flags);
+	
+	if (!wait_for_completion_timeout(&scb->complete, msecs_to_jiffies(timeout)))
+	{
+	    spin_lock_irqsave(&p_this->lock, flags);
+	    
+	    SET_SCIRER(id, GET_SCIRER(id) & ~(SC_TXEMPTY_INT | SC_TXDONE_INT));
+	    p_this->tx_scb = NULL;
+	    
+	    spin_unlock_irqrestore(&p_this->lock, flags);
+	    
+	    if (scb->status == WAIT_XMIT)
+	    {
+	        scb->status = XMIT_TIMEOUT;
+	        SC_WARNING("[SC%d] xmit timeout, %d bytes left\n", id, scb->len);
+	        return -1;
+	    }
+	}
 	
 	return 0;
 }                        
 
 
 
+/*------------------------------------------------------------------
+ * Func : mars_scd_recv
+ *
+ * Desc : receive data via smart card bus
+ *
+ * Parm : p_this   : handle of mars scd   
+ *        buf      : receive buffer
+ *        len      : number of bytes to receive
+ *        timeout  : max waiting time (in ms)
+ *         
+ * Retn : number of bytes received, negative for error
+ *------------------------------------------------------------------*/        
+int mars_scd_recv(
+    mars_scd*               p_this, 
+    unsigned char*          buf, 
+    unsigned int            len, 
+    unsigned long           timeout
+    )
+{    
+    unsigned long expire = jiffies + msecs_to_jiffies(timeout);
+    unsigned long flags;
+    unsigned int  n = 0;
+    unsigned char err;
+    long          left;
+    
+    for (;;)
+    {
+        spin_lock_irqsave(&p_this->lock, flags);
+        
+        while (n < len && p_this->rx_head != p_this->rx_tail)
+        {
+            buf[n++] = p_this->rx_buff[p_this->rx_head];
+            p_this->rx_head = (p_this->rx_head + 1) & (RX_BUFF_SIZE - 1);
+        }
+        
+        err = p_this->rx_err;
+        p_this->rx_err = 0;
+        
+        spin_unlock_irqrestore(&p_this->lock, flags);
+        
+        if (err)
+            return -EIO;
+            
+        left = (long) (expire - jiffies);
+        
+        if (n == len || left <= 0)
+            break;
+            
+        if (p_this->fsm != IFD_FSM_ACTIVE)
+            return -ENODEV;
+            
+        wait_event_timeout(p_this->rx_wait, 
+                           p_this->rx_head != p_this->rx_tail || 
+                           p_this->rx_err || 
+                           p_this->fsm != IFD_FSM_ACTIVE,
+                           left);
+    }
+    
+    return n;
+}
+
+
 
 /*------------------------------------------------------------------
  * Func : mars_scd_read
@@ -791,23 +978,31 @@ int mars_scd_xmit(mars_scd* p_this, sc_buff* scb)
  *------------------------------------------------------------------*/        
 sc_buff* mars_scd_read(mars_scd* p_this)
 {    
-    unsigned char id = p_this->id;        
-    sc_buff* scb = NULL;    
-    int len, i;
+    sc_buff* scb;    
+    int len;
             
-    SC_WARNING("RX LEN = %lu\n", GET_SC_RXLENR(id));
+    len = (p_this->rx_tail - p_this->rx_head) & (RX_BUFF_SIZE - 1);
+    
+    if (!len)
+        return NULL;
           
-    if ((len=GET_SC_RXLENR(id))>0)
+    scb = alloc_scb(len);
+    
+    if (!scb)
     {
-        scb = alloc_scb(len);
-        if (!scb)
-            SC_WARNING("read failed, alloc_scb failed\n");
-                    
-        for(i = 0; i < len; i++)
-			scb->data[i] = (unsigned char) GET_SC_RXFIFO(id);
-			
-        scb_put(scb, len);
+        SC_WARNING("read failed, alloc_scb failed\n");
+        return NULL;
     }
+    
+    len = mars_scd_recv(p_this, scb->data, len, 0);
+    
+    if (len < 0)
+    {
+        kfree_scb(scb);
+        return NULL;
+    }
+    
+    scb_put(scb, len);
 
     return scb;
 }
@@ -843,6 +1038,8 @@ mars_scd* mars_scd_open(unsigned char id)
         p_this->fsm              = IFD_FSM_UNKNOWN;
         p_this->atr.length       = 0;        
         init_completion(&p_this->card_detect_completion);                        
+        spin_lock_init(&p_this->lock);
+        init_waitqueue_head(&p_this->rx_wait);
         
         // configurations ---
     	p_this->clock_div        = 1;         
@@ -865,6 +1062,7 @@ mars_scd* mars_scd_open(unsigned char id)
         p_this->get_atr          = mars_scd_get_atr;                
         p_this->xmit             = mars_scd_xmit;
         p_this->read             = mars_scd_read;             
+        p_this->recv             = mars_scd_recv;
         p_this->get_card_status  = mars_scd_card_detect;
         p_this->poll_card_status = mars_scd_poll_card_status;   	                			                                        
         
@@ -911,7 +1109,8 @@ mars_scd* mars_scd_open(unsigned char id)
         if (request_irq(MISC_IRQ, mars_scd_isr, SA_INTERRUPT | SA_SHIRQ, "MARS SCD", p_this) < 0) 
         {
             SC_WARNING("scd : open mars scd failed, unable to request irq#%d\n", MISC_IRQ);	    		
-            return -1;
+            kfree(p_this);
+            return NULL;
         }        
 #endif                
         
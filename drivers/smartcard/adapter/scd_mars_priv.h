@@ -4,6 +4,7 @@
 #include <linux/wait.h>
 #include <linux/timer.h>
 #include <linux/completion.h>
+#include <linux/spinlock.h>
 #include "../core/scd.h"
 #include "../core/scd_atr.h"
 
@@ -13,6 +14,7 @@
 #define MISC_IRQ        3
 #define RX_RING_LENGTH  32
 #define TX_RING_LENGTH  32
+#define RX_BUFF_SIZE    512             // software rx buffer, must be power of 2
 
 
 typedef enum {    
@@ -52,6 +54,15 @@ struct mars_scd_tag
 	
 	struct completion  m_card_status_change;    
 	
+	// data transfer
+	spinlock_t          lock;
+	sc_buff*            tx_scb;             // frame being xmitted
+	unsigned char       rx_buff[RX_BUFF_SIZE];
+	unsigned int        rx_head;
+	unsigned int        rx_tail;
+	unsigned char       rx_err;             // parity error / overrun
+	wait_queue_head_t   rx_wait;
+	
 	int (*enable)           (mars_scd* p_this, unsigned char on_off);    	
 	int (*set_clock)        (mars_scd* p_this, unsigned long clock);
 	int (*set_etu)          (mars_scd* p_this, unsigned long etu);
@@ -69,6 +80,7 @@ struct mars_scd_tag
     int (*poll_card_status) (mars_scd* p_this);
     int (*xmit)             (mars_scd* p_this, sc_buff* p_data);    		    
     sc_buff* (*read)        (mars_scd* p_this);
+    int (*recv)             (mars_scd* p_this, unsigned char* buf, unsigned int len, unsigned long timeout);
 };
 
 
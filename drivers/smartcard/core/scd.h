@@ -2,6 +2,7 @@
 #define __SCD_H__
 
 #include <linux/device.h>
+#include <asm/semaphore.h>
 #include "scd_debug.h"
 #include "scd_atr.h"
 #include "scd_buff.h"
@@ -9,6 +10,24 @@
 extern struct bus_type scd_bus_type;
 
 
+//-------------------------------------------------------
+// protocol
+//-------------------------------------------------------
+typedef struct 
+{
+    struct semaphore    sem;        // serialize exchanges with the card
+    unsigned char       protocol;   // T=0 / T=1
+    unsigned char       ifsc;       // T=1 : max INF size of the card
+    unsigned char       ifsd;       // T=1 : max INF size of the reader
+    unsigned char       edc;        // T=1 : 0 : LRC, 1 : CRC
+    unsigned char       ns;         // T=1 : send sequence number
+    unsigned char       nr;         // T=1 : receive sequence number
+    unsigned long       wwt;        // T=0 : work waiting time (ms)
+    unsigned long       bwt;        // T=1 : block waiting time (ms)
+    unsigned long       cwt;        // T=1 : character waiting time (ms)
+}scd_proto;
+
+
 //-------------------------------------------------------
 // device
 //-------------------------------------------------------
@@ -17,6 +36,7 @@ typedef struct
     unsigned long   id;
     char*           name;
     struct device   dev;
+    scd_proto       proto;
 }scd_device;
 
 
@@ -87,6 +107,11 @@ typedef struct
                                  sc_buff*           p_data);    
     
     sc_buff* (*read)            (scd_device*        dev);   
+    
+    int     (*recv)             (scd_device*        dev, 
+                                 unsigned char*     buf,
+                                 unsigned int       len,
+                                 unsigned long      timeout);   // in ms
     //--------- power management ------------
     int     (*suspend)          (scd_device* dev);
     
@@ -100,6 +125,15 @@ typedef struct
 extern int  register_scd_driver(scd_driver* driver);
 extern void unregister_scd_driver(scd_driver* driver);
 
+//-------------------------------------------------------
+// protocol (scd_proto.c)
+//-------------------------------------------------------
+extern void scd_proto_init(scd_device* dev);
+extern int  scd_negotiate(scd_device* dev);
+extern int  scd_transceive(scd_device* dev, 
+                           const unsigned char* tx, unsigned int tx_len, 
+                           unsigned char* rx, unsigned int rx_size);
+
 //-------------------Error Code
 /* scd error code definition */
 typedef enum {
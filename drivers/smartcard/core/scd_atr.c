@@ -158,7 +158,7 @@ int decompress_atr(scd_atr* p_atr, scd_atr_info* p_info)
         SC_ATR_DBG(" %02x\n", p_atr->data[i]);
 #endif
         
-    memset(p_info, 0, sizeof(p_info));
+    memset(p_info, 0, sizeof(*p_info));
             
     p_info->TS = p_atr->data[id++];
         
@@ -220,8 +220,166 @@ void init_atr(scd_atr* p_atr)
 }
 
 
+/*------------------------------------------------------------------
+ * Func : atr_fi / atr_di / atr_fmax
+ *
+ * Desc : decode clock rate conversion factor, baud rate adjustment 
+ *        factor and maximum clock of TA1 (ISO 7816-3 table 7/8)
+ *
+ * Parm : ta1 : TA1 of the ATR
+ *         
+ * Retn : value, 0 for RFU
+ *------------------------------------------------------------------*/
+unsigned int atr_fi(unsigned char ta1)
+{
+    static const unsigned short fi[16] = {
+        372, 372, 558, 744, 1116, 1488, 1860, 0,
+        0,   512, 768, 1024, 1536, 2048, 0,   0 };
+        
+    return fi[(ta1 >> 4) & 0xF];
+}
+
+
+unsigned int atr_di(unsigned char ta1)
+{
+    static const unsigned char di[16] = {
+        0,  1,  2,  4,  8,  16, 32, 64,
+        12, 20, 0,  0,  0,  0,  0,  0 };
+        
+    return di[ta1 & 0xF];
+}
+
+
+unsigned long atr_fmax(unsigned char ta1)
+{
+    static const unsigned long fmax[16] = {
+        4000000,  5000000,  6000000, 8000000, 12000000, 16000000, 20000000, 0,
+        0,        5000000,  7500000, 10000000, 15000000, 20000000, 0,       0 };
+        
+    return fmax[(ta1 >> 4) & 0xF];
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : atr_get_ta1
+ *
+ * Desc : get TA1 of the ATR
+ *
+ * Parm : p_info : decompressed atr
+ *         
+ * Retn : TA1, ATR_TA1_DEFAULT if absent
+ *------------------------------------------------------------------*/
+unsigned char atr_get_ta1(const scd_atr_info* p_info)
+{
+    return (p_info->T0 & 0x10) ? p_info->T1[0] : ATR_TA1_DEFAULT;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : atr_get_protocol
+ *
+ * Desc : get first offered protocol (T) of the ATR
+ *
+ * Parm : p_info : decompressed atr
+ *         
+ * Retn : protocol type
+ *------------------------------------------------------------------*/
+int atr_get_protocol(const scd_atr_info* p_info)
+{
+    return (p_info->T0 & 0x80) ? (p_info->T1[3] & 0xF) : 0;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : atr_is_specific_mode
+ *
+ * Desc : check if the card is in specific mode (TA2 present), 
+ *        PPS is not allowed in specific mode
+ *
+ * Parm : p_info : decompressed atr
+ *         
+ * Retn : 1 : specific mode, 0 : negotiable mode
+ *------------------------------------------------------------------*/
+int atr_is_specific_mode(const scd_atr_info* p_info)
+{
+    return ((p_info->T0 & 0x80) && (p_info->T1[3] & 0x10)) ? 1 : 0;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : atr_get_wi / ifsc / bwi / cwi / edc
+ *
+ * Desc : get protocol parameters of the ATR, default values are 
+ *        returned for the absent interface bytes
+ *
+ * Parm : p_info : decompressed atr
+ *         
+ * Retn : value of the parameter
+ *------------------------------------------------------------------*/
+unsigned char atr_get_wi(const scd_atr_info* p_info)
+{
+    // TC2 : waiting time integer of T=0
+    if ((p_info->T0 & 0x80) && (p_info->T1[3] & 0x40) && p_info->T2[2])
+        return p_info->T2[2];
+        
+    return 10;
+}
+
+
+static inline int atr_has_t1_bytes(const scd_atr_info* p_info, unsigned char mask)
+{
+    // TA3/TB3/TC3 are T=1 specific if TD2 indicates T=1
+    return ((p_info->T0 & 0x80) && (p_info->T1[3] & 0x80) && 
+            ((p_info->T2[3] & 0xF)==1) && (p_info->T2[3] & mask)) ? 1 : 0;
+}
+
+
+unsigned char atr_get_ifsc(const scd_atr_info* p_info)
+{
+    if (atr_has_t1_bytes(p_info, 0x10) && p_info->T3[0] && p_info->T3[0]!=0xFF)
+        return p_info->T3[0];
+        
+    return 32;
+}
+
+
+unsigned char atr_get_bwi(const scd_atr_info* p_info)
+{
+    return atr_has_t1_bytes(p_info, 0x20) ? ((p_info->T3[1] >> 4) & 0xF) : 4;
+}
+
+
+unsigned char atr_get_cwi(const scd_atr_info* p_info)
+{
+    return atr_has_t1_bytes(p_info, 0x20) ? (p_info->T3[1] & 0xF) : 13;
+}
+
+
+int atr_get_edc(const scd_atr_info* p_info)
+{
+    // 0 : LRC, 1 : CRC
+    return atr_has_t1_bytes(p_info, 0x40) ? (p_info->T3[2] & 0x1) : 0;
+}
+
+
+
 EXPORT_SYMBOL(init_atr);
 EXPORT_SYMBOL(decompress_atr);
 EXPORT_SYMBOL(is_atr_complete);
+EXPORT_SYMBOL(atr_fi);
+EXPORT_SYMBOL(atr_di);
+EXPORT_SYMBOL(atr_fmax);
+EXPORT_SYMBOL(atr_get_ta1);
+EXPORT_SYMBOL(atr_get_protocol);
+EXPORT_SYMBOL(atr_is_specific_mode);
+EXPORT_SYMBOL(atr_get_wi);
+EXPORT_SYMBOL(atr_get_ifsc);
+EXPORT_SYMBOL(atr_get_bwi);
+EXPORT_SYMBOL(atr_get_cwi);
+EXPORT_SYMBOL(atr_get_edc);
 
 
@@ -50,6 +50,23 @@ extern int  is_atr_complete(scd_atr* p_atr);
 extern int  decompress_atr(scd_atr* p_atr, scd_atr_info* p_info);
 extern void init_atr(scd_atr* p_atr);
 
+//-------------------------------------------------------
+// interface bytes
+//-------------------------------------------------------
+#define ATR_TA1_DEFAULT     0x11        // Fi = 372, Di = 1, f max = 5 MHz
+
+extern unsigned int  atr_fi(unsigned char ta1);
+extern unsigned int  atr_di(unsigned char ta1);
+extern unsigned long atr_fmax(unsigned char ta1);
+extern unsigned char atr_get_ta1(const scd_atr_info* p_info);
+extern int  atr_get_protocol(const scd_atr_info* p_info);
+extern int  atr_is_specific_mode(const scd_atr_info* p_info);
+extern unsigned char atr_get_wi(const scd_atr_info* p_info);
+extern unsigned char atr_get_ifsc(const scd_atr_info* p_info);
+extern unsigned char atr_get_bwi(const scd_atr_info* p_info);
+extern unsigned char atr_get_cwi(const scd_atr_info* p_info);
+extern int  atr_get_edc(const scd_atr_info* p_info);
+
 #define SC_ATR_DBG          printk
 
 #endif  //__SCD_ATR_H__
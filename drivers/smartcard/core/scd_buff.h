@@ -24,7 +24,7 @@ typedef struct {
     unsigned char*      data;          
     unsigned char*      tail;          
     unsigned char*      end;    
-    unsigned char       len;        
+    unsigned int        len;        
 }sc_buff;
 
 
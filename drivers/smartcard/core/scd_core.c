@@ -125,6 +125,8 @@ int register_scd_device(scd_device* device)
     
     dev->release  = scd_device_release;                    
     
+    scd_proto_init(device);
+    
     return device_register(dev);
 }
 
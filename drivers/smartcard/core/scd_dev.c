@@ -10,6 +10,7 @@
 #include <linux/fs.h>
 #include <linux/cdev.h>
 #include <linux/devfs_fs_kernel.h>
+#include <asm/uaccess.h>
 #include "scd.h"
 #include "scd_dev.h"
 
@@ -143,6 +144,60 @@ int scd_dev_release(
 
 
 
+/*------------------------------------------------------------------
+ * Func : scd_dev_transceive
+ *
+ * Desc : exchange an APDU with the card
+ *
+ * Parm : dev    : scd device
+ *        p_apdu : apdu buffer descriptor from user space
+ *         
+ * Retn : length of response APDU, negative for error
+ *------------------------------------------------------------------*/
+static 
+int scd_dev_transceive(
+    scd_device*             dev,
+    sc_apdu_buff __user*    p_apdu
+    )
+{
+    sc_apdu_buff    apdu;
+    unsigned char*  tx;
+    unsigned char*  rx;
+    int             len;
+    
+    if (copy_from_user(&apdu, p_apdu, sizeof(sc_apdu_buff)))
+        return -EFAULT;
+        
+    if (!apdu.tx_len || apdu.tx_len > SCD_MAX_CAPDU_LEN || apdu.rx_len < 2)
+        return -EINVAL;
+        
+    if (apdu.rx_len > SCD_MAX_RAPDU_LEN)
+        apdu.rx_len = SCD_MAX_RAPDU_LEN;
+    
+    if ((tx = kmalloc(SCD_MAX_CAPDU_LEN + SCD_MAX_RAPDU_LEN, GFP_KERNEL))==NULL)
+        return -ENOMEM;
+        
+    rx = tx + SCD_MAX_CAPDU_LEN;
+    
+    if (copy_from_user(tx, (unsigned char __user *) apdu.p_tx, apdu.tx_len))
+    {
+        len = -EFAULT;
+        goto end_proc;
+    }
+    
+    len = scd_transceive(dev, tx, apdu.tx_len, rx, apdu.rx_len);
+    
+    if (len > 0 && copy_to_user((unsigned char __user *) apdu.p_rx, rx, len))
+        len = -EFAULT;
+    
+end_proc:
+    kfree(tx);
+    return len;
+}
+
+
+
+
 /*------------------------------------------------------------------
  * Func : scd_dev_ioctl
  *
@@ -194,9 +249,24 @@ int scd_dev_ioctl(
         
         return copy_to_user((scd_param __user *)arg, &param, sizeof(scd_param));			
                 
-	case SCD_ACTIVE:                    return drv->activate(dev);
+	case SCD_ACTIVE:                    
+	
+	    if (drv->get_atr(dev, &atr)==0)     // activated already
+	        return 0;
+	    
+	    if (drv->activate(dev))
+	        return -1;
+	        
+	    return scd_negotiate(dev);
+	    
 	case SCD_DEACTIVE:                  return drv->deactivate(dev);	        
-	case SCD_RESET:                     return drv->reset(dev);     	          
+	case SCD_RESET:                     
+	
+	    if (drv->reset(dev))
+	        return -1;
+	        
+	    return scd_negotiate(dev);
+	    
 	case SCD_CARD_DETECT:               return drv->get_card_status(dev);
     case SCD_POLL_CARD_STATUS_CHANGE:   return drv->poll_card_status(dev);
     case SCD_GET_ATR:
@@ -213,18 +283,17 @@ int scd_dev_ioctl(
             
         return 0;
 
+	case SCD_SET_PARAM_USING_ATR:       return scd_negotiate(dev);
+	
     /*
 	case SCD_PARSE_ATR:
 		Scd_ParseATR(cardDev);
 		break;
-	
-		
-	case SCD_SET_PARAM_USING_ATR:
-		scd_info("SCD_SET_PARAM_USING_ATR\n");
-		Scd_SetParametersUsingATR(cardDev);
-		break;
-		
     */
+    
+    case SCD_TRANSCEIVE:
+    
+        return scd_dev_transceive(dev, (sc_apdu_buff __user *) arg);
     		
 	case SCD_READ:			
 	
@@ -265,9 +334,14 @@ int scd_dev_ioctl(
             return -ENOMEM;
             
         if (copy_from_user(scb_put(scb, buff.length), (unsigned char __user *)buff.p_data, buff.length))
+        {
+            kfree_scb(scb);
             return -EFAULT;
-                    
-        return drv->xmit(dev, scb);
+        }
+        
+        len = drv->xmit(dev, scb);
+        kfree_scb(scb);
+        return len;
             
 	default:		
 		return -EFAULT;          
@@ -19,6 +19,10 @@
 #define SCD_GET_STATUS		    0x730c
 #define SCD_CARD_DETECT			0x730d
 #define SCD_POLL_CARD_STATUS_CHANGE	0x730e
+#define SCD_TRANSCEIVE          0x730f
+
+#define SCD_MAX_CAPDU_LEN       261         // CLA INS P1 P2 Lc 255 bytes Le
+#define SCD_MAX_RAPDU_LEN       258         // 256 bytes SW1 SW2
 
 
 
@@ -28,6 +32,14 @@ typedef struct{
 }sc_msg_buff;
 
 
+typedef struct{                
+    unsigned char*  p_tx;               // command APDU
+    unsigned int    tx_len;
+    unsigned char*  p_rx;               // response APDU
+    unsigned int    rx_len;             // size of response buffer
+}sc_apdu_buff;
+
+
 typedef struct{        
     struct cdev     cdev;
     scd_device*     device;
@@ -0,0 +1,935 @@
+/* -------------------------------------------------------------------------
+   scd_proto.c  T=0/T=1 protocol engine and PPS of the smart card core
+   -------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+----------------------------------------------------------------------------*/
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#include <linux/crc-ccitt.h>
+#include "scd.h"
+
+#define SCD_TIME_MARGIN     20          // ms, covers the timer granularity
+
+// T=1 block
+#define T1_MAX_RETRY        3
+#define T1_IFSD             254
+#define T1_BLOCK_SIZE       (3 + 254 + 2)
+
+#define T1_I_BLOCK          0x00
+#define T1_R_BLOCK          0x80
+#define T1_S_BLOCK          0xC0
+#define T1_BLOCK_TYPE(pcb)  (((pcb) & 0x80) ? ((pcb) & 0xC0) : T1_I_BLOCK)
+#define T1_I_NS(pcb)        (((pcb) >> 6) & 0x1)
+#define T1_I_MORE           0x20
+#define T1_R_NR(pcb)        (((pcb) >> 4) & 0x1)
+#define T1_R_EDC_ERR        0x01
+#define T1_R_OTHER_ERR      0x02
+#define T1_S_RESPONSE       0x20
+#define T1_S_TYPE(pcb)      ((pcb) & 0x1F)
+#define T1_S_RESYNCH        0x00
+#define T1_S_IFS            0x01
+#define T1_S_ABORT          0x02
+#define T1_S_WTX            0x03
+
+
+static inline scd_driver* scd_drv(scd_device* dev)
+{
+    return to_scd_driver(dev->dev.driver);
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_proto_init
+ *
+ * Desc : init protocol context of a scd device, default values are
+ *        used until the ATR has been negotiated
+ *
+ * Parm : dev : scd device
+ *
+ * Retn : N/A
+ *------------------------------------------------------------------*/
+void scd_proto_init(scd_device* dev)
+{
+    scd_proto* p = &dev->proto;
+
+    init_MUTEX(&p->sem);
+    p->protocol = 0;
+    p->ifsc     = 32;
+    p->ifsd     = 32;
+    p->edc      = 0;
+    p->ns       = 0;
+    p->nr       = 0;
+    p->wwt      = 1000;
+    p->bwt      = 1600;
+    p->cwt      = 100;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_send / scd_recv
+ *
+ * Desc : send / receive raw characters via the adapter
+ *
+ * Parm : dev     : scd device
+ *        data    : data to send / receive buffer
+ *        len     : number of bytes
+ *        timeout : max time to wait for the data (ms)
+ *
+ * Retn : 0 : success, others fail
+ *------------------------------------------------------------------*/
+static int scd_send(scd_device* dev, const unsigned char* data, unsigned int len)
+{
+    sc_buff* scb = alloc_scb(len);
+    int ret;
+
+    if (!scb)
+        return -ENOMEM;
+
+    memcpy(scb_put(scb, len), data, len);
+
+    ret = scd_drv(dev)->xmit(dev, scb);
+
+    kfree_scb(scb);
+
+    return (ret < 0) ? -EIO : 0;
+}
+
+
+static int scd_recv(scd_device* dev, unsigned char* buf, unsigned int len, unsigned long timeout)
+{
+    scd_driver* drv = scd_drv(dev);
+    int ret;
+
+    if (!drv->recv)
+        return -ENOSYS;
+
+    ret = drv->recv(dev, buf, len, timeout);
+
+    if (ret < 0)
+        return ret;
+
+    return (ret==len) ? 0 : -ETIMEDOUT;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_update_timing
+ *
+ * Desc : compute waiting times of the protocols from the current clock
+ *        and etu of the adapter
+ *
+ * Parm : dev   : scd device
+ *        p_info: decompressed atr
+ *        fi    : clock rate conversion factor in use
+ *
+ * Retn : N/A
+ *------------------------------------------------------------------*/
+static void scd_update_timing(scd_device* dev, const scd_atr_info* p_info, unsigned int fi)
+{
+    scd_proto* p = &dev->proto;
+    scd_param  param;
+    unsigned long khz;
+    unsigned long bwi = atr_get_bwi(p_info);
+    unsigned long cwi = atr_get_cwi(p_info);
+
+    if (scd_drv(dev)->get_param(dev, &param)<0 || param.clk < 1000)
+        return;
+
+    khz = param.clk / 1000;
+
+    // T=0 : WWT = 960 x WI x Fi / f
+    p->wwt = (960UL * atr_get_wi(p_info) * fi) / khz + SCD_TIME_MARGIN;
+
+    // T=1 : BWT = 11 etu + 2^BWI x 960 x 372 / f, CWT = (11 + 2^CWI) etu
+    p->bwt = ((1UL << bwi) * 960 * 372) / khz + (11 * param.etu) / khz + SCD_TIME_MARGIN;
+    p->cwt = ((11 + (1UL << cwi)) * param.etu) / khz + SCD_TIME_MARGIN;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_param_supported
+ *
+ * Desc : check if the adapter can run with the given param exactly,
+ *        the current param is restored
+ *
+ * Parm : dev     : scd device
+ *        p_param : param to check
+ *
+ * Retn : 1 : supported, 0 : not supported
+ *------------------------------------------------------------------*/
+static int scd_param_supported(scd_device* dev, scd_param* p_param)
+{
+    scd_driver* drv = scd_drv(dev);
+    scd_param   cur;
+    scd_param   chk;
+    int ret = 0;
+
+    if (drv->get_param(dev, &cur)<0)
+        return 0;
+
+    if (drv->set_param(dev, p_param)==0 && drv->get_param(dev, &chk)==0)
+        ret = (chk.etu == p_param->etu) ? 1 : 0;
+
+    drv->set_param(dev, &cur);
+    return ret;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_pps_exchange
+ *
+ * Desc : do PPS exchange
+ *
+ * Parm : dev : scd device
+ *        t   : protocol
+ *        ta1 : Fi/Di to request
+ *
+ * Retn : 0 : accepted, -EINVAL : card stays at default Fi/Di,
+ *        others : PPS failed
+ *------------------------------------------------------------------*/
+static int scd_pps_exchange(scd_device* dev, unsigned char t, unsigned char ta1)
+{
+    unsigned char req[4];
+    unsigned char rsp[6];
+    unsigned char pck = 0;
+    int i, n = 0, ret;
+
+    req[0] = 0xFF;              // PPSS
+    req[1] = 0x10 | t;          // PPS0 : PPS1 present
+    req[2] = ta1;               // PPS1
+    req[3] = req[0] ^ req[1] ^ req[2];
+
+    if ((ret = scd_send(dev, req, 4)))
+        return ret;
+
+    if ((ret = scd_recv(dev, rsp, 2, dev->proto.wwt)))
+        return ret;
+
+    if (rsp[0]!=0xFF || (rsp[1] & 0xF)!=t)
+        return -EIO;
+
+    for (i=0; i<3; i++)
+        if (rsp[1] & (0x10 << i))
+            n++;
+
+    if ((ret = scd_recv(dev, &rsp[2], n + 1, dev->proto.wwt)))
+        return ret;
+
+    for (i=0; i<n+3; i++)
+        pck ^= rsp[i];
+
+    if (pck)
+        return -EIO;
+
+    if (!(rsp[1] & 0x10) || rsp[2]!=ta1)
+        return -EINVAL;
+
+    return 0;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_negotiate
+ *
+ * Desc : setup protocol parameters from the ATR of an activated card
+ *        and switch to the highest speed it supports, via PPS if the
+ *        card is in negotiable mode.
+ *
+ * Parm : dev : scd device
+ *
+ * Retn : 0 : success, others fail
+ *------------------------------------------------------------------*/
+int scd_negotiate(scd_device* dev)
+{
+    scd_driver*  drv = scd_drv(dev);
+    scd_proto*   p   = &dev->proto;
+    scd_atr      atr;
+    scd_atr_info info;
+    scd_param    param;
+    unsigned char ta1;
+    unsigned int fi, di;
+    int t, ret;
+
+    if (drv->get_atr(dev, &atr) || decompress_atr(&atr, &info)<0)
+        return -EIO;
+
+    down(&p->sem);
+
+    t = atr_get_protocol(&info);
+    p->protocol = t;
+    p->ifsc     = atr_get_ifsc(&info);
+    p->ifsd     = 32;
+    p->edc      = atr_get_edc(&info);
+    p->ns       = 0;
+    p->nr       = 0;
+
+    // default speed until PPS
+    scd_update_timing(dev, &info, atr_fi(ATR_TA1_DEFAULT));
+
+    ta1 = atr_get_ta1(&info);
+    fi  = atr_fi(ta1);
+    di  = atr_di(ta1);
+
+    if (ta1 != ATR_TA1_DEFAULT)
+    {
+        ret = drv->get_param(dev, &param);
+        param.etu = (fi && di) ? (fi / di) : 0;
+
+        if (ret<0 || !fi || !di || (fi % di) || !scd_param_supported(dev, &param))
+        {
+            SC_INFO("Fi/Di=%u/%u is not supported, use default\n", fi, di);
+            ta1 = ATR_TA1_DEFAULT;
+        }
+        else if (atr_is_specific_mode(&info))
+        {
+            // TA2 b5 = 1 : implicit parameters, use default
+            if (info.T2[0] & 0x10)
+                ta1 = ATR_TA1_DEFAULT;
+        }
+        else if ((ret = scd_pps_exchange(dev, t, ta1)))
+        {
+            SC_WARNING("PPS (TA1=%02x) failed (%d)\n", ta1, ret);
+
+            ta1 = ATR_TA1_DEFAULT;
+
+            // the card is in an unknown state after a broken PPS
+            if (ret!=-EINVAL && drv->reset(dev))
+            {
+                up(&p->sem);
+                return -EIO;
+            }
+        }
+
+        if (ta1 != ATR_TA1_DEFAULT)
+        {
+            param.clk = atr_fmax(ta1);
+            drv->set_param(dev, &param);
+            scd_update_timing(dev, &info, fi);
+            SC_INFO("T=%d, Fi/Di=%u/%u\n", t, fi, di);
+        }
+    }
+
+    up(&p->sem);
+
+    if (t==1)
+    {
+        unsigned char ifsd = T1_IFSD;
+        unsigned char rsp[4];
+
+        // tell the card how much we can receive in one block
+        if (scd_transceive(dev, &ifsd, 0, rsp, sizeof(rsp))<0)
+            SC_WARNING("T=1 IFS request failed, IFSD=%d\n", p->ifsd);
+    }
+
+    return 0;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//                                T=0                                       //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_t0_tpdu
+ *
+ * Desc : exchange a T=0 TPDU, procedure bytes are handled here
+ *
+ * Parm : dev    : scd device
+ *        hdr    : CLA INS P1 P2 P3
+ *        out    : data to send (P3 bytes) or NULL
+ *        in     : receive buffer or NULL
+ *        in_len : number of bytes to receive
+ *        sw     : status words output
+ *
+ * Retn : number of bytes received, negative for error
+ *------------------------------------------------------------------*/
+static int scd_t0_tpdu(
+    scd_device*             dev,
+    const unsigned char*    hdr,
+    const unsigned char*    out,
+    unsigned char*          in,
+    unsigned int            in_len,
+    unsigned char*          sw
+    )
+{
+    unsigned long wwt = dev->proto.wwt;
+    unsigned int total = (out) ? hdr[4] : in_len;
+    unsigned int done  = 0;
+    unsigned int n;
+    unsigned char b;
+    int ret;
+
+    if ((ret = scd_send(dev, hdr, 5)))
+        return ret;
+
+    for (;;)
+    {
+        if ((ret = scd_recv(dev, &b, 1, wwt)))
+            return ret;
+
+        if (b==0x60)                                // NULL : wait more
+            continue;
+
+        if ((b & 0xF0)==0x60 || (b & 0xF0)==0x90)   // SW1
+        {
+            sw[0] = b;
+
+            if ((ret = scd_recv(dev, &sw[1], 1, wwt)))
+                return ret;
+
+            return done;
+        }
+
+        if (b==hdr[1])                              // ACK : all remaining bytes
+            n = total - done;
+        else if (b==(hdr[1] ^ 0xFF))                // ACK : next byte
+            n = (done < total) ? 1 : 0;
+        else
+            return -EIO;
+
+        if (!n)
+            continue;
+
+        if (out)
+            ret = scd_send(dev, out + done, n);
+        else if (in)
+            ret = scd_recv(dev, in + done, n, wwt);
+        else
+            ret = -EIO;
+
+        if (ret)
+            return ret;
+
+        done += n;
+    }
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_t0_transceive
+ *
+ * Desc : exchange an APDU with T=0, GET RESPONSE and wrong Le are
+ *        handled transparently
+ *
+ * Parm : dev     : scd device
+ *        tx      : command APDU
+ *        tx_len  : length of command APDU
+ *        rx      : response APDU buffer
+ *        rx_size : size of response APDU buffer
+ *
+ * Retn : length of response APDU, negative for error
+ *------------------------------------------------------------------*/
+static int scd_t0_transceive(
+    scd_device*             dev,
+    const unsigned char*    tx,
+    unsigned int            tx_len,
+    unsigned char*          rx,
+    unsigned int            rx_size
+    )
+{
+    unsigned char hdr[5];
+    unsigned char sw[2];
+    unsigned int lc = 0;
+    unsigned int le = 0;
+    unsigned int rlen = 0;
+    unsigned int n;
+    int ret;
+
+    if (tx_len < 4 || rx_size < 2)
+        return -EINVAL;
+
+    memcpy(hdr, tx, 4);
+    hdr[4] = 0;
+
+    if (tx_len==5)
+    {
+        le = (tx[4]) ? tx[4] : 256;                 // case 2
+        hdr[4] = tx[4];
+    }
+    else if (tx_len > 5)
+    {
+        lc = tx[4];                                 // case 3/4
+
+        if (!lc || tx_len < 5 + lc || tx_len > 6 + lc)
+            return -EINVAL;
+
+        hdr[4] = lc;
+
+        if (tx_len==6 + lc)
+            le = (tx[5 + lc]) ? tx[5 + lc] : 256;
+    }
+
+    if (le > rx_size - 2)
+        le = rx_size - 2;
+
+    if (lc)
+        ret = scd_t0_tpdu(dev, hdr, tx + 5, NULL, 0, sw);
+    else if (le)
+        ret = scd_t0_tpdu(dev, hdr, NULL, rx, le, sw);
+    else
+        ret = scd_t0_tpdu(dev, hdr, NULL, NULL, 0, sw);
+
+    if (ret < 0)
+        return ret;
+
+    if (!lc)
+        rlen = ret;
+
+    // case 2 with wrong Le : resend with the right one
+    if (sw[0]==0x6C && !lc && le)
+    {
+        hdr[4] = sw[1];
+        n = (sw[1]) ? sw[1] : 256;
+
+        if ((ret = scd_t0_tpdu(dev, hdr, NULL, rx, min(n, rx_size - 2), sw)) < 0)
+            return ret;
+
+        rlen = ret;
+    }
+
+    // response data available : fetch it with GET RESPONSE
+    while (sw[0]==0x61 && le)
+    {
+        n = (sw[1]) ? sw[1] : 256;
+        n = min(n, rx_size - 2 - rlen);
+
+        if (!n)
+            break;
+
+        hdr[0] = tx[0];
+        hdr[1] = 0xC0;
+        hdr[2] = 0;
+        hdr[3] = 0;
+        hdr[4] = n & 0xFF;
+
+        if ((ret = scd_t0_tpdu(dev, hdr, NULL, rx + rlen, n, sw)) < 0)
+            return ret;
+
+        rlen += ret;
+    }
+
+    rx[rlen++] = sw[0];
+    rx[rlen++] = sw[1];
+    return rlen;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//                                T=1                                       //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_t1_edc
+ *
+ * Desc : compute epilogue of a T=1 block
+ *
+ * Parm : p   : protocol context
+ *        blk : block
+ *        len : length of prologue + INF
+ *        edc : epilogue output
+ *
+ * Retn : length of epilogue
+ *------------------------------------------------------------------*/
+static int scd_t1_edc(scd_proto* p, const unsigned char* blk, unsigned int len, unsigned char* edc)
+{
+    unsigned char lrc = 0;
+    unsigned short crc;
+
+    if (p->edc)
+    {
+        crc = crc_ccitt(0xFFFF, blk, len);
+        edc[0] = crc >> 8;
+        edc[1] = crc & 0xFF;
+        return 2;
+    }
+
+    while (len--)
+        lrc ^= *blk++;
+
+    edc[0] = lrc;
+    return 1;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_t1_send_block
+ *
+ * Desc : send a T=1 block
+ *
+ * Parm : dev : scd device
+ *        pcb : protocol control byte
+ *        inf : information field
+ *        len : length of information field
+ *
+ * Retn : 0 : success, others fail
+ *------------------------------------------------------------------*/
+static int scd_t1_send_block(
+    scd_device*             dev,
+    unsigned char           pcb,
+    const unsigned char*    inf,
+    unsigned int            len
+    )
+{
+    unsigned char blk[T1_BLOCK_SIZE];
+
+    blk[0] = 0;                 // NAD
+    blk[1] = pcb;
+    blk[2] = len;
+    memcpy(&blk[3], inf, len);
+
+    len += 3;
+    len += scd_t1_edc(&dev->proto, blk, len, &blk[len]);
+
+    return scd_send(dev, blk, len);
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_t1_recv_block
+ *
+ * Desc : receive a T=1 block
+ *
+ * Parm : dev     : scd device
+ *        blk     : block buffer (T1_BLOCK_SIZE bytes)
+ *        timeout : max waiting time of the first character (ms)
+ *
+ * Retn : length of INF, negative for error
+ *------------------------------------------------------------------*/
+static int scd_t1_recv_block(scd_device* dev, unsigned char* blk, unsigned long timeout)
+{
+    scd_proto* p = &dev->proto;
+    unsigned char edc[2];
+    int edc_len = (p->edc) ? 2 : 1;
+    int len;
+    int ret;
+
+    if ((ret = scd_recv(dev, blk, 3, timeout)))
+        return ret;
+
+    len = blk[2];
+
+    if (len==0xFF)
+        return -EIO;
+
+    if ((ret = scd_recv(dev, &blk[3], len + edc_len, p->bwt)))
+        return ret;
+
+    scd_t1_edc(p, blk, len + 3, edc);
+
+    if (memcmp(edc, &blk[3 + len], edc_len))
+        return -EIO;
+
+    return len;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_t1_resynch
+ *
+ * Desc : resynchronize T=1 protocol
+ *
+ * Parm : dev : scd device
+ *
+ * Retn : 0 : success, others fail
+ *------------------------------------------------------------------*/
+static int scd_t1_resynch(scd_device* dev)
+{
+    scd_proto* p = &dev->proto;
+    unsigned char blk[T1_BLOCK_SIZE];
+    int i;
+
+    for (i=0; i<T1_MAX_RETRY; i++)
+    {
+        if (scd_t1_send_block(dev, T1_S_BLOCK | T1_S_RESYNCH, NULL, 0))
+            continue;
+
+        if (scd_t1_recv_block(dev, blk, p->bwt) >= 0 &&
+            blk[1]==(T1_S_BLOCK | T1_S_RESPONSE | T1_S_RESYNCH))
+        {
+            p->ns = 0;
+            p->nr = 0;
+            return 0;
+        }
+    }
+
+    return -EIO;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_t1_transceive
+ *
+ * Desc : exchange an APDU with T=1. The command is chained into blocks
+ *        of IFSC bytes and chained responses are reassembled. A command
+ *        of zero length sends a S(IFS request) with the byte of tx as
+ *        IFSD instead.
+ *
+ * Parm : dev     : scd device
+ *        tx      : command APDU
+ *        tx_len  : length of command APDU
+ *        rx      : response APDU buffer
+ *        rx_size : size of response APDU buffer
+ *
+ * Retn : length of response APDU, negative for error
+ *------------------------------------------------------------------*/
+static int scd_t1_transceive(
+    scd_device*             dev,
+    const unsigned char*    tx,
+    unsigned int            tx_len,
+    unsigned char*          rx,
+    unsigned int            rx_size
+    )
+{
+    scd_proto* p = &dev->proto;
+    unsigned char blk[T1_BLOCK_SIZE];
+    unsigned int  sent  = 0;           // bytes of tx acknowledged
+    unsigned int  chunk = 0;
+    unsigned int  rlen  = 0;
+    unsigned long wtx   = 1;
+    unsigned char pcb;
+    unsigned char last_pcb;            // last block sent
+    const unsigned char* last_inf;
+    unsigned int  last_len;
+    int retry = 0;
+    int len;
+    int ret;
+
+    if (!tx_len)
+    {
+        // S(IFS request)
+        last_pcb = T1_S_BLOCK | T1_S_IFS;
+        last_inf = tx;
+        last_len = 1;
+    }
+    else
+    {
+        chunk    = min(tx_len, (unsigned int) p->ifsc);
+        last_pcb = T1_I_BLOCK | (p->ns << 6) | ((chunk < tx_len) ? T1_I_MORE : 0);
+        last_inf = tx;
+        last_len = chunk;
+    }
+
+    if ((ret = scd_t1_send_block(dev, last_pcb, last_inf, last_len)))
+        return ret;
+
+    for (;;)
+    {
+        len = scd_t1_recv_block(dev, blk, p->bwt * wtx);
+        wtx = 1;
+
+        if (len < 0)
+        {
+            if (++retry > T1_MAX_RETRY)
+                goto err_resynch;
+
+            // ask the card to send its last block again
+            pcb = T1_R_BLOCK | (p->nr << 4) | ((len==-EIO) ? T1_R_EDC_ERR : T1_R_OTHER_ERR);
+
+            if ((ret = scd_t1_send_block(dev, pcb, NULL, 0)))
+                return ret;
+
+            continue;
+        }
+
+        pcb = blk[1];
+
+        switch (T1_BLOCK_TYPE(pcb))
+        {
+        case T1_R_BLOCK:
+
+            if (T1_BLOCK_TYPE(last_pcb)==T1_I_BLOCK &&
+                (last_pcb & T1_I_MORE) && T1_R_NR(pcb)!=p->ns)
+            {
+                // chained block acknowledged : send the next one
+                p->ns ^= 1;
+                sent  += chunk;
+                chunk  = min(tx_len - sent, (unsigned int) p->ifsc);
+                retry  = 0;
+
+                last_pcb = T1_I_BLOCK | (p->ns << 6) | ((sent + chunk < tx_len) ? T1_I_MORE : 0);
+                last_inf = tx + sent;
+                last_len = chunk;
+            }
+            else if (++retry > T1_MAX_RETRY)
+                goto err_resynch;
+
+            // send next block or retransmit the last one
+            if ((ret = scd_t1_send_block(dev, last_pcb, last_inf, last_len)))
+                return ret;
+
+            break;
+
+        case T1_S_BLOCK:
+
+            if (pcb & T1_S_RESPONSE)
+            {
+                if (T1_BLOCK_TYPE(last_pcb)==T1_S_BLOCK &&
+                    T1_S_TYPE(pcb)==T1_S_TYPE(last_pcb))
+                {
+                    if (T1_S_TYPE(pcb)==T1_S_IFS && len)
+                        p->ifsd = blk[3];
+                    return 0;
+                }
+
+                if (++retry > T1_MAX_RETRY)
+                    goto err_resynch;
+
+                if ((ret = scd_t1_send_block(dev, last_pcb, last_inf, last_len)))
+                    return ret;
+
+                break;
+            }
+
+            switch (T1_S_TYPE(pcb))
+            {
+            case T1_S_WTX:
+                wtx = (len && blk[3]) ? blk[3] : 1;
+                break;
+
+            case T1_S_IFS:
+                if (len && blk[3])
+                    p->ifsc = blk[3];
+                break;
+
+            case T1_S_ABORT:
+                scd_t1_send_block(dev, pcb | T1_S_RESPONSE, &blk[3], len);
+                return -EIO;
+
+            default:
+                goto err_resynch;
+            }
+
+            // answer the request
+            if ((ret = scd_t1_send_block(dev, pcb | T1_S_RESPONSE, &blk[3], len)))
+                return ret;
+
+            break;
+
+        default:    // I-Block
+
+            if (!tx_len || T1_I_NS(pcb)!=p->nr)
+            {
+                if (++retry > T1_MAX_RETRY)
+                    goto err_resynch;
+
+                if ((ret = scd_t1_send_block(dev, T1_R_BLOCK | (p->nr << 4) | T1_R_OTHER_ERR, NULL, 0)))
+                    return ret;
+
+                break;
+            }
+
+            // the response acknowledges our last I-Block
+            if (T1_BLOCK_TYPE(last_pcb)==T1_I_BLOCK)
+            {
+                p->ns ^= 1;
+                last_pcb = T1_R_BLOCK;
+            }
+
+            if (rlen + len > rx_size)
+                return -ENOSPC;
+
+            memcpy(rx + rlen, &blk[3], len);
+            rlen  += len;
+            p->nr ^= 1;
+            retry  = 0;
+
+            if (!(pcb & T1_I_MORE))
+                return rlen;
+
+            // chained response : ask for the next block
+            last_pcb = T1_R_BLOCK | (p->nr << 4);
+            last_inf = NULL;
+            last_len = 0;
+
+            if ((ret = scd_t1_send_block(dev, last_pcb, NULL, 0)))
+                return ret;
+
+            break;
+        }
+    }
+
+err_resynch:
+    SC_WARNING("T=1 exchange failed, resynch\n");
+    scd_t1_resynch(dev);
+    return -EIO;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Func : scd_transceive
+ *
+ * Desc : exchange an APDU with the card using the negotiated protocol
+ *
+ * Parm : dev     : scd device
+ *        tx      : command APDU
+ *        tx_len  : length of command APDU
+ *        rx      : response APDU buffer
+ *        rx_size : size of response APDU buffer
+ *
+ * Retn : length of response APDU, negative for error
+ *------------------------------------------------------------------*/
+int scd_transceive(
+    scd_device*             dev,
+    const unsigned char*    tx,
+    unsigned int            tx_len,
+    unsigned char*          rx,
+    unsigned int            rx_size
+    )
+{
+    scd_proto* p = &dev->proto;
+    int ret;
+
+    down(&p->sem);
+
+    switch (p->protocol)
+    {
+    case 0:  ret = scd_t0_transceive(dev, tx, tx_len, rx, rx_size); break;
+    case 1:  ret = scd_t1_transceive(dev, tx, tx_len, rx, rx_size); break;
+    default: ret = -EPROTONOSUPPORT;
+    }
+
+    up(&p->sem);
+
+    return ret;
+}
+
+
+
+EXPORT_SYMBOL(scd_negotiate);
+EXPORT_SYMBOL(scd_transceive);
@@ -46,6 +46,7 @@
 #include <linux/usb.h>
 #include <linux/moduleparam.h>
 #include <linux/dma-mapping.h>
+#include <linux/async.h>
 
 #include "../core/hcd.h"
 
@@ -1570,6 +1571,28 @@ MODULE_DESCRIPTION (DRIVER_INFO);
 MODULE_AUTHOR (DRIVER_AUTHOR);
 MODULE_LICENSE ("GPL");
 
+#ifdef CONFIG_REALTEK_VENUS_USB
+static int ehci_hcd_registered;
+
+/*
+ * Probing resets the controller and powers up the root hub ports, which
+ * sleeps for a good while; let the other initcalls run meanwhile. The
+ * OHCI companion orders itself after this with async_synchronize_cookie().
+ */
+static void __init ehci_hcd_register_async (void *data, async_cookie_t cookie)
+{
+	int ret;
+
+	ret = driver_register (&ehci_hcd_driver);
+	if (ret) {
+		printk (KERN_ERR "%s: driver register failed (%d)\n",
+			hcd_name, ret);
+		return;
+	}
+	ehci_hcd_registered = 1;
+}
+#endif /* CONFIG_REALTEK_VENUS_USB */
+
 static int __init init (void) 
 {
 #ifdef CONFIG_REALTEK_VENUS_USB	//cfyeh+ 2005/11/07
@@ -1594,7 +1617,8 @@ static int __init init (void)
 		return ret;
 	}
 
-	return driver_register (&ehci_hcd_driver);
+	async_schedule (ehci_hcd_register_async, NULL);
+	return 0;
 	//cfyeh- 2005/10/05
 #else
 	return pci_register_driver (&ehci_pci_driver);
@@ -1609,7 +1633,8 @@ static void __exit cleanup (void)
 	struct platform_device *hcd_dev = ehci_hcd_devs;
 	ehci_hcd_devs = NULL;
 
-	driver_unregister (&ehci_hcd_driver);
+	if (ehci_hcd_registered)
+		driver_unregister (&ehci_hcd_driver);
 	platform_device_unregister(hcd_dev);
 	//cfyeh- 2005/10/05
 #else
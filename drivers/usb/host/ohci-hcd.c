@@ -103,6 +103,7 @@
 #include "../core/hcd.h"
 #include <linux/dma-mapping.h> 
 #include <linux/dmapool.h>    /* needed by ohci-mem.c when no PCI */
+#include <linux/async.h>
 
 #include <asm/io.h>
 #include <asm/irq.h>
@@ -228,7 +228,28 @@ static struct device_driver ohci_hcd_driver = {
 };
 
 static struct platform_device *ohci_hcd_devs;
+static int ohci_hcd_registered;
 /*-------------------------------------------------------------------------*/
+
+/*
+ * The EHCI driver registers asynchronously, and it has to own the ports
+ * before its companion probes; waiting for every earlier cookie orders us
+ * after it.
+ */
+static void __init ohci_hcd_register_async (void *data, async_cookie_t cookie)
+{
+	int ret;
+
+	async_synchronize_cookie (cookie);
+
+	ret = driver_register (&ohci_hcd_driver);
+	if (ret) {
+		printk (KERN_ERR "%s: driver register failed (%d)\n",
+			hcd_name, ret);
+		return;
+	}
+	ohci_hcd_registered = 1;
+}
  
 static int __init ohci_hcd_pci_init (void) 
 {
@@ -250,7 +271,8 @@ static int __init ohci_hcd_pci_init (void)
 		return ret;
 	}
 
-	return driver_register (&ohci_hcd_driver);
+	async_schedule (ohci_hcd_register_async, NULL);
+	return 0;
 }
 module_init (ohci_hcd_pci_init);
 
@@ -262,7 +284,8 @@ static void __exit ohci_hcd_pci_cleanup (void)
 	struct platform_device *hcd_dev = ohci_hcd_devs;
 	ohci_hcd_devs = NULL;
 
-	driver_unregister (&ohci_hcd_driver);
+	if (ohci_hcd_registered)
+		driver_unregister (&ohci_hcd_driver);
 	platform_device_unregister(hcd_dev);
 	//cfyeh- 2005/10/05
 }
@@ -748,13 +748,13 @@ static ssize_t aio_run_iocb(struct kiocb *iocb)
 	 * the aio_wake_function callback).
 	 */
 	BUG_ON(current->io_wait != NULL);
-	current->io_wait = &iocb->ki_wait;
+	current->io_wait = &iocb->ki_wait.wait;
 	ret = retry(iocb);
 	current->io_wait = NULL;
 
 	if (-EIOCBRETRY != ret) {
  		if (-EIOCBQUEUED != ret) {
-			BUG_ON(!list_empty(&iocb->ki_wait.task_list));
+			BUG_ON(!list_empty(&iocb->ki_wait.wait.task_list));
 			aio_complete(iocb, ret, 0);
 			/* must not access the iocb after this */
 		}
@@ -763,7 +763,7 @@ static ssize_t aio_run_iocb(struct kiocb *iocb)
 		 * Issue an additional retry to avoid waiting forever if
 		 * no waits were queued (e.g. in case of a short read).
 		 */
-		if (list_empty(&iocb->ki_wait.task_list))
+		if (list_empty(&iocb->ki_wait.wait.task_list))
 			kiocbSetKicked(iocb);
 	}
 out:
@@ -906,7 +906,7 @@ static void queue_kicked_iocb(struct kiocb *iocb)
 	unsigned long flags;
 	int run = 0;
 
-	WARN_ON((!list_empty(&iocb->ki_wait.task_list)));
+	WARN_ON((!list_empty(&iocb->ki_wait.wait.task_list)));
 
 	spin_lock_irqsave(&ctx->ctx_lock, flags);
 	run = __queue_kicked_iocb(iocb);
@@ -1485,7 +1485,21 @@ static ssize_t aio_setup_iocb(struct kiocb *kiocb)
 static int aio_wake_function(wait_queue_t *wait, unsigned mode,
 			     int sync, void *key)
 {
-	struct kiocb *iocb = container_of(wait, struct kiocb, ki_wait);
+	struct kiocb *iocb = container_of(wait, struct kiocb, ki_wait.wait);
+
+	/*
+	 * Page lock and writeback waits share hashed wait queues, so
+	 * ignore wakeups meant for another page or bit, as
+	 * wake_bit_function() does for sleeping waiters.
+	 */
+	if (key && iocb->ki_wait.key.flags) {
+		struct wait_bit_key *bit_key = key;
+
+		if (iocb->ki_wait.key.flags != bit_key->flags ||
+		    iocb->ki_wait.key.bit_nr != bit_key->bit_nr ||
+		    test_bit(bit_key->bit_nr, bit_key->flags))
+			return 0;
+	}
 
 	list_del_init(&wait->task_list);
 	kick_iocb(iocb);
@@ -1540,8 +1554,9 @@ int fastcall io_submit_one(struct kioctx *ctx, struct iocb __user *user_iocb,
 	req->ki_buf = (char __user *)(unsigned long)iocb->aio_buf;
 	req->ki_left = req->ki_nbytes = iocb->aio_nbytes;
 	req->ki_opcode = iocb->aio_lio_opcode;
-	init_waitqueue_func_entry(&req->ki_wait, aio_wake_function);
-	INIT_LIST_HEAD(&req->ki_wait.task_list);
+	init_waitqueue_func_entry(&req->ki_wait.wait, aio_wake_function);
+	INIT_LIST_HEAD(&req->ki_wait.wait.task_list);
+	req->ki_wait.key.flags = NULL;
 	req->ki_retried = 0;
 
 	ret = aio_setup_iocb(req);
@@ -1777,8 +1792,9 @@ unsigned long submit_kernel_aio(unsigned long ctx_id, struct file *file, struct
 	req->ki_buf = (char __user *)(unsigned long)iocb->aio_buf;
 	req->ki_left = req->ki_nbytes = iocb->aio_nbytes;
 	req->ki_opcode = iocb->aio_lio_opcode;
-	init_waitqueue_func_entry(&req->ki_wait, aio_wake_function);
-	INIT_LIST_HEAD(&req->ki_wait.task_list);
+	init_waitqueue_func_entry(&req->ki_wait.wait, aio_wake_function);
+	INIT_LIST_HEAD(&req->ki_wait.wait.task_list);
+	req->ki_wait.key.flags = NULL;
 	req->ki_retried = 0;
 
 	ret = aio_setup_iocb(req);
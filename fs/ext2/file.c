@@ -53,6 +53,7 @@ struct file_operations ext2_file_operations = {
 	.readv		= generic_file_readv,
 	.writev		= generic_file_writev,
 	.sendfile	= generic_file_sendfile,
+	.splice_write	= generic_file_splice_write,
 };
 
 struct inode_operations ext2_file_inode_operations = {
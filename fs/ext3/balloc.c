@@ -282,6 +282,7 @@ void ext3_init_block_alloc_info(struct inode *inode)
 		else
 			rsv->rsv_goal_size = EXT3_DEFAULT_RESERVE_BLOCKS;
 		rsv->rsv_alloc_hit = 0;
+		rsv->rsv_prealloc = 0;
 		block_i->last_alloc_logical_block = 0;
 		block_i->last_alloc_physical_block = 0;
 	}
@@ -299,6 +300,8 @@ void ext3_discard_reservation(struct inode *inode)
 		return;
 
 	rsv = &block_i->rsv_window_node;
+	/* an EXT3_IOC_PREALLOC hint only lasts as long as this window */
+	rsv->rsv_prealloc = 0;
 	if (!rsv_is_empty(&rsv->rsv_window)) {
 		spin_lock(rsv_lock);
 		if (!rsv_is_empty(&rsv->rsv_window))
@@ -541,6 +544,21 @@ static int ext3_test_allocatable(int nr, struct buffer_head *bh)
 	return ret;
 }
 
+/*
+ * Count the allocatable blocks in a row starting at group relative block
+ * @start, looking at no more than @want of them.
+ */
+static int bitmap_free_run(struct buffer_head *bh, int start, int want,
+			   int maxblocks)
+{
+	int here = start;
+
+	while (here < maxblocks && here - start < want &&
+	       ext3_test_allocatable(here, bh))
+		here++;
+	return here - start;
+}
+
 static int
 bitmap_search_next_usable_block(int start, struct buffer_head *bh,
 					int maxblocks)
@@ -862,8 +880,10 @@ static int alloc_new_reservation(struct ext3_reserve_window_node *my_rsv,
 	int first_free_block;
 	int reservable_space_start;
 	struct ext3_reserve_window_node *prev_rsv;
+	struct ext3_reserve_window_node *first_head;
 	struct rb_root *fs_rsv_root = &EXT3_SB(sb)->s_rsv_window_root;
 	unsigned long size;
+	int first_start, want_run = 0;
 
 	group_first_block = le32_to_cpu(EXT3_SB(sb)->s_es->s_first_data_block) +
 				group * EXT3_BLOCKS_PER_GROUP(sb);
@@ -895,7 +915,7 @@ static int alloc_new_reservation(struct ext3_reserve_window_node *my_rsv,
 				(start_block >= my_rsv->rsv_start))
 			return -1;
 
-		if ((my_rsv->rsv_alloc_hit >
+		if (!my_rsv->rsv_prealloc && (my_rsv->rsv_alloc_hit >
 		     (my_rsv->rsv_end - my_rsv->rsv_start + 1) / 2)) {
 			/*
 			 * if we previously allocation hit ration is greater than half
@@ -908,10 +928,27 @@ static int alloc_new_reservation(struct ext3_reserve_window_node *my_rsv,
 			my_rsv->rsv_goal_size= size;
 		}
 	}
+
+	/*
+	 * a file with an outstanding preallocation (EXT3_IOC_PREALLOC) gets
+	 * windows sized to what it still expects to write, up to a group,
+	 * and only takes a window which starts with a free run of at least
+	 * half that size
+	 */
+	if (my_rsv->rsv_prealloc) {
+		size = min_t(unsigned long, my_rsv->rsv_prealloc,
+			     EXT3_BLOCKS_PER_GROUP(sb));
+		if (size < my_rsv->rsv_goal_size)
+			size = my_rsv->rsv_goal_size;
+		want_run = size / 2;
+	}
+
 	/*
 	 * shift the search start to the window near the goal block
 	 */
 	search_head = search_reserve_window(fs_rsv_root, start_block);
+	first_head = search_head;
+	first_start = start_block;
 
 	/*
 	 * find_next_reservable_window() simply finds a reservable window
@@ -954,8 +991,31 @@ retry:
 	 * free space we just found
 	 */
 	if ((start_block >= reservable_space_start) &&
-	  (start_block < reservable_space_start + size))
-		goto found_rsv_window;
+	  (start_block < reservable_space_start + size)) {
+		int run = 0;
+
+		if (!want_run)
+			goto found_rsv_window;
+
+		/*
+		 * the window starts at reservable_space_start, so that is
+		 * where the free run has to start too
+		 */
+		if (start_block == reservable_space_start)
+			run = bitmap_free_run(bitmap_bh, first_free_block,
+				want_run,
+				group_end_block - group_first_block + 1);
+		if (run >= want_run)
+			goto found_rsv_window;
+
+		/*
+		 * too fragmented here for a preallocating file, go on
+		 * searching behind this free run
+		 */
+		start_block += run;
+		search_head = prev_rsv;
+		goto retry;
+	}
 	/*
 	 * if the first free bit we found is out of the reservable space
 	 * this means there is no free block on the reservable space
@@ -986,6 +1046,21 @@ found_rsv_window:
 	}
 	return 0;		/* succeed */
 failed:
+	/*
+	 * nothing this big and unfragmented for the preallocation, try
+	 * again with half the window, down to the normal goal size
+	 */
+	if (want_run) {
+		size >>= 1;
+		if (size <= my_rsv->rsv_goal_size) {
+			size = my_rsv->rsv_goal_size;
+			want_run = 0;
+		} else
+			want_run = size / 2;
+		search_head = first_head;
+		start_block = first_start;
+		goto retry;
+	}
 	/*
 	 * failed to find a new reservation window in the current
 	 * group, remove the current(stale) reservation window
@@ -1104,6 +1179,8 @@ ext3_try_to_allocate_with_rsv(struct super_block *sb, handle_t *handle,
 					   &rsv_copy);
 		if (ret >= 0) {
 			my_rsv->rsv_alloc_hit++;
+			if (my_rsv->rsv_prealloc)
+				my_rsv->rsv_prealloc--;
 			break;				/* succeed */
 		}
 	}
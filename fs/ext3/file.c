@@ -126,6 +126,7 @@ struct file_operations ext3_file_operations = {
 #else
 	.sendfile	= generic_file_sendfile,
 #endif
+	.splice_write	= generic_file_splice_write,
 };
 
 struct inode_operations ext3_file_inode_operations = {
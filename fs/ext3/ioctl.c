@@ -217,6 +217,59 @@ flags_err:
 		up(&ei->truncate_sem);
 		return 0;
 	}
+	case EXT3_IOC_PREALLOC: {
+		struct ext3_reserve_window_node *rsv;
+		unsigned long long size, blocks;
+		unsigned long written;
+
+		if (!test_opt(inode->i_sb, RESERVATION) ||!S_ISREG(inode->i_mode))
+			return -ENOTTY;
+
+		if (IS_RDONLY(inode))
+			return -EROFS;
+
+		if ((current->fsuid != inode->i_uid) && !capable(CAP_FOWNER))
+			return -EACCES;
+
+		if (copy_from_user(&size, (__u64 __user *)arg, sizeof(size)))
+			return -EFAULT;
+
+		/*
+		 * size is the expected final size of the file: reserve for
+		 * whatever is still to be written beyond the current end.
+		 * The windows come out of the normal block reservation, so
+		 * the file is laid out contiguously while nothing is
+		 * written to disk ahead of the data.
+		 */
+		blocks = (size + inode->i_sb->s_blocksize - 1) >>
+				inode->i_blkbits;
+		written = (i_size_read(inode) + inode->i_sb->s_blocksize - 1) >>
+				inode->i_blkbits;
+		blocks = blocks > written ? blocks - written : 0;
+		if (blocks > le32_to_cpu(EXT3_SB(inode->i_sb)->s_es->s_blocks_count))
+			return -EFBIG;
+
+		down(&ei->truncate_sem);
+		if (!ei->i_block_alloc_info)
+			ext3_init_block_alloc_info(inode);
+
+		if (!ei->i_block_alloc_info) {
+			up(&ei->truncate_sem);
+			return -ENOMEM;
+		}
+
+		/*
+		 * drop the current window, the next allocation reserves one
+		 * sized for the preallocation
+		 */
+		ext3_discard_reservation(inode);
+		rsv = &ei->i_block_alloc_info->rsv_window_node;
+		rsv->rsv_prealloc = blocks;
+		if (blocks && !rsv->rsv_goal_size)
+			rsv->rsv_goal_size = EXT3_DEFAULT_RESERVE_BLOCKS;
+		up(&ei->truncate_sem);
+		return 0;
+	}
 	case EXT3_IOC_GROUP_EXTEND: {
 		unsigned long n_blocks_count;
 		struct super_block *sb = inode->i_sb;
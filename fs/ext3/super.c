@@ -1517,6 +1517,7 @@ static int ext3_fill_super (struct super_block *sb, void *data, int silent)
 	sbi->s_rsv_window_head.rsv_end = EXT3_RESERVE_WINDOW_NOT_ALLOCATED;
 	sbi->s_rsv_window_head.rsv_alloc_hit = 0;
 	sbi->s_rsv_window_head.rsv_goal_size = 0;
+	sbi->s_rsv_window_head.rsv_prealloc = 0;
 	ext3_rsv_window_add(sb, &sbi->s_rsv_window_head);
 
 	/*
@@ -11,12 +11,17 @@
 #include <linux/fs.h>
 #include <linux/msdos_fs.h>
 #include <linux/buffer_head.h>
+#include <linux/rbtree.h>
 
-/* this must be > 0. */
-#define FAT_MAX_CACHE	8
-
+/*
+ * Each cache entry is an extent of contiguous clusters.  The extents of an
+ * inode are kept in a rbtree sorted by the cluster number in the file, so
+ * finding the extent nearest to a cluster is O(log nr_caches), and in a
+ * LRU list for reuse.
+ */
 struct fat_cache {
 	struct list_head cache_list;
+	struct rb_node rb_node;
 	int nr_contig;	/* number of contiguous clusters */
 	int fcluster;	/* cluster number in the file. */
 	int dcluster;	/* cluster number on disk. */
@@ -31,7 +36,7 @@ struct fat_cache_id {
 
 static inline int fat_max_cache(struct inode *inode)
 {
-	return FAT_MAX_CACHE;
+	return MSDOS_SB(inode->i_sb)->options.cache_extents;
 }
 
 static kmem_cache_t *fat_cache_cachep;
@@ -73,6 +78,44 @@ static inline void fat_cache_free(struct fat_cache *cache)
 	kmem_cache_free(fat_cache_cachep, cache);
 }
 
+static void fat_cache_insert(struct inode *inode, struct fat_cache *cache)
+{
+	struct rb_node **p = &MSDOS_I(inode)->cache_tree.rb_node;
+	struct rb_node *parent = NULL;
+	struct fat_cache *tmp;
+
+	while (*p) {
+		parent = *p;
+		tmp = rb_entry(parent, struct fat_cache, rb_node);
+		if (cache->fcluster < tmp->fcluster)
+			p = &(*p)->rb_left;
+		else
+			p = &(*p)->rb_right;
+	}
+	rb_link_node(&cache->rb_node, parent, p);
+	rb_insert_color(&cache->rb_node, &MSDOS_I(inode)->cache_tree);
+}
+
+/* Find the cache of the highest fcluster which is <= "fclus". */
+static struct fat_cache *fat_cache_find(struct inode *inode, int fclus)
+{
+	struct rb_node *n = MSDOS_I(inode)->cache_tree.rb_node;
+	struct fat_cache *p, *hit = NULL;
+
+	while (n) {
+		p = rb_entry(n, struct fat_cache, rb_node);
+		if (fclus < p->fcluster)
+			n = n->rb_left;
+		else {
+			hit = p;
+			if (fclus == p->fcluster)
+				break;
+			n = n->rb_right;
+		}
+	}
+	return hit;
+}
+
 static inline void fat_cache_update_lru(struct inode *inode,
 					struct fat_cache *cache)
 {
@@ -84,25 +127,18 @@ static int fat_cache_lookup(struct inode *inode, int fclus,
 			    struct fat_cache_id *cid,
 			    int *cached_fclus, int *cached_dclus)
 {
-	static struct fat_cache nohit = { .fcluster = 0, };
-
-	struct fat_cache *hit = &nohit, *p;
+	struct fat_cache *hit;
 	int offset = -1;
 
 	spin_lock(&MSDOS_I(inode)->cache_lru_lock);
-	list_for_each_entry(p, &MSDOS_I(inode)->cache_lru, cache_list) {
-		/* Find the cache of "fclus" or nearest cache. */
-		if (p->fcluster <= fclus && hit->fcluster < p->fcluster) {
-			hit = p;
-			if ((hit->fcluster + hit->nr_contig) < fclus) {
-				offset = hit->nr_contig;
-			} else {
-				offset = fclus - hit->fcluster;
-				break;
-			}
-		}
-	}
-	if (hit != &nohit) {
+	/* Find the cache of "fclus" or nearest cache. */
+	hit = fat_cache_find(inode, fclus);
+	if (hit) {
+		if ((hit->fcluster + hit->nr_contig) < fclus)
+			offset = hit->nr_contig;
+		else
+			offset = fclus - hit->fcluster;
+
 		fat_cache_update_lru(inode, hit);
 
 		cid->id = MSDOS_I(inode)->cache_valid_id;
@@ -122,14 +158,13 @@ static struct fat_cache *fat_cache_merge(struct inode *inode,
 {
 	struct fat_cache *p;
 
-	list_for_each_entry(p, &MSDOS_I(inode)->cache_lru, cache_list) {
-		/* Find the same part as "new" in cluster-chain. */
-		if (p->fcluster == new->fcluster) {
-			BUG_ON(p->dcluster != new->dcluster);
-			if (new->nr_contig > p->nr_contig)
-				p->nr_contig = new->nr_contig;
-			return p;
-		}
+	/* Find the same part as "new" in cluster-chain. */
+	p = fat_cache_find(inode, new->fcluster);
+	if (p && p->fcluster == new->fcluster) {
+		BUG_ON(p->dcluster != new->dcluster);
+		if (new->nr_contig > p->nr_contig)
+			p->nr_contig = new->nr_contig;
+		return p;
 	}
 	return NULL;
 }
@@ -164,10 +199,12 @@ static void fat_cache_add(struct inode *inode, struct fat_cache_id *new)
 		} else {
 			struct list_head *p = MSDOS_I(inode)->cache_lru.prev;
 			cache = list_entry(p, struct fat_cache, cache_list);
+			rb_erase(&cache->rb_node, &MSDOS_I(inode)->cache_tree);
 		}
 		cache->fcluster = new->fcluster;
 		cache->dcluster = new->dcluster;
 		cache->nr_contig = new->nr_contig;
+		fat_cache_insert(inode, cache);
 	}
 out_update_lru:
 	fat_cache_update_lru(inode, cache);
@@ -187,9 +224,11 @@ static void __fat_cache_inval_inode(struct inode *inode)
 	while (!list_empty(&i->cache_lru)) {
 		cache = list_entry(i->cache_lru.next, struct fat_cache, cache_list);
 		list_del_init(&cache->cache_list);
+		rb_erase(&cache->rb_node, &i->cache_tree);
 		i->nr_caches--;
 		fat_cache_free(cache);
 	}
+	BUG_ON(i->cache_tree.rb_node != NULL);
 	/* Update. The copy of caches before this id is discarded. */
 	i->cache_valid_id++;
 	if (i->cache_valid_id == FAT_CACHE_VALID)
@@ -221,8 +260,10 @@ int fat_get_cluster(struct inode *inode, int cluster, int *fclus, int *dclus)
 {
 	struct super_block *sb = inode->i_sb;
 	const int limit = sb->s_maxbytes >> MSDOS_SB(sb)->cluster_bits;
+	const int ents_per_block = (sb->s_blocksize << 3) / MSDOS_SB(sb)->fat_bits;
 	struct fat_entry fatent;
 	struct fat_cache_id cid;
+	sector_t ra_start = 0, ra_end = 0;
 	int nr;
 
 	BUG_ON(MSDOS_I(inode)->i_start == 0);
@@ -252,6 +293,10 @@ int fat_get_cluster(struct inode *inode, int cluster, int *fclus, int *dclus)
 			goto out;
 		}
 
+		/* Read the FAT in bulk if the chain still has a long way to go */
+		if (cluster - *fclus > ents_per_block)
+			fat_ent_reada(sb, *dclus, &ra_start, &ra_end);
+
 		nr = fat_ent_read(inode, &fatent, *dclus);
 		if (nr < 0)
 			goto out;
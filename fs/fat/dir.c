@@ -15,6 +15,7 @@
 
 #include <linux/module.h>
 #include <linux/slab.h>
+#include <linux/vmalloc.h>
 #include <linux/time.h>
 #include <linux/msdos_fs.h>
 #include <linux/dirent.h>
@@ -198,11 +199,125 @@ fat_shortname2uni(struct nls_table *nls, unsigned char *buf, int buf_size,
 }
 
 /*
- * Return values: negative -> error, 0 -> not found, positive -> found,
- * value is the total amount of slots, including the shortname entry.
+ * Directory name index.
+ *
+ * Looking up a name in a vfat directory means decoding every long name in
+ * the directory until the name is found, which gets painfully slow for
+ * directories with thousands of entries.  So the first lookup in a directory
+ * decodes the whole directory once and records the hash of each short and
+ * long name together with the position of the directory record in an index
+ * hanging off the directory inode.  Subsequent lookups only decode the records
+ * whose name hash matches, and a name which is not in the index does not
+ * exist.
+ *
+ * The index is protected by the i_sem of the directory.  Removed records are
+ * marked dead in the index, added records are indexed as long as there is
+ * room, otherwise the index is thrown away and rebuilt by the next lookup.
  */
-int fat_search_long(struct inode *inode, const unsigned char *name,
-		    int name_len, struct fat_slot_info *sinfo)
+#define FAT_DIR_INDEX_MIN_SLOTS	64	/* don't index smaller directories */
+#define FAT_DIR_INDEX_END	(~0U)	/* end of hash chain */
+#define FAT_DIR_INDEX_DEAD	(~0U)	/* position of a removed record */
+
+struct fat_dir_index_entry {
+	u32 hash;		/* hash of the short or long name */
+	u32 pos;		/* position of the first slot of the record */
+	u32 next;		/* next entry in the hash chain */
+};
+
+struct fat_dir_index {
+	unsigned int nr_buckets;	/* number of hash chains, power of 2 */
+	unsigned int nr_entries;	/* number of used entries */
+	unsigned int max_entries;	/* number of allocated entries */
+	u32 *buckets;			/* heads of the hash chains */
+	struct fat_dir_index_entry entries[0];
+};
+
+static inline u32 fat_name_hash(struct nls_table *t, const unsigned char *name,
+				int len, int anycase)
+{
+	unsigned long hash = init_name_hash();
+
+	while (len--) {
+		unsigned char c = *name++;
+		hash = partial_name_hash(anycase ? nls_tolower(t, c) : c, hash);
+	}
+	return end_name_hash(hash);
+}
+
+static void fat_dir_index_free(struct fat_dir_index *index)
+{
+	if (index) {
+		if (index->max_entries * sizeof(index->entries[0]) +
+		    sizeof(*index) > PAGE_SIZE)
+			vfree(index);
+		else
+			kfree(index);
+	}
+}
+
+void fat_dir_index_inval(struct inode *dir)
+{
+	fat_dir_index_free(MSDOS_I(dir)->i_dir_index);
+	MSDOS_I(dir)->i_dir_index = NULL;
+}
+
+static struct fat_dir_index *fat_dir_index_alloc(struct inode *dir)
+{
+	struct fat_dir_index *index;
+	unsigned int nr_slots, nr_buckets, i;
+	size_t size;
+
+	/* Every record has at most one long and one short name. */
+	nr_slots = dir->i_size >> MSDOS_DIR_BITS;
+	if (nr_slots < FAT_DIR_INDEX_MIN_SLOTS)
+		return NULL;
+	for (nr_buckets = 16; nr_buckets < nr_slots / 2; nr_buckets <<= 1)
+		;
+	size = sizeof(*index) + nr_slots * sizeof(index->entries[0]) +
+		nr_buckets * sizeof(u32);
+	if (nr_slots * sizeof(index->entries[0]) + sizeof(*index) > PAGE_SIZE)
+		index = vmalloc(size);
+	else
+		index = kmalloc(size, GFP_KERNEL);
+	if (!index)
+		return NULL;
+	index->nr_buckets = nr_buckets;
+	index->nr_entries = 0;
+	index->max_entries = nr_slots;
+	index->buckets = (u32 *)&index->entries[nr_slots];
+	for (i = 0; i < nr_buckets; i++)
+		index->buckets[i] = FAT_DIR_INDEX_END;
+	return index;
+}
+
+static int fat_dir_index_add(struct fat_dir_index *index, u32 hash, loff_t pos)
+{
+	struct fat_dir_index_entry *e;
+	u32 *bucket;
+
+	if (index->nr_entries == index->max_entries)
+		return -ENOSPC;
+	bucket = &index->buckets[hash & (index->nr_buckets - 1)];
+	e = &index->entries[index->nr_entries];
+	e->hash = hash;
+	e->pos = pos;
+	e->next = *bucket;
+	*bucket = index->nr_entries++;
+	return 0;
+}
+
+/*
+ * Scan the directory starting at @start for @name.  If @name is NULL, nothing
+ * is matched and the whole directory is scanned.  If @probe is set, only the
+ * record at @start is looked at.  If @index is non-NULL, the short and long
+ * names of every record scanned are added to it.
+ *
+ * Return values: negative -> error, 0 -> found, -ENOENT -> not found.
+ */
+static int __fat_search_long(struct inode *inode, const unsigned char *name,
+			     int name_len, struct fat_slot_info *sinfo,
+			     loff_t start, int probe,
+			     struct fat_dir_index *index)
 {
 	struct super_block *sb = inode->i_sb;
 	struct msdos_sb_info *sbi = MSDOS_SB(sb);
@@ -219,35 +334,15 @@ int fat_search_long(struct inode *inode, const unsigned char *name,
 	int utf8 = sbi->options.utf8;
 	int anycase = (sbi->options.name_check != 's');
 	unsigned short opt_shortname = sbi->options.shortname;
-	loff_t cpos = 0;
-	int chl, i, j, last_u, err;
-	static loff_t ppos = 0;
-	int isCached = 0;
-
-	if (ppos != 0) {
-		cpos = ppos;
-		isCached = 2;
-	}
-//	printk("searching %s, cache value: %lld...\n", name, ppos);
+	loff_t cpos = start;
+	int chl, i, j, last_u, err, nr_records = 0;
+
 	err = -ENOENT;
 	while(1) {
-		if (isCached > 0) {
-			if (--isCached == 0) {
-				if (bh) {
-					brelse(bh);
-					bh = NULL;
-				}
-				cpos = 0;
-			}
-		}
-		if (fat_get_entry(inode, &cpos, &bh, &de) == -1) {
-//			printk("1 Error in fat_get_entry...%lld %lld %d\n", cpos, ppos, isCached);
-			ppos = 0;
-			if (isCached > 0)
-				continue;
-			else
-				goto EODir;
-		}
+		if (probe && nr_records++)
+			goto EODir;
+		if (fat_get_entry(inode, &cpos, &bh, &de) == -1)
+			goto EODir;
 parse_record:
 		nr_slots = 0;
 		if (de->name[0] == DELETED_FLAG)
@@ -269,7 +364,6 @@ parse_record:
 					__get_free_page(GFP_KERNEL);
 				if (!unicode) {
 					brelse(bh);
-					ppos = 0;
 					return -ENOMEM;
 				}
 			}
@@ -298,14 +392,8 @@ parse_long:
 				if (ds->id & 0x40) {
 					unicode[offset + 13] = 0;
 				}
-				if (fat_get_entry(inode, &cpos, &bh, &de) < 0) {
-//					printk("2 Error in fat_get_entry...%lld %lld %d\n", cpos, ppos, isCached);
-					ppos = 0;
-					if (isCached > 0)
-						continue;
-					else
-						goto EODir;
-				}
+				if (fat_get_entry(inode, &cpos, &bh, &de) < 0)
+					goto EODir;
 				if (slot == 0)
 					break;
 				ds = (struct msdos_dir_slot *) de;
@@ -367,19 +455,37 @@ parse_long:
 		xlate_len = utf8
 			?utf8_wcstombs(bufname, bufuname, sizeof(bufname))
 			:uni16_to_x8(bufname, bufuname, uni_xlate, nls_io);
-		if (xlate_len == name_len)
+		if (index) {
+			err = fat_dir_index_add(index,
+				fat_name_hash(nls_io, bufname, xlate_len,
+					      anycase),
+				cpos - (nr_slots + 1) * sizeof(*de));
+			if (err)
+				goto EODir;
+			err = -ENOENT;
+		}
+		if (name && xlate_len == name_len)
 			if ((!anycase && !memcmp(name, bufname, xlate_len)) ||
 			    (anycase && !nls_strnicmp(nls_io, name, bufname,
 								xlate_len)))
 				goto Found;
 
-		if (nr_slots) {
+		if (nr_slots && (name || index)) {
 			void *longname = unicode + 261;
 			int buf_size = PAGE_SIZE - (261 * sizeof(unicode[0]));
 			xlate_len = utf8
 				? utf8_wcstombs(longname, unicode, buf_size)
 				: uni16_to_x8(longname, unicode, uni_xlate, nls_io);
-			if (xlate_len != name_len)
+			if (index) {
+				err = fat_dir_index_add(index,
+					fat_name_hash(nls_io, longname,
+						      xlate_len, anycase),
+					cpos - (nr_slots + 1) * sizeof(*de));
+				if (err)
+					goto EODir;
+				err = -ENOENT;
+			}
+			if (!name || xlate_len != name_len)
 				continue;
 			if ((!anycase && !memcmp(name, longname, xlate_len)) ||
 			    (anycase && !nls_strnicmp(nls_io, name, longname,
@@ -396,15 +502,83 @@ Found:
 	sinfo->bh = bh;
 	sinfo->i_pos = fat_make_i_pos(sb, sinfo->bh, sinfo->de);
 	err = 0;
-//	if (isCached > 0) printk("Hit...\n");
-	ppos = cpos;
+	bh = NULL;
 EODir:
+	brelse(bh);
 	if (unicode)
 		free_page((unsigned long)unicode);
 
 	return err;
 }
 
+/*
+ * Add the record which has just been written at @pos to the name index of
+ * @dir, or throw the index away if it is full.
+ */
+static void fat_dir_index_add_record(struct inode *dir, loff_t pos)
+{
+	struct fat_dir_index *index = MSDOS_I(dir)->i_dir_index;
+
+	if (index &&
+	    __fat_search_long(dir, NULL, 0, NULL, pos, 1, index) != -ENOENT)
+		fat_dir_index_inval(dir);
+}
+
+/* Mark the record at @pos as removed in the name index of @dir. */
+static void fat_dir_index_remove_record(struct inode *dir, loff_t pos)
+{
+	struct fat_dir_index *index = MSDOS_I(dir)->i_dir_index;
+	unsigned int i;
+
+	if (!index)
+		return;
+	for (i = 0; i < index->nr_entries; i++) {
+		if (index->entries[i].pos == pos)
+			index->entries[i].pos = FAT_DIR_INDEX_DEAD;
+	}
+}
+
+/*
+ * Return values: negative -> error, 0 -> found, -ENOENT -> not found.
+ */
+int fat_search_long(struct inode *inode, const unsigned char *name,
+		    int name_len, struct fat_slot_info *sinfo)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(inode->i_sb);
+	struct fat_dir_index *index = MSDOS_I(inode)->i_dir_index;
+	struct fat_dir_index_entry *e;
+	u32 hash, i;
+	int err;
+
+	if (!index) {
+		index = fat_dir_index_alloc(inode);
+		if (!index)
+			goto scan;
+		err = __fat_search_long(inode, NULL, 0, NULL, 0, 0, index);
+		if (err != -ENOENT) {
+			/* Out of memory or index too small, just scan. */
+			fat_dir_index_free(index);
+			goto scan;
+		}
+		MSDOS_I(inode)->i_dir_index = index;
+	}
+	hash = fat_name_hash(sbi->nls_io, name, name_len,
+			     sbi->options.name_check != 's');
+	for (i = index->buckets[hash & (index->nr_buckets - 1)];
+	     i != FAT_DIR_INDEX_END; i = e->next) {
+		e = &index->entries[i];
+		if (e->hash != hash || e->pos == FAT_DIR_INDEX_DEAD)
+			continue;
+		err = __fat_search_long(inode, name, name_len, sinfo, e->pos,
+					1, NULL);
+		if (err != -ENOENT)
+			return err;
+	}
+	return -ENOENT;
+scan:
+	return __fat_search_long(inode, name, name_len, sinfo, 0, 0, NULL);
+}
+
 EXPORT_SYMBOL(fat_search_long);
 
 struct fat_ioctl_filldir_callback {
@@ -415,10 +589,16 @@ struct fat_ioctl_filldir_callback {
 	int long_len;
 	const char *shortname;
 	int short_len;
+	/* for VFAT_IOCTL_READDIR_PLUS */
+	struct inode *dir;
+	struct msdos_dir_entry *de;
+	char __user *plus_buf;
+	unsigned int plus_size;
+	int plus_full;
 };
 
 static int fat_readdirx(struct inode *inode, struct file *filp, void *dirent,
-			filldir_t filldir, int short_only, int both)
+			filldir_t filldir, int short_only, int both, int plus)
 {
 	struct super_block *sb = inode->i_sb;
 	struct msdos_sb_info *sbi = MSDOS_SB(sb);
@@ -449,6 +629,8 @@ static int fat_readdirx(struct inode *inode, struct file *filp, void *dirent,
 	cpos = filp->f_pos;
 	/* Fake . and .. for the root directory. */
 	if (inode->i_ino == MSDOS_ROOT_INO) {
+		if (plus)
+			((struct fat_ioctl_filldir_callback *)dirent)->de = NULL;
 		while (cpos < 2) {
 			if (filldir(dirent, "..", cpos+1, cpos, MSDOS_ROOT_INO, DT_DIR) < 0)
 				goto out;
@@ -683,6 +865,10 @@ ParseLong:
 //		printk("start cluster is out of range...\n");
 		goto RecEnd;
 	}
+	if (plus) {
+		/* hack for fat_ioctl_filldir_plus() */
+		((struct fat_ioctl_filldir_callback *)dirent)->de = de;
+	}
 	if (filldir(dirent, fill_name, fill_len, *furrfu, inum,
 		    (de->attr & ATTR_DIR) ? DT_DIR : DT_REG) < 0)
 		goto FillFailed;
@@ -706,7 +892,7 @@ out:
 static int fat_readdir(struct file *filp, void *dirent, filldir_t filldir)
 {
 	struct inode *inode = filp->f_dentry->d_inode;
-	return fat_readdirx(inode, filp, dirent, filldir, 0, 0);
+	return fat_readdirx(inode, filp, dirent, filldir, 0, 0, 0);
 }
 
 static int fat_ioctl_filldir(void *__buf, const char *name, int name_len,
@@ -759,6 +945,100 @@ efault:
 	return -EFAULT;
 }
 
+/*
+ * Fill one struct fat_dirent_plus, the attributes come from the directory
+ * entry readdir just parsed, so no lookup of the inode is needed.
+ */
+static int fat_ioctl_filldir_plus(void *__buf, const char *name, int name_len,
+				  loff_t offset, ino_t ino,
+				  unsigned int d_type)
+{
+	struct fat_ioctl_filldir_callback *buf = __buf;
+	struct msdos_dir_entry *de = buf->de;
+	struct fat_dirent_plus d;
+	unsigned int reclen;
+
+	reclen = ALIGN(offsetof(struct fat_dirent_plus, d_name) +
+		       name_len + 1, sizeof(long));
+	if (reclen > buf->plus_size) {
+		buf->plus_full = 1;
+		return -EINVAL;
+	}
+	memset(&d, 0, sizeof(d));
+	d.d_ino = ino;
+	d.d_off = offset;
+	d.d_reclen = reclen;
+	d.d_namlen = name_len;
+	if (de) {
+		struct msdos_sb_info *sbi = MSDOS_SB(buf->dir->i_sb);
+
+		d.d_size = le32_to_cpu(de->size);
+		d.d_mtime = date_dos2unix(le16_to_cpu(de->time),
+					  le16_to_cpu(de->date));
+		d.d_start = le16_to_cpu(de->start);
+		if (sbi->fat_bits == 32)
+			d.d_start |= (le16_to_cpu(de->starthi) << 16);
+		d.d_attr = de->attr;
+	} else
+		d.d_attr = ATTR_DIR;	/* faked . and .. of the root */
+
+	if (copy_to_user(buf->plus_buf, &d,
+			 offsetof(struct fat_dirent_plus, d_name))	||
+	    copy_to_user(buf->plus_buf +
+			 offsetof(struct fat_dirent_plus, d_name),
+			 name, name_len)				||
+	    put_user(0, buf->plus_buf +
+		     offsetof(struct fat_dirent_plus, d_name) + name_len)) {
+		buf->result = -EFAULT;
+		return -EFAULT;
+	}
+	buf->plus_buf += reclen;
+	buf->plus_size -= reclen;
+	buf->result++;
+	return 0;
+}
+
+/*
+ * VFAT_IOCTL_READDIR_PLUS: read as many directory records as fit into the
+ * user buffer together with their attributes, in a single pass over the
+ * directory.  Returns the number of records, 0 at the end of the directory.
+ */
+static int fat_dir_ioctl_plus(struct inode *inode, struct file *filp,
+			      struct fat_readdir_plus __user *arg)
+{
+	struct fat_ioctl_filldir_callback buf;
+	struct fat_readdir_plus rp;
+	int ret;
+
+	if (copy_from_user(&rp, arg, sizeof(rp)))
+		return -EFAULT;
+	if (!access_ok(VERIFY_WRITE, rp.buf, rp.size))
+		return -EFAULT;
+
+	buf.dir = inode;
+	buf.de = NULL;
+	buf.plus_buf = (char __user *)rp.buf;
+	buf.plus_size = rp.size;
+	buf.plus_full = 0;
+	buf.result = 0;
+	down(&inode->i_sem);
+	ret = -ENOENT;
+	if (!IS_DEADDIR(inode)) {
+		ret = fat_readdirx(inode, filp, &buf, fat_ioctl_filldir_plus,
+				   0, 0, 1);
+	}
+	up(&inode->i_sem);
+	if (ret >= 0) {
+		ret = buf.result;
+		/* The buffer can't hold even a single record. */
+		if (!ret && buf.plus_full)
+			ret = -EINVAL;
+	}
+	if (ret >= 0 && put_user(ret, &arg->count))
+		ret = -EFAULT;
+	return ret;
+}
+
 static int fat_dir_ioctl(struct inode * inode, struct file * filp,
 		  unsigned int cmd, unsigned long arg)
 {
@@ -775,6 +1055,9 @@ static int fat_dir_ioctl(struct inode * inode, struct file * filp,
 		short_only = 0;
 		both = 1;
 		break;
+	case VFAT_IOCTL_READDIR_PLUS:
+		return fat_dir_ioctl_plus(inode, filp,
+				(struct fat_readdir_plus __user *)arg);
 	default:
 		return fat_generic_ioctl(inode, filp, cmd, arg);
 	}
@@ -796,7 +1079,7 @@ static int fat_dir_ioctl(struct inode * inode, struct file * filp,
 	ret = -ENOENT;
 	if (!IS_DEADDIR(inode)) {
 		ret = fat_readdirx(inode, filp, &buf, fat_ioctl_filldir,
-				   short_only, both);
+				   short_only, both, 0);
 	}
 	up(&inode->i_sem);
 	if (ret >= 0)
@@ -959,6 +1242,7 @@ int fat_remove_entries(struct inode *dir, struct fat_slot_info *sinfo)
 	 * First stage: Remove the shortname. By this, the directory
 	 * entry is removed.
 	 */
+	fat_dir_index_remove_record(dir, sinfo->slot_off);
 	nr_slots = sinfo->nr_slots;
 	de = sinfo->de;
 	sinfo->de = NULL;
@@ -1311,6 +1595,7 @@ found:
 	sinfo->de = de;
 	sinfo->bh = bh;
 	sinfo->i_pos = fat_make_i_pos(sb, sinfo->bh, sinfo->de);
+	fat_dir_index_add_record(dir, pos);
 
 	return 0;
 
@@ -345,6 +345,33 @@ int fat_ent_read(struct inode *inode, struct fat_entry *fatent, int entry)
 	return ops->ent_get(fatent);
 }
 
+/*
+ * Start reading the READAHEAD_NUM blocks of FAT following the one which
+ * holds "entry", so that walking a long cluster chain is served from the
+ * buffer cache.  [*ra_start, *ra_end) is the window which was read ahead
+ * last time, nothing is done until the walk leaves it.
+ */
+void fat_ent_reada(struct super_block *sb, int entry,
+		   sector_t *ra_start, sector_t *ra_end)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+	sector_t blocknr, end;
+	int offset;
+
+	if (entry < FAT_START_ENT || sbi->max_cluster <= entry)
+		return;
+	sbi->fatent_ops->ent_blocknr(sb, entry, &offset, &blocknr);
+	if (*ra_start <= blocknr && blocknr + 1 < *ra_end)
+		return;
+
+	end = min_t(sector_t, blocknr + READAHEAD_NUM,
+		    sbi->fat_start + sbi->fat_length);
+	*ra_start = blocknr;
+	*ra_end = end;
+	for (blocknr++; blocknr < end; blocknr++)
+		sb_breadahead(sb, blocknr);
+}
+
 /* FIXME: We can write the blocks as more big chunk. */
 static int fat_mirror_bhs(struct super_block *sb, struct buffer_head **bhs,
 			  int nr_bhs)
@@ -155,6 +155,7 @@ struct file_operations fat_file_operations = {
 	.ioctl		= fat_generic_ioctl,
 	.fsync		= file_fsync,
 	.sendfile	= generic_file_sendfile,
+	.splice_write	= generic_file_splice_write,
 };
 
 int fat_notify_change(struct dentry *dentry, struct iattr *attr)
@@ -427,6 +427,7 @@ static void fat_clear_inode(struct inode *inode)
 {
 	struct msdos_sb_info *sbi = MSDOS_SB(inode->i_sb);
 
+	fat_dir_index_inval(inode);
 	if (is_bad_inode(inode))
 		return;
 	lock_kernel();
@@ -488,7 +489,9 @@ static void init_once(void * foo, kmem_cache_t * cachep, unsigned long flags)
 		ei->nr_caches = 0;
 		ei->cache_valid_id = FAT_CACHE_VALID + 1;
 		INIT_LIST_HEAD(&ei->cache_lru);
+		ei->cache_tree = RB_ROOT;
 		INIT_HLIST_NODE(&ei->i_fat_hash);
+		ei->i_dir_index = NULL;
 		inode_init_once(&ei->vfs_inode);
 	}
 }
@@ -812,6 +815,8 @@ static int fat_show_options(struct seq_file *m, struct vfsmount *mnt)
 		seq_puts(m, ",showexec");
 	if (opts->sys_immutable)
 		seq_puts(m, ",sys_immutable");
+	if (opts->cache_extents != FAT_DEF_CACHE_EXTENTS)
+		seq_printf(m, ",cache_extents=%u", opts->cache_extents);
 	if (!isvfat) {
 		if (opts->dotsOK)
 			seq_puts(m, ",dotsOK=yes");
@@ -837,7 +842,7 @@ enum {
 	Opt_charset, Opt_shortname_lower, Opt_shortname_win95,
 	Opt_shortname_winnt, Opt_shortname_mixed, Opt_utf8_no, Opt_utf8_yes,
 	Opt_uni_xl_no, Opt_uni_xl_yes, Opt_nonumtail_no, Opt_nonumtail_yes,
-	Opt_obsolate, Opt_err,
+	Opt_cache_extents, Opt_obsolate, Opt_err,
 };
 
 static match_table_t fat_tokens = {
@@ -858,6 +863,7 @@ static match_table_t fat_tokens = {
 	{Opt_showexec, "showexec"},
 	{Opt_debug, "debug"},
 	{Opt_immutable, "sys_immutable"},
+	{Opt_cache_extents, "cache_extents=%u"},
 	{Opt_obsolate, "conv=binary"},
 	{Opt_obsolate, "conv=text"},
 	{Opt_obsolate, "conv=auto"},
@@ -932,6 +938,7 @@ static int parse_options(char *options, int is_vfat, int *debug,
 	opts->utf8 = opts->unicode_xlate = 0;
 	opts->numtail = 1;
 	opts->nocase = 0;
+	opts->cache_extents = FAT_DEF_CACHE_EXTENTS;
 	*debug = 0;
 
 	if (!options)
@@ -1010,6 +1017,17 @@ static int parse_options(char *options, int is_vfat, int *debug,
 				return 0;
 			opts->codepage = option;
 			break;
+		case Opt_cache_extents:
+			if (match_int(&args[0], &option))
+				return 0;
+			if (option < 1 || option > FAT_MAX_CACHE_EXTENTS) {
+				printk(KERN_ERR "FAT: cache_extents must be "
+				       "between 1 and %d\n",
+				       FAT_MAX_CACHE_EXTENTS);
+				return -EINVAL;
+			}
+			opts->cache_extents = option;
+			break;
 
 		/* msdos specific */
 		case Opt_dots:
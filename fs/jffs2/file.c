@@ -52,8 +52,9 @@ struct file_operations jffs2_file_operations =
 	.mmap =		generic_file_readonly_mmap,
 	.fsync =	jffs2_fsync,
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2,5,29)
-	.sendfile =	generic_file_sendfile
+	.sendfile =	generic_file_sendfile,
 #endif
+	.splice_write =	generic_file_splice_write,
 };
 
 /* jffs2_file_inode_operations */
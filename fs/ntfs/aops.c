@@ -175,98 +175,74 @@ still_busy:
 	return;
 }
 
-static int ntfs_get_block(struct inode *inode, sector_t iblock,
-		struct buffer_head *bh_result, int create)
+/**
+ * ntfs_get_blocks - map a range of blocks of an inode for direct i/o
+ * @inode:	inode whose blocks to map
+ * @iblock:	first block to map
+ * @max_blocks:	maximum number of blocks to map
+ * @bh_result:	buffer head in which to return the mapping
+ * @create:	non-zero if the mapping is needed for a write
+ *
+ * Map as many as @max_blocks blocks starting at @iblock of the inode @inode to
+ * physically contiguous blocks on disk and return the mapping in @bh_result.
+ * The number of mapped bytes is returned in @bh_result->b_size.
+ *
+ * The vcn to lcn conversion goes through the run cache of the runlist so that
+ * streaming direct i/o does not need to walk the runlist for every request.
+ *
+ * Holes and blocks outside the allocated size are returned unmapped.  For
+ * reads the direct i/o code zeroes them, for writes it falls back to buffered
+ * i/o.
+ *
+ * Return 0 on success and -errno on error.
+ */
+static int ntfs_get_blocks(struct inode *inode, sector_t iblock,
+		unsigned long max_blocks, struct buffer_head *bh_result,
+		int create)
 {
-	struct super_block *sb = inode->i_sb;
 	VCN vcn;
 	LCN lcn;
-	ntfs_inode *ni;
-	ntfs_volume *vol;
-	runlist_element *rl;
+	s64 clusters, nr_blocks;
+	ntfs_inode *ni = NTFS_I(inode);
+	ntfs_volume *vol = ni->vol;
 	sector_t lblock;
+	unsigned long flags;
 	unsigned int blocksize, vcn_ofs;
 	unsigned char blocksize_bits;
-	int err = 0;
-
-	ni = NTFS_I(inode);
-	vol = ni->vol;
 
 	blocksize = vol->sb->s_blocksize;
 	blocksize_bits = vol->sb->s_blocksize_bits;
-
+	read_lock_irqsave(&ni->size_lock, flags);
 	lblock = (ni->allocated_size + blocksize - 1) >> blocksize_bits;
-
-	if (iblock >= lblock)
-		return err;
+	read_unlock_irqrestore(&ni->size_lock, flags);
+	if (iblock >= lblock || !NInoNonResident(ni))
+		return 0;
 	/* Convert iblock into corresponding vcn and offset. */
-	vcn = (VCN)iblock << blocksize_bits >>
-		vol->cluster_size_bits;
-	vcn_ofs = ((VCN)iblock << blocksize_bits) &
-		vol->cluster_size_mask;
-	down_read(&ni->runlist.lock);
-	rl = ni->runlist.rl;
-	if (likely(rl != NULL)) {
-		/* Seek to element containing target vcn. */
-		while (rl->length && rl[1].vcn <= vcn)
-			rl++;
-		lcn = ntfs_rl_vcn_to_lcn(rl, vcn);
-	} else
-		lcn = LCN_RL_NOT_MAPPED;
-
-	if (lcn == LCN_RL_NOT_MAPPED) {
-		/*
-		 * * Attempt to map runlist, dropping lock for
-		 * * the duration.
-		 * */
-		up_read(&ni->runlist.lock);
-		rl = NULL;
-		err = ntfs_map_runlist(ni, vcn);
-		if (likely(!err)) {
-			down_read(&ni->runlist.lock);
-			rl = ni->runlist.rl;
-			if (likely(rl != NULL)) {
-				/* Seek to element containing target vcn. */
-				while (rl->length && rl[1].vcn <= vcn)
-					        rl++;
-				lcn = ntfs_rl_vcn_to_lcn(rl, vcn);
-			} else
-				lcn = LCN_RL_NOT_MAPPED;
-		} else {
-			goto out;
-		}
-	}
-
-	/* Successful remap. */
-//      printk("1 vnc: %lld, vcn_ofs: %d, lcn: %lld \n", vcn, vcn_ofs, lcn);
-	if (lcn >= 0) {
-		/* Setup buffer head to correct block. */
-		bh_result->b_bdev = sb->s_bdev;
-		bh_result->b_blocknr = ((lcn << vol->cluster_size_bits)
-				+ vcn_ofs) >> blocksize_bits;
-		set_buffer_mapped(bh_result);
-
-		up_read(&ni->runlist.lock);
-		return err;
-	} else {
-		printk("lcn value: %lld \n", lcn);
-		up_read(&ni->runlist.lock);
-		err = -EPERM;
-		return err;
+	vcn = (VCN)iblock << blocksize_bits >> vol->cluster_size_bits;
+	vcn_ofs = ((VCN)iblock << blocksize_bits) & vol->cluster_size_mask;
+	lcn = ntfs_attr_vcn_to_lcn(ni, vcn, &clusters);
+	if (unlikely(lcn < 0)) {
+		if (lcn == LCN_HOLE || lcn == LCN_ENOENT)
+			return 0;
+		ntfs_error(vol->sb, "Failed to map inode 0x%lx, vcn 0x%llx "
+				"for direct i/o (error code %lli).",
+				ni->mft_no, (unsigned long long)vcn,
+				(long long)lcn);
+		return lcn == LCN_ENOMEM ? -ENOMEM : -EIO;
 	}
-out:
-	return err;
-}
-
-static int ntfs_get_blocks(struct inode *inode, sector_t iblock, unsigned long max_blocks,
-		struct buffer_head *bh_result, int create)
-{
-	int ret;
-
-	ret = ntfs_get_block(inode, iblock, bh_result, create);
-	if (ret == 0)
-		bh_result->b_size = (1 << inode->i_blkbits);
-	return ret;
+	/* Map the remainder of the run, limited by the request and lblock. */
+	nr_blocks = ((clusters << vol->cluster_size_bits) - vcn_ofs) >>
+			blocksize_bits;
+	if (nr_blocks > lblock - iblock)
+		nr_blocks = lblock - iblock;
+	if (nr_blocks > max_blocks)
+		nr_blocks = max_blocks;
+	bh_result->b_bdev = vol->sb->s_bdev;
+	bh_result->b_blocknr = ((lcn << vol->cluster_size_bits) + vcn_ofs) >>
+			blocksize_bits;
+	bh_result->b_size = nr_blocks << blocksize_bits;
+	set_buffer_mapped(bh_result);
+	return 0;
 }
 
 /**
@@ -371,6 +347,14 @@ static int ntfs_read_block(struct page *page)
 			vcn_ofs = ((VCN)iblock << blocksize_bits) &
 					vol->cluster_size_mask;
 			if (!rl) {
+				/*
+				 * Try the run cache first so that we do not
+				 * need the runlist lock at all for hot runs.
+				 */
+				lcn = ntfs_run_cache_lookup(&ni->runlist, vcn,
+						NULL);
+				if (lcn >= 0)
+					goto remapped;
 lock_retry_remap:
 				down_read(&ni->runlist.lock);
 				rl = ni->runlist.rl;
@@ -380,8 +364,11 @@ lock_retry_remap:
 				while (rl->length && rl[1].vcn <= vcn)
 					rl++;
 				lcn = ntfs_rl_vcn_to_lcn(rl, vcn);
+				if (lcn >= 0)
+					ntfs_run_cache_add(&ni->runlist, rl);
 			} else
 				lcn = LCN_RL_NOT_MAPPED;
+remapped:
 			/* Successful remap. */
 			if (lcn >= 0) {
 				/* Setup buffer head to correct block. */
@@ -406,6 +406,51 @@ retry_remap:
 	return lcn;
 }
 
+/**
+ * ntfs_attr_vcn_to_lcn - convert a vcn into a lcn using the run cache
+ * @ni:		ntfs inode of the attribute whose runlist to search
+ * @vcn:	vcn to convert
+ * @count:	if not NULL, return number of contiguous clusters at @vcn
+ *
+ * Find the virtual cluster number @vcn in the runlist of the ntfs attribute
+ * described by the ntfs inode @ni and return the corresponding logical cluster
+ * number (lcn).  If @count is not NULL and the @vcn is allocated, *@count is
+ * set to the number of physically contiguous clusters starting at @vcn.
+ *
+ * The run cache of the runlist is consulted first so that repeated lookups in
+ * the same runs neither take the runlist lock nor walk the runlist.  On a miss
+ * the lookup is done by ntfs_attr_vcn_to_lcn_nolock() and the run containing
+ * @vcn is added to the run cache.
+ *
+ * Return codes are as for ntfs_attr_vcn_to_lcn_nolock().
+ *
+ * Locking: - The runlist must be unlocked on entry and is unlocked on return.
+ *	    - This function takes the runlist lock for reading and may drop
+ *	      and reacquire it (see ntfs_attr_vcn_to_lcn_nolock()).
+ */
+LCN ntfs_attr_vcn_to_lcn(ntfs_inode *ni, const VCN vcn, s64 *count)
+{
+	runlist_element *rl;
+	LCN lcn;
+
+	lcn = ntfs_run_cache_lookup(&ni->runlist, vcn, count);
+	if (likely(lcn >= 0))
+		return lcn;
+	down_read(&ni->runlist.lock);
+	lcn = ntfs_attr_vcn_to_lcn_nolock(ni, vcn, false);
+	if (likely(lcn >= 0)) {
+		/* Seek to element containing target vcn and cache it. */
+		rl = ni->runlist.rl;
+		while (rl->length && rl[1].vcn <= vcn)
+			rl++;
+		ntfs_run_cache_add(&ni->runlist, rl);
+		if (count)
+			*count = rl->length - (vcn - rl->vcn);
+	}
+	up_read(&ni->runlist.lock);
+	return lcn;
+}
+
 /**
  * ntfs_attr_find_vcn_nolock - find a vcn in the runlist of an ntfs inode
  * @ni:		ntfs inode describing the runlist to search
@@ -66,6 +66,7 @@ extern int ntfs_map_runlist(ntfs_inode *ni, VCN vcn);
 
 extern LCN ntfs_attr_vcn_to_lcn_nolock(ntfs_inode *ni, const VCN vcn,
 		const bool write_locked);
+extern LCN ntfs_attr_vcn_to_lcn(ntfs_inode *ni, const VCN vcn, s64 *count);
 
 extern runlist_element *ntfs_attr_find_vcn_nolock(ntfs_inode *ni,
 		const VCN vcn, ntfs_attr_search_ctx *ctx);
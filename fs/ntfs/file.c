@@ -1909,10 +1909,31 @@ static ssize_t ntfs_file_buffered_write(struct kiocb *iocb,
 	ll = ni->allocated_size;
 	read_unlock_irqrestore(&ni->size_lock, flags);
 	if (end > ll) {
+		s64 alloc_end = end;
+
+		/*
+		 * For extending writes to the unnamed $DATA attribute of a
+		 * non-resident file, allocate some extra clusters beyond the
+		 * end of the write if the volume was mounted with the
+		 * prealloc_size option.  Sequential writes, e.g. of
+		 * recordings or when copying large files, then get contiguous
+		 * clusters and do not have to update the mapping pairs array
+		 * for every write.  The preallocated clusters are given back
+		 * in ntfs_file_release() when the last writer goes away.
+		 */
+		if (vol->prealloc_size && NInoNonResident(ni) &&
+				!NInoAttr(ni) && !NInoSparse(ni))
+			alloc_end += vol->prealloc_size;
 		/* Extend the allocation without changing the data size. */
-		ll = ntfs_attr_extend_allocation(ni, end, -1, pos);
+		ll = ntfs_attr_extend_allocation(ni, alloc_end, -1, pos);
+		if (unlikely(ll < 0 && alloc_end != end)) {
+			/* Retry without the preallocation. */
+			ll = ntfs_attr_extend_allocation(ni, end, -1, pos);
+		}
 		if (likely(ll >= 0)) {
 			BUG_ON(pos >= ll);
+			if (ll > end)
+				NInoSetPreallocated(ni);
 			/* If the extension was partial truncate the write. */
 			if (end > ll) {
 				ntfs_debug("Truncating write to inode 0x%lx, "
@@ -2188,25 +2209,26 @@ out:
 }
 
 /**
- * ntfs_file_aio_write -
+ * ntfs_file_aio_write - asynchronous write to an ntfs file
+ *
+ * Basically the same as generic_file_aio_write() except that it ends up
+ * calling ntfs_file_aio_write_nolock() instead of
+ * __generic_file_aio_write_nolock().
  */
-/* commented by jacky
-static ssize_t ntfs_file_aio_write(struct kiocb *iocb, const struct iovec *iov,
-		unsigned long nr_segs, loff_t pos)
+static ssize_t ntfs_file_aio_write(struct kiocb *iocb, const char __user *buf,
+		size_t count, loff_t pos)
 {
 	struct file *file = iocb->ki_filp;
 	struct address_space *mapping = file->f_mapping;
 	struct inode *inode = mapping->host;
+	struct iovec local_iov = { .iov_base = (void __user *)buf,
+				   .iov_len = count };
 	ssize_t ret;
 
 	BUG_ON(iocb->ki_pos != pos);
 
-	// modified by jacky
-//	mutex_lock(&inode->i_mutex);
 	down(&inode->i_sem);
-	ret = ntfs_file_aio_write_nolock(iocb, iov, nr_segs, &iocb->ki_pos);
-	// modified by jacky
-//	mutex_unlock(&inode->i_mutex);
+	ret = ntfs_file_aio_write_nolock(iocb, &local_iov, 1, &iocb->ki_pos);
 	up(&inode->i_sem);
 	if (ret > 0 && ((file->f_flags & O_SYNC) || IS_SYNC(inode))) {
 		int err = sync_page_range(inode, mapping, pos, ret);
@@ -2215,7 +2237,6 @@ static ssize_t ntfs_file_aio_write(struct kiocb *iocb, const struct iovec *iov,
 	}
 	return ret;
 }
-*/
 
 /**
  * ntfs_file_writev -
@@ -2261,6 +2282,38 @@ static ssize_t ntfs_file_write(struct file *file, const char __user *buf,
 	return ntfs_file_writev(file, &local_iov, 1, ppos);
 }
 
+/**
+ * ntfs_file_release - called when the last reference to an open file goes away
+ * @vi:		inode of the file being released
+ * @filp:	file structure being released
+ *
+ * If @filp is the last writer of the file, give back the clusters which
+ * ntfs_file_buffered_write() preallocated beyond the end of the data.  This is
+ * done by truncating the file to its current size which shrinks the allocated
+ * size back to the data size rounded up to the cluster size.
+ *
+ * This is modelled on fs/ext2/file.c::ext2_release_file().
+ */
+static int ntfs_file_release(struct inode *vi, struct file *filp)
+{
+	ntfs_inode *ni = NTFS_I(vi);
+
+	if (!(filp->f_mode & FMODE_WRITE) || !NInoPreallocated(ni) ||
+			atomic_read(&vi->i_writecount) != 1)
+		return 0;
+	down(&vi->i_sem);
+	down_write(&vi->i_alloc_sem);
+	if (NInoPreallocated(ni)) {
+		NInoClearPreallocated(ni);
+		ntfs_debug("Discarding preallocated clusters of inode 0x%lx.",
+				vi->i_ino);
+		ntfs_truncate(vi);
+	}
+	up_write(&vi->i_alloc_sem);
+	up(&vi->i_sem);
+	return 0;
+}
+
 /**
  * ntfs_file_fsync - sync a file to disk
  * @filp:	file to be synced
@@ -2326,15 +2379,11 @@ struct file_operations ntfs_file_ops = {
 	.aio_read	= generic_file_aio_read, /* Async read from file. */
 #ifdef NTFS_RW
 	.write		= ntfs_file_write,	 /* Write to file. */
-	// modified by jacky
-//	.aio_write	= ntfs_file_aio_write,	 /* Async write to file. */
-	.aio_write      = generic_file_aio_write,/* Async write to file. */
-	/*.release	= ,*/			 /* Last file is closed.  See
-						    fs/ext2/file.c::
-						    ext2_release_file() for
-						    how to use this to discard
-						    preallocated space for
-						    write opened files. */
+	.aio_write	= ntfs_file_aio_write,	 /* Async write to file. */
+	.writev		= ntfs_file_writev,	 /* Write to file. */
+	.release	= ntfs_file_release,	 /* Last file is closed.  Discard
+						    the clusters preallocated
+						    by extending writes. */
 	.fsync		= ntfs_file_fsync,	 /* Sync a file to disk. */
 	/*.aio_fsync	= ,*/			 /* Sync all outstanding async
 						    i/o operations on a
@@ -2333,6 +2333,8 @@ int ntfs_show_options(struct seq_file *sf, struct vfsmount *mnt)
 			seq_printf(sf, ",errors=%s", on_errors_arr[i].str);
 	}
 	seq_printf(sf, ",mft_zone_multiplier=%i", vol->mft_zone_multiplier);
+	if (vol->prealloc_size)
+		seq_printf(sf, ",prealloc_size=%u", vol->prealloc_size);
 	return 0;
 }
 
@@ -2706,6 +2708,11 @@ do_non_resident_truncate:
 			goto alloc_done;
 	}
 	/* alloc_change < 0 */
+	/*
+	 * Drop the cached runs before the clusters are freed so nobody can map
+	 * a block to a cluster which is about to be reused.
+	 */
+	ntfs_run_cache_invalidate(&ni->runlist);
 	/* Free the clusters. */
 	nr_freed = ntfs_cluster_free(ni, new_alloc_size >>
 			vol->cluster_size_bits, -1, ctx);
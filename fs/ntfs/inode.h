@@ -176,6 +176,8 @@ typedef enum {
 				   1: Attribute is sparse (a). */
 	NI_SparseDisabled,	/* 1: May not create sparse regions. */
 	NI_TruncateFailed,	/* 1: Last ntfs_truncate() call failed. */
+	NI_Preallocated,	/* 1: Clusters beyond the data size have been
+				      preallocated by a write (f). */
 } ntfs_inode_state_bits;
 
 /*
@@ -229,6 +231,7 @@ NINO_FNS(Encrypted)
 NINO_FNS(Sparse)
 NINO_FNS(SparseDisabled)
 NINO_FNS(TruncateFailed)
+NINO_FNS(Preallocated)
 
 /*
  * The full structure containing a ntfs_inode and a vfs struct inode. Used for
@@ -45,6 +45,7 @@ typedef enum {
 	NTFS_MAX_ATTR_NAME_LEN	= 255,
 	NTFS_MAX_CLUSTER_SIZE	= 64 * 1024,	/* 64kiB */
 	NTFS_MAX_PAGES_PER_CLUSTER = NTFS_MAX_CLUSTER_SIZE / PAGE_CACHE_SIZE,
+	NTFS_MAX_PREALLOC_SIZE	= 64 * 1024 * 1024,	/* 64MiB */
 } NTFS_CONSTANTS;
 
 // added by jacky
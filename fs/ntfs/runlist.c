@@ -1035,6 +1035,82 @@ LCN ntfs_rl_vcn_to_lcn(const runlist_element *rl, const VCN vcn)
 	return LCN_ENOENT;
 }
 
+/**
+ * ntfs_run_cache_lookup - look up a vcn in the run cache of a runlist
+ * @runlist:	runlist whose run cache to search
+ * @vcn:	vcn to look up
+ * @count:	if not NULL, return number of clusters mapped from @vcn onwards
+ *
+ * Search the run cache of the runlist @runlist for a cached allocated run
+ * containing the virtual cluster number @vcn.
+ *
+ * On a cache hit return the lcn corresponding to @vcn and, if @count is not
+ * NULL, set *@count to the number of physically contiguous clusters starting
+ * at @vcn, i.e. up to the end of the cached run.
+ *
+ * On a cache miss return LCN_RL_NOT_MAPPED.  The caller then has to fall back
+ * to ntfs_rl_vcn_to_lcn() and is expected to add the run it finds to the run
+ * cache using ntfs_run_cache_add().
+ *
+ * Locking: - The caller does not need to hold the runlist lock.
+ *	    - This function takes the run cache spinlock.
+ */
+LCN ntfs_run_cache_lookup(runlist *runlist, const VCN vcn, s64 *count)
+{
+	ntfs_run_cache *rc = &runlist->cache;
+	runlist_element *run;
+	unsigned long flags;
+	LCN lcn = LCN_RL_NOT_MAPPED;
+
+	spin_lock_irqsave(&rc->lock, flags);
+	for (run = rc->run; run < rc->run + NTFS_RUN_CACHE_SIZE; run++) {
+		if (vcn >= run->vcn && vcn < run->vcn + run->length) {
+			lcn = run->lcn + (vcn - run->vcn);
+			if (count)
+				*count = run->length - (vcn - run->vcn);
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&rc->lock, flags);
+	return lcn;
+}
+
+/**
+ * ntfs_run_cache_add - add a run to the run cache of a runlist
+ * @runlist:	runlist whose run cache to add @rl to
+ * @rl:		runlist element describing the run to add
+ *
+ * Add the run described by the runlist element @rl to the run cache of the
+ * runlist @runlist, replacing the oldest cached run.  Runs which are not
+ * allocated on disk (holes, unmapped regions, and the terminator) are not
+ * cached.
+ *
+ * Locking: - The caller must have locked the runlist (for reading or writing)
+ *	      as @rl points into it.
+ *	    - This function takes the run cache spinlock.
+ */
+void ntfs_run_cache_add(runlist *runlist, const runlist_element *rl)
+{
+	ntfs_run_cache *rc = &runlist->cache;
+	unsigned long flags;
+	int i;
+
+	if (rl->lcn < (LCN)0 || !rl->length)
+		return;
+	spin_lock_irqsave(&rc->lock, flags);
+	for (i = 0; i < NTFS_RUN_CACHE_SIZE; i++) {
+		if (rc->run[i].vcn == rl->vcn && rc->run[i].length) {
+			/* Already cached, just refresh the length. */
+			rc->run[i] = *rl;
+			goto out;
+		}
+	}
+	rc->run[rc->next] = *rl;
+	rc->next = (rc->next + 1) % NTFS_RUN_CACHE_SIZE;
+out:
+	spin_unlock_irqrestore(&rc->lock, flags);
+}
+
 #ifdef NTFS_RW
 
 /**
@@ -1505,6 +1581,7 @@ int ntfs_rl_truncate_nolock(const ntfs_volume *vol, runlist *const runlist,
 	ntfs_debug("Entering for new_length 0x%llx.", (long long)new_length);
 	BUG_ON(!runlist);
 	BUG_ON(new_length < 0);
+	ntfs_run_cache_invalidate(runlist);
 	rl = runlist->rl;
 	if (!new_length) {
 		ntfs_debug("Freeing runlist.");
@@ -1656,6 +1733,7 @@ int ntfs_rl_punch_nolock(const ntfs_volume *vol, runlist *const runlist,
 	BUG_ON(start < 0);
 	BUG_ON(length < 0);
 	BUG_ON(end < 0);
+	ntfs_run_cache_invalidate(runlist);
 	rl = runlist->rl;
 	if (unlikely(!rl)) {
 		if (likely(!start && !length))
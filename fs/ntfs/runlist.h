@@ -45,21 +45,59 @@ typedef struct {	/* In memory vcn to lcn mapping structure element. */
 	s64 length;	/* Run length in clusters. */
 } runlist_element;
 
+/* Number of recently used runs remembered by a runlist's run cache. */
+#define NTFS_RUN_CACHE_SIZE	4
+
+/**
+ * ntfs_run_cache - cache of recently used allocated runs of a runlist
+ * @run:	recently resolved runs, a zero @length marks an unused slot
+ * @next:	index of the slot to be replaced next (round robin)
+ * @lock:	spinlock serializing access to @run and @next
+ *
+ * The run cache allows the vcn to lcn mapping of the hot regions of a file to
+ * be looked up without taking the runlist lock and without walking the runlist
+ * array from its beginning each time.  Only runs of allocated clusters (i.e.
+ * lcn >= 0) are ever cached.  Extending a runlist or filling in holes does not
+ * change the mapping of allocated runs so the cache only has to be
+ * invalidated when clusters are freed, i.e. when the runlist is truncated or
+ * punched.
+ */
+typedef struct {
+	runlist_element run[NTFS_RUN_CACHE_SIZE];
+	unsigned int next;
+	spinlock_t lock;
+} ntfs_run_cache;
+
 /**
  * runlist - in memory vcn to lcn mapping array including a read/write lock
  * @rl:		pointer to an array of runlist elements
  * @lock:	read/write spinlock for serializing access to @rl
+ * @cache:	cache of recently used allocated runs of @rl
  *
  */
 typedef struct {
 	runlist_element *rl;
 	struct rw_semaphore lock;
+	ntfs_run_cache cache;
 } runlist;
 
+static inline void ntfs_run_cache_invalidate(runlist *runlist)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&runlist->cache.lock, flags);
+	memset(runlist->cache.run, 0, sizeof(runlist->cache.run));
+	runlist->cache.next = 0;
+	spin_unlock_irqrestore(&runlist->cache.lock, flags);
+}
+
 static inline void ntfs_init_runlist(runlist *rl)
 {
 	rl->rl = NULL;
 	init_rwsem(&rl->lock);
+	memset(rl->cache.run, 0, sizeof(rl->cache.run));
+	rl->cache.next = 0;
+	spin_lock_init(&rl->cache.lock);
 }
 
 typedef enum {
@@ -78,6 +116,11 @@ extern runlist_element *ntfs_mapping_pairs_decompress(const ntfs_volume *vol,
 
 extern LCN ntfs_rl_vcn_to_lcn(const runlist_element *rl, const VCN vcn);
 
+extern LCN ntfs_run_cache_lookup(runlist *runlist, const VCN vcn,
+		s64 *count);
+
+extern void ntfs_run_cache_add(runlist *runlist, const runlist_element *rl);
+
 #ifdef NTFS_RW
 
 extern runlist_element *ntfs_rl_find_vcn_nolock(runlist_element *rl,
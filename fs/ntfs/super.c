@@ -109,6 +109,7 @@ static bool parse_options(ntfs_volume *vol, char *opt)
 	mode_t fmask = (mode_t)-1, dmask = (mode_t)-1;
 	int mft_zone_multiplier = -1, on_errors = -1;
 	int show_sys_files = -1, case_sensitive = -1, disable_sparse = -1;
+	s64 prealloc_size = -1;
 	struct nls_table *nls_map = NULL, *old_nls;
 
 	/* I am lazy... (-8 */
@@ -177,6 +178,13 @@ static bool parse_options(ntfs_volume *vol, char *opt)
 		else NTFS_GETOPT_BOOL("show_sys_files", show_sys_files)
 		else NTFS_GETOPT_BOOL("case_sensitive", case_sensitive)
 		else NTFS_GETOPT_BOOL("disable_sparse", disable_sparse)
+		else if (!strcmp(p, "prealloc_size")) {
+			if (!v || !*v)
+				goto needs_arg;
+			prealloc_size = memparse(ov = v, &v);
+			if (*v)
+				goto needs_val;
+		}
 		else NTFS_GETOPT_OPTIONS_ARRAY("errors", on_errors,
 				on_errors_arr)
 		else if (!strcmp(p, "posix") || !strcmp(p, "show_inodes"))
@@ -306,6 +314,15 @@ no_mount_options:
 		else
 			NVolClearCaseSensitive(vol);
 	}
+	if (prealloc_size != -1) {
+		if (prealloc_size > NTFS_MAX_PREALLOC_SIZE) {
+			ntfs_warning(vol->sb, "prealloc_size is too large, "
+					"using the maximum of %u bytes.",
+					NTFS_MAX_PREALLOC_SIZE);
+			prealloc_size = NTFS_MAX_PREALLOC_SIZE;
+		}
+		vol->prealloc_size = prealloc_size;
+	}
 	if (disable_sparse != -1) {
 		if (disable_sparse)
 			NVolClearSparseEnabled(vol);
@@ -53,6 +53,9 @@ typedef struct {
 					   permissions. */
 	u8 mft_zone_multiplier;		/* Initial mft zone multiplier. */
 	u8 on_errors;			/* What to do on filesystem errors. */
+	u32 prealloc_size;		/* Bytes of clusters to preallocate
+					   beyond the end of extending writes
+					   (0 = no preallocation). */
 	/* NTFS bootsector provided information. */
 	u16 sector_size;		/* in bytes */
 	u8 sector_size_bits;		/* log2(sector_size) */
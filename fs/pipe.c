@@ -90,7 +90,11 @@ static void anon_pipe_buf_release(struct pipe_inode_info *info, struct pipe_buff
 {
 	struct page *page = buf->page;
 
-	if (info->tmp_page) {
+	/*
+	 * Only recycle the page if nobody else (tee) still refers to it,
+	 * the next write would scribble over their data otherwise.
+	 */
+	if (info->tmp_page || page_count(page) != 1) {
 		__free_page(page);
 		return;
 	}
@@ -107,11 +111,17 @@ static void anon_pipe_buf_unmap(struct pipe_inode_info *info, struct pipe_buffer
 	kunmap(buf->page);
 }
 
+static void anon_pipe_buf_get(struct pipe_inode_info *info, struct pipe_buffer *buf)
+{
+	get_page(buf->page);
+}
+
 static struct pipe_buf_operations anon_pipe_buf_ops = {
 	.can_merge = 1,
 	.map = anon_pipe_buf_map,
 	.unmap = anon_pipe_buf_unmap,
 	.release = anon_pipe_buf_release,
+	.get = anon_pipe_buf_get,
 };
 
 static ssize_t
@@ -249,7 +259,8 @@ pipe_writev(struct file *filp, const struct iovec *_iov,
 		struct pipe_buffer *buf = info->bufs + lastbuf;
 		struct pipe_buf_operations *ops = buf->ops;
 		int offset = buf->offset + buf->len;
-		if (ops->can_merge && offset + chars <= PAGE_SIZE) {
+		if (ops->can_merge && offset + chars <= PAGE_SIZE &&
+		    page_count(buf->page) == 1) {
 			void *addr = ops->map(filp, info, buf);
 			int error = pipe_iov_copy_from_user(offset + addr, iov, chars);
 			ops->unmap(info, buf);
@@ -155,6 +155,7 @@ struct file_operations ramfs_file_operations = {
 	.mmap		= generic_file_mmap,
 	.fsync		= simple_sync_file,
 	.sendfile	= generic_file_sendfile,
+	.splice_write	= generic_file_splice_write,
 	.llseek		= generic_file_llseek,
 };
 
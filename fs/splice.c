@@ -0,0 +1,731 @@
+/*
+ * "splice": joining two ropes together by interweaving their strands.
+ *
+ * This is the "extended pipe" functionality, where a pipe is used as
+ * an arbitrary in-memory buffer. Think of a pipe as a small kernel
+ * buffer that you can use to transfer data from one end to the other.
+ *
+ * The traditional unix read/write is extended with a "splice()" operation
+ * that transfers data buffers to or from a pipe buffer, and "tee()" which
+ * duplicates the buffers of one pipe into another without consuming them.
+ *
+ * Data sources (->splice_read) hand pages to the pipe by reference, so
+ * e.g. a network or DVR recording written to disk with
+ *
+ *	splice(sock, NULL, pipe[1], NULL, len, 0);
+ *	splice(pipe[0], NULL, file, NULL, len, 0);
+ *
+ * is copied once, into the page cache, and never visits user space.
+ */
+#include <linux/config.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/pagemap.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/swap.h>
+#include <linux/writeback.h>
+#include <linux/module.h>
+#include <linux/syscalls.h>
+#include <linux/security.h>
+#include <linux/highmem.h>
+
+#include <asm/uaccess.h>
+
+static void *page_pipe_buf_map(struct file *file, struct pipe_inode_info *info,
+			       struct pipe_buffer *buf)
+{
+	return kmap(buf->page);
+}
+
+static void page_pipe_buf_unmap(struct pipe_inode_info *info,
+				struct pipe_buffer *buf)
+{
+	kunmap(buf->page);
+}
+
+static void page_pipe_buf_release(struct pipe_inode_info *info,
+				  struct pipe_buffer *buf)
+{
+	page_cache_release(buf->page);
+}
+
+static void page_pipe_buf_get(struct pipe_inode_info *info,
+			      struct pipe_buffer *buf)
+{
+	page_cache_get(buf->page);
+}
+
+/*
+ * Pages spliced in from other objects (socket fragments, page cache,
+ * device buffers) are shared, so they must never be merged into by a
+ * later write(2) to the pipe.
+ */
+struct pipe_buf_operations page_pipe_buf_ops = {
+	.can_merge = 0,
+	.map = page_pipe_buf_map,
+	.unmap = page_pipe_buf_unmap,
+	.release = page_pipe_buf_release,
+	.get = page_pipe_buf_get,
+};
+EXPORT_SYMBOL(page_pipe_buf_ops);
+
+static inline struct inode *file_pipe(struct file *file)
+{
+	struct inode *inode = file->f_dentry->d_inode;
+
+	return inode->i_pipe ? inode : NULL;
+}
+
+static inline void splice_wakeup(struct inode *pipe, int band)
+{
+	wake_up_interruptible(PIPE_WAIT(*pipe));
+	kill_fasync(band == POLL_IN ? PIPE_FASYNC_READERS(*pipe) :
+		    PIPE_FASYNC_WRITERS(*pipe), SIGIO, band);
+}
+
+/**
+ * splice_to_pipe - fill a pipe with the pages of a splice_pipe_desc
+ * @pipe:	the pipe inode
+ * @spd:	pages to insert, with a reference held on each
+ *
+ * The data has already been taken from its source, so all pages are
+ * inserted, sleeping for the reader to make room as needed.  With
+ * SPLICE_F_NONBLOCK (or on a signal, or when the reader went away) we
+ * stop early and drop the pages that did not fit; callers size their
+ * requests with splice_pipe_room() so this only happens if several
+ * writers race for the same pipe.
+ */
+ssize_t splice_to_pipe(struct inode *pipe, struct splice_pipe_desc *spd)
+{
+	struct pipe_inode_info *info;
+	int do_wakeup = 0, page_nr = 0;
+	ssize_t ret = 0;
+
+	down(PIPE_SEM(*pipe));
+	info = pipe->i_pipe;
+
+	while (page_nr < spd->nr_pages) {
+		if (!PIPE_READERS(*pipe)) {
+			send_sig(SIGPIPE, current, 0);
+			if (!ret)
+				ret = -EPIPE;
+			break;
+		}
+
+		if (info->nrbufs < PIPE_BUFFERS) {
+			int newbuf = (info->curbuf + info->nrbufs) &
+				     (PIPE_BUFFERS - 1);
+			struct pipe_buffer *buf = info->bufs + newbuf;
+
+			buf->page = spd->pages[page_nr];
+			buf->offset = spd->partial[page_nr].offset;
+			buf->len = spd->partial[page_nr].len;
+			buf->ops = spd->ops;
+			info->nrbufs++;
+			ret += buf->len;
+			page_nr++;
+			do_wakeup = 1;
+			continue;
+		}
+
+		if (spd->flags & SPLICE_F_NONBLOCK) {
+			if (!ret)
+				ret = -EAGAIN;
+			break;
+		}
+
+		if (signal_pending(current)) {
+			if (!ret)
+				ret = -ERESTARTSYS;
+			break;
+		}
+
+		if (do_wakeup) {
+			wake_up_interruptible_sync(PIPE_WAIT(*pipe));
+			kill_fasync(PIPE_FASYNC_READERS(*pipe), SIGIO, POLL_IN);
+			do_wakeup = 0;
+		}
+
+		PIPE_WAITING_WRITERS(*pipe)++;
+		pipe_wait(pipe);
+		PIPE_WAITING_WRITERS(*pipe)--;
+	}
+
+	up(PIPE_SEM(*pipe));
+
+	if (do_wakeup)
+		splice_wakeup(pipe, POLL_IN);
+
+	while (page_nr < spd->nr_pages)
+		page_cache_release(spd->pages[page_nr++]);
+
+	return ret;
+}
+EXPORT_SYMBOL(splice_to_pipe);
+
+/**
+ * splice_from_pipe - feed the buffers of a pipe to an actor
+ * @pipe:	the pipe inode
+ * @out:	file the actor writes to
+ * @ppos:	position in @out, updated
+ * @len:	maximum number of bytes to move
+ * @flags:	splice flags
+ * @actor:	consumes (part of) a buffer and returns the bytes it took
+ *
+ * Sleeps for data like pipe_readv() does, including the "syscall
+ * merging" rule of not blocking once some data was moved unless a
+ * writer is already waiting.
+ */
+ssize_t splice_from_pipe(struct inode *pipe, struct file *out, loff_t *ppos,
+			 size_t len, unsigned int flags, splice_actor *actor)
+{
+	struct pipe_inode_info *info;
+	int ret, do_wakeup, err;
+	struct splice_desc sd;
+
+	ret = 0;
+	do_wakeup = 0;
+
+	sd.total_len = len;
+	sd.flags = flags;
+	sd.file = out;
+	sd.pos = *ppos;
+
+	down(PIPE_SEM(*pipe));
+	info = pipe->i_pipe;
+
+	for (;;) {
+		if (info->nrbufs) {
+			struct pipe_buffer *buf = info->bufs + info->curbuf;
+			struct pipe_buf_operations *ops = buf->ops;
+
+			sd.len = buf->len;
+			if (sd.len > sd.total_len)
+				sd.len = sd.total_len;
+
+			err = actor(info, buf, &sd);
+			if (err <= 0) {
+				if (!ret)
+					ret = err;
+				break;
+			}
+
+			ret += err;
+			buf->offset += err;
+			buf->len -= err;
+
+			sd.len -= err;
+			sd.pos += err;
+			sd.total_len -= err;
+			if (sd.len)
+				continue;
+
+			if (!buf->len) {
+				buf->ops = NULL;
+				ops->release(info, buf);
+				info->curbuf = (info->curbuf + 1) &
+					       (PIPE_BUFFERS - 1);
+				info->nrbufs--;
+				do_wakeup = 1;
+			}
+
+			if (!sd.total_len)
+				break;
+		}
+
+		if (info->nrbufs)
+			continue;
+		if (!PIPE_WRITERS(*pipe))
+			break;
+		if (!PIPE_WAITING_WRITERS(*pipe)) {
+			if (ret)
+				break;
+		}
+
+		if (flags & SPLICE_F_NONBLOCK) {
+			if (!ret)
+				ret = -EAGAIN;
+			break;
+		}
+
+		if (signal_pending(current)) {
+			if (!ret)
+				ret = -ERESTARTSYS;
+			break;
+		}
+
+		if (do_wakeup) {
+			wake_up_interruptible_sync(PIPE_WAIT(*pipe));
+			kill_fasync(PIPE_FASYNC_WRITERS(*pipe), SIGIO, POLL_OUT);
+			do_wakeup = 0;
+		}
+
+		pipe_wait(pipe);
+	}
+
+	up(PIPE_SEM(*pipe));
+
+	if (do_wakeup)
+		splice_wakeup(pipe, POLL_OUT);
+
+	*ppos = sd.pos;
+	return ret;
+}
+EXPORT_SYMBOL(splice_from_pipe);
+
+/*
+ * Send data from a pipe buffer to a file, through the page cache.  The
+ * same prepare_write/commit_write sequence as generic_file_buffered_write(),
+ * only the source is a kernel mapping of the pipe page.
+ */
+static int pipe_to_file(struct pipe_inode_info *info, struct pipe_buffer *buf,
+			struct splice_desc *sd)
+{
+	struct file *file = sd->file;
+	struct address_space *mapping = file->f_mapping;
+	struct inode *inode = mapping->host;
+	unsigned int offset, this_len;
+	struct page *page;
+	pgoff_t index;
+	char *src, *dst;
+	int ret;
+
+	index = sd->pos >> PAGE_CACHE_SHIFT;
+	offset = sd->pos & ~PAGE_CACHE_MASK;
+
+	this_len = sd->len;
+	if (this_len + offset > PAGE_CACHE_SIZE)
+		this_len = PAGE_CACHE_SIZE - offset;
+
+	page = grab_cache_page(mapping, index);
+	if (!page)
+		return -ENOMEM;
+
+	ret = mapping->a_ops->prepare_write(file, page, offset,
+					    offset + this_len);
+	if (unlikely(ret)) {
+		loff_t isize = i_size_read(inode);
+
+		/*
+		 * prepare_write() may have instantiated a few blocks
+		 * outside i_size.  Trim these off again.
+		 */
+		unlock_page(page);
+		page_cache_release(page);
+		if (sd->pos + this_len > isize)
+			vmtruncate(inode, isize);
+		return ret;
+	}
+
+	src = buf->ops->map(file, info, buf);
+	dst = kmap_atomic(page, KM_USER0);
+	memcpy(dst + offset, src + buf->offset, this_len);
+	flush_dcache_page(page);
+	kunmap_atomic(dst, KM_USER0);
+	buf->ops->unmap(info, buf);
+
+	ret = mapping->a_ops->commit_write(file, page, offset,
+					   offset + this_len);
+	if (!ret)
+		ret = this_len;
+
+	mark_page_accessed(page);
+	unlock_page(page);
+	page_cache_release(page);
+	balance_dirty_pages_ratelimited(mapping);
+	return ret;
+}
+
+/**
+ * generic_file_splice_write - splice data from a pipe to a file
+ * @pipe:	pipe inode
+ * @out:	file to write to
+ * @ppos:	position in @out
+ * @len:	number of bytes to splice
+ * @flags:	splice modifier flags
+ *
+ * Will either move or copy pages (determined by @flags options) from
+ * the given pipe inode to the given file.  Pages are always copied into
+ * the page cache for now; SPLICE_F_MOVE is accepted as a hint.
+ */
+ssize_t generic_file_splice_write(struct inode *pipe, struct file *out,
+				  loff_t *ppos, size_t len, unsigned int flags)
+{
+	struct address_space *mapping = out->f_mapping;
+	struct inode *inode = mapping->host;
+	loff_t pos = *ppos;
+	ssize_t ret;
+
+	down(&inode->i_sem);
+
+	ret = generic_write_checks(out, &pos, &len, 0);
+	if (ret || !len)
+		goto out;
+
+	ret = remove_suid(out->f_dentry);
+	if (ret)
+		goto out;
+
+	inode_update_time(inode, 1);
+
+	ret = splice_from_pipe(pipe, out, &pos, len, flags, pipe_to_file);
+	if (ret > 0) {
+		*ppos = pos;
+
+		/*
+		 * If file or inode is SYNC and we actually wrote some data,
+		 * sync it.
+		 */
+		if (unlikely((out->f_flags & O_SYNC) || IS_SYNC(inode))) {
+			int err = generic_osync_inode(inode, mapping,
+						      OSYNC_METADATA|OSYNC_DATA);
+
+			if (err)
+				ret = err;
+		}
+	}
+out:
+	up(&inode->i_sem);
+	return ret;
+}
+EXPORT_SYMBOL(generic_file_splice_write);
+
+/*
+ * Attempt to initiate a splice from pipe to file.
+ */
+static long do_splice_from(struct inode *pipe, struct file *out, loff_t *ppos,
+			   size_t len, unsigned int flags)
+{
+	int ret;
+
+	if (unlikely(!out->f_op || !out->f_op->splice_write))
+		return -EINVAL;
+
+	if (unlikely(!(out->f_mode & FMODE_WRITE)))
+		return -EBADF;
+
+	ret = rw_verify_area(WRITE, out, ppos, len);
+	if (unlikely(ret))
+		return ret;
+
+	ret = security_file_permission(out, MAY_WRITE);
+	if (unlikely(ret))
+		return ret;
+
+	return out->f_op->splice_write(pipe, out, ppos, len, flags);
+}
+
+/*
+ * Attempt to initiate a splice from a file to a pipe.
+ */
+static long do_splice_to(struct file *in, loff_t *ppos, struct inode *pipe,
+			 size_t len, unsigned int flags)
+{
+	int ret;
+
+	if (unlikely(!in->f_op || !in->f_op->splice_read))
+		return -EINVAL;
+
+	if (unlikely(!(in->f_mode & FMODE_READ)))
+		return -EBADF;
+
+	ret = rw_verify_area(READ, in, ppos, len);
+	if (unlikely(ret))
+		return ret;
+
+	ret = security_file_permission(in, MAY_READ);
+	if (unlikely(ret))
+		return ret;
+
+	return in->f_op->splice_read(in, ppos, pipe, len, flags);
+}
+
+/*
+ * Determine where to splice to/from.
+ */
+static long do_splice(struct file *in, loff_t __user *off_in,
+		      struct file *out, loff_t __user *off_out,
+		      size_t len, unsigned int flags)
+{
+	struct inode *pipe;
+	loff_t offset, *off;
+	long ret;
+
+	pipe = file_pipe(in);
+	if (pipe) {
+		if (off_in)
+			return -ESPIPE;
+		if (off_out) {
+			if (!(out->f_mode & FMODE_PWRITE))
+				return -EINVAL;
+			if (copy_from_user(&offset, off_out, sizeof(loff_t)))
+				return -EFAULT;
+			off = &offset;
+		} else
+			off = &out->f_pos;
+
+		ret = do_splice_from(pipe, out, off, len, flags);
+
+		if (off_out && copy_to_user(off_out, off, sizeof(loff_t)))
+			ret = -EFAULT;
+
+		return ret;
+	}
+
+	pipe = file_pipe(out);
+	if (pipe) {
+		if (off_out)
+			return -ESPIPE;
+		if (off_in) {
+			if (!(in->f_mode & FMODE_PREAD))
+				return -EINVAL;
+			if (copy_from_user(&offset, off_in, sizeof(loff_t)))
+				return -EFAULT;
+			off = &offset;
+		} else
+			off = &in->f_pos;
+
+		ret = do_splice_to(in, off, pipe, len, flags);
+
+		if (off_in && copy_to_user(off_in, off, sizeof(loff_t)))
+			ret = -EFAULT;
+
+		return ret;
+	}
+
+	return -EINVAL;
+}
+
+asmlinkage long sys_splice(int fd_in, loff_t __user *off_in,
+			   int fd_out, loff_t __user *off_out,
+			   size_t len, unsigned int flags)
+{
+	long error;
+	struct file *in, *out;
+	int fput_in, fput_out;
+
+	if (unlikely(!len))
+		return 0;
+
+	error = -EBADF;
+	in = fget_light(fd_in, &fput_in);
+	if (in) {
+		if (in->f_mode & FMODE_READ) {
+			out = fget_light(fd_out, &fput_out);
+			if (out) {
+				if (out->f_mode & FMODE_WRITE)
+					error = do_splice(in, off_in,
+							  out, off_out,
+							  len, flags);
+				fput_light(out, fput_out);
+			}
+		}
+
+		fput_light(in, fput_in);
+	}
+
+	return error;
+}
+
+/*
+ * Wait for the input pipe to have some data, or for the writers to be
+ * gone.  Called and returns with the pipe semaphore held.
+ */
+static int link_ipipe_prep(struct inode *ipipe, unsigned int flags)
+{
+	int ret = 0;
+
+	while (!ipipe->i_pipe->nrbufs) {
+		if (!PIPE_WRITERS(*ipipe))
+			break;
+		if (!PIPE_WAITING_WRITERS(*ipipe) &&
+		    (flags & SPLICE_F_NONBLOCK)) {
+			ret = -EAGAIN;
+			break;
+		}
+		if (signal_pending(current)) {
+			ret = -ERESTARTSYS;
+			break;
+		}
+		pipe_wait(ipipe);
+	}
+
+	return ret;
+}
+
+/*
+ * Wait for the output pipe to have room, or for the readers to be
+ * gone.  Called and returns with the pipe semaphore held.
+ */
+static int link_opipe_prep(struct inode *opipe, unsigned int flags)
+{
+	int ret = 0;
+
+	while (opipe->i_pipe->nrbufs >= PIPE_BUFFERS) {
+		if (!PIPE_READERS(*opipe)) {
+			send_sig(SIGPIPE, current, 0);
+			ret = -EPIPE;
+			break;
+		}
+		if (flags & SPLICE_F_NONBLOCK) {
+			ret = -EAGAIN;
+			break;
+		}
+		if (signal_pending(current)) {
+			ret = -ERESTARTSYS;
+			break;
+		}
+		PIPE_WAITING_WRITERS(*opipe)++;
+		pipe_wait(opipe);
+		PIPE_WAITING_WRITERS(*opipe)--;
+	}
+
+	return ret;
+}
+
+/**
+ * splice_wait_pipe_room - wait until a pipe can take another buffer
+ * @pipe:	the pipe inode
+ * @flags:	splice flags, SPLICE_F_NONBLOCK makes this return -EAGAIN
+ *
+ * For sources that must not sleep in splice_to_pipe() because they hold
+ * their own locks: they splice what fits, drop their locks and wait here.
+ */
+int splice_wait_pipe_room(struct inode *pipe, unsigned int flags)
+{
+	int ret;
+
+	down(PIPE_SEM(*pipe));
+	ret = link_opipe_prep(pipe, flags);
+	up(PIPE_SEM(*pipe));
+
+	return ret;
+}
+EXPORT_SYMBOL(splice_wait_pipe_room);
+
+/*
+ * Link the buffers of ipipe into opipe without consuming them.  Both
+ * semaphores are taken in address order so that two tee()s in opposite
+ * directions cannot deadlock.
+ */
+static long link_pipe(struct inode *ipipe, struct inode *opipe,
+		      size_t len, unsigned int flags)
+{
+	struct pipe_inode_info *ii, *oi;
+	int i, ret = 0;
+
+	down(PIPE_SEM(*ipipe));
+	ret = link_ipipe_prep(ipipe, flags);
+	up(PIPE_SEM(*ipipe));
+	if (ret)
+		return ret;
+
+	down(PIPE_SEM(*opipe));
+	ret = link_opipe_prep(opipe, flags);
+	up(PIPE_SEM(*opipe));
+	if (ret)
+		return ret;
+
+	if (ipipe < opipe) {
+		down(PIPE_SEM(*ipipe));
+		down(PIPE_SEM(*opipe));
+	} else {
+		down(PIPE_SEM(*opipe));
+		down(PIPE_SEM(*ipipe));
+	}
+
+	ii = ipipe->i_pipe;
+	oi = opipe->i_pipe;
+
+	for (i = 0; len && i < ii->nrbufs; i++) {
+		struct pipe_buffer *ibuf, *obuf;
+
+		if (!PIPE_READERS(*opipe)) {
+			send_sig(SIGPIPE, current, 0);
+			if (!ret)
+				ret = -EPIPE;
+			break;
+		}
+
+		if (oi->nrbufs >= PIPE_BUFFERS)
+			break;
+
+		ibuf = ii->bufs + ((ii->curbuf + i) & (PIPE_BUFFERS - 1));
+		obuf = oi->bufs + ((oi->curbuf + oi->nrbufs) &
+				   (PIPE_BUFFERS - 1));
+
+		/*
+		 * Get a reference to this pipe buffer, so we can copy the
+		 * contents over.
+		 */
+		ibuf->ops->get(ii, ibuf);
+		*obuf = *ibuf;
+
+		if (obuf->len > len)
+			obuf->len = len;
+
+		oi->nrbufs++;
+		ret += obuf->len;
+		len -= obuf->len;
+	}
+
+	up(PIPE_SEM(*ipipe));
+	up(PIPE_SEM(*opipe));
+
+	/*
+	 * If we put data in the output pipe, wakeup any potential readers.
+	 */
+	if (ret > 0)
+		splice_wakeup(opipe, POLL_IN);
+
+	return ret;
+}
+
+/*
+ * This is a tee(1) implementation that works on pipes. It doesn't copy
+ * any data, it simply references the 'in' pages on the 'out' pipe.
+ * The 'flags' used are the SPLICE_F_* variants, currently the only
+ * applicable one is SPLICE_F_NONBLOCK.
+ */
+static long do_tee(struct file *in, struct file *out, size_t len,
+		   unsigned int flags)
+{
+	struct inode *ipipe = file_pipe(in);
+	struct inode *opipe = file_pipe(out);
+
+	/*
+	 * Duplicate the contents of ipipe to opipe without actually
+	 * copying the data.
+	 */
+	if (ipipe && opipe && ipipe != opipe)
+		return link_pipe(ipipe, opipe, len, flags);
+
+	return -EINVAL;
+}
+
+asmlinkage long sys_tee(int fdin, int fdout, size_t len, unsigned int flags)
+{
+	struct file *in;
+	int error, fput_in;
+
+	if (unlikely(!len))
+		return 0;
+
+	error = -EBADF;
+	in = fget_light(fdin, &fput_in);
+	if (in) {
+		if (in->f_mode & FMODE_READ) {
+			int fput_out;
+			struct file *out = fget_light(fdout, &fput_out);
+
+			if (out) {
+				if (out->f_mode & FMODE_WRITE)
+					error = do_tee(in, out, len, flags);
+				fput_light(out, fput_out);
+			}
+		}
+		fput_light(in, fput_in);
+	}
+
+	return error;
+}
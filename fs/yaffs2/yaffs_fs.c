@@ -327,6 +327,7 @@ static const struct file_operations yaffs_file_operations = {
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(2,5,0))
 	.sendfile = generic_file_sendfile,
 #endif
+	.splice_write = generic_file_splice_write,
 };
 #endif
 
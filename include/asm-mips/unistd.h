@@ -304,16 +304,21 @@
 #define __NR_request_key		(__NR_Linux + 281)
 #define __NR_keyctl			(__NR_Linux + 282)
 #define __NR_set_thread_area		(__NR_Linux + 283)
+#define __NR_ioprio_set			(__NR_Linux + 284)
+#define __NR_ioprio_get			(__NR_Linux + 285)
+#define __NR_recvmmsg			(__NR_Linux + 286)
+#define __NR_splice			(__NR_Linux + 287)
+#define __NR_tee			(__NR_Linux + 288)
 
 /*
  * Offset of the last Linux o32 flavoured syscall
  */
-#define __NR_Linux_syscalls		283
+#define __NR_Linux_syscalls		288
 
 #endif /* _MIPS_SIM == _MIPS_SIM_ABI32 */
 
 #define __NR_O32_Linux			4000
-#define __NR_O32_Linux_syscalls		283
+#define __NR_O32_Linux_syscalls		288
 
 #if _MIPS_SIM == _MIPS_SIM_ABI64
 
@@ -564,16 +569,21 @@
 #define __NR_request_key		(__NR_Linux + 240)
 #define __NR_keyctl			(__NR_Linux + 241)
 #define __NR_set_thread_area		(__NR_Linux + 242)
+#define __NR_ioprio_set			(__NR_Linux + 243)
+#define __NR_ioprio_get			(__NR_Linux + 244)
+#define __NR_recvmmsg			(__NR_Linux + 245)
+#define __NR_splice			(__NR_Linux + 246)
+#define __NR_tee			(__NR_Linux + 247)
 
 /*
  * Offset of the last Linux 64-bit flavoured syscall
  */
-#define __NR_Linux_syscalls		242
+#define __NR_Linux_syscalls		247
 
 #endif /* _MIPS_SIM == _MIPS_SIM_ABI64 */
 
 #define __NR_64_Linux			5000
-#define __NR_64_Linux_syscalls		242
+#define __NR_64_Linux_syscalls		247
 
 #if _MIPS_SIM == _MIPS_SIM_NABI32
 
@@ -828,16 +838,21 @@
 #define __NR_request_key		(__NR_Linux + 244)
 #define __NR_keyctl			(__NR_Linux + 245)
 #define __NR_set_thread_area		(__NR_Linux + 246)
+#define __NR_ioprio_set			(__NR_Linux + 247)
+#define __NR_ioprio_get			(__NR_Linux + 248)
+#define __NR_recvmmsg			(__NR_Linux + 249)
+#define __NR_splice			(__NR_Linux + 250)
+#define __NR_tee			(__NR_Linux + 251)
 
 /*
  * Offset of the last N32 flavoured syscall
  */
-#define __NR_Linux_syscalls		246
+#define __NR_Linux_syscalls		251
 
 #endif /* _MIPS_SIM == _MIPS_SIM_NABI32 */
 
 #define __NR_N32_Linux			6000
-#define __NR_N32_Linux_syscalls		246
+#define __NR_N32_Linux_syscalls		251
 
 #ifndef __ASSEMBLY__
 
@@ -0,0 +1,26 @@
+#ifndef _LINUX_ASYNC_H
+#define _LINUX_ASYNC_H
+
+/*
+ * Asynchronous function calls for boot time probing.
+ *
+ * async_schedule() queues a function to run in a helper thread and
+ * returns a cookie. Cookies increase in the order the calls were
+ * scheduled, so a function that depends on everything scheduled before
+ * it (a USB companion controller waiting for its EHCI, say) calls
+ * async_synchronize_cookie() with its own cookie before it starts.
+ *
+ * The kernel waits for every outstanding call before mounting the root
+ * filesystem, and before a module's init sections are freed.
+ */
+
+#include <linux/types.h>
+
+typedef unsigned long long async_cookie_t;
+typedef void (async_func_ptr)(void *data, async_cookie_t cookie);
+
+extern async_cookie_t async_schedule(async_func_ptr *func, void *data);
+extern void async_synchronize_full(void);
+extern void async_synchronize_cookie(async_cookie_t cookie);
+
+#endif /* _LINUX_ASYNC_H */
@@ -246,6 +246,7 @@ struct ext3_new_group_data {
 #endif
 #define EXT3_IOC_GETRSVSZ		_IOR('f', 5, long)
 #define EXT3_IOC_SETRSVSZ		_IOW('f', 6, long)
+#define EXT3_IOC_PREALLOC		_IOW('f', 11, __u64)
 
 /*
  * Structure of an inode on the disk
@@ -29,6 +29,7 @@ struct ext3_reserve_window_node {
 	struct rb_node	 	rsv_node;
 	__u32			rsv_goal_size;
 	__u32			rsv_alloc_hit;
+	__u32			rsv_prealloc;	/* blocks still expected */
 	struct ext3_reserve_window	rsv_window;
 };
 
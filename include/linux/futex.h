@@ -1,6 +1,8 @@
 #ifndef _LINUX_FUTEX_H
 #define _LINUX_FUTEX_H
 
+#include <linux/config.h>
+
 /* Second argument to futex syscall */
 
 
@@ -9,9 +11,29 @@
 #define FUTEX_FD (2)
 #define FUTEX_REQUEUE (3)
 #define FUTEX_CMP_REQUEUE (4)
+#define FUTEX_LOCK_PI (6)
+#define FUTEX_UNLOCK_PI (7)
+#define FUTEX_TRYLOCK_PI (8)
+
+/*
+ * Layout of a PI futex word: the owner's TID, or 0 when unlocked.
+ * Userspace locks with cmpxchg(0 -> TID) and unlocks with
+ * cmpxchg(TID -> 0); when either fails the kernel takes over.
+ */
+#define FUTEX_WAITERS		0x80000000	/* kernel has queued waiters */
+#define FUTEX_OWNER_DIED	0x40000000	/* owner exited holding it */
+#define FUTEX_TID_MASK		0x3fffffff
+
+struct task_struct;
 
 long do_futex(unsigned long uaddr, int op, int val,
 		unsigned long timeout, unsigned long uaddr2, int val2,
 		int val3);
 
+#ifdef CONFIG_FUTEX
+extern void exit_pi_state_list(struct task_struct *tsk);
+#else
+static inline void exit_pi_state_list(struct task_struct *tsk) { }
+#endif
+
 #endif
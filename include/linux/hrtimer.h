@@ -0,0 +1,77 @@
+#ifndef _LINUX_HRTIMER_H
+#define _LINUX_HRTIMER_H
+
+/*
+ * High resolution one-shot timers.
+ *
+ * Expiry times are absolute CLOCK_MONOTONIC nanoseconds. Expired timers
+ * run from a high priority tasklet, i.e. in softirq context, the same
+ * context timer_list callbacks run in. When the architecture registers a
+ * one-shot event source the timers fire with the resolution of that
+ * source, otherwise they fall back to timer tick granularity.
+ */
+
+#include <linux/config.h>
+#include <linux/rbtree.h>
+#include <linux/time.h>
+#include <linux/types.h>
+
+struct restart_block;
+
+struct hrtimer {
+	struct rb_node		node;
+	u64			expires;
+	void			(*function)(struct hrtimer *);
+	unsigned long		data;
+	int			state;
+};
+
+#define HRTIMER_INACTIVE	0
+#define HRTIMER_ENQUEUED	1
+
+/*
+ * One-shot event source. set_next_event() arms the hardware to interrupt
+ * @delta nanoseconds from now and returns 0, or -ETIME when the delta is
+ * already in the past by the time the hardware was written. The interrupt
+ * handler of the source calls hrtimer_interrupt().
+ */
+struct hrtimer_event_source {
+	const char		*name;
+	unsigned long		min_delta_ns;
+	unsigned long		max_delta_ns;
+	int			(*set_next_event)(unsigned long delta);
+};
+
+#ifdef CONFIG_HIGH_RES_TIMERS
+
+static inline void hrtimer_init(struct hrtimer *timer)
+{
+	timer->state = HRTIMER_INACTIVE;
+	timer->function = NULL;
+	timer->data = 0;
+}
+
+static inline int hrtimer_active(struct hrtimer *timer)
+{
+	return timer->state == HRTIMER_ENQUEUED;
+}
+
+static inline u64 timespec_to_ns(const struct timespec *ts)
+{
+	return (u64)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+extern u64 hrtimer_now(void);
+extern int hrtimer_start(struct hrtimer *timer, u64 expires);
+extern int hrtimer_try_to_cancel(struct hrtimer *timer);
+extern int hrtimer_cancel(struct hrtimer *timer);
+
+extern void hrtimer_register_event_source(struct hrtimer_event_source *src);
+extern void hrtimer_interrupt(void);
+
+extern long hrtimer_nanosleep(u64 expires, struct timespec *rem, int abs);
+extern long hrtimer_nanosleep_restart(struct restart_block *restart);
+
+#endif /* CONFIG_HIGH_RES_TIMERS */
+
+#endif /* _LINUX_HRTIMER_H */
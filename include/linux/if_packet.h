@@ -39,6 +39,7 @@ struct sockaddr_ll
 #define PACKET_RX_RING			5
 #define PACKET_STATISTICS		6
 #define PACKET_COPY_THRESH		7
+#define PACKET_TX_RING			13
 
 struct tpacket_stats
 {
@@ -54,6 +55,10 @@ struct tpacket_hdr
 #define TP_STATUS_COPY		2
 #define TP_STATUS_LOSING	4
 #define TP_STATUS_CSUMNOTREADY	8
+	/* TX ring frame status */
+#define TP_STATUS_AVAILABLE	0
+#define TP_STATUS_SEND_REQUEST	1
+#define TP_STATUS_WRONG_FORMAT	4
 	unsigned int	tp_len;
 	unsigned int	tp_snaplen;
 	unsigned short	tp_mac;
@@ -77,6 +82,17 @@ struct tpacket_hdr
    - Start+tp_mac: [ Optional MAC header ]
    - Start+tp_net: Packet data, aligned to TPACKET_ALIGNMENT=16.
    - Pad to align to TPACKET_ALIGNMENT=16
+
+   TX ring frames use the same header.  Userspace writes tp_len bytes of
+   packet data (starting with the link level header on SOCK_RAW sockets)
+   at Start+TPACKET_HDRLEN-sizeof(struct sockaddr_ll), sets tp_status to
+   TP_STATUS_SEND_REQUEST and calls send().  The kernel transmits every
+   requested frame from the ring head on and sets each one back to
+   TP_STATUS_AVAILABLE, or to TP_STATUS_WRONG_FORMAT if it is too long
+   for the device.
+
+   When both rings are set up, a single mmap() covers the RX ring
+   followed by the TX ring.
  */
 
 struct tpacket_req
@@ -4,6 +4,7 @@
 /*
  * The MS-DOS filesystem constants/structures
  */
+#include <linux/compiler.h>
 #include <asm/byteorder.h>
 
 #define SECTOR_SIZE	512		/* sector size (bytes) */
@@ -99,6 +100,7 @@
 /* <linux/videotext.h> has used 0x72 ('r') in collision, so skip a few */
 #define FAT_IOCTL_GET_ATTRIBUTES	_IOR('r', 0x10, __u32)
 #define FAT_IOCTL_SET_ATTRIBUTES	_IOW('r', 0x11, __u32)
+#define VFAT_IOCTL_READDIR_PLUS		_IOWR('r', 0x12, struct fat_readdir_plus)
 
 /*
  * vfat shortname flags
@@ -170,6 +172,30 @@ struct msdos_dir_slot {
 	__u8    name11_12[4];	/* last 2 characters in name */
 };
 
+/*
+ * Directory record returned by VFAT_IOCTL_READDIR_PLUS.  The records are
+ * packed into the user buffer, each one aligned to sizeof(long).  The name
+ * is the long name if the entry has one, NUL terminated.
+ */
+struct fat_dirent_plus {
+	long		d_ino;		/* inode number */
+	__kernel_off_t	d_off;		/* directory offset of this record */
+	unsigned short	d_reclen;	/* length of this record */
+	unsigned short	d_namlen;	/* length of d_name without the NUL */
+	__u32		d_size;		/* file size in bytes */
+	__u32		d_mtime;	/* modification time, seconds since Epoch */
+	__u32		d_start;	/* first cluster */
+	__u8		d_attr;		/* ATTR_* bits */
+	char		d_name[0];	/* name */
+};
+
+/* Argument of VFAT_IOCTL_READDIR_PLUS. */
+struct fat_readdir_plus {
+	void __user	*buf;		/* buffer receiving the records */
+	unsigned int	size;		/* size of buf in bytes */
+	unsigned int	count;		/* returned number of records */
+};
+
 struct fat_slot_info {
 	loff_t i_pos;		/* on-disk position of directory entry */
 	loff_t slot_off;	/* offset for slot or de start */
@@ -183,6 +209,7 @@ struct fat_slot_info {
 #include <linux/buffer_head.h>
 #include <linux/string.h>
 #include <linux/nls.h>
+#include <linux/rbtree.h>
 #include <linux/fs.h>
 
 struct fat_mount_options {
@@ -204,8 +231,11 @@ struct fat_mount_options {
 		 numtail:1,       /* Does first alias have a numeric '~1' type tail? */
 		 atari:1,         /* Use Atari GEMDOS variation of MS-DOS fs */
 		 nocase:1;	  /* Does this need case conversion? 0=need case conversion*/
+	unsigned short cache_extents; /* max. cached cluster extents per inode */
 };
 
+struct fat_dir_index;
+
 #define FAT_HASH_BITS	8
 #define FAT_HASH_SIZE	(1UL << FAT_HASH_BITS)
 #define FAT_HASH_MASK	(FAT_HASH_SIZE-1)
@@ -244,6 +274,8 @@ struct msdos_sb_info {
 };
 
 #define FAT_CACHE_VALID	0	/* special case for valid cache */
+#define FAT_DEF_CACHE_EXTENTS	8	/* default of cache_extents= */
+#define FAT_MAX_CACHE_EXTENTS	1024
 
 /*
  * MS-DOS file system inode data in memory
@@ -251,6 +283,7 @@ struct msdos_sb_info {
 struct msdos_inode_info {
 	spinlock_t cache_lru_lock;
 	struct list_head cache_lru;
+	struct rb_root cache_tree;	/* extents sorted by fcluster */
 	int nr_caches;
 	/* for avoiding the race between fat_free() and fat_get_cluster() */
 	unsigned int cache_valid_id;
@@ -261,6 +294,7 @@ struct msdos_inode_info {
 	int i_attrs;		/* unused attribute bits */
 	loff_t i_pos;		/* on-disk position of directory entry or 0 */
 	struct hlist_node i_fat_hash;	/* hash by i_location */
+	struct fat_dir_index *i_dir_index; /* name index of a directory */
 	struct inode vfs_inode;
 };
 
@@ -334,6 +368,7 @@ extern int fat_alloc_new_dir(struct inode *dir, struct timespec *ts);
 extern int fat_add_entries(struct inode *dir, void *slots, int nr_slots,
 			   struct fat_slot_info *sinfo);
 extern int fat_remove_entries(struct inode *dir, struct fat_slot_info *sinfo);
+extern void fat_dir_index_inval(struct inode *dir);
 
 /* fat/fatent.c */
 struct fat_entry {
@@ -374,6 +409,8 @@ static inline void fatent_brelse(struct fat_entry *fatent)
 extern void fat_ent_access_init(struct super_block *sb);
 extern int fat_ent_read(struct inode *inode, struct fat_entry *fatent,
 			int entry);
+extern void fat_ent_reada(struct super_block *sb, int entry,
+			  sector_t *ra_start, sector_t *ra_end);
 extern int fat_ent_write(struct inode *inode, struct fat_entry *fatent,
 			 int new, int wait);
 extern int fat_alloc_clusters(struct inode *inode, int *cluster,
@@ -48,5 +48,20 @@ static inline int ip_conntrack_confirm(struct sk_buff **pskb)
 extern struct list_head *ip_conntrack_hash;
 extern struct list_head ip_conntrack_expect_list;
 DECLARE_RWLOCK_EXTERN(ip_conntrack_lock);
+
+/* Hash chains are protected by an array of bucket locks rather than by
+   ip_conntrack_lock.  The table size is always a multiple of
+   IP_CT_HASH_LOCKS, so bucket n and every raw hash value that lands in
+   it map to the same lock.  Nests inside ip_conntrack_lock. */
+#define IP_CT_HASH_LOCKS	16
+
+extern spinlock_t ip_conntrack_hash_locks[IP_CT_HASH_LOCKS];
+
+static inline spinlock_t *ip_conntrack_hash_lock(u_int32_t hash)
+{
+	return &ip_conntrack_hash_locks[hash % IP_CT_HASH_LOCKS];
+}
+
+extern int ip_conntrack_set_hashsize(unsigned int size);
 #endif /* _IP_CONNTRACK_CORE_H */
 
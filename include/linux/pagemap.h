@@ -172,6 +172,21 @@ static inline void lock_page(struct page *page)
 	if (TestSetPageLocked(page))
 		__lock_page(page);
 }
+
+/*
+ * AIO-aware lock_page(): from an aio retry (current->io_wait set up by
+ * aio_run_iocb) it returns -EIOCBRETRY instead of sleeping, and the iocb
+ * is retried when the page is unlocked.  Otherwise it blocks like
+ * lock_page() and returns 0.
+ */
+extern int FASTCALL(__lock_page_async(struct page *page));
+
+static inline int lock_page_async(struct page *page)
+{
+	if (TestSetPageLocked(page))
+		return __lock_page_async(page);
+	return 0;
+}
 	
 /*
  * This is exported only for wait_on_page_locked/wait_on_page_writeback.
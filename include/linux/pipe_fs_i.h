@@ -16,6 +16,8 @@ struct pipe_buf_operations {
 	void * (*map)(struct file *, struct pipe_inode_info *, struct pipe_buffer *);
 	void (*unmap)(struct pipe_inode_info *, struct pipe_buffer *);
 	void (*release)(struct pipe_inode_info *, struct pipe_buffer *);
+	/* take an extra reference on the buffer, used by tee() */
+	void (*get)(struct pipe_inode_info *, struct pipe_buffer *);
 };
 
 struct pipe_inode_info {
@@ -56,4 +58,59 @@ void pipe_wait(struct inode * inode);
 struct inode* pipe_new(struct inode* inode);
 void free_pipe_info(struct inode* inode);
 
+/*
+ * splice is tied to pipes as a transport (at least for now), so we'll just
+ * add the splice infrastructure here.
+ */
+#define SPLICE_F_MOVE		(0x01)	/* move pages instead of copying */
+#define SPLICE_F_NONBLOCK	(0x02)	/* don't block on the pipe splicing
+					   (but we may still block on the fd
+					   we splice from/to, of course */
+#define SPLICE_F_MORE		(0x04)	/* expect more data */
+
+/*
+ * A page (or part of one) handed to splice_to_pipe().  The caller holds
+ * a reference on every page; splice_to_pipe() passes it on to the pipe
+ * buffer, or drops it if the page could not be inserted.
+ */
+struct partial_page {
+	unsigned int offset;
+	unsigned int len;
+};
+
+struct splice_pipe_desc {
+	struct page **pages;		/* page map */
+	struct partial_page *partial;	/* pages[] may not be contig */
+	int nr_pages;			/* number of pages in map */
+	unsigned int flags;		/* splice flags */
+	struct pipe_buf_operations *ops;/* ops associated with output pipe */
+};
+
+/*
+ * Passed to the actors of splice_from_pipe()
+ */
+struct splice_desc {
+	unsigned int len, total_len;	/* current and remaining length */
+	unsigned int flags;		/* splice flags */
+	struct file *file;		/* file to read/write */
+	loff_t pos;			/* file position */
+};
+
+typedef int (splice_actor)(struct pipe_inode_info *, struct pipe_buffer *,
+			   struct splice_desc *);
+
+/* pipe buffer operations for pages with a plain page reference */
+extern struct pipe_buf_operations page_pipe_buf_ops;
+
+extern ssize_t splice_to_pipe(struct inode *, struct splice_pipe_desc *);
+extern ssize_t splice_from_pipe(struct inode *, struct file *, loff_t *,
+				size_t, unsigned int, splice_actor *);
+extern int splice_wait_pipe_room(struct inode *, unsigned int);
+
+/* Free buffer slots, a hint for sizing splice_to_pipe() requests */
+static inline int splice_pipe_room(struct inode *pipe)
+{
+	return PIPE_BUFFERS - pipe->i_pipe->nrbufs;
+}
+
 #endif
@@ -582,6 +582,7 @@ struct task_struct {
 	int lock_depth;		/* BKL lock depth */
 
 	int prio, static_prio;
+	int pi_prio;		/* priority inherited through PI futexes */
 	struct list_head run_list;
 	prio_array_t *array;
 
@@ -651,6 +652,8 @@ struct task_struct {
 	unsigned long long it_sched_expires;
 	struct list_head cpu_timers[3];
 
+	struct list_head pi_state_list;	/* PI futexes owned with waiters */
+
 /* process credentials */
 	uid_t uid,euid,suid,fsuid;
 	gid_t gid,egid,sgid,fsgid;
@@ -715,6 +718,7 @@ struct task_struct {
 	struct backing_dev_info *backing_dev_info;
 
 	struct io_context *io_context;
+	unsigned short ioprio;
 
 	unsigned long ptrace_message;
 	siginfo_t *last_siginfo; /* For ptrace use.  */
@@ -849,6 +853,7 @@ static inline void idle_task_exit(void) {}
 
 extern void sched_idle_next(void);
 extern void set_user_nice(task_t *p, long nice);
+extern void set_task_pi_prio(task_t *p, int prio);
 extern int task_prio(const task_t *p);
 extern int task_nice(const task_t *p);
 extern int can_nice(const task_t *p, const int nice);
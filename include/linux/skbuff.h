@@ -199,6 +199,7 @@ struct skb_shared_info {
  *	@tc_index: Traffic control index
  *	@tc_verd: traffic control verdict
  *	@tc_classid: traffic control classid
+ *	@pool: receive pool the buffer returns to when freed
  */
 
 struct sk_buff {
@@ -283,6 +284,9 @@ struct sk_buff {
 	__u32           tc_classid;            /* traffic control classid */
 #endif
 
+#endif
+#ifdef CONFIG_NET_SKB_RECYCLE
+	struct sk_buff_pool	*pool;
 #endif
 
 
@@ -1011,6 +1015,71 @@ static inline struct sk_buff *dev_alloc_skb(unsigned int length)
 	return __dev_alloc_skb(length, GFP_ATOMIC);
 }
 
+#ifdef CONFIG_NET_SKB_RECYCLE
+/**
+ *	struct sk_buff_pool - receive buffer recycling pool
+ *	@queue: buffers waiting to be handed out again
+ *	@dev: device owning the pool, for reporting only
+ *	@length: dev_alloc_skb() length of every buffer in the pool
+ *	@bufsize: data area size (end - head) of a pristine buffer
+ *	@headroom: headroom of a pristine buffer
+ *	@max: maximum number of buffers kept in @queue
+ *	@refcnt: owner reference plus one per buffer tagged with the pool
+ *	@dead: pool destroyed, tagged buffers are freed normally
+ *	@list: entry in the global list shown in /proc/net/skb_pool
+ *	@hits: allocations served from @queue
+ *	@misses: allocations that fell back to the slab
+ *	@recycled: buffers returned to @queue on free
+ *	@overflow: buffers freed because @queue was full
+ *	@unsafe: buffers freed because they were shared, resized or paged
+ *
+ *	The statistics are protected by the @queue lock.
+ */
+struct sk_buff_pool {
+	struct sk_buff_head	queue;
+	struct net_device	*dev;
+	unsigned int		length;
+	unsigned int		bufsize;
+	unsigned int		headroom;
+	unsigned int		max;
+	atomic_t		refcnt;
+	int			dead;
+	struct list_head	list;
+
+	unsigned long		hits;
+	unsigned long		misses;
+	unsigned long		recycled;
+	unsigned long		overflow;
+	unsigned long		unsafe;
+};
+
+extern struct sk_buff_pool *skb_pool_create(struct net_device *dev,
+					    unsigned int length,
+					    unsigned int max);
+extern void skb_pool_destroy(struct sk_buff_pool *pool);
+extern struct sk_buff *skb_pool_alloc(struct sk_buff_pool *pool,
+				      unsigned int length, int gfp_mask);
+#else
+struct sk_buff_pool;
+
+static inline struct sk_buff_pool *skb_pool_create(struct net_device *dev,
+						   unsigned int length,
+						   unsigned int max)
+{
+	return NULL;
+}
+
+static inline void skb_pool_destroy(struct sk_buff_pool *pool)
+{
+}
+
+static inline struct sk_buff *skb_pool_alloc(struct sk_buff_pool *pool,
+					     unsigned int length, int gfp_mask)
+{
+	return __dev_alloc_skb(length, gfp_mask);
+}
+#endif /* CONFIG_NET_SKB_RECYCLE */
+
 /**
  *	skb_cow - copy header of skb when it is required
  *	@skb: buffer to cow
@@ -1180,6 +1249,10 @@ extern int	       skb_copy_bits(const struct sk_buff *skb, int offset,
 				     void *to, int len);
 extern int	       skb_store_bits(const struct sk_buff *skb, int offset,
 				      void *from, int len);
+struct inode;
+extern int	       skb_splice_bits(struct sk_buff *skb, unsigned int offset,
+				       struct inode *pipe, unsigned int len,
+				       unsigned int flags);
 extern unsigned int    skb_copy_and_csum_bits(const struct sk_buff *skb,
 					      int offset, u8 *to, int len,
 					      unsigned int csum);
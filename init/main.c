@@ -47,6 +47,7 @@
 #include <linux/rmap.h>
 #include <linux/mempolicy.h>
 #include <linux/key.h>
+#include <linux/async.h>
 #include <mcp.h>
 #include <linux/reboot.h>	// For machine_restart
 #if CONFIG_REALTEK_TEXT_DEBUG || CONFIG_REALTEK_MEMORY_DEBUG_MODE || CONFIG_REALTEK_USER_DEBUG
@@ -691,7 +692,8 @@ asmlinkage void __init start_kernel(void)
 	rest_init();
 }
 
-static int __initdata initcall_debug;
+/* Also used by kernel/async.c, which outlives the init sections */
+int initcall_debug;
 
 static int __init initcall_debug_setup(char *str)
 {
@@ -710,15 +712,25 @@ static void __init do_initcalls(void)
 	int count = preempt_count();
 
 	for (call = __initcall_start; call < __initcall_end; call++) {
+		struct timeval start, end;
 		char *msg;
+		int ret;
 
 		if (initcall_debug) {
 			printk(KERN_DEBUG "Calling initcall 0x%p", *call);
 			print_fn_descriptor_symbol(": %s()", (unsigned long) *call);
 			printk("\n");
+			do_gettimeofday(&start);
 		}
 
-		(*call)();
+		ret = (*call)();
+
+		if (initcall_debug) {
+			do_gettimeofday(&end);
+			printk(KERN_DEBUG "initcall 0x%p returned %d after %ld usecs\n",
+			       *call, ret, (end.tv_sec - start.tv_sec) * USEC_PER_SEC +
+			       (end.tv_usec - start.tv_usec));
+		}
 
 		msg = NULL;
 		if (preempt_count() != count) {
@@ -840,6 +852,9 @@ static int init(void * unused)
 
 	do_basic_setup();
 
+	/* Asynchronous probes must be done before we look for the root fs */
+	async_synchronize_full();
+
 #ifdef CONFIG_PRINTK
 	printk_setup_tail();
 #endif
@@ -0,0 +1,207 @@
+/*
+ * kernel/async.c
+ *
+ * Asynchronous function calls for boot time probing.
+ *
+ * Drivers whose probe mostly sleeps on hardware (spinning up a disk,
+ * scanning a NAND bad block table, resetting a USB controller) hand that
+ * work to async_schedule() instead of doing it inline in their initcall,
+ * so the rest of the initcalls carry on meanwhile.
+ *
+ * Every call gets a cookie from a counter that only goes up. Calls are
+ * started in cookie order by a small pool of helper threads which exit
+ * once there is nothing left to run; async_synchronize_cookie() waits
+ * until every call with a lower cookie has finished.
+ *
+ * Booting with "noasync" runs every call synchronously at the point it
+ * is scheduled, which is handy to rule out probe ordering problems.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <linux/config.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/wait.h>
+#include <linux/kthread.h>
+#include <linux/kallsyms.h>
+#include <linux/err.h>
+#include <linux/time.h>
+#include <linux/async.h>
+
+#define MAX_ASYNC_THREADS	8
+
+struct async_entry {
+	struct list_head	list;
+	async_cookie_t		cookie;
+	async_func_ptr		*func;
+	void			*data;
+};
+
+static async_cookie_t next_cookie = 1;
+
+/* Both lists are kept in cookie order */
+static LIST_HEAD(async_pending);
+static LIST_HEAD(async_running);
+static DEFINE_SPINLOCK(async_lock);
+static int async_nr_threads;
+
+static DECLARE_WAIT_QUEUE_HEAD(async_done);
+
+static int async_enabled = 1;
+
+static int __init noasync_setup(char *str)
+{
+	async_enabled = 0;
+	return 1;
+}
+__setup("noasync", noasync_setup);
+
+static void run_one_entry(async_func_ptr *func, void *data,
+			  async_cookie_t cookie)
+{
+	struct timeval start, end;
+
+	if (initcall_debug) {
+		printk(KERN_DEBUG "async: calling %llu @ ", cookie);
+		print_fn_descriptor_symbol("%s()\n", (unsigned long) func);
+		do_gettimeofday(&start);
+	}
+
+	func(data, cookie);
+
+	if (initcall_debug) {
+		do_gettimeofday(&end);
+		printk(KERN_DEBUG "async: %llu returned after %ld usecs\n",
+		       cookie, (end.tv_sec - start.tv_sec) * USEC_PER_SEC +
+		       (end.tv_usec - start.tv_usec));
+	}
+}
+
+/*
+ * Runs queued calls until there are none left. Also called directly by
+ * async_schedule() when no helper thread could be started.
+ */
+static int async_thread(void *unused)
+{
+	struct async_entry *entry;
+
+	spin_lock(&async_lock);
+	while (!list_empty(&async_pending)) {
+		entry = list_entry(async_pending.next, struct async_entry, list);
+		list_move_tail(&entry->list, &async_running);
+		spin_unlock(&async_lock);
+
+		run_one_entry(entry->func, entry->data, entry->cookie);
+
+		spin_lock(&async_lock);
+		list_del(&entry->list);
+		kfree(entry);
+		wake_up(&async_done);
+	}
+	async_nr_threads--;
+	spin_unlock(&async_lock);
+
+	return 0;
+}
+
+/**
+ * async_schedule - run a function asynchronously
+ * @func: function to run, called with @data and its cookie
+ * @data: argument for @func
+ *
+ * Returns the cookie of the call. When the call cannot be queued it is
+ * run before async_schedule() returns.
+ */
+async_cookie_t async_schedule(async_func_ptr *func, void *data)
+{
+	struct async_entry *entry = NULL;
+	struct task_struct *tsk;
+	async_cookie_t cookie;
+	int spawn = -1;
+
+	if (async_enabled)
+		entry = kmalloc(sizeof(*entry), GFP_KERNEL);
+
+	spin_lock(&async_lock);
+	cookie = next_cookie++;
+	if (entry) {
+		entry->cookie = cookie;
+		entry->func = func;
+		entry->data = data;
+		list_add_tail(&entry->list, &async_pending);
+		if (async_nr_threads < MAX_ASYNC_THREADS)
+			spawn = async_nr_threads++;
+	}
+	spin_unlock(&async_lock);
+
+	if (!entry) {
+		run_one_entry(func, data, cookie);
+		return cookie;
+	}
+
+	if (spawn >= 0) {
+		tsk = kthread_run(async_thread, NULL, "async/%d", spawn);
+		if (IS_ERR(tsk))
+			async_thread(NULL);
+	}
+
+	return cookie;
+}
+EXPORT_SYMBOL_GPL(async_schedule);
+
+static async_cookie_t lowest_in_progress(void)
+{
+	async_cookie_t ret;
+
+	spin_lock(&async_lock);
+	ret = next_cookie;
+	if (!list_empty(&async_running))
+		ret = list_entry(async_running.next,
+				 struct async_entry, list)->cookie;
+	else if (!list_empty(&async_pending))
+		ret = list_entry(async_pending.next,
+				 struct async_entry, list)->cookie;
+	spin_unlock(&async_lock);
+
+	return ret;
+}
+
+/**
+ * async_synchronize_cookie - wait for the calls scheduled before a cookie
+ * @cookie: the cookie
+ *
+ * Returns once every call with a cookie lower than @cookie has finished.
+ * Calls scheduled later may still be running.
+ */
+void async_synchronize_cookie(async_cookie_t cookie)
+{
+	wait_event(async_done, lowest_in_progress() >= cookie);
+}
+EXPORT_SYMBOL_GPL(async_synchronize_cookie);
+
+static int async_idle(void)
+{
+	int ret;
+
+	spin_lock(&async_lock);
+	ret = list_empty(&async_running) && list_empty(&async_pending);
+	spin_unlock(&async_lock);
+
+	return ret;
+}
+
+/**
+ * async_synchronize_full - wait for every outstanding call
+ */
+void async_synchronize_full(void)
+{
+	wait_event(async_done, async_idle());
+}
+EXPORT_SYMBOL_GPL(async_synchronize_full);
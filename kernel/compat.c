@@ -255,6 +255,16 @@ asmlinkage long compat_sys_futex(u32 __user *uaddr, int op, int val,
 			return -EFAULT;
 		timeout = timespec_to_jiffies(&t) + 1;
 	}
+	if ((op == FUTEX_LOCK_PI) && utime) {
+		struct timespec now;
+
+		if (get_compat_timespec(&t, utime))
+			return -EFAULT;
+		getnstimeofday(&now);
+		set_normalized_timespec(&t, t.tv_sec - now.tv_sec,
+					t.tv_nsec - now.tv_nsec);
+		timeout = t.tv_sec < 0 ? 0 : timespec_to_jiffies(&t) + 1;
+	}
 	if (op >= FUTEX_REQUEUE)
 		val2 = (int) (unsigned long) utime;
 
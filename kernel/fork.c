@@ -935,6 +935,7 @@ static task_t *copy_process(unsigned long clone_flags,
  	INIT_LIST_HEAD(&p->cpu_timers[0]);
  	INIT_LIST_HEAD(&p->cpu_timers[1]);
  	INIT_LIST_HEAD(&p->cpu_timers[2]);
+	INIT_LIST_HEAD(&p->pi_state_list);
 
 	p->lock_depth = -1;		/* -1 = no lock */
 	do_posix_clock_monotonic_gettime(&p->start_time);
@@ -91,8 +91,35 @@ struct futex_q {
 	/* For fd, sigio sent using these. */
 	int fd;
 	struct file *filp;
+
+	/*
+	 * For PI futexes: the state we are blocked on, and why we were
+	 * woken: 1 when the lock was handed to us, -ESRCH when its owner
+	 * exited. Both are protected by futex_pi_lock.
+	 */
+	struct futex_pi_state *pi_state;
+	struct list_head pi_list;
+	struct task_struct *task;
+	int pi_result;
 };
 
+/*
+ * Kernel side of a contended PI futex. It exists while there are
+ * waiters, sits on the owner's pi_state_list and makes the owner run
+ * at the priority of its most important waiter.
+ */
+struct futex_pi_state {
+	struct list_head list;
+	struct list_head waiters;
+	struct task_struct *owner;
+};
+
+/*
+ * Nests inside the hash bucket locks and protects all futex_pi_states
+ * and the pi fields of the futex_qs queued on them.
+ */
+static DEFINE_SPINLOCK(futex_pi_lock);
+
 /*
  * Split the global futex_lock into every hash list lock.
  */
@@ -431,6 +458,7 @@ queue_lock(struct futex_q *q, int fd, struct file *filp)
 	q->filp = filp;
 
 	init_waitqueue_head(&q->waiters);
+	q->pi_state = NULL;
 
 	get_key_refs(&q->key);
 	bh = hash_futex(&q->key);
@@ -718,6 +746,377 @@ out:
 	return ret;
 }
 
+/*
+ * Read-modify-write of a PI futex word happens with the hash bucket lock
+ * held, hence with preemption disabled: on a uniprocessor no other user
+ * thread can touch the word in the meantime, so plain user accesses are
+ * atomic enough. There are no user space cmpxchg primitives for SMP here,
+ * so PI futexes are only offered on UP kernels.
+ */
+static inline int put_futex_value_locked(int __user *to, int val)
+{
+	int ret;
+
+	inc_preempt_count();
+	ret = __copy_to_user_inatomic(to, &val, sizeof(int));
+	dec_preempt_count();
+
+	return ret ? -EFAULT : 0;
+}
+
+/*
+ * Fault the futex page in for writing. Called with mmap_sem held and
+ * no spinlocks. Writing the word back with put_user() instead would
+ * race with user space once the fault sleeps.
+ */
+static int fault_in_futex_writable(unsigned long uaddr)
+{
+	int ret;
+
+	ret = get_user_pages(current, current->mm, uaddr, 1, 1, 0, NULL, NULL);
+	return ret < 0 ? ret : 0;
+}
+
+/* Any waiter, PI or not, queued on the key? Hash bucket lock held. */
+static int futex_has_waiters(struct futex_hash_bucket *bh,
+			     union futex_key *key)
+{
+	struct futex_q *this;
+
+	list_for_each_entry(this, &bh->chain, list)
+		if (match_futex(&this->key, key))
+			return 1;
+	return 0;
+}
+
+/* Hash bucket lock and futex_pi_lock held. */
+static struct futex_pi_state *lookup_pi_state(struct futex_hash_bucket *bh,
+					      union futex_key *key)
+{
+	struct futex_q *this;
+
+	list_for_each_entry(this, &bh->chain, list)
+		if (this->pi_state && match_futex(&this->key, key))
+			return this->pi_state;
+	return NULL;
+}
+
+/*
+ * Boost @p to the priority of the most important task blocked on any
+ * of the PI futexes it owns, or drop the boost. futex_pi_lock held.
+ */
+static void futex_pi_adjust(struct task_struct *p)
+{
+	struct futex_pi_state *pi_state;
+	struct futex_q *this;
+	int prio = MAX_PRIO;
+
+	list_for_each_entry(pi_state, &p->pi_state_list, list)
+		list_for_each_entry(this, &pi_state->waiters, pi_list)
+			if (this->task->prio < prio)
+				prio = this->task->prio;
+
+	if (prio != p->pi_prio)
+		set_task_pi_prio(p, prio);
+}
+
+/* A waiter gives up. futex_pi_lock held. */
+static void futex_pi_remove_waiter(struct futex_q *q)
+{
+	struct futex_pi_state *pi_state = q->pi_state;
+	struct task_struct *owner = pi_state->owner;
+
+	list_del(&q->pi_list);
+	q->pi_state = NULL;
+
+	if (list_empty(&pi_state->waiters)) {
+		list_del(&pi_state->list);
+		kfree(pi_state);
+		futex_pi_adjust(owner);
+		put_task_struct(owner);
+	} else
+		futex_pi_adjust(owner);
+}
+
+static int futex_lock_pi(unsigned long uaddr, unsigned long time, int trylock)
+{
+	DECLARE_WAITQUEUE(wait, current);
+	struct futex_pi_state *pi_state = NULL, *ps;
+	struct futex_hash_bucket *bh;
+	struct task_struct *owner;
+	struct futex_q q;
+	int ret, uval, newval;
+
+#ifdef CONFIG_SMP
+	return -ENOSYS;
+#endif
+ retry:
+	if (!pi_state && !trylock) {
+		pi_state = kmalloc(sizeof(*pi_state), GFP_KERNEL);
+		if (!pi_state)
+			return -ENOMEM;
+	}
+
+	down_read(&current->mm->mmap_sem);
+
+	ret = get_futex_key(uaddr, &q.key);
+	if (unlikely(ret != 0))
+		goto out_release_sem;
+
+	bh = queue_lock(&q, -1, NULL);
+
+	ret = get_futex_value_locked(&uval, (int __user *)uaddr);
+	if (unlikely(ret)) {
+		queue_unlock(&q, bh);
+		up_read(&current->mm->mmap_sem);
+
+		ret = get_user(uval, (int __user *)uaddr);
+		if (!ret)
+			goto retry;
+		goto out;
+	}
+
+	ret = -EDEADLK;
+	if ((uval & FUTEX_TID_MASK) == current->pid)
+		goto out_unlock;
+
+	owner = NULL;
+	if (uval & FUTEX_TID_MASK) {
+		read_lock(&tasklist_lock);
+		owner = find_task_by_pid(uval & FUTEX_TID_MASK);
+		if (owner)
+			get_task_struct(owner);
+		read_unlock(&tasklist_lock);
+	}
+
+	/*
+	 * PF_EXITING is checked under futex_pi_lock, which the exiting
+	 * owner takes afterwards to release its waiters: either it finds
+	 * us on its list, or we see it leaving.
+	 */
+	spin_lock(&futex_pi_lock);
+	if (!owner || (owner->flags & PF_EXITING)) {
+		spin_unlock(&futex_pi_lock);
+		/*
+		 * Unlocked, or the owner is gone: take it. The death of the
+		 * previous owner is reported through FUTEX_OWNER_DIED.
+		 */
+		newval = current->pid;
+		if (uval & FUTEX_TID_MASK)
+			newval |= FUTEX_OWNER_DIED;
+		if (futex_has_waiters(bh, &q.key))
+			newval |= FUTEX_WAITERS;
+		ret = put_futex_value_locked((int __user *)uaddr, newval);
+		goto out_unlock_put;
+	}
+
+	ret = -EWOULDBLOCK;
+	if (trylock)
+		goto out_unlock_pi;
+
+	/* User space and the kernel disagree about the owner */
+	ret = -EINVAL;
+	ps = lookup_pi_state(bh, &q.key);
+	if (ps && ps->owner != owner)
+		goto out_unlock_pi;
+
+	/* Force the owner's unlock into the kernel */
+	if (!(uval & FUTEX_WAITERS)) {
+		ret = put_futex_value_locked((int __user *)uaddr,
+					     uval | FUTEX_WAITERS);
+		if (ret)
+			goto out_unlock_pi;
+	}
+
+	if (!ps) {
+		ps = pi_state;
+		pi_state = NULL;
+		INIT_LIST_HEAD(&ps->waiters);
+		ps->owner = owner;
+		list_add(&ps->list, &owner->pi_state_list);
+		owner = NULL;		/* the reference now belongs to ps */
+	}
+	q.pi_state = ps;
+	q.task = current;
+	q.pi_result = 0;
+	list_add_tail(&q.pi_list, &ps->waiters);
+	futex_pi_adjust(ps->owner);
+	spin_unlock(&futex_pi_lock);
+
+	if (owner)
+		put_task_struct(owner);
+	__queue_me(&q, bh);
+	up_read(&current->mm->mmap_sem);
+
+	/* add_wait_queue is the barrier after __set_current_state. */
+	__set_current_state(TASK_INTERRUPTIBLE);
+	add_wait_queue(&q.waiters, &wait);
+	if (likely(!list_empty(&q.list) && !q.pi_result))
+		time = schedule_timeout(time);
+	__set_current_state(TASK_RUNNING);
+
+	/* The unlock may have handed the futex over in the meantime */
+	spin_lock(&futex_pi_lock);
+	if (!q.pi_result)
+		futex_pi_remove_waiter(&q);
+	ret = q.pi_result;
+	spin_unlock(&futex_pi_lock);
+
+	unqueue_me(&q);
+
+	if (ret > 0) {
+		ret = 0;
+		goto out;
+	}
+	/* Owner died, or a spurious wakeup: look at the word again */
+	if (ret == -ESRCH || (time && !signal_pending(current)))
+		goto retry;
+	ret = time ? -EINTR : -ETIMEDOUT;
+	goto out;
+
+ out_unlock_pi:
+	spin_unlock(&futex_pi_lock);
+ out_unlock_put:
+	if (owner)
+		put_task_struct(owner);
+ out_unlock:
+	queue_unlock(&q, bh);
+	if (ret == -EFAULT) {
+		ret = fault_in_futex_writable(uaddr);
+		if (!ret) {
+			up_read(&current->mm->mmap_sem);
+			goto retry;
+		}
+	}
+ out_release_sem:
+	up_read(&current->mm->mmap_sem);
+ out:
+	kfree(pi_state);
+	return ret;
+}
+
+/*
+ * Hand the futex to the most important waiter, or release it when there
+ * is none.
+ */
+static int futex_unlock_pi(unsigned long uaddr)
+{
+	union futex_key key;
+	struct futex_hash_bucket *bh;
+	struct futex_pi_state *pi_state;
+	struct futex_q *this, *top;
+	int ret, uval, newval;
+
+#ifdef CONFIG_SMP
+	return -ENOSYS;
+#endif
+ retry:
+	down_read(&current->mm->mmap_sem);
+
+	ret = get_futex_key(uaddr, &key);
+	if (unlikely(ret != 0))
+		goto out;
+
+	bh = hash_futex(&key);
+	spin_lock(&bh->lock);
+
+	ret = get_futex_value_locked(&uval, (int __user *)uaddr);
+	if (unlikely(ret)) {
+		spin_unlock(&bh->lock);
+		up_read(&current->mm->mmap_sem);
+
+		ret = get_user(uval, (int __user *)uaddr);
+		if (!ret)
+			goto retry;
+		return ret;
+	}
+
+	ret = -EPERM;
+	if ((uval & FUTEX_TID_MASK) != current->pid)
+		goto out_unlock;
+
+	spin_lock(&futex_pi_lock);
+	top = NULL;
+	pi_state = lookup_pi_state(bh, &key);
+	if (pi_state)
+		list_for_each_entry(this, &pi_state->waiters, pi_list)
+			if (!top || this->task->prio < top->task->prio)
+				top = this;
+
+	newval = 0;
+	if (top) {
+		newval = top->task->pid;
+		if (pi_state->waiters.next != pi_state->waiters.prev)
+			newval |= FUTEX_WAITERS;
+	}
+	ret = put_futex_value_locked((int __user *)uaddr, newval);
+	if (unlikely(ret)) {
+		spin_unlock(&futex_pi_lock);
+		spin_unlock(&bh->lock);
+		ret = fault_in_futex_writable(uaddr);
+		up_read(&current->mm->mmap_sem);
+		if (!ret)
+			goto retry;
+		return ret;
+	}
+
+	if (top) {
+		list_del_init(&top->pi_list);
+		top->pi_state = NULL;
+		top->pi_result = 1;
+
+		list_del(&pi_state->list);
+		put_task_struct(pi_state->owner);
+		if (list_empty(&pi_state->waiters))
+			kfree(pi_state);
+		else {
+			/* The remaining waiters now boost the new owner */
+			pi_state->owner = top->task;
+			get_task_struct(top->task);
+			list_add(&pi_state->list, &top->task->pi_state_list);
+			futex_pi_adjust(top->task);
+		}
+		wake_futex(top);
+	}
+	futex_pi_adjust(current);
+	spin_unlock(&futex_pi_lock);
+
+ out_unlock:
+	spin_unlock(&bh->lock);
+ out:
+	up_read(&current->mm->mmap_sem);
+	return ret;
+}
+
+/*
+ * Called by an exiting task: wake everybody blocked on the PI futexes it
+ * still owns. They find the owner gone and take the futex over with
+ * FUTEX_OWNER_DIED set.
+ */
+void exit_pi_state_list(struct task_struct *tsk)
+{
+	struct futex_pi_state *pi_state;
+	struct futex_q *this, *next;
+
+	spin_lock(&futex_pi_lock);
+	while (!list_empty(&tsk->pi_state_list)) {
+		pi_state = list_entry(tsk->pi_state_list.next,
+				      struct futex_pi_state, list);
+		list_del(&pi_state->list);
+		list_for_each_entry_safe(this, next, &pi_state->waiters, pi_list) {
+			list_del_init(&this->pi_list);
+			this->pi_state = NULL;
+			this->pi_result = -ESRCH;
+			wake_up_all(&this->waiters);
+		}
+		put_task_struct(pi_state->owner);
+		kfree(pi_state);
+	}
+	if (tsk->pi_prio != MAX_PRIO)
+		set_task_pi_prio(tsk, MAX_PRIO);
+	spin_unlock(&futex_pi_lock);
+}
+
 long do_futex(unsigned long uaddr, int op, int val, unsigned long timeout,
 		unsigned long uaddr2, int val2, int val3)
 {
@@ -740,6 +1139,15 @@ long do_futex(unsigned long uaddr, int op, int val, unsigned long timeout,
 	case FUTEX_CMP_REQUEUE:
 		ret = futex_requeue(uaddr, uaddr2, val, val2, &val3);
 		break;
+	case FUTEX_LOCK_PI:
+		ret = futex_lock_pi(uaddr, timeout, 0);
+		break;
+	case FUTEX_UNLOCK_PI:
+		ret = futex_unlock_pi(uaddr);
+		break;
+	case FUTEX_TRYLOCK_PI:
+		ret = futex_lock_pi(uaddr, 0, 1);
+		break;
 	default:
 		ret = -ENOSYS;
 	}
@@ -760,6 +1168,19 @@ asmlinkage long sys_futex(u32 __user *uaddr, int op, int val,
 			return -EFAULT;
 		timeout = timespec_to_jiffies(&t) + 1;
 	}
+	/*
+	 * FUTEX_LOCK_PI takes an absolute CLOCK_REALTIME timeout.
+	 */
+	if ((op == FUTEX_LOCK_PI) && utime) {
+		struct timespec now;
+
+		if (copy_from_user(&t, utime, sizeof(t)) != 0)
+			return -EFAULT;
+		getnstimeofday(&now);
+		set_normalized_timespec(&t, t.tv_sec - now.tv_sec,
+					t.tv_nsec - now.tv_nsec);
+		timeout = t.tv_sec < 0 ? 0 : timespec_to_jiffies(&t) + 1;
+	}
 	/*
 	 * requeue parameter in 'utime' if op == FUTEX_REQUEUE.
 	 */
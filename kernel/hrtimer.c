@@ -0,0 +1,359 @@
+/*
+ * linux/kernel/hrtimer.c
+ *
+ * High resolution one-shot timers.
+ *
+ * Timers are kept in an rbtree ordered by their absolute CLOCK_MONOTONIC
+ * expiry in nanoseconds. Only the earliest timer is ever programmed into
+ * the hardware: the architecture registers a one-shot event source and
+ * calls hrtimer_interrupt() from its interrupt handler, which kicks a high
+ * priority tasklet that runs every expired callback and re-arms the source
+ * for the next one.
+ *
+ * Without an event source, or for deltas beyond the reach of the source,
+ * a plain timer_list stands in, so timers still work at tick granularity.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <linux/config.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/interrupt.h>
+#include <linux/timer.h>
+#include <linux/hrtimer.h>
+
+#include <asm/uaccess.h>
+#include <asm/div64.h>
+
+static void hrtimer_run(unsigned long data);
+static void hrtimer_tick_fn(unsigned long data);
+
+static struct hrtimer_base {
+	spinlock_t			lock;
+	struct rb_root			active;
+	struct rb_node			*first;
+	struct hrtimer			*running;
+	struct hrtimer_event_source	*source;
+	struct timer_list		tick_timer;
+} hrtimer_base = {
+	.lock		= SPIN_LOCK_UNLOCKED,
+	.active		= RB_ROOT,
+	.tick_timer	= TIMER_INITIALIZER(hrtimer_tick_fn, 0, 0),
+};
+
+static DECLARE_TASKLET(hrtimer_tasklet, hrtimer_run, 0);
+
+/**
+ * hrtimer_now - current CLOCK_MONOTONIC time in nanoseconds
+ */
+u64 hrtimer_now(void)
+{
+	struct timespec ts;
+
+	do_posix_clock_monotonic_gettime(&ts);
+	return timespec_to_ns(&ts);
+}
+EXPORT_SYMBOL_GPL(hrtimer_now);
+
+static void hrtimer_enqueue(struct hrtimer_base *base, struct hrtimer *timer)
+{
+	struct rb_node **link = &base->active.rb_node;
+	struct rb_node *parent = NULL;
+	int leftmost = 1;
+
+	while (*link) {
+		struct hrtimer *entry;
+
+		parent = *link;
+		entry = rb_entry(parent, struct hrtimer, node);
+		if (timer->expires < entry->expires)
+			link = &parent->rb_left;
+		else {
+			link = &parent->rb_right;
+			leftmost = 0;
+		}
+	}
+
+	rb_link_node(&timer->node, parent, link);
+	rb_insert_color(&timer->node, &base->active);
+	if (leftmost)
+		base->first = &timer->node;
+	timer->state = HRTIMER_ENQUEUED;
+}
+
+static void hrtimer_dequeue(struct hrtimer_base *base, struct hrtimer *timer)
+{
+	if (base->first == &timer->node)
+		base->first = rb_next(&timer->node);
+	rb_erase(&timer->node, &base->active);
+	timer->state = HRTIMER_INACTIVE;
+}
+
+/*
+ * Arm the event source (or the tick fallback) for the earliest pending
+ * timer. Called with base->lock held.
+ */
+static void hrtimer_reprogram(struct hrtimer_base *base)
+{
+	struct hrtimer_event_source *src = base->source;
+	struct hrtimer *timer;
+	struct timespec ts;
+	u64 now, delta;
+
+	if (!base->first)
+		return;
+
+	timer = rb_entry(base->first, struct hrtimer, node);
+	now = hrtimer_now();
+	if (timer->expires <= now) {
+		tasklet_hi_schedule(&hrtimer_tasklet);
+		return;
+	}
+
+	delta = timer->expires - now;
+	if (src && delta <= src->max_delta_ns) {
+		if (delta < src->min_delta_ns)
+			delta = src->min_delta_ns;
+		if (src->set_next_event((unsigned long) delta))
+			tasklet_hi_schedule(&hrtimer_tasklet);
+		return;
+	}
+
+	/*
+	 * Out of reach of the event source: sleep on the tick and have
+	 * another look when it fires.
+	 */
+	if (src)
+		delta = src->max_delta_ns;
+	ts.tv_nsec = do_div(delta, NSEC_PER_SEC);
+	ts.tv_sec = (time_t) delta;
+	mod_timer(&base->tick_timer, jiffies + timespec_to_jiffies(&ts));
+}
+
+/**
+ * hrtimer_start - (re)start a high resolution timer
+ * @timer: the timer to be added
+ * @expires: absolute CLOCK_MONOTONIC expiry in nanoseconds
+ *
+ * Returns 1 when the timer was pending and has been requeued, 0 otherwise.
+ */
+int hrtimer_start(struct hrtimer *timer, u64 expires)
+{
+	struct hrtimer_base *base = &hrtimer_base;
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&base->lock, flags);
+	if (hrtimer_active(timer)) {
+		hrtimer_dequeue(base, timer);
+		ret = 1;
+	}
+	timer->expires = expires;
+	hrtimer_enqueue(base, timer);
+	if (base->first == &timer->node)
+		hrtimer_reprogram(base);
+	spin_unlock_irqrestore(&base->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(hrtimer_start);
+
+/**
+ * hrtimer_try_to_cancel - try to deactivate a timer
+ * @timer: the timer to be deactivated
+ *
+ * Returns 1 when the timer was pending, 0 when it was not, and -1 when
+ * its callback is running right now and it cannot be stopped.
+ */
+int hrtimer_try_to_cancel(struct hrtimer *timer)
+{
+	struct hrtimer_base *base = &hrtimer_base;
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&base->lock, flags);
+	if (base->running == timer)
+		ret = -1;
+	else if (hrtimer_active(timer)) {
+		/*
+		 * The event source stays armed for the removed timer; the
+		 * tasklet copes with finding nothing expired.
+		 */
+		hrtimer_dequeue(base, timer);
+		ret = 1;
+	}
+	spin_unlock_irqrestore(&base->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(hrtimer_try_to_cancel);
+
+/**
+ * hrtimer_cancel - deactivate a timer and wait for its callback to finish
+ * @timer: the timer to be deactivated
+ *
+ * Must not be called from the timer's own callback.
+ */
+int hrtimer_cancel(struct hrtimer *timer)
+{
+	int ret;
+
+	while ((ret = hrtimer_try_to_cancel(timer)) < 0)
+		cpu_relax();
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(hrtimer_cancel);
+
+static void hrtimer_run(unsigned long data)
+{
+	struct hrtimer_base *base = &hrtimer_base;
+	struct rb_node *node;
+	u64 now;
+
+	spin_lock_irq(&base->lock);
+	now = hrtimer_now();
+	while ((node = base->first)) {
+		struct hrtimer *timer = rb_entry(node, struct hrtimer, node);
+
+		if (timer->expires > now)
+			break;
+
+		hrtimer_dequeue(base, timer);
+		base->running = timer;
+		spin_unlock_irq(&base->lock);
+
+		timer->function(timer);
+
+		spin_lock_irq(&base->lock);
+		base->running = NULL;
+	}
+	hrtimer_reprogram(base);
+	spin_unlock_irq(&base->lock);
+}
+
+static void hrtimer_tick_fn(unsigned long data)
+{
+	tasklet_hi_schedule(&hrtimer_tasklet);
+}
+
+/**
+ * hrtimer_interrupt - event source interrupt entry
+ *
+ * Called by the architecture from the event source's interrupt handler,
+ * inside irq_enter()/irq_exit() so that the tasklet runs on the way out.
+ */
+void hrtimer_interrupt(void)
+{
+	tasklet_hi_schedule(&hrtimer_tasklet);
+}
+
+/**
+ * hrtimer_register_event_source - install the one-shot event source
+ * @src: the event source
+ *
+ * Pending timers are reprogrammed onto the new source.
+ */
+void hrtimer_register_event_source(struct hrtimer_event_source *src)
+{
+	struct hrtimer_base *base = &hrtimer_base;
+	unsigned long flags;
+
+	spin_lock_irqsave(&base->lock, flags);
+	base->source = src;
+	hrtimer_reprogram(base);
+	spin_unlock_irqrestore(&base->lock, flags);
+
+	printk(KERN_INFO "hrtimer: using %s as event source\n", src->name);
+}
+
+static void hrtimer_wakeup(struct hrtimer *timer)
+{
+	struct task_struct *task = (struct task_struct *) timer->data;
+
+	timer->data = 0;
+	wake_up_process(task);
+}
+
+static int hrtimer_sleep_until(u64 expires)
+{
+	struct hrtimer t;
+
+	hrtimer_init(&t);
+	t.function = hrtimer_wakeup;
+	t.data = (unsigned long) current;
+
+	do {
+		set_current_state(TASK_INTERRUPTIBLE);
+		hrtimer_start(&t, expires);
+		if (t.data)
+			schedule();
+		hrtimer_cancel(&t);
+	} while (t.data && !signal_pending(current));
+
+	__set_current_state(TASK_RUNNING);
+
+	return t.data ? -EINTR : 0;
+}
+
+/**
+ * hrtimer_nanosleep - sleep until an absolute CLOCK_MONOTONIC time
+ * @expires: wakeup time in nanoseconds
+ * @rem: time left, filled in when interrupted
+ * @abs: the caller asked for an absolute (TIMER_ABSTIME) sleep
+ *
+ * Returns 0 when the full time has elapsed, or -ERESTART_RESTARTBLOCK
+ * with the restart block set up to resume the sleep.  An interrupted
+ * absolute sleep leaves @rem alone and returns -ERESTARTNOHAND, the
+ * restarted call then sleeps until the same absolute time.
+ */
+long hrtimer_nanosleep(u64 expires, struct timespec *rem, int abs)
+{
+	struct restart_block *restart;
+	u64 now, left;
+
+	if (!hrtimer_sleep_until(expires))
+		return 0;
+
+	now = hrtimer_now();
+	if (expires <= now)
+		return 0;
+
+	if (abs)
+		return -ERESTARTNOHAND;
+
+	left = expires - now;
+	rem->tv_nsec = do_div(left, NSEC_PER_SEC);
+	rem->tv_sec = (time_t) left;
+
+	/* The caller fills in arg1 with the user's timespec pointer */
+	restart = &current_thread_info()->restart_block;
+	restart->fn = hrtimer_nanosleep_restart;
+	restart->arg2 = (unsigned long) expires;
+	restart->arg3 = (unsigned long) (expires >> 32);
+
+	return -ERESTART_RESTARTBLOCK;
+}
+
+long hrtimer_nanosleep_restart(struct restart_block *restart)
+{
+	struct timespec __user *rmtp = (struct timespec __user *) restart->arg1;
+	struct timespec rem;
+	u64 expires;
+	long ret;
+
+	expires = ((u64) restart->arg3 << 32) | (u32) restart->arg2;
+	restart->fn = do_no_restart_syscall;
+
+	ret = hrtimer_nanosleep(expires, &rem, 0);
+	if (ret == -ERESTART_RESTARTBLOCK && rmtp &&
+	    copy_to_user(rmtp, &rem, sizeof(rem)))
+		return -EFAULT;
+
+	return ret;
+}
@@ -35,6 +35,7 @@
 #include <linux/notifier.h>
 #include <linux/stop_machine.h>
 #include <linux/device.h>
+#include <linux/async.h>
 #include <asm/uaccess.h>
 #include <asm/semaphore.h>
 #include <asm/cacheflush.h>
@@ -1827,6 +1828,12 @@ sys_init_module(void __user *umod,
 		return ret;
 	}
 
+	/*
+	 * The init routine may have scheduled asynchronous probes that still
+	 * run code or touch data in the init sections we are about to free.
+	 */
+	async_synchronize_full();
+
 	/* Now it's a first class citizen! */
 	down(&module_mutex);
 	mod->state = MODULE_STATE_LIVE;
@@ -43,6 +43,7 @@
 #include <linux/compiler.h>
 #include <linux/idr.h>
 #include <linux/posix-timers.h>
+#include <linux/hrtimer.h>
 #include <linux/syscalls.h>
 #include <linux/wait.h>
 #include <linux/workqueue.h>
@@ -1480,6 +1481,25 @@ static int common_nsleep(clockid_t which_clock,
 	struct restart_block *restart_block =
 	    &current_thread_info()->restart_block;
 
+#ifdef CONFIG_HIGH_RES_TIMERS
+	/*
+	 * Relative sleeps and absolute monotonic ones cannot be disturbed
+	 * by clock_settime(), so they go to the high resolution timers.
+	 * The caller has already put rmtp in arg1 for the restart.  An
+	 * absolute sleep never reports a remainder and is restarted with
+	 * its original expiry.
+	 */
+	if (restart_block->fn != clock_nanosleep_restart &&
+	    (!(flags & TIMER_ABSTIME) || which_clock == CLOCK_MONOTONIC)) {
+		u64 expires = timespec_to_ns(tsave);
+
+		if (!(flags & TIMER_ABSTIME))
+			expires += hrtimer_now();
+		return hrtimer_nanosleep(expires, tsave,
+					 flags & TIMER_ABSTIME);
+	}
+#endif
+
 	abs_wqueue.flags = 0;
 	init_timer(&new_timer);
 	new_timer.expires = 0;
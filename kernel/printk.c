@@ -31,6 +31,8 @@
 #include <linux/security.h>
 #include <linux/bootmem.h>
 #include <linux/syscalls.h>
+#include <linux/kthread.h>
+#include <linux/err.h>
 
 #include <asm/uaccess.h>
 
@@ -123,6 +125,33 @@ static int preferred_console = -1;
 /* Flag: console code may call schedule() */
 static int console_may_schedule;
 
+#ifdef CONFIG_PRINTK_DEFERRED
+/*
+ * printk() only appends to log_buf; printk_drain_thread() writes it out
+ * to the consoles, at most printk_drain_budget chars per tick and with
+ * interrupts enabled. Until the thread is up, and while an oops is in
+ * progress, printk() writes to the consoles synchronously as before.
+ */
+static DECLARE_WAIT_QUEUE_HEAD(printk_drain_wait);
+static struct task_struct *printk_drain_task;
+static unsigned long printk_drain_budget = 128;
+
+static int __init printk_drain_setup(char *str)
+{
+	printk_drain_budget = simple_strtoul(str, NULL, 0);
+	return 1;
+}
+
+__setup("printk_drain=", printk_drain_setup);
+
+static inline int printk_deferred(void)
+{
+	return printk_drain_task && !oops_in_progress;
+}
+#else
+#define printk_deferred()	0
+#endif
+
 /*
  *	Setup a list of consoles. Called from init/main.c
  */
@@ -724,7 +753,15 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 		spin_unlock_irqrestore(&logbuf_lock, flags);
 		goto out;
 	}
-	if (!down_trylock(&console_sem)) {
+	if (printk_deferred()) {
+		/* Leave the text for printk_drain_thread() */
+		unlock_hw_sem();
+		spin_unlock_irqrestore(&logbuf_lock, flags);
+#ifdef CONFIG_PRINTK_DEFERRED
+		if (waitqueue_active(&printk_drain_wait))
+			wake_up_interruptible(&printk_drain_wait);
+#endif
+	} else if (!down_trylock(&console_sem)) {
 		console_locked = 1;
 		/*
 		 * We own the drivers.  We can drop the spinlock and let
@@ -831,21 +868,12 @@ int is_console_locked(void)
 }
 EXPORT_SYMBOL(is_console_locked);
 
-/**
- * release_console_sem - unlock the console system
- *
- * Releases the semaphore which the caller holds on the console system
- * and the console driver list.
- *
- * While the semaphore was held, console output may have been buffered
- * by printk().  If this is the case, release_console_sem() emits
- * the output prior to releasing the semaphore.
- *
- * If there is output waiting for klogd, we wake it up.
- *
- * release_console_sem() may be called from any context.
+/*
+ * Write out at most @budget chars of pending output, then drop the
+ * console semaphore. With @irqs_on the console drivers are called with
+ * interrupts enabled.
  */
-void release_console_sem(void)
+static void __release_console_sem(unsigned long budget, int irqs_on)
 {
 	unsigned long flags;
 	unsigned long _con_start, _log_end;
@@ -856,25 +884,25 @@ void release_console_sem(void)
 		spin_lock_irqsave(&logbuf_lock, flags);
 		lock_hw_sem();
 		wake_klogd |= log_start - log_end;
-		if (con_start == log_end)
+		if (con_start == log_end || !budget)
 			break;			/* Nothing to print */
 		_con_start = con_start;
-#ifdef CONFIG_SHARED_PRINTK
-		if (log_end - con_start > 100) {
-			_log_end = _con_start+100;
-			con_start = _log_end;
-		} else {
-			_log_end = log_end;
-			con_start = log_end;	/* Flush */
-		}
-#else
 		_log_end = log_end;
-		con_start = log_end;		/* Flush */
+#ifdef CONFIG_SHARED_PRINTK
+		if (_log_end - _con_start > 100)
+			_log_end = _con_start + 100;
 #endif
+		if (_log_end - _con_start > budget)
+			_log_end = _con_start + budget;
+		budget -= _log_end - _con_start;
+		con_start = _log_end;
 		unlock_hw_sem();
 		spin_unlock(&logbuf_lock);
+		if (irqs_on)
+			local_irq_restore(flags);
 		call_console_drivers(_con_start, _log_end);
-		local_irq_restore(flags);
+		if (!irqs_on)
+			local_irq_restore(flags);
 	}
 	console_locked = 0;
 	console_may_schedule = 0;
@@ -883,9 +911,72 @@ void release_console_sem(void)
 	spin_unlock_irqrestore(&logbuf_lock, flags);
 	if (wake_klogd && !oops_in_progress && waitqueue_active(&log_wait))
 		wake_up_interruptible(&log_wait);
+#ifdef CONFIG_PRINTK_DEFERRED
+	/* Unlocked peek; the drain thread looks again under the lock */
+	if (con_start != log_end && printk_deferred() &&
+	    current != printk_drain_task &&
+	    waitqueue_active(&printk_drain_wait))
+		wake_up_interruptible(&printk_drain_wait);
+#endif
+}
+
+/**
+ * release_console_sem - unlock the console system
+ *
+ * Releases the semaphore which the caller holds on the console system
+ * and the console driver list.
+ *
+ * While the semaphore was held, console output may have been buffered
+ * by printk().  If this is the case, release_console_sem() emits
+ * the output prior to releasing the semaphore, unless printk output is
+ * deferred, in which case the drain thread is kicked to do it.
+ *
+ * If there is output waiting for klogd, we wake it up.
+ *
+ * release_console_sem() may be called from any context.
+ */
+void release_console_sem(void)
+{
+	__release_console_sem(printk_deferred() ? 0 : ~0UL, 0);
 }
 EXPORT_SYMBOL(release_console_sem);
 
+#ifdef CONFIG_PRINTK_DEFERRED
+static int printk_drain_thread(void *unused)
+{
+	for (;;) {
+		wait_event_interruptible(printk_drain_wait, con_start != log_end);
+
+		acquire_console_sem();
+		__release_console_sem(printk_drain_budget, 1);
+
+		/* Rate limit: the rest waits for the next tick */
+		if (con_start != log_end) {
+			set_current_state(TASK_INTERRUPTIBLE);
+			schedule_timeout(1);
+		}
+	}
+
+	return 0;
+}
+
+static int __init printk_drain_init(void)
+{
+	struct task_struct *tsk;
+
+	if (!printk_drain_budget)
+		return 0;
+
+	tsk = kthread_run(printk_drain_thread, NULL, "kprintkd");
+	if (IS_ERR(tsk))
+		return PTR_ERR(tsk);
+	printk_drain_task = tsk;
+
+	return 0;
+}
+postcore_initcall(printk_drain_init);
+#endif
+
 /** console_conditional_schedule - yield the CPU if required
  *
  * If the console code is currently allowed to sleep, and
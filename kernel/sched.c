@@ -591,13 +591,15 @@ static inline void enqueue_task_head(struct task_struct *p, prio_array_t *array)
  * 2) nice -20 CPU hogs do not get preempted by nice 0 tasks.
  *
  * Both properties are important to certain workloads.
+ *
+ * normal_prio() is that priority for any policy, ignoring PI boosting.
  */
-static int effective_prio(task_t *p)
+static int normal_prio(task_t *p)
 {
 	int bonus, prio;
 
-	if (rt_task(p))
-		return p->prio;
+	if (p->policy != SCHED_NORMAL)
+		return MAX_USER_RT_PRIO-1 - p->rt_priority;
 
 	bonus = CURRENT_BONUS(p) - MAX_BONUS / 2;
 
@@ -609,6 +611,25 @@ static int effective_prio(task_t *p)
 	return prio;
 }
 
+/*
+ * effective_prio - the normal priority, raised to any priority inherited
+ * through PI futexes. RT priorities are only changed by setscheduler and
+ * set_task_pi_prio().
+ */
+static int effective_prio(task_t *p)
+{
+	int prio;
+
+	if (rt_task(p))
+		return p->prio;
+
+	prio = normal_prio(p);
+	/* A PI futex owner runs at least at its top waiter's priority */
+	if (prio > p->pi_prio)
+		prio = p->pi_prio;
+	return prio;
+}
+
 /*
  * __activate_task - move a task to the runqueue.
  */
@@ -1146,6 +1167,11 @@ void fastcall sched_fork(task_t *p)
 	INIT_LIST_HEAD(&p->run_list);
 	p->array = NULL;
 	spin_lock_init(&p->switch_lock);
+	/* The child does not own the parent's PI futexes */
+	if (unlikely(p->pi_prio != MAX_PRIO)) {
+		p->pi_prio = MAX_PRIO;
+		p->prio = normal_prio(p);
+	}
 #ifdef CONFIG_SCHEDSTATS
 	memset(&p->sched_info, 0, sizeof(p->sched_info));
 #endif
@@ -3243,6 +3269,52 @@ out_unlock:
 
 EXPORT_SYMBOL(set_user_nice);
 
+/**
+ * set_task_pi_prio - set the priority a task inherits through PI futexes
+ * @p: the task
+ * @prio: the top waiter's priority, MAX_PRIO to drop the boost
+ *
+ * The task runs at the higher of its own and the inherited priority. A
+ * SCHED_NORMAL task boosted into the RT range is scheduled like a
+ * SCHED_FIFO one until the boost is dropped.
+ */
+void set_task_pi_prio(task_t *p, int prio)
+{
+	unsigned long flags;
+	prio_array_t *array;
+	runqueue_t *rq;
+	int oldprio, newprio;
+
+	rq = task_rq_lock(p, &flags);
+	p->pi_prio = prio;
+	newprio = normal_prio(p);
+	if (newprio > prio)
+		newprio = prio;
+	oldprio = p->prio;
+	if (newprio == oldprio)
+		goto out_unlock;
+
+	array = p->array;
+	if (array)
+		dequeue_task(p, array);
+	p->prio = newprio;
+	if (array) {
+		enqueue_task(p, array);
+		/*
+		 * Reschedule if we are currently running on this runqueue and
+		 * our priority decreased, or if we are not currently running on
+		 * this runqueue and our priority is higher than the current's
+		 */
+		if (task_running(rq, p)) {
+			if (p->prio > oldprio)
+				resched_task(rq->curr);
+		} else if (TASK_PREEMPTS_CURR(p, rq))
+			resched_task(rq->curr);
+	}
+out_unlock:
+	task_rq_unlock(rq, &flags);
+}
+
 /*
  * can_nice - check if a task can reduce its nice value
  * @p: task
@@ -3369,6 +3441,8 @@ static void __setscheduler(struct task_struct *p, int policy, int prio)
 		p->prio = MAX_USER_RT_PRIO-1 - p->rt_priority;
 	else
 		p->prio = p->static_prio;
+	if (p->prio > p->pi_prio)
+		p->prio = p->pi_prio;
 }
 
 /**
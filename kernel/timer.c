@@ -31,6 +31,7 @@
 #include <linux/time.h>
 #include <linux/jiffies.h>
 #include <linux/posix-timers.h>
+#include <linux/hrtimer.h>
 #include <linux/cpu.h>
 #include <linux/syscalls.h>
 #include <linux/auth.h>
@@ -1154,6 +1155,7 @@ asmlinkage long sys_gettid(void)
 	return current->pid;
 }
 
+#ifndef CONFIG_HIGH_RES_TIMERS
 static long __sched nanosleep_restart(struct restart_block *restart)
 {
 	unsigned long expire = restart->arg0, now = jiffies;
@@ -1179,11 +1181,14 @@ static long __sched nanosleep_restart(struct restart_block *restart)
 	}
 	return ret;
 }
+#endif
 
 asmlinkage long sys_nanosleep(struct timespec __user *rqtp, struct timespec __user *rmtp)
 {
 	struct timespec t;
+#ifndef CONFIG_HIGH_RES_TIMERS
 	unsigned long expire;
+#endif
 	long ret;
 
 	if (copy_from_user(&t, rqtp, sizeof(t)))
@@ -1192,6 +1197,15 @@ asmlinkage long sys_nanosleep(struct timespec __user *rqtp, struct timespec __us
 	if ((t.tv_nsec >= 1000000000L) || (t.tv_nsec < 0) || (t.tv_sec < 0))
 		return -EINVAL;
 
+#ifdef CONFIG_HIGH_RES_TIMERS
+	/* Relative sleeps are measured on the monotonic clock */
+	current_thread_info()->restart_block.arg1 = (unsigned long) rmtp;
+	ret = hrtimer_nanosleep(hrtimer_now() + timespec_to_ns(&t), &t, 0);
+	if (ret == -ERESTART_RESTARTBLOCK && rmtp &&
+	    copy_to_user(rmtp, &t, sizeof(t)))
+		return -EFAULT;
+	return ret;
+#else
 	expire = timespec_to_jiffies(&t) + (t.tv_sec || t.tv_nsec);
 	current->state = TASK_INTERRUPTIBLE;
 	expire = schedule_timeout(expire);
@@ -1210,6 +1224,7 @@ asmlinkage long sys_nanosleep(struct timespec __user *rqtp, struct timespec __us
 		ret = -ERESTART_RESTARTBLOCK;
 	}
 	return ret;
+#endif
 }
 
 /*
@@ -149,6 +149,13 @@ EXPORT_SYMBOL(wake_bit_function);
  * To allow interruptible waiting and asynchronous (i.e. nonblocking)
  * waiting, the actions of __wait_on_bit() and __wait_on_bit_lock() are
  * permitted return codes. Nonzero return codes halt waiting and return.
+ *
+ * An async waiter (a kiocb's wait entry, see is_sync_wait()) whose action
+ * returns -EIOCBRETRY stays queued: the wakeup callback dequeues it and
+ * kicks the iocb for another retry.  In __wait_on_bit_lock() it is queued
+ * non-exclusively, the retry may never take the lock (e.g. the page came
+ * uptodate meanwhile) and must not swallow the single exclusive wakeup
+ * meant for a sleeping locker; it just races for the bit when it runs.
  */
 int __sched fastcall
 __wait_on_bit(wait_queue_head_t *wq, struct wait_bit_queue *q,
@@ -161,7 +168,8 @@ __wait_on_bit(wait_queue_head_t *wq, struct wait_bit_queue *q,
 		if (test_bit(q->key.bit_nr, q->key.flags))
 			ret = (*action)(q->key.flags);
 	} while (test_bit(q->key.bit_nr, q->key.flags) && !ret);
-	finish_wait(wq, &q->wait);
+	if (is_sync_wait(&q->wait) || ret != -EIOCBRETRY)
+		finish_wait(wq, &q->wait);
 	return ret;
 }
 EXPORT_SYMBOL(__wait_on_bit);
@@ -183,13 +191,17 @@ __wait_on_bit_lock(wait_queue_head_t *wq, struct wait_bit_queue *q,
 	int ret = 0;
 
 	do {
-		prepare_to_wait_exclusive(wq, &q->wait, mode);
+		if (is_sync_wait(&q->wait))
+			prepare_to_wait_exclusive(wq, &q->wait, mode);
+		else
+			prepare_to_wait(wq, &q->wait, mode);
 		if (test_bit(q->key.bit_nr, q->key.flags)) {
 			if ((ret = (*action)(q->key.flags)))
 				break;
 		}
 	} while (test_and_set_bit(q->key.bit_nr, q->key.flags));
-	finish_wait(wq, &q->wait);
+	if (is_sync_wait(&q->wait) || ret != -EIOCBRETRY)
+		finish_wait(wq, &q->wait);
 	return ret;
 }
 EXPORT_SYMBOL(__wait_on_bit_lock);
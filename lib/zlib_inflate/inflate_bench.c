@@ -0,0 +1,147 @@
+/*
+ * linux/lib/zlib_inflate/inflate_bench.c
+ *
+ * Boot time inflate throughput measurement.
+ *
+ * A buffer of text-like data is deflated once and then inflated
+ * repeatedly, both in a single Z_FINISH call (the cramfs/zisofs pattern)
+ * and in 4KB output chunks (the jffs2/squashfs streaming pattern).  The
+ * figures are printed in KB/s of uncompressed output so that kernels
+ * built with different inflate implementations can be compared.
+ */
+
+#include <linux/config.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/time.h>
+#include <linux/zlib.h>
+
+#define BENCH_SIZE	(256 * 1024)
+#define BENCH_CHUNK	4096
+#define BENCH_LOOPS	8
+
+static const char *bench_words[] = {
+	"the", "inode", "block", "page", "cache", "buffer", "kernel", "mips",
+	"squashfs", "fragment", "index", "directory", "of", "and", "to", "a",
+};
+
+static void __init bench_fill(unsigned char *buf, unsigned int len)
+{
+	unsigned int seed = 1, pos = 0;
+
+	while (pos < len) {
+		const char *w;
+
+		seed = seed * 1103515245 + 12345;
+		w = bench_words[(seed >> 16) % ARRAY_SIZE(bench_words)];
+		while (*w && pos < len)
+			buf[pos++] = *w++;
+		if (pos < len)
+			buf[pos++] = (seed >> 8) & 0x100 ? '\n' : ' ';
+	}
+}
+
+static long __init bench_usecs(struct timeval *start)
+{
+	struct timeval now;
+
+	do_gettimeofday(&now);
+	return (now.tv_sec - start->tv_sec) * USEC_PER_SEC +
+	       (now.tv_usec - start->tv_usec);
+}
+
+static int __init bench_inflate(z_stream *strm, unsigned char *src,
+				unsigned int slen, unsigned char *dst,
+				unsigned int chunk)
+{
+	int ret;
+
+	if (zlib_inflateInit(strm) != Z_OK)
+		return -EINVAL;
+	strm->next_in = src;
+	strm->avail_in = slen;
+	strm->next_out = dst;
+	strm->avail_out = 0;
+
+	do {
+		if (strm->avail_out == 0)
+			strm->avail_out = min_t(unsigned int, chunk,
+						BENCH_SIZE - strm->total_out);
+		ret = zlib_inflate(strm, chunk == BENCH_SIZE ?
+				   Z_FINISH : Z_SYNC_FLUSH);
+	} while (ret == Z_OK);
+
+	zlib_inflateEnd(strm);
+	if (ret != Z_STREAM_END || strm->total_out != BENCH_SIZE)
+		return -EIO;
+	return 0;
+}
+
+static int __init zlib_inflate_bench(void)
+{
+	static const unsigned int chunks[] = { BENCH_SIZE, BENCH_CHUNK };
+	unsigned char *orig, *comp, *out;
+	z_stream strm;
+	unsigned int clen;
+	int i, j, ret = -ENOMEM;
+
+	memset(&strm, 0, sizeof(strm));
+	orig = vmalloc(BENCH_SIZE);
+	comp = vmalloc(BENCH_SIZE);
+	out = vmalloc(BENCH_SIZE);
+	strm.workspace = vmalloc(max(zlib_deflate_workspacesize(),
+				     zlib_inflate_workspacesize()));
+	if (!orig || !comp || !out || !strm.workspace)
+		goto out;
+
+	bench_fill(orig, BENCH_SIZE);
+
+	ret = -EIO;
+	if (zlib_deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK)
+		goto out;
+	strm.next_in = orig;
+	strm.avail_in = BENCH_SIZE;
+	strm.next_out = comp;
+	strm.avail_out = BENCH_SIZE;
+	i = zlib_deflate(&strm, Z_FINISH);
+	clen = strm.total_out;
+	zlib_deflateEnd(&strm);
+	if (i != Z_STREAM_END)
+		goto out;
+
+	for (i = 0; i < ARRAY_SIZE(chunks); i++) {
+		struct timeval start;
+		long usecs;
+
+		do_gettimeofday(&start);
+		for (j = 0; j < BENCH_LOOPS; j++) {
+			ret = bench_inflate(&strm, comp, clen, out, chunks[i]);
+			if (ret)
+				goto out;
+		}
+		usecs = bench_usecs(&start);
+		if (memcmp(orig, out, BENCH_SIZE)) {
+			ret = -EIO;
+			goto out;
+		}
+		printk(KERN_INFO "zlib_inflate: %u -> %u bytes, %s: %lu KB/s\n",
+		       clen, BENCH_SIZE,
+		       chunks[i] == BENCH_SIZE ? "single call" : "4KB chunks",
+		       (unsigned long)(BENCH_LOOPS * (BENCH_SIZE / 1024)) *
+		       1000 / (usecs / 1000 + 1));
+	}
+	ret = 0;
+out:
+	if (ret)
+		printk(KERN_WARNING "zlib_inflate: benchmark failed (%d)\n", ret);
+	vfree(strm.workspace);
+	vfree(out);
+	vfree(comp);
+	vfree(orig);
+	return 0;
+}
+
+late_initcall(zlib_inflate_bench);
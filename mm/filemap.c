@@ -242,7 +242,7 @@ void remove_from_page_cache(struct page *page)
 	write_unlock_irq(&mapping->tree_lock);
 }
 
-static int sync_page(void *word)
+static void __sync_page(void *word)
 {
 	struct address_space *mapping;
 	struct page *page;
@@ -274,10 +274,25 @@ static int sync_page(void *word)
 	mapping = page_mapping(page);
 	if (mapping && mapping->a_ops && mapping->a_ops->sync_page)
 		mapping->a_ops->sync_page(page);
+}
+
+static int sync_page(void *word)
+{
+	__sync_page(word);
 	io_schedule();
 	return 0;
 }
 
+/*
+ * Wait action for AIO retries: kick off the I/O like sync_page(), but
+ * leave the kiocb queued and return instead of sleeping.
+ */
+static int sync_page_async(void *word)
+{
+	__sync_page(word);
+	return -EIOCBRETRY;
+}
+
 /**
  * filemap_fdatawrite_range - start writeback against all of a mapping's
  * dirty pages that lie within the byte offsets <start, end>
@@ -606,6 +621,21 @@ void fastcall wait_on_page_bit(struct page *page, int bit_nr)
 }
 EXPORT_SYMBOL(wait_on_page_bit);
 
+/*
+ * Point an AIO retry's wait entry (current->io_wait) at a page bit, so
+ * that aio_wake_function() only reacts to wakeups for that bit.
+ */
+static inline struct wait_bit_queue *page_bit_io_wait(struct page *page,
+						       int bit_nr)
+{
+	struct wait_bit_queue *wait;
+
+	wait = container_of(current->io_wait, struct wait_bit_queue, wait);
+	wait->key.flags = &page->flags;
+	wait->key.bit_nr = bit_nr;
+	return wait;
+}
+
 /**
  * unlock_page() - unlock a locked page
  *
@@ -662,6 +692,22 @@ void fastcall __lock_page(struct page *page)
 }
 EXPORT_SYMBOL(__lock_page);
 
+/*
+ * Get a lock on the page, or, from an AIO retry, queue the iocb and return
+ * -EIOCBRETRY if that would mean sleeping.
+ */
+int fastcall __lock_page_async(struct page *page)
+{
+	if (is_sync_wait(current->io_wait)) {
+		__lock_page(page);
+		return 0;
+	}
+	return __wait_on_bit_lock(page_waitqueue(page),
+				  page_bit_io_wait(page, PG_locked),
+				  sync_page_async, TASK_UNINTERRUPTIBLE);
+}
+EXPORT_SYMBOL(__lock_page_async);
+
 /*
  * a rather lightweight function, finding and getting a reference to a
  * hashed page atomically.
@@ -738,6 +784,43 @@ repeat:
 
 EXPORT_SYMBOL(find_lock_page);
 
+/*
+ * find_lock_page() for the buffered write path: from an AIO retry it
+ * returns ERR_PTR(-EIOCBRETRY) rather than sleeping on a locked page.
+ */
+static struct page *find_lock_page_async(struct address_space *mapping,
+					 unsigned long offset)
+{
+	struct page *page;
+	int err;
+
+	read_lock_irq(&mapping->tree_lock);
+repeat:
+	page = radix_tree_lookup(&mapping->page_tree, offset);
+	if (page) {
+		page_cache_get(page);
+		if (TestSetPageLocked(page)) {
+			read_unlock_irq(&mapping->tree_lock);
+			err = __lock_page_async(page);
+			if (err) {
+				page_cache_release(page);
+				return ERR_PTR(err);
+			}
+			read_lock_irq(&mapping->tree_lock);
+
+			/* Has the page been truncated while we slept? */
+			if (page->mapping != mapping || page->index != offset) {
+				unlock_page(page);
+				page_cache_release(page);
+				goto repeat;
+			}
+			BUG_ON(PageAgain(page));
+		}
+	}
+	read_unlock_irq(&mapping->tree_lock);
+	return page;
+}
+
 /**
  * find_or_create_page - locate or add a pagecache page
  *
@@ -982,7 +1065,9 @@ page_ok:
 
 page_not_up_to_date:
 		/* Get exclusive access to the page ... */
-		lock_page(page);
+		error = lock_page_async(page);
+		if (unlikely(error))
+			goto readpage_error;
 
 		/* Did it get unhashed before we got the lock? */
 		if (!page->mapping) {
@@ -1007,7 +1092,10 @@ readpage:
 			goto readpage_error;
 
 		if (!PageUptodate(page)) {
-			lock_page(page);
+			/* An AIO retry picks the page up once the read is done */
+			error = lock_page_async(page);
+			if (unlikely(error))
+				goto readpage_error;
 			if (!PageUptodate(page)) {
 				if (page->mapping == NULL) {
 					/*
@@ -1052,7 +1140,8 @@ readpage:
 		goto page_ok;
 
 readpage_error:
-		/* UHHUH! A synchronous read error occurred. Report it */
+		/* UHHUH! A synchronous read error occurred (or an AIO retry
+		   has to wait for the page).  Report it */
 		desc->error = error;
 		page_cache_release(page);
 		goto out;
@@ -1206,6 +1295,9 @@ __generic_file_aio_read(struct kiocb *iocb, const struct iovec *iov,
 				retval = desc.error;
 				break;
 			}
+			/* Short read: the next segment must not skip ahead */
+			if (desc.count > 0)
+				break;
 		}
 	}
 out:
@@ -1916,7 +2008,9 @@ __grab_cache_page(struct address_space *mapping, unsigned long index,
 	struct page *page;
 	unsigned long flags;
 repeat:
-	page = find_lock_page(mapping, index);
+	page = find_lock_page_async(mapping, index);
+	if (IS_ERR(page))
+		return page;
 	if (!page) {
 		if (!*cached_page) {
 			if ((platform_info.update_mode) && (mapping->host->i_sb->s_magic == RAMFS_MAGIC)) {
@@ -2314,6 +2408,11 @@ generic_file_buffered_write(struct kiocb *iocb, const struct iovec *iov,
 			status = -ENOMEM;
 			break;
 		}
+		if (IS_ERR(page)) {
+			/* AIO retry: written so far is returned */
+			status = PTR_ERR(page);
+			break;
+		}
 
 		status = a_ops->prepare_write(file, page, offset, offset+bytes);
 		if (unlikely(status)) {
@@ -58,6 +58,9 @@
 #include <linux/rtnetlink.h>
 #include <linux/init.h>
 #include <linux/highmem.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 
 #include <net/protocol.h>
 #include <net/dst.h>
@@ -228,6 +231,277 @@ nodata:
 	goto out;
 }
 
+#ifdef CONFIG_NET_SKB_RECYCLE
+/*
+ *	Receive buffer recycling.
+ *
+ *	A driver that opts in allocates its receive buffers with
+ *	skb_pool_alloc().  Those buffers remember their pool, and when the
+ *	stack frees one that is still intact -- data not shared with a
+ *	clone, not reallocated, no paged data -- __kfree_skb() resets it and
+ *	parks it on the pool instead of handing head and data back to the
+ *	slab.  The next refill gets a buffer that already has the right size
+ *	and alignment and whose header is most likely still in the cache.
+ *
+ *	Every tagged buffer holds a reference on its pool, so a driver may
+ *	destroy the pool while buffers are still travelling up the stack.
+ */
+static LIST_HEAD(skb_pool_list);
+static DEFINE_SPINLOCK(skb_pool_list_lock);
+
+static inline void skb_pool_put(struct sk_buff_pool *pool)
+{
+	if (atomic_dec_and_test(&pool->refcnt))
+		kfree(pool);
+}
+
+static inline void skb_pool_detach(struct sk_buff *skb)
+{
+	struct sk_buff_pool *pool = skb->pool;
+
+	if (pool) {
+		skb->pool = NULL;
+		skb_pool_put(pool);
+	}
+}
+
+/**
+ *	skb_pool_create	-	create a receive buffer recycling pool
+ *	@dev: device the pool belongs to
+ *	@length: dev_alloc_skb() length of the receive buffers
+ *	@max: maximum number of idle buffers to keep
+ *
+ *	Returns the new pool or %NULL, in which case skb_pool_alloc()
+ *	simply falls back to __dev_alloc_skb().  Must be called from
+ *	process context.
+ */
+struct sk_buff_pool *skb_pool_create(struct net_device *dev,
+				     unsigned int length, unsigned int max)
+{
+	struct sk_buff_pool *pool;
+
+	pool = kmalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return NULL;
+
+	memset(pool, 0, sizeof(*pool));
+	skb_queue_head_init(&pool->queue);
+	pool->dev = dev;
+	pool->length = length;
+	pool->max = max;
+	atomic_set(&pool->refcnt, 1);
+
+	spin_lock_bh(&skb_pool_list_lock);
+	list_add_tail(&pool->list, &skb_pool_list);
+	spin_unlock_bh(&skb_pool_list_lock);
+
+	return pool;
+}
+
+/**
+ *	skb_pool_destroy	-	release a receive buffer recycling pool
+ *	@pool: pool to release, may be %NULL
+ *
+ *	Frees the idle buffers.  Buffers still in flight are freed normally
+ *	when the stack is done with them, and the last one frees the pool.
+ */
+void skb_pool_destroy(struct sk_buff_pool *pool)
+{
+	struct sk_buff *skb;
+	unsigned long flags;
+
+	if (!pool)
+		return;
+
+	spin_lock_bh(&skb_pool_list_lock);
+	list_del(&pool->list);
+	spin_unlock_bh(&skb_pool_list_lock);
+
+	spin_lock_irqsave(&pool->queue.lock, flags);
+	pool->dead = 1;
+	spin_unlock_irqrestore(&pool->queue.lock, flags);
+
+	while ((skb = skb_dequeue(&pool->queue)) != NULL)
+		kfree_skb(skb);
+
+	skb_pool_put(pool);
+}
+
+/**
+ *	skb_pool_alloc	-	allocate a receive buffer
+ *	@pool: pool created by skb_pool_create(), may be %NULL
+ *	@length: length to allocate
+ *	@gfp_mask: get_free_pages mask, passed to alloc_skb
+ *
+ *	Like __dev_alloc_skb(), but an idle buffer from @pool is used when
+ *	there is one, and the buffer returns to @pool when it is freed.
+ *	Requests larger than the pool length are not pooled.
+ */
+struct sk_buff *skb_pool_alloc(struct sk_buff_pool *pool,
+			       unsigned int length, int gfp_mask)
+{
+	struct sk_buff *skb;
+	unsigned long flags;
+
+	if (!pool || length > pool->length)
+		return __dev_alloc_skb(length, gfp_mask);
+
+	spin_lock_irqsave(&pool->queue.lock, flags);
+	skb = __skb_dequeue(&pool->queue);
+	if (skb)
+		pool->hits++;
+	else
+		pool->misses++;
+	spin_unlock_irqrestore(&pool->queue.lock, flags);
+
+	if (skb) {
+		skb_reserve(skb, pool->headroom);
+		return skb;
+	}
+
+	skb = __dev_alloc_skb(pool->length, gfp_mask);
+	if (skb) {
+		pool->bufsize = skb->end - skb->head;
+		pool->headroom = skb_headroom(skb);
+		atomic_inc(&pool->refcnt);
+		skb->pool = pool;
+	}
+	return skb;
+}
+
+/*
+ *	Called by __kfree_skb() once the buffer's state has been released.
+ *	Returns 1 if the buffer went back to its pool.
+ */
+static int skb_pool_recycle(struct sk_buff *skb)
+{
+	struct sk_buff_pool *pool = skb->pool;
+	struct skb_shared_info *shinfo = skb_shinfo(skb);
+	unsigned long flags;
+	int recycled = 0;
+
+	spin_lock_irqsave(&pool->queue.lock, flags);
+	if (pool->dead)
+		goto out;
+
+	if (skb_cloned(skb) || shinfo->nr_frags || shinfo->frag_list ||
+	    skb->end - skb->head != pool->bufsize) {
+		pool->unsafe++;
+		goto out;
+	}
+
+	if (skb_queue_len(&pool->queue) >= pool->max) {
+		pool->overflow++;
+		goto out;
+	}
+
+	memset(skb, 0, offsetof(struct sk_buff, truesize));
+	skb->pool = pool;
+	atomic_set(&skb->users, 1);
+	skb->data = skb->head;
+	skb->tail = skb->head;
+	atomic_set(&shinfo->dataref, 1);
+	shinfo->tso_size = 0;
+	shinfo->tso_segs = 0;
+
+	/* LIFO, so the next refill gets the buffer most likely cached */
+	__skb_queue_head(&pool->queue, skb);
+	pool->recycled++;
+	recycled = 1;
+out:
+	spin_unlock_irqrestore(&pool->queue.lock, flags);
+	return recycled;
+}
+
+#ifdef CONFIG_PROC_FS
+static void *skb_pool_seq_start(struct seq_file *seq, loff_t *pos)
+{
+	struct sk_buff_pool *pool;
+	loff_t off = 1;
+
+	spin_lock_bh(&skb_pool_list_lock);
+	if (*pos == 0)
+		return SEQ_START_TOKEN;
+
+	list_for_each_entry(pool, &skb_pool_list, list)
+		if (off++ == *pos)
+			return pool;
+	return NULL;
+}
+
+static void *skb_pool_seq_next(struct seq_file *seq, void *v, loff_t *pos)
+{
+	struct list_head *next;
+
+	++*pos;
+	if (v == SEQ_START_TOKEN)
+		next = skb_pool_list.next;
+	else
+		next = ((struct sk_buff_pool *)v)->list.next;
+
+	return next == &skb_pool_list ?
+		NULL : list_entry(next, struct sk_buff_pool, list);
+}
+
+static void skb_pool_seq_stop(struct seq_file *seq, void *v)
+{
+	spin_unlock_bh(&skb_pool_list_lock);
+}
+
+static int skb_pool_seq_show(struct seq_file *seq, void *v)
+{
+	struct sk_buff_pool *pool = v;
+
+	if (v == SEQ_START_TOKEN) {
+		seq_puts(seq, "Device   length  max queued       hits     misses"
+			      "   recycled   overflow     unsafe\n");
+		return 0;
+	}
+
+	seq_printf(seq, "%-8s %6u %4u %6u %10lu %10lu %10lu %10lu %10lu\n",
+		   pool->dev ? pool->dev->name : "-", pool->length, pool->max,
+		   skb_queue_len(&pool->queue), pool->hits, pool->misses,
+		   pool->recycled, pool->overflow, pool->unsafe);
+	return 0;
+}
+
+static struct seq_operations skb_pool_seq_ops = {
+	.start = skb_pool_seq_start,
+	.next  = skb_pool_seq_next,
+	.stop  = skb_pool_seq_stop,
+	.show  = skb_pool_seq_show,
+};
+
+static int skb_pool_seq_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &skb_pool_seq_ops);
+}
+
+static struct file_operations skb_pool_seq_fops = {
+	.owner	 = THIS_MODULE,
+	.open	 = skb_pool_seq_open,
+	.read	 = seq_read,
+	.llseek	 = seq_lseek,
+	.release = seq_release,
+};
+
+static int __init skb_pool_proc_init(void)
+{
+	return proc_net_fops_create("skb_pool", S_IRUGO,
+				    &skb_pool_seq_fops) ? 0 : -ENOBUFS;
+}
+
+subsys_initcall(skb_pool_proc_init);
+#endif /* CONFIG_PROC_FS */
+
+EXPORT_SYMBOL(skb_pool_create);
+EXPORT_SYMBOL(skb_pool_destroy);
+EXPORT_SYMBOL(skb_pool_alloc);
+#else
+static inline void skb_pool_detach(struct sk_buff *skb)
+{
+}
+#endif /* CONFIG_NET_SKB_RECYCLE */
 
 static void skb_drop_fraglist(struct sk_buff *skb)
 {
@@ -252,6 +526,9 @@ static void skb_clone_fraglist(struct sk_buff *skb)
 
 void skb_release_data(struct sk_buff *skb)
 {
+	/* the data area is going away or being replaced */
+	skb_pool_detach(skb);
+
 	if (!skb->cloned ||
 	    !atomic_sub_return(skb->nohdr ? (1 << SKB_DATAREF_SHIFT) + 1 : 1,
 			       &skb_shinfo(skb)->dataref)) {
@@ -313,6 +590,10 @@ void __kfree_skb(struct sk_buff *skb)
 #endif
 #endif
 
+#ifdef CONFIG_NET_SKB_RECYCLE
+	if (skb->pool && skb_pool_recycle(skb))
+		return;
+#endif
 	kfree_skbmem(skb);
 }
 
@@ -394,6 +675,10 @@ struct sk_buff *skb_clone(struct sk_buff *skb, int gfp_mask)
 	C(tc_classid);
 #endif
 
+#endif
+#ifdef CONFIG_NET_SKB_RECYCLE
+	/* the data stays with the original, and so does the pool */
+	n->pool = NULL;
 #endif
 	C(truesize);
 	atomic_set(&n->users, 1);
@@ -1136,6 +1421,134 @@ fault:
 
 EXPORT_SYMBOL(skb_store_bits);
 
+/*
+ * Map (part of) one skb into splice_pipe_desc pages.  Paged fragments
+ * are handed over by reference; the linear area lives in kmalloc()ed
+ * memory that a page reference cannot pin, so it is copied into fresh
+ * pages.  *offset is relative to this skb on entry and is consumed as
+ * we go.  Returns 1 when the request is complete or the descriptor full.
+ */
+static int __skb_splice_bits(struct sk_buff *skb, unsigned int *offset,
+			     unsigned int *len, struct splice_pipe_desc *spd,
+			     int max)
+{
+	unsigned int seg_len, plen;
+	int seg;
+
+	seg_len = skb_headlen(skb);
+	if (*offset >= seg_len)
+		*offset -= seg_len;
+	else {
+		while (*offset < seg_len) {
+			struct page *page;
+
+			if (spd->nr_pages == max)
+				return 1;
+
+			plen = min_t(unsigned int, seg_len - *offset, *len);
+			if (plen > PAGE_SIZE)
+				plen = PAGE_SIZE;
+
+			page = alloc_page(GFP_KERNEL);
+			if (!page)
+				return 1;
+			memcpy(page_address(page), skb->data + *offset, plen);
+
+			spd->pages[spd->nr_pages] = page;
+			spd->partial[spd->nr_pages].offset = 0;
+			spd->partial[spd->nr_pages].len = plen;
+			spd->nr_pages++;
+
+			*offset += plen;
+			*len -= plen;
+			if (!*len)
+				return 1;
+		}
+		*offset = 0;
+	}
+
+	for (seg = 0; seg < skb_shinfo(skb)->nr_frags; seg++) {
+		skb_frag_t *f = &skb_shinfo(skb)->frags[seg];
+
+		if (*offset >= f->size) {
+			*offset -= f->size;
+			continue;
+		}
+
+		if (spd->nr_pages == max)
+			return 1;
+
+		plen = min_t(unsigned int, f->size - *offset, *len);
+
+		get_page(f->page);
+		spd->pages[spd->nr_pages] = f->page;
+		spd->partial[spd->nr_pages].offset = f->page_offset + *offset;
+		spd->partial[spd->nr_pages].len = plen;
+		spd->nr_pages++;
+
+		*offset = 0;
+		*len -= plen;
+		if (!*len)
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ *	skb_splice_bits - splice skb data into a pipe
+ *	@skb: source buffer
+ *	@offset: offset in source
+ *	@pipe: destination pipe inode
+ *	@len: number of bytes to splice
+ *	@flags: SPLICE_F_* flags
+ *
+ *	Moves at most as many pages as the pipe currently has room for,
+ *	so nothing is lost when the reader is slow.  Never sleeps on the
+ *	pipe, as the caller usually holds the socket lock: returns the
+ *	number of bytes spliced, which may be short, or 0 if the pipe is
+ *	full.  The caller only consumes that much of the skb and waits for
+ *	room itself (splice_wait_pipe_room()).  Must be called from
+ *	process context.
+ */
+int skb_splice_bits(struct sk_buff *skb, unsigned int offset,
+		    struct inode *pipe, unsigned int len, unsigned int flags)
+{
+	struct partial_page partial[PIPE_BUFFERS];
+	struct page *pages[PIPE_BUFFERS];
+	struct splice_pipe_desc spd = {
+		.pages = pages,
+		.partial = partial,
+		.flags = flags | SPLICE_F_NONBLOCK,
+		.ops = &page_pipe_buf_ops,
+	};
+	struct sk_buff *list;
+	int max, ret;
+
+	max = splice_pipe_room(pipe);
+	if (max <= 0)
+		return 0;
+
+	if (__skb_splice_bits(skb, &offset, &len, &spd, max))
+		goto done;
+
+	for (list = skb_shinfo(skb)->frag_list; list; list = list->next)
+		if (__skb_splice_bits(list, &offset, &len, &spd, max))
+			break;
+
+done:
+	if (!spd.nr_pages)
+		return -ENOMEM;
+
+	/* another writer took the room we saw, the caller waits for more */
+	ret = splice_to_pipe(pipe, &spd);
+	if (ret == -EAGAIN)
+		ret = 0;
+	return ret;
+}
+
+EXPORT_SYMBOL(skb_splice_bits);
+
 /* Checksum skb data. */
 
 unsigned int skb_checksum(const struct sk_buff *skb, int offset,
@@ -794,7 +794,8 @@ struct proto_ops inet_stream_ops = {
 	.sendmsg =	inet_sendmsg,
 	.recvmsg =	sock_common_recvmsg,
 	.mmap =		sock_no_mmap,
-	.sendpage =	tcp_sendpage
+	.sendpage =	tcp_sendpage,
+	.splice_read =	tcp_splice_read,
 };
 
 struct proto_ops inet_dgram_ops = {
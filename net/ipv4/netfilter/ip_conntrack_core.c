@@ -37,9 +37,11 @@
 #include <linux/err.h>
 #include <linux/percpu.h>
 #include <linux/moduleparam.h>
+#include <linux/workqueue.h>
 
-/* This rwlock protects the main hash table, protocol/helper/expected
-   registrations, conntrack timers*/
+/* This rwlock protects protocol/helper/expected registrations, the
+   unconfirmed list and the hash table geometry; the hash chains themselves
+   are covered by the bucket locks below. */
 #define ASSERT_READ_LOCK(x) MUST_BE_READ_LOCKED(&ip_conntrack_lock)
 #define ASSERT_WRITE_LOCK(x) MUST_BE_WRITE_LOCKED(&ip_conntrack_lock)
 
@@ -58,6 +60,7 @@
 #endif
 
 DECLARE_RWLOCK(ip_conntrack_lock);
+spinlock_t ip_conntrack_hash_locks[IP_CT_HASH_LOCKS];
 
 /* ip_conntrack_standalone needs this */
 atomic_t ip_conntrack_count = ATOMIC_INIT(0);
@@ -88,16 +91,47 @@ ip_conntrack_put(struct ip_conntrack *ct)
 static int ip_conntrack_hash_rnd_initted;
 static unsigned int ip_conntrack_hash_rnd;
 
-static u_int32_t
-hash_conntrack(const struct ip_conntrack_tuple *tuple)
+/* Raw hash: picks the bucket lock, and the bucket once reduced modulo
+   the table size under that lock. */
+static inline u_int32_t
+__hash_conntrack(const struct ip_conntrack_tuple *tuple)
 {
 #if 0
 	dump_tuple(tuple);
 #endif
-	return (jhash_3words(tuple->src.ip,
-	                     (tuple->dst.ip ^ tuple->dst.protonum),
-	                     (tuple->src.u.all | (tuple->dst.u.all << 16)),
-	                     ip_conntrack_hash_rnd) % ip_conntrack_htable_size);
+	return jhash_3words(tuple->src.ip,
+	                    (tuple->dst.ip ^ tuple->dst.protonum),
+	                    (tuple->src.u.all | (tuple->dst.u.all << 16)),
+	                    ip_conntrack_hash_rnd);
+}
+
+/* Lock the bucket locks covering two raw hashes, lower lock first. */
+static void ct_lock_pair(u_int32_t a, u_int32_t b)
+{
+	a %= IP_CT_HASH_LOCKS;
+	b %= IP_CT_HASH_LOCKS;
+	if (a > b) {
+		u_int32_t t = a;
+		a = b;
+		b = t;
+	}
+	spin_lock_bh(&ip_conntrack_hash_locks[a]);
+	if (a != b)
+		spin_lock(&ip_conntrack_hash_locks[b]);
+}
+
+static void ct_unlock_pair(u_int32_t a, u_int32_t b)
+{
+	a %= IP_CT_HASH_LOCKS;
+	b %= IP_CT_HASH_LOCKS;
+	if (a > b) {
+		u_int32_t t = a;
+		a = b;
+		b = t;
+	}
+	if (a != b)
+		spin_unlock(&ip_conntrack_hash_locks[b]);
+	spin_unlock_bh(&ip_conntrack_hash_locks[a]);
 }
 
 int
@@ -206,18 +240,25 @@ static void remove_expectations(struct ip_conntrack *ct)
 static void
 clean_from_lists(struct ip_conntrack *ct)
 {
-	unsigned int ho, hr;
+	u_int32_t ho, hr;
 	
 	DEBUGP("clean_from_lists(%p)\n", ct);
-	MUST_BE_WRITE_LOCKED(&ip_conntrack_lock);
+	MUST_BE_READ_WRITE_UNLOCKED(&ip_conntrack_lock);
 
-	ho = hash_conntrack(&ct->tuplehash[IP_CT_DIR_ORIGINAL].tuple);
-	hr = hash_conntrack(&ct->tuplehash[IP_CT_DIR_REPLY].tuple);
-	LIST_DELETE(&ip_conntrack_hash[ho], &ct->tuplehash[IP_CT_DIR_ORIGINAL]);
-	LIST_DELETE(&ip_conntrack_hash[hr], &ct->tuplehash[IP_CT_DIR_REPLY]);
+	ho = __hash_conntrack(&ct->tuplehash[IP_CT_DIR_ORIGINAL].tuple);
+	hr = __hash_conntrack(&ct->tuplehash[IP_CT_DIR_REPLY].tuple);
+	ct_lock_pair(ho, hr);
+	/* Inside lock so preempt is disabled on module removal path.
+	 * Otherwise we can get spurious warnings. */
+	CONNTRACK_STAT_INC(delete_list);
+	list_del(&ct->tuplehash[IP_CT_DIR_ORIGINAL].list);
+	list_del(&ct->tuplehash[IP_CT_DIR_REPLY].list);
+	ct_unlock_pair(ho, hr);
 
 	/* Destroy all pending expectations */
+	WRITE_LOCK(&ip_conntrack_lock);
 	remove_expectations(ct);
+	WRITE_UNLOCK(&ip_conntrack_lock);
 }
 
 static void
@@ -268,12 +309,7 @@ static void death_by_timeout(unsigned long ul_conntrack)
 {
 	struct ip_conntrack *ct = (void *)ul_conntrack;
 
-	WRITE_LOCK(&ip_conntrack_lock);
-	/* Inside lock so preempt is disabled on module removal path.
-	 * Otherwise we can get spurious warnings. */
-	CONNTRACK_STAT_INC(delete_list);
 	clean_from_lists(ct);
-	WRITE_UNLOCK(&ip_conntrack_lock);
 	ip_conntrack_put(ct);
 }
 
@@ -282,20 +318,20 @@ conntrack_tuple_cmp(const struct ip_conntrack_tuple_hash *i,
 		    const struct ip_conntrack_tuple *tuple,
 		    const struct ip_conntrack *ignored_conntrack)
 {
-	MUST_BE_READ_LOCKED(&ip_conntrack_lock);
 	return tuplehash_to_ctrack(i) != ignored_conntrack
 		&& ip_ct_tuple_equal(tuple, &i->tuple);
 }
 
+/* Caller holds the bucket lock for hash. */
 static struct ip_conntrack_tuple_hash *
 __ip_conntrack_find(const struct ip_conntrack_tuple *tuple,
-		    const struct ip_conntrack *ignored_conntrack)
+		    const struct ip_conntrack *ignored_conntrack,
+		    u_int32_t hash)
 {
 	struct ip_conntrack_tuple_hash *h;
-	unsigned int hash = hash_conntrack(tuple);
 
-	MUST_BE_READ_LOCKED(&ip_conntrack_lock);
-	list_for_each_entry(h, &ip_conntrack_hash[hash], list) {
+	list_for_each_entry(h, &ip_conntrack_hash[hash % ip_conntrack_htable_size],
+			    list) {
 		if (conntrack_tuple_cmp(h, tuple, ignored_conntrack)) {
 			CONNTRACK_STAT_INC(found);
 			return h;
@@ -312,12 +348,14 @@ ip_conntrack_find_get(const struct ip_conntrack_tuple *tuple,
 		      const struct ip_conntrack *ignored_conntrack)
 {
 	struct ip_conntrack_tuple_hash *h;
+	u_int32_t hash = __hash_conntrack(tuple);
+	spinlock_t *lock = ip_conntrack_hash_lock(hash);
 
-	READ_LOCK(&ip_conntrack_lock);
-	h = __ip_conntrack_find(tuple, ignored_conntrack);
+	spin_lock_bh(lock);
+	h = __ip_conntrack_find(tuple, ignored_conntrack, hash);
 	if (h)
 		atomic_inc(&tuplehash_to_ctrack(h)->ct_general.use);
-	READ_UNLOCK(&ip_conntrack_lock);
+	spin_unlock_bh(lock);
 
 	return h;
 }
@@ -326,7 +364,7 @@ ip_conntrack_find_get(const struct ip_conntrack_tuple *tuple,
 int
 __ip_conntrack_confirm(struct sk_buff **pskb)
 {
-	unsigned int hash, repl_hash;
+	u_int32_t hash, repl_hash;
 	struct ip_conntrack *ct;
 	enum ip_conntrack_info ctinfo;
 
@@ -339,8 +377,8 @@ __ip_conntrack_confirm(struct sk_buff **pskb)
 	if (CTINFO2DIR(ctinfo) != IP_CT_DIR_ORIGINAL)
 		return NF_ACCEPT;
 
-	hash = hash_conntrack(&ct->tuplehash[IP_CT_DIR_ORIGINAL].tuple);
-	repl_hash = hash_conntrack(&ct->tuplehash[IP_CT_DIR_REPLY].tuple);
+	hash = __hash_conntrack(&ct->tuplehash[IP_CT_DIR_ORIGINAL].tuple);
+	repl_hash = __hash_conntrack(&ct->tuplehash[IP_CT_DIR_REPLY].tuple);
 
 	/* We're not in hash table, and we refuse to set up related
 	   connections for unconfirmed conns.  But packet copies and
@@ -352,26 +390,29 @@ __ip_conntrack_confirm(struct sk_buff **pskb)
 	IP_NF_ASSERT(!is_confirmed(ct));
 	DEBUGP("Confirming conntrack %p\n", ct);
 
+	/* ip_conntrack_lock for the unconfirmed list, bucket locks for
+	   the chains we insert into. */
 	WRITE_LOCK(&ip_conntrack_lock);
+	ct_lock_pair(hash, repl_hash);
 
 	/* See if there's one in the list already, including reverse:
            NAT could have grabbed it without realizing, since we're
            not in the hash.  If there is, we lost race. */
-	if (!LIST_FIND(&ip_conntrack_hash[hash],
+	if (!LIST_FIND(&ip_conntrack_hash[hash % ip_conntrack_htable_size],
 		       conntrack_tuple_cmp,
 		       struct ip_conntrack_tuple_hash *,
 		       &ct->tuplehash[IP_CT_DIR_ORIGINAL].tuple, NULL)
-	    && !LIST_FIND(&ip_conntrack_hash[repl_hash],
+	    && !LIST_FIND(&ip_conntrack_hash[repl_hash % ip_conntrack_htable_size],
 			  conntrack_tuple_cmp,
 			  struct ip_conntrack_tuple_hash *,
 			  &ct->tuplehash[IP_CT_DIR_REPLY].tuple, NULL)) {
 		/* Remove from unconfirmed list */
 		list_del(&ct->tuplehash[IP_CT_DIR_ORIGINAL].list);
 
-		list_prepend(&ip_conntrack_hash[hash],
-			     &ct->tuplehash[IP_CT_DIR_ORIGINAL]);
-		list_prepend(&ip_conntrack_hash[repl_hash],
-			     &ct->tuplehash[IP_CT_DIR_REPLY]);
+		list_add(&ct->tuplehash[IP_CT_DIR_ORIGINAL].list,
+			 &ip_conntrack_hash[hash % ip_conntrack_htable_size]);
+		list_add(&ct->tuplehash[IP_CT_DIR_REPLY].list,
+			 &ip_conntrack_hash[repl_hash % ip_conntrack_htable_size]);
 		/* Timer relative to confirmation time, not original
 		   setting time, otherwise we'd get timer wrap in
 		   weird delay cases. */
@@ -380,11 +421,13 @@ __ip_conntrack_confirm(struct sk_buff **pskb)
 		atomic_inc(&ct->ct_general.use);
 		set_bit(IPS_CONFIRMED_BIT, &ct->status);
 		CONNTRACK_STAT_INC(insert);
+		ct_unlock_pair(hash, repl_hash);
 		WRITE_UNLOCK(&ip_conntrack_lock);
 		return NF_ACCEPT;
 	}
 
 	CONNTRACK_STAT_INC(insert_failed);
+	ct_unlock_pair(hash, repl_hash);
 	WRITE_UNLOCK(&ip_conntrack_lock);
 
 	return NF_DROP;
@@ -397,14 +440,154 @@ ip_conntrack_tuple_taken(const struct ip_conntrack_tuple *tuple,
 			 const struct ip_conntrack *ignored_conntrack)
 {
 	struct ip_conntrack_tuple_hash *h;
+	u_int32_t hash = __hash_conntrack(tuple);
+	spinlock_t *lock = ip_conntrack_hash_lock(hash);
 
-	READ_LOCK(&ip_conntrack_lock);
-	h = __ip_conntrack_find(tuple, ignored_conntrack);
-	READ_UNLOCK(&ip_conntrack_lock);
+	spin_lock_bh(lock);
+	h = __ip_conntrack_find(tuple, ignored_conntrack, hash);
+	spin_unlock_bh(lock);
 
 	return h != NULL;
 }
 
+static struct list_head *alloc_conntrack_hash(unsigned int size,
+					      int *vmalloced)
+{
+	struct list_head *hash;
+	unsigned int i;
+
+	/* AK: the hash table is twice as big than needed because it
+	   uses list_head.  it would be much nicer to caches to use a
+	   single pointer list head here. */
+	*vmalloced = 0;
+	hash = (void *)__get_free_pages(GFP_KERNEL,
+					get_order(sizeof(struct list_head)
+						  * size));
+	if (!hash) {
+		*vmalloced = 1;
+		printk(KERN_WARNING "ip_conntrack: falling back to vmalloc.\n");
+		hash = vmalloc(sizeof(struct list_head) * size);
+	}
+	if (hash)
+		for (i = 0; i < size; i++)
+			INIT_LIST_HEAD(&hash[i]);
+
+	return hash;
+}
+
+static void free_conntrack_hash(struct list_head *hash, int vmalloced,
+				unsigned int size)
+{
+	if (vmalloced)
+		vfree(hash);
+	else
+		free_pages((unsigned long)hash,
+			   get_order(sizeof(struct list_head) * size));
+}
+
+/* Keep the table a multiple of the bucket lock count (see
+   ip_conntrack_core.h). */
+static inline unsigned int ip_conntrack_hash_roundup(unsigned int size)
+{
+	return (size + IP_CT_HASH_LOCKS - 1) & ~(IP_CT_HASH_LOCKS - 1);
+}
+
+static DECLARE_MUTEX(ip_conntrack_resize_sem);
+
+/* Rehash every confirmed conntrack into a new table of size buckets.
+   Holding ip_conntrack_lock and all bucket locks keeps out lookups,
+   insertions, deletions and the table walkers. */
+static int ip_conntrack_resize(unsigned int size)
+{
+	struct list_head *hash, *old_hash;
+	struct ip_conntrack_tuple_hash *h;
+	unsigned int i, old_size;
+	int vmalloced, old_vmalloced;
+
+	size = ip_conntrack_hash_roundup(size);
+	if (size == 0 || size > (1 << 20))
+		return -EINVAL;
+
+	down(&ip_conntrack_resize_sem);
+	if (size == ip_conntrack_htable_size) {
+		up(&ip_conntrack_resize_sem);
+		return 0;
+	}
+
+	hash = alloc_conntrack_hash(size, &vmalloced);
+	if (!hash) {
+		up(&ip_conntrack_resize_sem);
+		return -ENOMEM;
+	}
+
+	WRITE_LOCK(&ip_conntrack_lock);
+	for (i = 0; i < IP_CT_HASH_LOCKS; i++)
+		spin_lock(&ip_conntrack_hash_locks[i]);
+
+	/* Moving entries in chain order keeps newest first. */
+	for (i = 0; i < ip_conntrack_htable_size; i++) {
+		while (!list_empty(&ip_conntrack_hash[i])) {
+			h = list_entry(ip_conntrack_hash[i].next,
+				       struct ip_conntrack_tuple_hash, list);
+			list_del(&h->list);
+			list_add_tail(&h->list,
+				      &hash[__hash_conntrack(&h->tuple) % size]);
+		}
+	}
+	old_hash = ip_conntrack_hash;
+	old_size = ip_conntrack_htable_size;
+	old_vmalloced = ip_conntrack_vmalloc;
+	ip_conntrack_hash = hash;
+	ip_conntrack_htable_size = size;
+	ip_conntrack_vmalloc = vmalloced;
+
+	for (i = IP_CT_HASH_LOCKS; i-- > 0; )
+		spin_unlock(&ip_conntrack_hash_locks[i]);
+	WRITE_UNLOCK(&ip_conntrack_lock);
+	up(&ip_conntrack_resize_sem);
+
+	free_conntrack_hash(old_hash, old_vmalloced, old_size);
+	DEBUGP("ip_conntrack: hash resized %u -> %u buckets\n",
+	       old_size, size);
+	return 0;
+}
+
+/* The table starts out sized from physical memory and doubles whenever
+   the average chain grows past IP_CT_GROW_LOAD entries, until either the
+   administrator picks a size (hashsize= or the ip_conntrack_buckets
+   sysctl) or IP_CT_HASH_AUTO_MAX is reached. */
+#define IP_CT_GROW_LOAD		2
+#define IP_CT_HASH_AUTO_MAX	65536
+
+static int ip_conntrack_hash_auto = 1;
+
+static void ip_conntrack_grow(void *unused)
+{
+	unsigned int size = ip_conntrack_htable_size;
+
+	if (ip_conntrack_hash_auto && size < IP_CT_HASH_AUTO_MAX
+	    && atomic_read(&ip_conntrack_count) > IP_CT_GROW_LOAD * size)
+		ip_conntrack_resize(size * 2);
+}
+
+static DECLARE_WORK(ip_conntrack_grow_work, ip_conntrack_grow, NULL);
+
+static inline void ip_conntrack_check_grow(void)
+{
+	if (ip_conntrack_hash_auto
+	    && ip_conntrack_htable_size < IP_CT_HASH_AUTO_MAX
+	    && atomic_read(&ip_conntrack_count)
+	       > IP_CT_GROW_LOAD * ip_conntrack_htable_size)
+		schedule_work(&ip_conntrack_grow_work);
+}
+
+/* Set the table size by hand; this turns off automatic growth. */
+int ip_conntrack_set_hashsize(unsigned int size)
+{
+	ip_conntrack_hash_auto = 0;
+	return ip_conntrack_resize(size);
+}
+
 /* There's a small race here where we may free a just-assured
    connection.  Too bad: we're in trouble anyway. */
 static inline int unreplied(const struct ip_conntrack_tuple_hash *i)
@@ -412,20 +595,39 @@ static inline int unreplied(const struct ip_conntrack_tuple_hash *i)
 	return !(test_bit(IPS_ASSURED_BIT, &tuplehash_to_ctrack(i)->status));
 }
 
-static int early_drop(struct list_head *chain)
+/* Once the table has grown the chains are short, so look at up to this
+   many entries, starting at the new connection's bucket and moving on
+   to the following ones, before giving up. */
+#define IP_CT_EVICTION_RANGE	8
+
+static int early_drop(u_int32_t hash)
 {
-	/* Traverse backwards: gives us oldest, which is roughly LRU */
 	struct ip_conntrack_tuple_hash *h;
 	struct ip_conntrack *ct = NULL;
+	unsigned int i, cnt = 0;
 	int dropped = 0;
 
-	READ_LOCK(&ip_conntrack_lock);
-	h = LIST_FIND_B(chain, unreplied, struct ip_conntrack_tuple_hash *);
-	if (h) {
-		ct = tuplehash_to_ctrack(h);
-		atomic_inc(&ct->ct_general.use);
+	for (i = 0; i < IP_CT_EVICTION_RANGE; i++) {
+		spinlock_t *lock = ip_conntrack_hash_lock(hash + i);
+		struct list_head *chain;
+
+		spin_lock_bh(lock);
+		chain = &ip_conntrack_hash[(hash + i) % ip_conntrack_htable_size];
+		/* Traverse backwards: gives us oldest, which is roughly LRU */
+		list_for_each_entry_reverse(h, chain, list) {
+			if (unreplied(h)) {
+				ct = tuplehash_to_ctrack(h);
+				atomic_inc(&ct->ct_general.use);
+				break;
+			}
+			if (++cnt >= IP_CT_EVICTION_RANGE)
+				break;
+		}
+		spin_unlock_bh(lock);
+
+		if (ct || cnt >= IP_CT_EVICTION_RANGE)
+			break;
 	}
-	READ_UNLOCK(&ip_conntrack_lock);
 
 	if (!ct)
 		return dropped;
@@ -461,7 +663,7 @@ init_conntrack(const struct ip_conntrack_tuple *tuple,
 {
 	struct ip_conntrack *conntrack;
 	struct ip_conntrack_tuple repl_tuple;
-	size_t hash;
+	u_int32_t hash;
 	struct ip_conntrack_expect *exp;
 
 	if (!ip_conntrack_hash_rnd_initted) {
@@ -469,12 +671,13 @@ init_conntrack(const struct ip_conntrack_tuple *tuple,
 		ip_conntrack_hash_rnd_initted = 1;
 	}
 
-	hash = hash_conntrack(tuple);
+	hash = __hash_conntrack(tuple);
 
 	if (ip_conntrack_max
 	    && atomic_read(&ip_conntrack_count) >= ip_conntrack_max) {
 		/* Try dropping from this hash chain. */
-		if (!early_drop(&ip_conntrack_hash[hash])) {
+		if (!early_drop(hash)) {
+			CONNTRACK_STAT_INC(early_drop_fail);
 			if (net_ratelimit())
 				printk(KERN_WARNING
 				       "ip_conntrack: table full, dropping"
@@ -534,6 +737,8 @@ init_conntrack(const struct ip_conntrack_tuple *tuple,
 	atomic_inc(&ip_conntrack_count);
 	WRITE_UNLOCK(&ip_conntrack_lock);
 
+	ip_conntrack_check_grow();
+
 	if (exp) {
 		if (exp->expectfn)
 			exp->expectfn(conntrack, exp);
@@ -890,9 +1095,12 @@ void ip_conntrack_helper_unregister(struct ip_conntrack_helper *me)
 	}
 	/* Get rid of expecteds, set helpers to NULL. */
 	LIST_FIND_W(&unconfirmed, unhelp, struct ip_conntrack_tuple_hash*, me);
-	for (i = 0; i < ip_conntrack_htable_size; i++)
+	for (i = 0; i < ip_conntrack_htable_size; i++) {
+		spin_lock(ip_conntrack_hash_lock(i));
 		LIST_FIND_W(&ip_conntrack_hash[i], unhelp,
 			    struct ip_conntrack_tuple_hash *, me);
+		spin_unlock(ip_conntrack_hash_lock(i));
+	}
 	WRITE_UNLOCK(&ip_conntrack_lock);
 
 	/* Someone could be still looking at the helper in a bh. */
@@ -925,14 +1133,17 @@ void ip_ct_refresh_acct(struct ip_conntrack *ct,
 		ct->timeout.expires = extra_jiffies;
 		ct_add_counters(ct, ctinfo, skb);
 	} else {
-		WRITE_LOCK(&ip_conntrack_lock);
+		spinlock_t *lock = ip_conntrack_hash_lock(
+			__hash_conntrack(&ct->tuplehash[IP_CT_DIR_ORIGINAL].tuple));
+
+		spin_lock_bh(lock);
 		/* Need del_timer for race avoidance (may already be dying). */
 		if (del_timer(&ct->timeout)) {
 			ct->timeout.expires = jiffies + extra_jiffies;
 			add_timer(&ct->timeout);
 		}
 		ct_add_counters(ct, ctinfo, skb);
-		WRITE_UNLOCK(&ip_conntrack_lock);
+		spin_unlock_bh(lock);
 	}
 }
 
@@ -999,16 +1210,21 @@ get_next_corpse(int (*iter)(struct ip_conntrack *i, void *data),
 
 	WRITE_LOCK(&ip_conntrack_lock);
 	for (; *bucket < ip_conntrack_htable_size; (*bucket)++) {
+		spin_lock(ip_conntrack_hash_lock(*bucket));
 		h = LIST_FIND_W(&ip_conntrack_hash[*bucket], do_iter,
 				struct ip_conntrack_tuple_hash *, iter, data);
+		if (h)
+			atomic_inc(&tuplehash_to_ctrack(h)->ct_general.use);
+		spin_unlock(ip_conntrack_hash_lock(*bucket));
 		if (h)
 			break;
 	}
-	if (!h)
+	if (!h) {
 		h = LIST_FIND_W(&unconfirmed, do_iter,
 				struct ip_conntrack_tuple_hash *, iter, data);
-	if (h)
-		atomic_inc(&tuplehash_to_ctrack(h)->ct_general.use);
+		if (h)
+			atomic_inc(&tuplehash_to_ctrack(h)->ct_general.use);
+	}
 	WRITE_UNLOCK(&ip_conntrack_lock);
 
 	return h;
@@ -1098,16 +1314,6 @@ static int kill_all(struct ip_conntrack *i, void *data)
 	return 1;
 }
 
-static void free_conntrack_hash(void)
-{
-	if (ip_conntrack_vmalloc)
-		vfree(ip_conntrack_hash);
-	else
-		free_pages((unsigned long)ip_conntrack_hash, 
-			   get_order(sizeof(struct list_head)
-				     * ip_conntrack_htable_size));
-}
-
 /* Mishearing the voices in his head, our hero wonders how he's
    supposed to kill the mall. */
 void ip_conntrack_cleanup(void)
@@ -1117,6 +1323,10 @@ void ip_conntrack_cleanup(void)
            netfilter framework.  Roll on, two-stage module
            delete... */
 	synchronize_net();
+
+	/* No more resizing behind our back. */
+	ip_conntrack_hash_auto = 0;
+	flush_scheduled_work();
  
  i_see_dead_people:
 	ip_ct_iterate_cleanup(kill_all, NULL);
@@ -1130,7 +1340,8 @@ void ip_conntrack_cleanup(void)
 
 	kmem_cache_destroy(ip_conntrack_cachep);
 	kmem_cache_destroy(ip_conntrack_expect_cachep);
-	free_conntrack_hash();
+	free_conntrack_hash(ip_conntrack_hash, ip_conntrack_vmalloc,
+			    ip_conntrack_htable_size);
 	nf_unregister_sockopt(&so_getorigdst);
 }
 
@@ -1146,15 +1357,18 @@ int __init ip_conntrack_init(void)
 	 * machine has 256 buckets.  >= 1GB machines have 8192 buckets. */
  	if (hashsize) {
  		ip_conntrack_htable_size = hashsize;
+		ip_conntrack_hash_auto = 0;
  	} else {
 		ip_conntrack_htable_size
 			= (((num_physpages << PAGE_SHIFT) / 16384)
 			   / sizeof(struct list_head));
 		if (num_physpages > (1024 * 1024 * 1024 / PAGE_SIZE))
 			ip_conntrack_htable_size = 8192;
-		if (ip_conntrack_htable_size < 16)
-			ip_conntrack_htable_size = 16;
 	}
+	if (ip_conntrack_htable_size < IP_CT_HASH_LOCKS)
+		ip_conntrack_htable_size = IP_CT_HASH_LOCKS;
+	ip_conntrack_htable_size =
+		ip_conntrack_hash_roundup(ip_conntrack_htable_size);
 	ip_conntrack_max = 8 * ip_conntrack_htable_size;
 
 	printk("ip_conntrack version %s (%u buckets, %d max)"
@@ -1168,20 +1382,11 @@ int __init ip_conntrack_init(void)
 		return ret;
 	}
 
-	/* AK: the hash table is twice as big than needed because it
-	   uses list_head.  it would be much nicer to caches to use a
-	   single pointer list head here. */
-	ip_conntrack_vmalloc = 0; 
-	ip_conntrack_hash 
-		=(void*)__get_free_pages(GFP_KERNEL, 
-					 get_order(sizeof(struct list_head)
-						   *ip_conntrack_htable_size));
-	if (!ip_conntrack_hash) { 
-		ip_conntrack_vmalloc = 1;
-		printk(KERN_WARNING "ip_conntrack: falling back to vmalloc.\n");
-		ip_conntrack_hash = vmalloc(sizeof(struct list_head)
-					    * ip_conntrack_htable_size);
-	}
+	for (i = 0; i < IP_CT_HASH_LOCKS; i++)
+		spin_lock_init(&ip_conntrack_hash_locks[i]);
+
+	ip_conntrack_hash = alloc_conntrack_hash(ip_conntrack_htable_size,
+						 &ip_conntrack_vmalloc);
 	if (!ip_conntrack_hash) {
 		printk(KERN_ERR "Unable to create ip_conntrack_hash\n");
 		goto err_unreg_sockopt;
@@ -1213,9 +1418,6 @@ int __init ip_conntrack_init(void)
 	ip_ct_protos[IPPROTO_ICMP] = &ip_conntrack_protocol_icmp;
 	WRITE_UNLOCK(&ip_conntrack_lock);
 
-	for (i = 0; i < ip_conntrack_htable_size; i++)
-		INIT_LIST_HEAD(&ip_conntrack_hash[i]);
-
 	/* For use by ipt_REJECT */
 	ip_ct_attach = ip_conntrack_attach;
 
@@ -1230,7 +1432,8 @@ int __init ip_conntrack_init(void)
 err_free_conntrack_slab:
 	kmem_cache_destroy(ip_conntrack_cachep);
 err_free_hash:
-	free_conntrack_hash();
+	free_conntrack_hash(ip_conntrack_hash, ip_conntrack_vmalloc,
+			    ip_conntrack_htable_size);
 err_unreg_sockopt:
 	nf_unregister_sockopt(&so_getorigdst);
 
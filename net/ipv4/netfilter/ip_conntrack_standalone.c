@@ -79,8 +79,23 @@ seq_print_counters(struct seq_file *s,
 
 struct ct_iter_state {
 	unsigned int bucket;
+	spinlock_t *lock;	/* bucket lock held while walking bucket */
 };
 
+static void ct_lock_bucket(struct ct_iter_state *st)
+{
+	st->lock = ip_conntrack_hash_lock(st->bucket);
+	spin_lock(st->lock);
+}
+
+static void ct_unlock_bucket(struct ct_iter_state *st)
+{
+	if (st->lock) {
+		spin_unlock(st->lock);
+		st->lock = NULL;
+	}
+}
+
 static struct list_head *ct_get_first(struct seq_file *seq)
 {
 	struct ct_iter_state *st = seq->private;
@@ -88,8 +103,10 @@ static struct list_head *ct_get_first(struct seq_file *seq)
 	for (st->bucket = 0;
 	     st->bucket < ip_conntrack_htable_size;
 	     st->bucket++) {
+		ct_lock_bucket(st);
 		if (!list_empty(&ip_conntrack_hash[st->bucket]))
 			return ip_conntrack_hash[st->bucket].next;
+		ct_unlock_bucket(st);
 	}
 	return NULL;
 }
@@ -100,8 +117,10 @@ static struct list_head *ct_get_next(struct seq_file *seq, struct list_head *hea
 
 	head = head->next;
 	while (head == &ip_conntrack_hash[st->bucket]) {
+		ct_unlock_bucket(st);
 		if (++st->bucket >= ip_conntrack_htable_size)
 			return NULL;
+		ct_lock_bucket(st);
 		head = ip_conntrack_hash[st->bucket].next;
 	}
 	return head;
@@ -119,7 +138,12 @@ static struct list_head *ct_get_idx(struct seq_file *seq, loff_t pos)
 
 static void *ct_seq_start(struct seq_file *seq, loff_t *pos)
 {
+	struct ct_iter_state *st = seq->private;
+
+	/* ip_conntrack_lock pins the table geometry, the bucket lock
+	   the chain being walked. */
 	READ_LOCK(&ip_conntrack_lock);
+	st->lock = NULL;
 	return ct_get_idx(seq, *pos);
 }
 
@@ -131,6 +155,7 @@ static void *ct_seq_next(struct seq_file *s, void *v, loff_t *pos)
   
 static void ct_seq_stop(struct seq_file *s, void *v)
 {
+	ct_unlock_bucket(s->private);
 	READ_UNLOCK(&ip_conntrack_lock);
 }
  
@@ -348,12 +373,12 @@ static int ct_cpu_seq_show(struct seq_file *seq, void *v)
 	struct ip_conntrack_stat *st = v;
 
 	if (v == SEQ_START_TOKEN) {
-		seq_printf(seq, "entries  searched found new invalid ignore delete delete_list insert insert_failed drop early_drop icmp_error  expect_new expect_create expect_delete\n");
+		seq_printf(seq, "entries  searched found new invalid ignore delete delete_list insert insert_failed drop early_drop icmp_error  expect_new expect_create expect_delete early_drop_fail\n");
 		return 0;
 	}
 
 	seq_printf(seq, "%08x  %08x %08x %08x %08x %08x %08x %08x "
-			"%08x %08x %08x %08x %08x  %08x %08x %08x \n",
+			"%08x %08x %08x %08x %08x  %08x %08x %08x %08x \n",
 		   nr_conntracks,
 		   st->searched,
 		   st->found,
@@ -370,7 +395,8 @@ static int ct_cpu_seq_show(struct seq_file *seq, void *v)
 
 		   st->expect_new,
 		   st->expect_create,
-		   st->expect_delete
+		   st->expect_delete,
+		   st->early_drop_fail
 		);
 	return 0;
 }
@@ -591,6 +617,42 @@ extern unsigned long ip_ct_icmp_timeout;
 /* From ip_conntrack_proto_icmp.c */
 extern unsigned long ip_ct_generic_timeout;
 
+/* Writing ip_conntrack_buckets rehashes the table into the new size. */
+static int ip_conntrack_buckets_sysctl(ctl_table *table, int write,
+				       struct file *filp, void __user *buffer,
+				       size_t *lenp, loff_t *ppos)
+{
+	unsigned int size = ip_conntrack_htable_size;
+	ctl_table tmp = *table;
+	int ret;
+
+	tmp.data = &size;
+	ret = proc_dointvec(&tmp, write, filp, buffer, lenp, ppos);
+	if (ret || !write)
+		return ret;
+	return ip_conntrack_set_hashsize(size);
+}
+
+static int ip_conntrack_buckets_strategy(ctl_table *table, int __user *name,
+					 int nlen, void __user *oldval,
+					 size_t __user *oldlenp,
+					 void __user *newval, size_t newlen,
+					 void **context)
+{
+	unsigned int size;
+	int ret;
+
+	/* Reads are handled by the default strategy. */
+	if (!newval || !newlen)
+		return 0;
+	if (newlen != sizeof(size))
+		return -EINVAL;
+	if (copy_from_user(&size, newval, sizeof(size)))
+		return -EFAULT;
+	ret = ip_conntrack_set_hashsize(size);
+	return ret ? ret : 1;
+}
+
 /* Log invalid packets of a given protocol */
 static int log_invalid_proto_min = 0;
 static int log_invalid_proto_max = 255;
@@ -619,8 +681,9 @@ static ctl_table ip_ct_sysctl_table[] = {
 		.procname	= "ip_conntrack_buckets",
 		.data		= &ip_conntrack_htable_size,
 		.maxlen		= sizeof(unsigned int),
-		.mode		= 0444,
-		.proc_handler	= &proc_dointvec,
+		.mode		= 0644,
+		.proc_handler	= &ip_conntrack_buckets_sysctl,
+		.strategy	= &ip_conntrack_buckets_strategy,
 	},
 	{
 		.ctl_name	= NET_IPV4_NF_CONNTRACK_TCP_TIMEOUT_SYN_SENT,
@@ -993,6 +1056,8 @@ EXPORT_SYMBOL(ip_ct_gather_frags);
 EXPORT_SYMBOL(ip_conntrack_htable_size);
 EXPORT_SYMBOL(ip_conntrack_lock);
 EXPORT_SYMBOL(ip_conntrack_hash);
+EXPORT_SYMBOL(ip_conntrack_hash_locks);
+EXPORT_SYMBOL(ip_conntrack_set_hashsize);
 EXPORT_SYMBOL(ip_conntrack_untracked);
 EXPORT_SYMBOL_GPL(ip_conntrack_find_get);
 EXPORT_SYMBOL_GPL(ip_conntrack_put);
@@ -255,6 +255,7 @@
 #include <linux/init.h>
 #include <linux/smp_lock.h>
 #include <linux/fs.h>
+#include <linux/pipe_fs_i.h>
 #include <linux/random.h>
 #include <linux/bootmem.h>
 
@@ -1198,7 +1199,8 @@ int tcp_read_sock(struct sock *sk, read_descriptor_t *desc,
 		return -ENOTCONN;
 	while ((skb = tcp_recv_skb(sk, seq, &offset)) != NULL) {
 		if (offset < skb->len) {
-			size_t used, len;
+			int used;
+			size_t len;
 
 			len = skb->len - offset;
 			/* Stop reading if we hit a patch of urgent data */
@@ -1210,7 +1212,12 @@ int tcp_read_sock(struct sock *sk, read_descriptor_t *desc,
 					break;
 			}
 			used = recv_actor(desc, skb, offset, len);
-			if (used <= len) {
+			if (used <= 0) {
+				/* error or nothing taken: report it, don't advance */
+				if (!copied)
+					copied = used;
+				break;
+			} else if (used <= len) {
 				seq += used;
 				copied += used;
 				offset += used;
@@ -1232,11 +1239,143 @@ int tcp_read_sock(struct sock *sk, read_descriptor_t *desc,
 	tcp_rcv_space_adjust(sk);
 
 	/* Clean up data we have read: This will do ACK frames. */
-	if (copied)
+	if (copied > 0)
 		cleanup_rbuf(sk, copied);
 	return copied;
 }
 
+struct tcp_splice_state {
+	struct inode *pipe;
+	size_t len;
+	unsigned int flags;
+	int full;
+};
+
+static int tcp_splice_data_recv(read_descriptor_t *rd_desc,
+				struct sk_buff *skb, unsigned int offset,
+				size_t len)
+{
+	struct tcp_splice_state *tss = rd_desc->arg.data;
+	int ret;
+
+	if (len > tss->len)
+		len = tss->len;
+
+	ret = skb_splice_bits(skb, offset, tss->pipe, len, tss->flags);
+	if (ret >= 0) {
+		tss->len -= ret;
+		rd_desc->count = tss->len;
+		/*
+		 * Short splice: the pipe is full, leave the rest queued.
+		 * tcp_splice_read() waits for room without the socket lock.
+		 */
+		if (ret < len) {
+			tss->full = 1;
+			rd_desc->count = 0;
+		}
+	}
+	return ret;
+}
+
+/*
+ * Splice data from a TCP socket into a pipe.  Only what the pipe
+ * actually accepted is consumed from the receive queue, so nothing is
+ * lost if the pipe fills up; the skb pages are referenced by the pipe
+ * buffers rather than copied (see skb_splice_bits()).
+ */
+ssize_t tcp_splice_read(struct socket *sock, loff_t *ppos,
+			struct inode *pipe, size_t len, unsigned int flags)
+{
+	struct sock *sk = sock->sk;
+	struct tcp_splice_state tss = {
+		.pipe = pipe,
+		.len = len,
+		.flags = flags,
+	};
+	read_descriptor_t rd_desc;
+	ssize_t spliced = 0;
+	long timeo;
+	int ret;
+#ifdef NET_DEBUG
+        printk("Entering tcp_splice_read\n");
+#endif
+
+	lock_sock(sk);
+
+	timeo = sock_rcvtimeo(sk, (sock->file->f_flags & O_NONBLOCK) ||
+				  (flags & SPLICE_F_NONBLOCK));
+	while (tss.len) {
+		rd_desc.arg.data = &tss;
+		rd_desc.count = tss.len;
+		tss.full = 0;
+		ret = tcp_read_sock(sk, &rd_desc, tcp_splice_data_recv);
+		if (ret < 0) {
+			if (!spliced)
+				spliced = ret;
+			break;
+		} else if (!ret) {
+			if (spliced)
+				break;
+			if (tss.full) {
+				/* Never sleep on the pipe with the socket locked */
+				release_sock(sk);
+				ret = splice_wait_pipe_room(pipe, timeo ? flags :
+						flags | SPLICE_F_NONBLOCK);
+				lock_sock(sk);
+				if (ret < 0) {
+					spliced = ret;
+					break;
+				}
+				continue;
+			}
+			if (sock_flag(sk, SOCK_DONE))
+				break;
+			if (sk->sk_err) {
+				spliced = sock_error(sk);
+				break;
+			}
+			if (sk->sk_shutdown & RCV_SHUTDOWN)
+				break;
+			if (sk->sk_state == TCP_CLOSE) {
+				/*
+				 * This occurs when user tries to read
+				 * from never connected socket.
+				 */
+				if (!sock_flag(sk, SOCK_DONE))
+					spliced = -ENOTCONN;
+				break;
+			}
+			if (!timeo) {
+				spliced = -EAGAIN;
+				break;
+			}
+			if (signal_pending(current)) {
+				spliced = sock_intr_errno(timeo);
+				break;
+			}
+			sk_wait_data(sk, &timeo);
+			continue;
+		}
+		spliced += ret;
+
+		if (tss.full || !timeo)
+			break;
+
+		/* Let the backlog in before looking for more data */
+		release_sock(sk);
+		lock_sock(sk);
+
+		if (sk->sk_err || sk->sk_state == TCP_CLOSE ||
+		    (sk->sk_shutdown & RCV_SHUTDOWN) ||
+		    signal_pending(current))
+			break;
+	}
+
+	release_sock(sk);
+
+	return spliced;
+}
+
 /*
  *	This routine copies from a sock struct into the user buffer.
  *
@@ -2006,6 +2145,25 @@ int tcp_setsockopt(struct sock *sk, int level, int optname, char __user *optval,
 		return tp->af_specific->setsockopt(sk, level, optname,
 						   optval, optlen);
 
+	/* This is a string value all the others are int's */
+	if (optname == TCP_CONGESTION) {
+		char name[TCP_CA_NAME_MAX];
+
+		if (optlen < 1)
+			return -EINVAL;
+
+		val = strncpy_from_user(name, optval,
+					min(TCP_CA_NAME_MAX-1, optlen));
+		if (val < 0)
+			return -EFAULT;
+		name[val] = 0;
+
+		lock_sock(sk);
+		err = tcp_set_congestion_control(tp, name);
+		release_sock(sk);
+		return err;
+	}
+
 	if (optlen < sizeof(int))
 		return -EINVAL;
 
@@ -2290,6 +2448,16 @@ int tcp_getsockopt(struct sock *sk, int level, int optname, char __user *optval,
 	case TCP_QUICKACK:
 		val = !tp->ack.pingpong;
 		break;
+
+	case TCP_CONGESTION:
+		if (get_user(len, optlen))
+			return -EFAULT;
+		len = min_t(unsigned int, len, TCP_CA_NAME_MAX);
+		if (put_user(len, optlen))
+			return -EFAULT;
+		if (copy_to_user(optval, tp->ca_ops->name, len))
+			return -EFAULT;
+		return 0;
 	default:
 		return -ENOPROTOOPT;
 	};
@@ -2419,6 +2587,8 @@ void __init tcp_init(void)
 	printk(KERN_INFO "TCP: Hash tables configured "
 	       "(established %d bind %d)\n",
 	       tcp_ehash_size << 1, tcp_bhash_size);
+
+	tcp_register_congestion_control(&tcp_reno);
 }
 
 EXPORT_SYMBOL(tcp_accept);
@@ -2435,5 +2605,6 @@ EXPORT_SYMBOL(tcp_sendmsg);
 EXPORT_SYMBOL(tcp_sendpage);
 EXPORT_SYMBOL(tcp_setsockopt);
 EXPORT_SYMBOL(tcp_shutdown);
+EXPORT_SYMBOL(tcp_splice_read);
 EXPORT_SYMBOL(tcp_statistics);
 EXPORT_SYMBOL(tcp_timewait_cachep);
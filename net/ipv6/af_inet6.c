@@ -483,7 +483,8 @@ struct proto_ops inet6_stream_ops = {
 	.sendmsg =	inet_sendmsg,			/* ok		*/
 	.recvmsg =	sock_common_recvmsg,		/* ok		*/
 	.mmap =		sock_no_mmap,
-	.sendpage =	tcp_sendpage
+	.sendpage =	tcp_sendpage,
+	.splice_read =	tcp_splice_read,
 };
 
 struct proto_ops inet6_dgram_ops = {
@@ -48,6 +48,7 @@
 #include <linux/types.h>
 #include <linux/sched.h>
 #include <linux/mm.h>
+#include <linux/vmalloc.h>
 #include <linux/fcntl.h>
 #include <linux/socket.h>
 #include <linux/in.h>
@@ -165,7 +166,19 @@ struct packet_mclist
 };
 #endif
 #ifdef CONFIG_PACKET_MMAP
-static int packet_set_ring(struct sock *sk, struct tpacket_req *req, int closing);
+static int packet_set_ring(struct sock *sk, struct tpacket_req *req,
+			   int closing, int tx_ring);
+
+struct packet_ring_buffer {
+	char *			*pg_vec;
+	unsigned int		head;
+	unsigned int		frames_per_block;
+	unsigned int		frame_size;
+	unsigned int		frame_max;
+	unsigned int		pg_vec_order;
+	unsigned int		pg_vec_pages;
+	unsigned int		pg_vec_len;
+};
 #endif
 
 static void packet_flush_mclist(struct sock *sk);
@@ -175,11 +188,8 @@ struct packet_sock {
 	struct sock		sk;
 	struct tpacket_stats	stats;
 #ifdef CONFIG_PACKET_MMAP
-	char *			*pg_vec;
-	unsigned int		head;
-	unsigned int            frames_per_block;
-	unsigned int		frame_size;
-	unsigned int		frame_max;
+	struct packet_ring_buffer	rx_ring;
+	struct packet_ring_buffer	tx_ring;
 	int			copy_thresh;
 #endif
 	struct packet_type	prot_hook;
@@ -192,26 +202,57 @@ struct packet_sock {
 #endif
 #ifdef CONFIG_PACKET_MMAP
 	atomic_t		mapped;
-	unsigned int            pg_vec_order;
-	unsigned int		pg_vec_pages;
-	unsigned int		pg_vec_len;
 #endif
 };
 
 #ifdef CONFIG_PACKET_MMAP
 
-static inline char *packet_lookup_frame(struct packet_sock *po, unsigned int position)
+/*
+ * Ring blocks come from the page allocator when a contiguous block of
+ * that order is available, and from vmalloc otherwise, so large blocks
+ * (and the large frames they hold) can still be set up on a fragmented
+ * system.
+ */
+static inline int pg_vec_is_vmalloc(const void *addr)
+{
+	return (unsigned long)addr >= VMALLOC_START &&
+	       (unsigned long)addr < VMALLOC_END;
+}
+
+static inline struct page *pgv_to_page(void *addr)
+{
+	if (pg_vec_is_vmalloc(addr))
+		return vmalloc_to_page(addr);
+	return virt_to_page(addr);
+}
+
+static void packet_flush_range(void *start, unsigned int len)
+{
+	unsigned long addr = (unsigned long)start & PAGE_MASK;
+	unsigned long end = (unsigned long)start + len;
+
+	for (; addr < end; addr += PAGE_SIZE)
+		flush_dcache_page(pgv_to_page((void *)addr));
+}
+
+static inline char *packet_lookup_frame(struct packet_ring_buffer *rb,
+					unsigned int position)
 {
 	unsigned int pg_vec_pos, frame_offset;
 	char *frame;
 
-	pg_vec_pos = position / po->frames_per_block;
-	frame_offset = position % po->frames_per_block;
+	pg_vec_pos = position / rb->frames_per_block;
+	frame_offset = position % rb->frames_per_block;
 
-	frame = po->pg_vec[pg_vec_pos] + (frame_offset * po->frame_size);
+	frame = rb->pg_vec[pg_vec_pos] + (frame_offset * rb->frame_size);
 	
 	return frame;
 }
+
+static inline void packet_increment_head(struct packet_ring_buffer *rb)
+{
+	rb->head = rb->head != rb->frame_max ? rb->head + 1 : 0;
+}
 #endif
 
 static inline struct packet_sock *pkt_sk(struct sock *sk)
@@ -594,7 +635,7 @@ static int tpacket_rcv(struct sk_buff *skb, struct net_device *dev,  struct pack
 		macoff = netoff - maclen;
 	}
 
-	if (macoff + snaplen > po->frame_size) {
+	if (macoff + snaplen > po->rx_ring.frame_size) {
 		if (po->copy_thresh &&
 		    atomic_read(&sk->sk_rmem_alloc) + skb->truesize <
 		    (unsigned)sk->sk_rcvbuf) {
@@ -607,7 +648,7 @@ static int tpacket_rcv(struct sk_buff *skb, struct net_device *dev,  struct pack
 			if (copy_skb)
 				skb_set_owner_r(copy_skb, sk);
 		}
-		snaplen = po->frame_size - macoff;
+		snaplen = po->rx_ring.frame_size - macoff;
 		if ((int)snaplen < 0)
 			snaplen = 0;
 	}
@@ -615,11 +656,12 @@ static int tpacket_rcv(struct sk_buff *skb, struct net_device *dev,  struct pack
 		snaplen = skb->len-skb->data_len;
 
 	spin_lock(&sk->sk_receive_queue.lock);
-	h = (struct tpacket_hdr *)packet_lookup_frame(po, po->head);
+	h = (struct tpacket_hdr *)packet_lookup_frame(&po->rx_ring,
+						      po->rx_ring.head);
 	
 	if (h->tp_status)
 		goto ring_is_full;
-	po->head = po->head != po->frame_max ? po->head+1 : 0;
+	packet_increment_head(&po->rx_ring);
 	po->stats.tp_packets++;
 	if (copy_skb) {
 		status |= TP_STATUS_COPY;
@@ -655,17 +697,7 @@ static int tpacket_rcv(struct sk_buff *skb, struct net_device *dev,  struct pack
 	h->tp_status = status;
 	mb();
 
-	{
-		struct page *p_start, *p_end;
-		u8 *h_end = (u8 *)h + macoff + snaplen - 1;
-
-		p_start = virt_to_page(h);
-		p_end = virt_to_page(h_end);
-		while (p_start <= p_end) {
-			flush_dcache_page(p_start);
-			p_start++;
-		}
-	}
+	packet_flush_range(h, macoff + snaplen);
 
 	sk->sk_data_ready(sk, 0);
 
@@ -688,6 +720,129 @@ ring_is_full:
 	goto drop_n_restore;
 }
 
+/*
+ * Transmit every frame of the TX ring that userspace has marked
+ * TP_STATUS_SEND_REQUEST, starting at the ring head.  Each frame holds
+ * tp_len bytes of packet data at TPACKET_HDRLEN - sizeof(struct sockaddr_ll)
+ * from its start (including the link level header for SOCK_RAW).  Frames
+ * are copied into an skb straight from the ring and handed back to
+ * userspace (TP_STATUS_AVAILABLE) as soon as they are queued, so one
+ * send() flushes the whole batch.
+ */
+static int tpacket_snd(struct packet_sock *po, struct msghdr *msg)
+{
+	struct sock *sk = &po->sk;
+	struct socket *sock = sk->sk_socket;
+	struct sockaddr_ll *saddr = (struct sockaddr_ll *)msg->msg_name;
+	struct packet_ring_buffer *rb = &po->tx_ring;
+	struct net_device *dev;
+	struct tpacket_hdr *h;
+	struct sk_buff *skb;
+	unsigned short proto;
+	unsigned char *addr;
+	u8 *data;
+	int ifindex, err, reserve = 0;
+	unsigned int size_max, tp_len;
+	int len_sum = 0;
+
+	if (saddr == NULL) {
+		ifindex	= po->ifindex;
+		proto	= po->num;
+		addr	= NULL;
+	} else {
+		if (msg->msg_namelen < sizeof(struct sockaddr_ll))
+			return -EINVAL;
+		ifindex	= saddr->sll_ifindex;
+		proto	= saddr->sll_protocol;
+		addr	= saddr->sll_addr;
+	}
+
+	dev = dev_get_by_index(ifindex);
+	if (dev == NULL)
+		return -ENXIO;
+
+	lock_sock(sk);
+
+	err = -ENETDOWN;
+	if (!(dev->flags & IFF_UP))
+		goto out;
+	err = -EBUSY;
+	if (rb->pg_vec == NULL)
+		goto out;
+
+	if (sock->type == SOCK_RAW)
+		reserve = dev->hard_header_len;
+	size_max = rb->frame_size - (TPACKET_HDRLEN - sizeof(struct sockaddr_ll));
+	if (size_max > dev->mtu + reserve)
+		size_max = dev->mtu + reserve;
+
+	err = 0;
+	for (;;) {
+		h = (struct tpacket_hdr *)packet_lookup_frame(rb, rb->head);
+		packet_flush_range(&h->tp_status, sizeof(h->tp_status));
+		if (h->tp_status != TP_STATUS_SEND_REQUEST)
+			break;
+		smp_rmb();
+
+		tp_len = h->tp_len;
+		if (tp_len > size_max || tp_len < reserve) {
+			h->tp_status = TP_STATUS_WRONG_FORMAT;
+			packet_flush_range(&h->tp_status, sizeof(h->tp_status));
+			err = -EMSGSIZE;
+			break;
+		}
+
+		skb = sock_alloc_send_skb(sk, tp_len + LL_RESERVED_SPACE(dev),
+					  msg->msg_flags & MSG_DONTWAIT, &err);
+		if (skb == NULL)
+			break;
+
+		skb_reserve(skb, LL_RESERVED_SPACE(dev));
+		skb->nh.raw = skb->data;
+
+		if (dev->hard_header) {
+			int res;
+
+			res = dev->hard_header(skb, dev, ntohs(proto), addr,
+					       NULL, tp_len);
+			if (sock->type != SOCK_DGRAM) {
+				skb->tail = skb->data;
+				skb->len = 0;
+			} else if (res < 0) {
+				kfree_skb(skb);
+				h->tp_status = TP_STATUS_WRONG_FORMAT;
+				packet_flush_range(&h->tp_status,
+						   sizeof(h->tp_status));
+				err = -EINVAL;
+				break;
+			}
+		}
+
+		data = (u8 *)h + TPACKET_HDRLEN - sizeof(struct sockaddr_ll);
+		packet_flush_range(data, tp_len);
+		memcpy(skb_put(skb, tp_len), data, tp_len);
+
+		skb->protocol = proto;
+		skb->dev = dev;
+		skb->priority = sk->sk_priority;
+
+		/* The data has been copied out, the frame can be reused */
+		smp_wmb();
+		h->tp_status = TP_STATUS_AVAILABLE;
+		packet_flush_range(&h->tp_status, sizeof(h->tp_status));
+		packet_increment_head(rb);
+
+		err = dev_queue_xmit(skb);
+		if (err > 0 && (err = net_xmit_errno(err)) != 0)
+			break;
+		len_sum += tp_len;
+	}
+
+out:
+	release_sock(sk);
+	dev_put(dev);
+	return len_sum ? len_sum : err;
+}
 #endif
 
 
@@ -702,6 +857,11 @@ static int packet_sendmsg(struct kiocb *iocb, struct socket *sock,
 	unsigned char *addr;
 	int ifindex, err, reserve = 0;
 
+#ifdef CONFIG_PACKET_MMAP
+	if (pkt_sk(sk)->tx_ring.pg_vec)
+		return tpacket_snd(pkt_sk(sk), msg);
+#endif
+
 	/*
 	 *	Get and verify the address. 
 	 */
@@ -824,10 +984,14 @@ static int packet_release(struct socket *sock)
 #endif
 
 #ifdef CONFIG_PACKET_MMAP
-	if (po->pg_vec) {
+	{
 		struct tpacket_req req;
 		memset(&req, 0, sizeof(req));
-		packet_set_ring(sk, &req, 1);
+
+		if (po->rx_ring.pg_vec)
+			packet_set_ring(sk, &req, 1, 0);
+		if (po->tx_ring.pg_vec)
+			packet_set_ring(sk, &req, 1, 1);
 	}
 #endif
 
@@ -1329,6 +1493,7 @@ packet_setsockopt(struct socket *sock, int level, int optname, char __user *optv
 #endif
 #ifdef CONFIG_PACKET_MMAP
 	case PACKET_RX_RING:
+	case PACKET_TX_RING:
 	{
 		struct tpacket_req req;
 
@@ -1336,7 +1501,7 @@ packet_setsockopt(struct socket *sock, int level, int optname, char __user *optv
 			return -EINVAL;
 		if (copy_from_user(&req,optval,sizeof(req)))
 			return -EFAULT;
-		return packet_set_ring(sk, &req, 0);
+		return packet_set_ring(sk, &req, 0, optname == PACKET_TX_RING);
 	}
 	case PACKET_COPY_THRESH:
 	{
@@ -1514,16 +1679,26 @@ static unsigned int packet_poll(struct file * file, struct socket *sock,
 	unsigned int mask = datagram_poll(file, sock, wait);
 
 	spin_lock_bh(&sk->sk_receive_queue.lock);
-	if (po->pg_vec) {
-		unsigned last = po->head ? po->head-1 : po->frame_max;
+	if (po->rx_ring.pg_vec) {
+		struct packet_ring_buffer *rb = &po->rx_ring;
+		unsigned last = rb->head ? rb->head-1 : rb->frame_max;
 		struct tpacket_hdr *h;
 
-		h = (struct tpacket_hdr *)packet_lookup_frame(po, last);
+		h = (struct tpacket_hdr *)packet_lookup_frame(rb, last);
 
 		if (h->tp_status)
 			mask |= POLLIN | POLLRDNORM;
 	}
 	spin_unlock_bh(&sk->sk_receive_queue.lock);
+
+	if (po->tx_ring.pg_vec) {
+		struct packet_ring_buffer *rb = &po->tx_ring;
+		struct tpacket_hdr *h;
+
+		h = (struct tpacket_hdr *)packet_lookup_frame(rb, rb->head);
+		if (h->tp_status == TP_STATUS_AVAILABLE)
+			mask |= POLLOUT | POLLWRNORM;
+	}
 	return mask;
 }
 
@@ -1559,9 +1734,20 @@ static struct vm_operations_struct packet_mmap_ops = {
 	.close =packet_mm_close,
 };
 
-static inline struct page *pg_vec_endpage(char *one_pg_vec, unsigned int order)
+static char *alloc_one_pg_vec_page(unsigned int order)
 {
-	return virt_to_page(one_pg_vec + (PAGE_SIZE << order) - 1);
+	char *block;
+	char *p;
+
+	block = (char *)__get_free_pages(GFP_KERNEL | __GFP_NOWARN, order);
+	if (!block)
+		block = vmalloc(PAGE_SIZE << order);
+	if (!block)
+		return NULL;
+
+	for (p = block; p < block + (PAGE_SIZE << order); p += PAGE_SIZE)
+		SetPageReserved(pgv_to_page(p));
+	return block;
 }
 
 static void free_pg_vec(char **pg_vec, unsigned order, unsigned len)
@@ -1569,24 +1755,30 @@ static void free_pg_vec(char **pg_vec, unsigned order, unsigned len)
 	int i;
 
 	for (i=0; i<len; i++) {
-		if (pg_vec[i]) {
-			struct page *page, *pend;
-
-			pend = pg_vec_endpage(pg_vec[i], order);
-			for (page = virt_to_page(pg_vec[i]); page <= pend; page++)
-				ClearPageReserved(page);
+		char *p;
+
+		if (!pg_vec[i])
+			continue;
+		for (p = pg_vec[i]; p < pg_vec[i] + (PAGE_SIZE << order);
+		     p += PAGE_SIZE)
+			ClearPageReserved(pgv_to_page(p));
+		if (pg_vec_is_vmalloc(pg_vec[i]))
+			vfree(pg_vec[i]);
+		else
 			free_pages((unsigned long)pg_vec[i], order);
-		}
 	}
 	kfree(pg_vec);
 }
 
 
-static int packet_set_ring(struct sock *sk, struct tpacket_req *req, int closing)
+static int packet_set_ring(struct sock *sk, struct tpacket_req *req,
+			   int closing, int tx_ring)
 {
 	char **pg_vec = NULL;
 	struct packet_sock *po = pkt_sk(sk);
+	struct packet_ring_buffer *rb = tx_ring ? &po->tx_ring : &po->rx_ring;
 	int was_running, num, order = 0;
+	unsigned int frames_per_block = 0;
 	int err = 0;
 	
 	if (req->tp_block_nr) {
@@ -1594,7 +1786,7 @@ static int packet_set_ring(struct sock *sk, struct tpacket_req *req, int closing
 
 		/* Sanity tests and some calculations */
 
-		if (po->pg_vec)
+		if (rb->pg_vec)
 			return -EBUSY;
 
 		if ((int)req->tp_block_size <= 0)
@@ -1606,10 +1798,10 @@ static int packet_set_ring(struct sock *sk, struct tpacket_req *req, int closing
 		if (req->tp_frame_size&(TPACKET_ALIGNMENT-1))
 			return -EINVAL;
 
-		po->frames_per_block = req->tp_block_size/req->tp_frame_size;
-		if (po->frames_per_block <= 0)
+		frames_per_block = req->tp_block_size/req->tp_frame_size;
+		if (frames_per_block <= 0)
 			return -EINVAL;
-		if (po->frames_per_block*req->tp_block_nr != req->tp_frame_nr)
+		if (frames_per_block*req->tp_block_nr != req->tp_frame_nr)
 			return -EINVAL;
 		/* OK! */
 
@@ -1625,14 +1817,9 @@ static int packet_set_ring(struct sock *sk, struct tpacket_req *req, int closing
 		memset(pg_vec, 0, req->tp_block_nr*sizeof(char **));
 
 		for (i=0; i<req->tp_block_nr; i++) {
-			struct page *page, *pend;
-			pg_vec[i] = (char *)__get_free_pages(GFP_KERNEL, order);
+			pg_vec[i] = alloc_one_pg_vec_page(order);
 			if (!pg_vec[i])
 				goto out_free_pgvec;
-
-			pend = pg_vec_endpage(pg_vec[i], order);
-			for (page = virt_to_page(pg_vec[i]); page <= pend; page++)
-				SetPageReserved(page);
 		}
 		/* Page vector is allocated */
 
@@ -1642,7 +1829,7 @@ static int packet_set_ring(struct sock *sk, struct tpacket_req *req, int closing
 			struct tpacket_hdr *header;
 			int k;
 
-			for (k=0; k<po->frames_per_block; k++) {
+			for (k=0; k<frames_per_block; k++) {
 				
 				header = (struct tpacket_hdr*)ptr;
 				header->tp_status = TP_STATUS_KERNEL;
@@ -1677,18 +1864,21 @@ static int packet_set_ring(struct sock *sk, struct tpacket_req *req, int closing
 #define XC(a, b) ({ __typeof__ ((a)) __t; __t = (a); (a) = (b); __t; })
 
 		spin_lock_bh(&sk->sk_receive_queue.lock);
-		pg_vec = XC(po->pg_vec, pg_vec);
-		po->frame_max = req->tp_frame_nr-1;
-		po->head = 0;
-		po->frame_size = req->tp_frame_size;
+		pg_vec = XC(rb->pg_vec, pg_vec);
+		rb->frame_max = req->tp_frame_nr-1;
+		rb->head = 0;
+		rb->frame_size = req->tp_frame_size;
+		rb->frames_per_block = frames_per_block;
 		spin_unlock_bh(&sk->sk_receive_queue.lock);
 
-		order = XC(po->pg_vec_order, order);
-		req->tp_block_nr = XC(po->pg_vec_len, req->tp_block_nr);
+		order = XC(rb->pg_vec_order, order);
+		req->tp_block_nr = XC(rb->pg_vec_len, req->tp_block_nr);
 
-		po->pg_vec_pages = req->tp_block_size/PAGE_SIZE;
-		po->prot_hook.func = po->pg_vec ? tpacket_rcv : packet_rcv;
-		skb_queue_purge(&sk->sk_receive_queue);
+		rb->pg_vec_pages = req->tp_block_size/PAGE_SIZE;
+		if (!tx_ring) {
+			po->prot_hook.func = rb->pg_vec ? tpacket_rcv : packet_rcv;
+			skb_queue_purge(&sk->sk_receive_queue);
+		}
 #undef XC
 		if (atomic_read(&po->mapped))
 			printk(KERN_DEBUG "packet_mmap: vma is busy: %d\n", atomic_read(&po->mapped));
@@ -1716,10 +1906,11 @@ static int packet_mmap(struct file *file, struct socket *sock, struct vm_area_st
 {
 	struct sock *sk = sock->sk;
 	struct packet_sock *po = pkt_sk(sk);
-	unsigned long size;
+	struct packet_ring_buffer *rings[] = { &po->rx_ring, &po->tx_ring };
+	unsigned long size, expected_size;
 	unsigned long start;
 	int err = -EINVAL;
-	int i;
+	int i, r;
 
 	if (vma->vm_pgoff)
 		return -EINVAL;
@@ -1727,21 +1918,48 @@ static int packet_mmap(struct file *file, struct socket *sock, struct vm_area_st
 	size = vma->vm_end - vma->vm_start;
 
 	lock_sock(sk);
-	if (po->pg_vec == NULL)
+
+	/* The RX ring, if any, is mapped first and the TX ring follows it */
+	expected_size = 0;
+	for (r = 0; r < ARRAY_SIZE(rings); r++)
+		if (rings[r]->pg_vec)
+			expected_size += rings[r]->pg_vec_len *
+					 rings[r]->pg_vec_pages * PAGE_SIZE;
+	if (expected_size == 0)
 		goto out;
-	if (size != po->pg_vec_len*po->pg_vec_pages*PAGE_SIZE)
+	if (size != expected_size)
 		goto out;
 
 	atomic_inc(&po->mapped);
 	start = vma->vm_start;
 	err = -EAGAIN;
-	for (i=0; i<po->pg_vec_len; i++) {
-		if (remap_pfn_range(vma, start,
-				     __pa(po->pg_vec[i]) >> PAGE_SHIFT,
-				     po->pg_vec_pages*PAGE_SIZE,
-				     vma->vm_page_prot))
-			goto out;
-		start += po->pg_vec_pages*PAGE_SIZE;
+	for (r = 0; r < ARRAY_SIZE(rings); r++) {
+		struct packet_ring_buffer *rb = rings[r];
+
+		for (i = 0; rb->pg_vec && i < rb->pg_vec_len; i++) {
+			char *block = rb->pg_vec[i];
+			unsigned long len = rb->pg_vec_pages * PAGE_SIZE;
+			unsigned long off;
+
+			if (!pg_vec_is_vmalloc(block)) {
+				if (remap_pfn_range(vma, start,
+						    __pa(block) >> PAGE_SHIFT,
+						    len, vma->vm_page_prot))
+					goto out;
+				start += len;
+				continue;
+			}
+			for (off = 0; off < len; off += PAGE_SIZE) {
+				struct page *page = vmalloc_to_page(block + off);
+
+				if (remap_pfn_range(vma, start,
+						    page_to_pfn(page),
+						    PAGE_SIZE,
+						    vma->vm_page_prot))
+					goto out;
+				start += PAGE_SIZE;
+			}
+		}
 	}
 	vma->vm_ops = &packet_mmap_ops;
 	err = 0;
@@ -113,6 +113,9 @@ static ssize_t sock_writev(struct file *file, const struct iovec *vector,
 			  unsigned long count, loff_t *ppos);
 static ssize_t sock_sendpage(struct file *file, struct page *page,
 			     int offset, size_t size, loff_t *ppos, int more);
+static ssize_t sock_splice_read(struct file *file, loff_t *ppos,
+				struct inode *pipe, size_t len,
+				unsigned int flags);
 
 
 /*
@@ -133,7 +136,8 @@ static struct file_operations socket_file_ops = {
 	.fasync =	sock_fasync,
 	.readv =	sock_readv,
 	.writev =	sock_writev,
-	.sendpage =	sock_sendpage
+	.sendpage =	sock_sendpage,
+	.splice_read =	sock_splice_read,
 };
 
 /*
@@ -770,6 +774,21 @@ ssize_t sock_sendpage(struct file *file, struct page *page,
 	return sock->ops->sendpage(sock, page, offset, size, flags);
 }
 
+static ssize_t sock_splice_read(struct file *file, loff_t *ppos,
+				struct inode *pipe, size_t len,
+				unsigned int flags)
+{
+	struct socket *sock = SOCKET_I(file->f_dentry->d_inode);
+#ifdef NET_DEBUG
+	printk("Entering sock_splice_read \n");
+#endif
+
+	if (!sock->ops->splice_read)
+		return -EINVAL;
+
+	return sock->ops->splice_read(sock, ppos, pipe, len, flags);
+}
+
 static int sock_readv_writev(int type, struct inode * inode,
 			     struct file * file, const struct iovec * iov,
 			     long count, size_t size)
@@ -1824,13 +1843,14 @@ out:
 }
 
 /*
- *	BSD recvmsg interface
+ *	Receive one message into a user msghdr on an already looked up
+ *	socket.  Shared by recvmsg and recvmmsg.
  */
 
-asmlinkage long sys_recvmsg(int fd, struct msghdr __user *msg, unsigned int flags)
+static int __sys_recvmsg(struct socket *sock, struct msghdr __user *msg,
+			 unsigned int flags)
 {
 	struct compat_msghdr __user *msg_compat = (struct compat_msghdr __user *)msg;
-	struct socket *sock;
 	struct iovec iovstack[UIO_FASTIOV];
 	struct iovec *iov=iovstack;
 	struct msghdr msg_sys;
@@ -1851,21 +1871,15 @@ asmlinkage long sys_recvmsg(int fd, struct msghdr __user *msg, unsigned int flag
 		if (copy_from_user(&msg_sys,msg,sizeof(struct msghdr)))
 			return -EFAULT;
 
-	sock = sockfd_lookup(fd, &err);
-	if (!sock)
-		goto out;
-
-	err = -EMSGSIZE;
 	if (msg_sys.msg_iovlen > UIO_MAXIOV)
-		goto out_put;
+		return -EMSGSIZE;
 	
 	/* Check whether to allocate the iovec area*/
-	err = -ENOMEM;
 	iov_size = msg_sys.msg_iovlen * sizeof(struct iovec);
 	if (msg_sys.msg_iovlen > UIO_FASTIOV) {
 		iov = sock_kmalloc(sock->sk, iov_size, GFP_KERNEL);
 		if (!iov)
-			goto out_put;
+			return -ENOMEM;
 	}
 
 	/*
@@ -1916,19 +1930,147 @@ asmlinkage long sys_recvmsg(int fd, struct msghdr __user *msg, unsigned int flag
 out_freeiov:
 	if (iov != iovstack)
 		sock_kfree_s(sock->sk, iov, iov_size);
-out_put:
+	return err;
+}
+
+/*
+ *	BSD recvmsg interface
+ */
+
+asmlinkage long sys_recvmsg(int fd, struct msghdr __user *msg, unsigned int flags)
+{
+	struct socket *sock;
+	int err;
+
+	sock = sockfd_lookup(fd, &err);
+	if (!sock)
+		return err;
+
+	err = __sys_recvmsg(sock, msg, flags);
 	sockfd_put(sock);
-out:
 	return err;
 }
 
+/*
+ *	Receive up to vlen messages in one call, storing the length of each
+ *	in msg_len.  Without MSG_WAITFORONE a blocking socket waits until all
+ *	vlen messages arrived; with it, only the first receive may block.
+ *
+ *	The timeout is checked after each message, so a receive that is
+ *	already blocked is bounded by SO_RCVTIMEO rather than by *timeout.
+ *	On return *timeout holds the time left.
+ */
+
+int __sys_recvmmsg(int fd, struct mmsghdr __user *mmsg, unsigned int vlen,
+		   unsigned int flags, struct timespec *timeout)
+{
+	struct compat_mmsghdr __user *compat_entry;
+	struct mmsghdr __user *entry;
+	struct socket *sock;
+	unsigned long end_time = 0;
+	int err, datagrams;
+
+	if (vlen > UIO_MAXIOV)
+		vlen = UIO_MAXIOV;
+
+	if (timeout) {
+		if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 ||
+		    timeout->tv_nsec >= NSEC_PER_SEC)
+			return -EINVAL;
+		end_time = jiffies + timespec_to_jiffies(timeout);
+	}
+
+	sock = sockfd_lookup(fd, &err);
+	if (!sock)
+		return err;
+
+	if (sock->file->f_flags & O_NONBLOCK)
+		flags |= MSG_DONTWAIT;
+
+	entry = mmsg;
+	compat_entry = (struct compat_mmsghdr __user *)mmsg;
+	datagrams = 0;
+	err = 0;
+
+	while (datagrams < vlen) {
+		if (MSG_CMSG_COMPAT & flags) {
+			err = __sys_recvmsg(sock,
+				(struct msghdr __user *)compat_entry,
+				flags & ~MSG_WAITFORONE);
+			if (err < 0)
+				break;
+			err = __put_user(err, &compat_entry->msg_len);
+			compat_entry++;
+		} else {
+			err = __sys_recvmsg(sock,
+				(struct msghdr __user *)entry,
+				flags & ~MSG_WAITFORONE);
+			if (err < 0)
+				break;
+			err = put_user(err, &entry->msg_len);
+			entry++;
+		}
+		if (err)
+			break;
+		datagrams++;
+
+		/* MSG_WAITFORONE turns MSG_DONTWAIT on after one datagram */
+		if (flags & MSG_WAITFORONE)
+			flags |= MSG_DONTWAIT;
+
+		if (timeout && time_after_eq(jiffies, end_time))
+			break;
+	}
+
+	if (timeout) {
+		long left = (long)(end_time - jiffies);
+
+		jiffies_to_timespec(left > 0 ? left : 0, timeout);
+	}
+
+	/*
+	 * If some datagrams were received before an error, report those
+	 * now and leave the error on the socket for the next call, as a
+	 * short read() would.
+	 */
+	if (datagrams && err < 0 && err != -EAGAIN)
+		sock->sk->sk_err = -err;
+
+	sockfd_put(sock);
+
+	return datagrams ? datagrams : err;
+}
+
+asmlinkage long sys_recvmmsg(int fd, struct mmsghdr __user *mmsg,
+			     unsigned int vlen, unsigned int flags,
+			     struct timespec __user *timeout)
+{
+	struct timespec timeout_sys;
+	int datagrams;
+
+	if (!timeout)
+		return __sys_recvmmsg(fd, mmsg, vlen, flags, NULL);
+
+	if (copy_from_user(&timeout_sys, timeout, sizeof(timeout_sys)))
+		return -EFAULT;
+
+	datagrams = __sys_recvmmsg(fd, mmsg, vlen, flags, &timeout_sys);
+
+	if (datagrams > 0 &&
+	    copy_to_user(timeout, &timeout_sys, sizeof(timeout_sys)))
+		datagrams = -EFAULT;
+
+	return datagrams;
+}
+
 #ifdef __ARCH_WANT_SYS_SOCKETCALL
 
 /* Argument list sizes for sys_socketcall */
 #define AL(x) ((x) * sizeof(unsigned long))
-static unsigned char nargs[18]={AL(0),AL(3),AL(3),AL(3),AL(2),AL(3),
+static unsigned char nargs[19]={AL(0),AL(3),AL(3),AL(3),AL(2),AL(3),
 				AL(3),AL(3),AL(4),AL(4),AL(4),AL(6),
-				AL(6),AL(2),AL(5),AL(5),AL(3),AL(3)};
+				AL(6),AL(2),AL(5),AL(5),AL(3),AL(3),
+				AL(5)};
 #undef AL
 
 /*
@@ -1945,7 +2087,7 @@ asmlinkage long sys_socketcall(int call, unsigned long __user *args)
 	unsigned long a0,a1;
 	int err;
 
-	if(call<1||call>SYS_RECVMSG)
+	if(call<1||call>SYS_RECVMMSG)
 		return -EINVAL;
 
 	/* copy_from_user should be SMP safe. */
@@ -2010,6 +2152,10 @@ asmlinkage long sys_socketcall(int call, unsigned long __user *args)
 		case SYS_RECVMSG:
 			err = sys_recvmsg(a0, (struct msghdr __user *) a1, a[2]);
 			break;
+		case SYS_RECVMMSG:
+			err = sys_recvmmsg(a0, (struct mmsghdr __user *) a1, a[2], a[3],
+					   (struct timespec __user *) a[4]);
+			break;
 		default:
 			err = -EINVAL;
 			break;